@@ -44,7 +44,8 @@ void Animation_dispose (Animation* self) {
 	FREE(self);
 }
 
-void Animation_apply (const Animation* self, Skeleton* skeleton, float time, int/*bool*/loop) {
+static void _Animation_apply (const Animation* self, Skeleton* skeleton, float time, int/*bool*/loop, float alpha,
+		int* frameCursors) {
 	int i, n = self->timelineCount;
 
 #ifdef __STDC_VERSION__
@@ -54,32 +55,36 @@ void Animation_apply (const Animation* self, Skeleton* skeleton, float time, int
 #endif
 
 	for (i = 0; i < n; ++i)
-		Timeline_apply(self->timelines[i], skeleton, time, 1);
+		Timeline_applyWithCursor(self->timelines[i], skeleton, time, alpha, frameCursors ? frameCursors + i : 0);
+}
+
+void Animation_apply (const Animation* self, Skeleton* skeleton, float time, int/*bool*/loop) {
+	_Animation_apply(self, skeleton, time, loop, 1, 0);
 }
 
 void Animation_mix (const Animation* self, Skeleton* skeleton, float time, int/*bool*/loop, float alpha) {
-	int i, n = self->timelineCount;
+	_Animation_apply(self, skeleton, time, loop, alpha, 0);
+}
 
-#ifdef __STDC_VERSION__
-	if (loop && self->duration) time = fmodf(time, self->duration);
-#else
-	if (loop && self->duration) time = (float)fmod(time, self->duration);
-#endif
+void Animation_applyWithCursors (const Animation* self, Skeleton* skeleton, float time, int/*bool*/loop, int* frameCursors) {
+	_Animation_apply(self, skeleton, time, loop, 1, frameCursors);
+}
 
-	for (i = 0; i < n; ++i)
-		Timeline_apply(self->timelines[i], skeleton, time, alpha);
+void Animation_mixWithCursors (const Animation* self, Skeleton* skeleton, float time, int/*bool*/loop, float alpha,
+		int* frameCursors) {
+	_Animation_apply(self, skeleton, time, loop, alpha, frameCursors);
 }
 
 /**/
 
 typedef struct _TimelineVtable {
-	void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha);
+	void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha, int* frameCursor);
 	void (*dispose) (Timeline* self);
 } _TimelineVtable;
 
 void _Timeline_init (Timeline* self, /**/
 		void (*dispose) (Timeline* self), /**/
-		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha)) {
+		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha, int* frameCursor)) {
 	CONST_CAST(_TimelineVtable*, self->vtable) = NEW(_TimelineVtable);
 	VTABLE(Timeline, self) ->dispose = dispose;
 	VTABLE(Timeline, self) ->apply = apply;
@@ -94,7 +99,11 @@ void Timeline_dispose (Timeline* self) {
 }
 
 void Timeline_apply (const Timeline* self, Skeleton* skeleton, float time, float alpha) {
-	VTABLE(Timeline, self) ->apply(self, skeleton, time, alpha);
+	VTABLE(Timeline, self) ->apply(self, skeleton, time, alpha, 0);
+}
+
+void Timeline_applyWithCursor (const Timeline* self, Skeleton* skeleton, float time, float alpha, int* frameCursor) {
+	VTABLE(Timeline, self) ->apply(self, skeleton, time, alpha, frameCursor);
 }
 
 /**/
@@ -105,22 +114,27 @@ static const int CURVE_SEGMENTS = 10;
 
 void _CurveTimeline_init (CurveTimeline* self, int frameCount, /**/
 		void (*dispose) (Timeline* self), /**/
-		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha)) {
+		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha, int* frameCursor)) {
 	_Timeline_init(SUPER(self), dispose, apply);
+	CONST_CAST(int, self->curveCount) = frameCount - 1;
 	self->curves = CALLOC(float, (frameCount - 1) * 6);
 }
 
 void _CurveTimeline_deinit (CurveTimeline* self) {
 	_Timeline_deinit(SUPER(self));
 	FREE(self->curves);
+	FREE(self->tableOffsets);
+	FREE(self->tables);
 }
 
 void CurveTimeline_setLinear (CurveTimeline* self, int frameIndex) {
 	self->curves[frameIndex * 6] = CURVE_LINEAR;
+	if (self->tableResolution) self->tableOffsets[frameIndex] = -1;
 }
 
 void CurveTimeline_setStepped (CurveTimeline* self, int frameIndex) {
 	self->curves[frameIndex * 6] = CURVE_STEPPED;
+	if (self->tableResolution) self->tableOffsets[frameIndex] = -1;
 }
 
 void CurveTimeline_setCurve (CurveTimeline* self, int frameIndex, float cx1, float cy1, float cx2, float cy2) {
@@ -142,6 +156,7 @@ void CurveTimeline_setCurve (CurveTimeline* self, int frameIndex, float cx1, flo
 	self->curves[i + 3] = tmp1y * pre4 + tmp2y * pre5;
 	self->curves[i + 4] = tmp2x * pre5;
 	self->curves[i + 5] = tmp2y * pre5;
+	if (self->tableResolution) self->tableOffsets[frameIndex] = -1;
 }
 
 float CurveTimeline_getCurvePercent (const CurveTimeline* self, int frameIndex, float percent) {
@@ -154,6 +169,16 @@ float CurveTimeline_getCurvePercent (const CurveTimeline* self, int frameIndex,
 	int i;
 	int curveIndex = frameIndex * 6;
 	float dfx = self->curves[curveIndex];
+	if (self->tableResolution && self->tableOffsets[frameIndex] != -1) {
+		const float* startX = self->tables + self->tableOffsets[frameIndex];
+		const float* startY = startX + CURVE_SEGMENTS + 1;
+		const float* slopes = startY + CURVE_SEGMENTS;
+		i = (int)(percent * self->tableResolution);
+		i = (int)slopes[CURVE_SEGMENTS + (i < self->tableResolution ? i : self->tableResolution - 1)];
+		while (startX[i + 1] < percent)
+			i++;
+		return startY[i] + slopes[i] * (percent - startX[i]);
+	}
 	if (dfx == CURVE_LINEAR) return percent;
 	if (dfx == CURVE_STEPPED) return 0;
 	dfy = self->curves[curveIndex + 1];
@@ -181,6 +206,68 @@ float CurveTimeline_getCurvePercent (const CurveTimeline* self, int frameIndex,
 	return y + (1 - y) * (percent - x) / (1 - x); /* Last point is 1,1. */
 }
 
+/* The floats in the table of a curve: the start x of each segment and 1, the start y and slope of each segment, and the segment
+ * at each of tableResolution evenly spaced percents. */
+#define CURVE_TABLE_SIZE(RESOLUTION) (CURVE_SEGMENTS * 3 + 1 + (RESOLUTION))
+
+static void _CurveTimeline_bakeCurve (const CurveTimeline* self, int frameIndex, float* table, int resolution) {
+	float* startX = table;
+	float* startY = table + CURVE_SEGMENTS + 1;
+	float* slopes = startY + CURVE_SEGMENTS;
+	float* segments = slopes + CURVE_SEGMENTS;
+	int i = frameIndex * 6, segment;
+	float dfx = self->curves[i], dfy = self->curves[i + 1];
+	float ddfx = self->curves[i + 2], ddfy = self->curves[i + 3];
+	float x = dfx, y = dfy, lastX = 0, lastY = 0;
+
+	/* Walk the segments as CurveTimeline_getCurvePercent does, the last one ending at 1,1. */
+	for (segment = 0; segment < CURVE_SEGMENTS; ++segment) {
+		if (segment == CURVE_SEGMENTS - 1) x = y = 1;
+		startX[segment] = lastX;
+		startY[segment] = lastY;
+		slopes[segment] = x > lastX ? (y - lastY) / (x - lastX) : 0;
+		lastX = x;
+		lastY = y;
+		dfx += ddfx;
+		dfy += ddfy;
+		ddfx += self->curves[i + 4];
+		ddfy += self->curves[i + 5];
+		x += dfx;
+		y += dfy;
+	}
+	startX[CURVE_SEGMENTS] = 1;
+
+	/* The first segment that ends at or after each percent. */
+	segment = 0;
+	for (i = 0; i < resolution; ++i) {
+		float percent = (float)i / resolution;
+		while (segment < CURVE_SEGMENTS - 1 && startX[segment + 1] < percent)
+			segment++;
+		segments[i] = (float)segment;
+	}
+}
+
+void CurveTimeline_bakeCurves (CurveTimeline* self, int resolution) {
+	int i, tableCount = 0;
+	FREE(self->tableOffsets);
+	FREE(self->tables);
+	CONST_CAST(int*, self->tableOffsets) = 0;
+	CONST_CAST(float*, self->tables) = 0;
+	CONST_CAST(int, self->tableResolution) = 0;
+	if (resolution <= 0) return;
+
+	/* Linear and stepped curves are as quick to evaluate without a table. */
+	CONST_CAST(int*, self->tableOffsets) = MALLOC(int, self->curveCount);
+	for (i = 0; i < self->curveCount; ++i) {
+		float dfx = self->curves[i * 6];
+		self->tableOffsets[i] = dfx == CURVE_LINEAR || dfx == CURVE_STEPPED ? -1 : CURVE_TABLE_SIZE(resolution) * tableCount++;
+	}
+	CONST_CAST(float*, self->tables) = MALLOC(float, CURVE_TABLE_SIZE(resolution) * tableCount);
+	for (i = 0; i < self->curveCount; ++i)
+		if (self->tableOffsets[i] != -1) _CurveTimeline_bakeCurve(self, i, self->tables + self->tableOffsets[i], resolution);
+	CONST_CAST(int, self->tableResolution) = resolution;
+}
+
 /* @param target After the first and before the last entry. */
 static int binarySearch (float *values, int valuesLength, float target, int step) {
 	int low = 0, current;
@@ -198,6 +285,23 @@ static int binarySearch (float *values, int valuesLength, float target, int step
 	return 0;
 }
 
+/* The frames cursorSearch steps forward before giving up and searching all of them. */
+static const int CURSOR_STEPS = 4;
+
+/* Returns the same as binarySearch, looking from the result of the last search first.
+ * @param cursor The last result, or 0 for none. Set to the result. */
+static int cursorSearch (float *values, int valuesLength, float target, int step, int* cursor) {
+	int i, current;
+	if (!cursor) return binarySearch(values, valuesLength, target, step);
+	current = *cursor;
+	if (current >= step && current < valuesLength && values[current - step] <= target) {
+		/* The target is at or after the last frame found, and before the last entry, so stepping forward ends there. */
+		for (i = 0; i < CURSOR_STEPS; ++i, current += step)
+			if (values[current] > target) return *cursor = current;
+	}
+	return *cursor = binarySearch(values, valuesLength, target, step);
+}
+
 /*static int linearSearch (float *values, int valuesLength, float target, int step) {
  int i, last = valuesLength - step;
  for (i = 0; i <= last; i += step) {
@@ -218,7 +322,7 @@ void _BaseTimeline_dispose (Timeline* timeline) {
 
 /* Many timelines have structure identical to struct BaseTimeline and extend CurveTimeline. **/
 struct BaseTimeline* _BaseTimeline_create (int frameCount, int frameSize, /**/
-		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha)) {
+		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha, int* frameCursor)) {
 
 	struct BaseTimeline* self = NEW(struct BaseTimeline);
 	_CurveTimeline_init(SUPER(self), frameCount, _BaseTimeline_dispose, apply);
@@ -234,7 +338,7 @@ struct BaseTimeline* _BaseTimeline_create (int frameCount, int frameSize, /**/
 static const int ROTATE_LAST_FRAME_TIME = -2;
 static const int ROTATE_FRAME_VALUE = 1;
 
-void _RotateTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha) {
+void _RotateTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha, int* frameCursor) {
 	Bone *bone;
 	int frameIndex;
 	float lastFrameValue, frameTime, percent, amount;
@@ -256,7 +360,7 @@ void _RotateTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float
 	}
 
 	/* Interpolate between the last frame and the current frame. */
-	frameIndex = binarySearch(self->frames, self->framesLength, time, 2);
+	frameIndex = cursorSearch(self->frames, self->framesLength, time, 2, frameCursor);
 	lastFrameValue = self->frames[frameIndex - 1];
 	frameTime = self->frames[frameIndex];
 	percent = 1 - (time - frameTime) / (self->frames[frameIndex + ROTATE_LAST_FRAME_TIME] - frameTime);
@@ -291,7 +395,7 @@ static const int TRANSLATE_LAST_FRAME_TIME = -3;
 static const int TRANSLATE_FRAME_X = 1;
 static const int TRANSLATE_FRAME_Y = 2;
 
-void _TranslateTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha) {
+void _TranslateTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha, int* frameCursor) {
 	Bone *bone;
 	int frameIndex;
 	float lastFrameX, lastFrameY, frameTime, percent;
@@ -309,7 +413,7 @@ void _TranslateTimeline_apply (const Timeline* timeline, Skeleton* skeleton, flo
 	}
 
 	/* Interpolate between the last frame and the current frame. */
-	frameIndex = binarySearch(self->frames, self->framesLength, time, 3);
+	frameIndex = cursorSearch(self->frames, self->framesLength, time, 3, frameCursor);
 	lastFrameX = self->frames[frameIndex - 2];
 	lastFrameY = self->frames[frameIndex - 1];
 	frameTime = self->frames[frameIndex];
@@ -335,7 +439,7 @@ void TranslateTimeline_setFrame (TranslateTimeline* self, int frameIndex, float
 
 /**/
 
-void _ScaleTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha) {
+void _ScaleTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha, int* frameCursor) {
 	Bone *bone;
 	int frameIndex;
 	float lastFrameX, lastFrameY, frameTime, percent;
@@ -352,7 +456,7 @@ void _ScaleTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float t
 	}
 
 	/* Interpolate between the last frame and the current frame. */
-	frameIndex = binarySearch(self->frames, self->framesLength, time, 3);
+	frameIndex = cursorSearch(self->frames, self->framesLength, time, 3, frameCursor);
 	lastFrameX = self->frames[frameIndex - 2];
 	lastFrameY = self->frames[frameIndex - 1];
 	frameTime = self->frames[frameIndex];
@@ -381,7 +485,7 @@ static const int COLOR_FRAME_G = 2;
 static const int COLOR_FRAME_B = 3;
 static const int COLOR_FRAME_A = 4;
 
-void _ColorTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha) {
+void _ColorTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha, int* frameCursor) {
 	Slot *slot;
 	int frameIndex;
 	float lastFrameR, lastFrameG, lastFrameB, lastFrameA, percent, frameTime;
@@ -402,7 +506,7 @@ void _ColorTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float t
 	}
 
 	/* Interpolate between the last frame and the current frame. */
-	frameIndex = binarySearch(self->frames, self->framesLength, time, 5);
+	frameIndex = cursorSearch(self->frames, self->framesLength, time, 5, frameCursor);
 	lastFrameR = self->frames[frameIndex - 4];
 	lastFrameG = self->frames[frameIndex - 3];
 	lastFrameB = self->frames[frameIndex - 2];
@@ -443,7 +547,7 @@ void ColorTimeline_setFrame (ColorTimeline* self, int frameIndex, float time, fl
 
 /**/
 
-void _AttachmentTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha) {
+void _AttachmentTimeline_apply (const Timeline* timeline, Skeleton* skeleton, float time, float alpha, int* frameCursor) {
 	int frameIndex;
 	const char* attachmentName;
 	AttachmentTimeline* self = (AttachmentTimeline*)timeline;
@@ -453,7 +557,7 @@ void _AttachmentTimeline_apply (const Timeline* timeline, Skeleton* skeleton, fl
 	if (time >= self->frames[self->framesLength - 1]) /* Time is after last frame. */
 		frameIndex = self->framesLength - 1;
 	else
-		frameIndex = binarySearch(self->frames, self->framesLength, time, 1) - 1;
+		frameIndex = cursorSearch(self->frames, self->framesLength, time, 1, frameCursor) - 1;
 
 	attachmentName = self->attachmentNames[frameIndex];
 	Slot_setAttachment(skeleton->slots[self->slotIndex],
@@ -493,3 +597,17 @@ void AttachmentTimeline_setFrame (AttachmentTimeline* self, int frameIndex, floa
 	else
 		self->attachmentNames[frameIndex] = 0;
 }
+
+/**/
+
+void Animation_bakeCurves (Animation* self, int resolution) {
+	int i;
+	for (i = 0; i < self->timelineCount; ++i) {
+		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha, int* frameCursor) =
+				VTABLE(Timeline, self->timelines[i]) ->apply;
+		if (apply == _RotateTimeline_apply || apply == _TranslateTimeline_apply || apply == _ScaleTimeline_apply
+				|| apply == _ColorTimeline_apply) {
+			CurveTimeline_bakeCurves(SUB_CAST(CurveTimeline, self->timelines[i]), resolution);
+		}
+	}
+}
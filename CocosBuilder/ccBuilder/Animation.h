@@ -47,6 +47,16 @@ void Animation_dispose (Animation* self);
 void Animation_apply (const Animation* self, struct Skeleton* skeleton, float time, int/*bool*/loop);
 void Animation_mix (const Animation* self, struct Skeleton* skeleton, float time, int/*bool*/loop, float alpha);
 
+/* Same as Animation_apply and Animation_mix, with a frame cursor for each timeline of the animation. See
+ * Timeline_applyWithCursor. */
+void Animation_applyWithCursors (const Animation* self, struct Skeleton* skeleton, float time, int/*bool*/loop,
+		int* frameCursors);
+void Animation_mixWithCursors (const Animation* self, struct Skeleton* skeleton, float time, int/*bool*/loop, float alpha,
+		int* frameCursors);
+
+/* Bakes the curves of all the curve timelines of the animation. See CurveTimeline_bakeCurves. */
+void Animation_bakeCurves (Animation* self, int resolution);
+
 /**/
 
 struct Timeline {
@@ -56,11 +66,21 @@ struct Timeline {
 void Timeline_dispose (Timeline* self);
 void Timeline_apply (const Timeline* self, struct Skeleton* skeleton, float time, float alpha);
 
+/* Same as Timeline_apply, but looks for the frames around time starting from the frame the timeline found last, which it keeps
+ * in frameCursor. While time advances by a few frames at most, the frames are found in constant time rather than by a binary
+ * search. Each animation state needs its own cursors, since the timeline is shared by all the skeletons playing it.
+ * @param frameCursor 0 for no cursor, else set to 0 before the first apply. */
+void Timeline_applyWithCursor (const Timeline* self, struct Skeleton* skeleton, float time, float alpha, int* frameCursor);
+
 /**/
 
 typedef struct {
 	Timeline super;
 	float* curves; /* dfx, dfy, ddfx, ddfy, dddfx, dddfy, ... */
+	int const curveCount; /* One less than the frames. */
+	int const tableResolution; /* 0 when the curves aren't baked. */
+	int* const tableOffsets; /* Where the table of each curve starts in tables, or -1 to evaluate the curve. */
+	float* const tables;
 } CurveTimeline;
 
 void CurveTimeline_setLinear (CurveTimeline* self, int frameIndex);
@@ -72,6 +92,12 @@ void CurveTimeline_setStepped (CurveTimeline* self, int frameIndex);
 void CurveTimeline_setCurve (CurveTimeline* self, int frameIndex, float cx1, float cy1, float cx2, float cy2);
 float CurveTimeline_getCurvePercent (const CurveTimeline* self, int frameIndex, float percent);
 
+/* Bakes each bezier curve into a table of the points between its segments, and of the segment at each of resolution evenly
+ * spaced percents, so CurveTimeline_getCurvePercent finds the segment with one lookup instead of stepping along the curve. The
+ * percents are the same to within float rounding. Curves set after baking are evaluated segment by segment until baked again.
+ * @param resolution The number of percents to look segments up at, 0 to free the tables. */
+void CurveTimeline_bakeCurves (CurveTimeline* self, int resolution);
+
 /**/
 
 typedef struct BaseTimeline {
@@ -34,6 +34,12 @@ struct _Entry {
 	_Entry* next;
 };
 
+/* The frame each timeline of an animation found last, so the next apply can look from there. */
+typedef struct {
+	int* frames;
+	int capacity;
+} _Cursors;
+
 typedef struct {
 	AnimationState super;
 	Animation *previous;
@@ -42,8 +48,20 @@ typedef struct {
 	float mixTime;
 	float mixDuration;
 	_Entry* queue;
+	_Cursors cursors;
+	_Cursors previousCursors;
 } _Internal;
 
+static void _Cursors_reset (_Cursors* self, const Animation* animation) {
+	int count = animation ? animation->timelineCount : 0;
+	if (count > self->capacity) {
+		FREE(self->frames);
+		self->frames = MALLOC(int, count);
+		self->capacity = count;
+	}
+	if (count) memset(self->frames, 0, sizeof(int) * count);
+}
+
 AnimationState* AnimationState_create (AnimationStateData* data) {
 	AnimationState* self = SUPER(NEW(_Internal));
 	CONST_CAST(AnimationStateData*, self->data) = data;
@@ -62,7 +80,10 @@ void _AnimationState_clearQueue (AnimationState* self) {
 }
 
 void AnimationState_dispose (AnimationState* self) {
+	_Internal* internal = SUB_CAST(_Internal, self);
 	_AnimationState_clearQueue(self);
+	FREE(internal->cursors.frames);
+	FREE(internal->previousCursors.frames);
 	FREE(self);
 }
 
@@ -103,6 +124,7 @@ void AnimationState_addAnimationByName (AnimationState* self, const char* animat
 }
 
 void _AnimationState_setAnimation (AnimationState* self, Animation* newAnimation, int/*bool*/loop) {
+	_Cursors cursors;
 	_Internal* internal = SUB_CAST(_Internal, self);
 	internal->previous = 0;
 	if (newAnimation && self->animation && self->data) {
@@ -112,8 +134,13 @@ void _AnimationState_setAnimation (AnimationState* self, Animation* newAnimation
 			internal->previous = self->animation;
 			internal->previousTime = self->time;
 			internal->previousLoop = self->loop;
+			/* The previous animation carries on from where it was. */
+			cursors = internal->previousCursors;
+			internal->previousCursors = internal->cursors;
+			internal->cursors = cursors;
 		}
 	}
+	_Cursors_reset(&internal->cursors, newAnimation);
 	CONST_CAST(Animation*, self->animation) = newAnimation;
 	self->loop = loop;
 	self->time = 0;
@@ -159,15 +186,16 @@ void AnimationState_apply (AnimationState* self, Skeleton* skeleton) {
 	if (!self->animation) return;
 	internal = SUB_CAST(_Internal, self);
 	if (internal->previous) {
-		Animation_apply(internal->previous, skeleton, internal->previousTime, internal->previousLoop);
+		Animation_applyWithCursors(internal->previous, skeleton, internal->previousTime, internal->previousLoop,
+				internal->previousCursors.frames);
 		alpha = internal->mixTime / internal->mixDuration;
 		if (alpha >= 1) {
 			alpha = 1;
 			internal->previous = 0;
 		}
-		Animation_mix(self->animation, skeleton, self->time, self->loop, alpha);
+		Animation_mixWithCursors(self->animation, skeleton, self->time, self->loop, alpha, internal->cursors.frames);
 	} else
-		Animation_apply(self->animation, skeleton, self->time, self->loop);
+		Animation_applyWithCursors(self->animation, skeleton, self->time, self->loop, internal->cursors.frames);
 }
 
 int/*bool*/AnimationState_isComplete (AnimationState* self) {
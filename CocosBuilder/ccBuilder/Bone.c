@@ -33,11 +33,19 @@ void Bone_setYDown (int value) {
 	yDown = value;
 }
 
-Bone* Bone_create (BoneData* data, Bone* parent) {
-	Bone* self = NEW(Bone);
+int Bone_isYDown () {
+	return yDown;
+}
+
+void _Bone_init (Bone* self, BoneData* data, Bone* parent) {
 	CONST_CAST(BoneData*, self->data) = data;
 	CONST_CAST(Bone*, self->parent) = parent;
 	Bone_setToSetupPose(self);
+}
+
+Bone* Bone_create (BoneData* data, Bone* parent) {
+	Bone* self = NEW(Bone);
+	_Bone_init(self, data, parent);
 	return self;
 }
 
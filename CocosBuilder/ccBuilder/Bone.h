@@ -47,6 +47,7 @@ struct Bone {
 };
 
 void Bone_setYDown (int/*bool*/yDown);
+int/*bool*/Bone_isYDown ();
 
 /* @param parent May be 0. */
 Bone* Bone_create (BoneData* data, Bone* parent);
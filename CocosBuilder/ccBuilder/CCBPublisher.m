@@ -566,28 +566,32 @@
             if (publishToSingleResolution) spriteSheetFile = outDir;
             else spriteSheetFile = [[spriteSheetDir stringByAppendingPathComponent:[NSString stringWithFormat:@"resources-%@", res]] stringByAppendingPathComponent:spriteSheetName];
             
-            // Skip publish if sprite sheet exists and is up to date
-            NSDate* dstDate = [CCBFileUtil modificationDateForFile:[spriteSheetFile stringByAppendingPathExtension:@"plist"]];
-            if (dstDate && [dstDate isEqualToDate:srcSpriteSheetDate] && !ssSettings.isDirty)
-            {
-                continue;
-            }
-                        
             Tupac* packer = [Tupac tupac];
             packer.outputName = spriteSheetFile;
             packer.outputFormat = TupacOutputFormatCocos2D;
+            packer.cacheDirectory = projectSettings.spriteSheetCacheDirectory;
+            packer.extrude = ssSettings.extrude;
+            packer.alphaBleed = ssSettings.alphaBleed;
+            packer.ditherMode = ssSettings.ditherMode;
+            packer.mipmaps = ssSettings.mipmaps;
+            packer.mipmapFilter = ssSettings.mipmapFilter;
+            packer.webpQuality = ssSettings.webpQuality;
+            packer.paletteColors = ssSettings.paletteColors;
             
             if (targetType == kCCBPublisherTargetTypeIPhone)
             {
                 packer.imageFormat = ssSettings.textureFileFormat;
                 packer.compress = ssSettings.compress;
                 packer.dither = ssSettings.dither;
+                packer.polygonMode = ssSettings.polygonMode;
+                packer.pvrtcQuality = ssSettings.pvrtcQuality;
             }
             else if (targetType == kCCBPublisherTargetTypeAndroid)
             {
                 packer.imageFormat = ssSettings.textureFileFormatAndroid;
                 packer.compress = NO;
                 packer.dither = ssSettings.ditherAndroid;
+                packer.polygonMode = ssSettings.polygonMode;
             }
             else if (targetType == kCCBPublisherTargetTypeHTML5)
             {
@@ -596,21 +600,32 @@
                 packer.dither = ssSettings.ditherHTML5;
             }
             
-            // Update progress
-            [ad modalStatusWindowUpdateStatusText:[NSString stringWithFormat:@"Generating sprite sheet %@...", [[subPath stringByAppendingPathExtension:@"plist"] lastPathComponent]]];
-            
-            // Pack texture
-            packer.directoryPrefix = subPath;
-            packer.border = YES;
-            [packer createTextureAtlasFromDirectoryPaths:srcDirs];
+            // Skip publish if sprite sheet exists and is up to date
+            NSDate* dstDate = [CCBFileUtil modificationDateForFile:[spriteSheetFile stringByAppendingPathExtension:@"plist"]];
+            if (!dstDate || ![dstDate isEqualToDate:srcSpriteSheetDate] || ssSettings.isDirty)
+            {
+                // Update progress
+                [ad modalStatusWindowUpdateStatusText:[NSString stringWithFormat:@"Generating sprite sheet %@...", [[subPath stringByAppendingPathExtension:@"plist"] lastPathComponent]]];
+                
+                // Pack texture
+                packer.directoryPrefix = subPath;
+                packer.border = YES;
+                [packer createTextureAtlasFromDirectoryPaths:srcDirs];
+                
+                // Set correct modification date
+                [CCBFileUtil setModificationDate:srcSpriteSheetDate forFile:[spriteSheetFile stringByAppendingPathExtension:@"plist"]];
+            }
             
-            // Set correct modification date
-            [CCBFileUtil setModificationDate:srcSpriteSheetDate forFile:[spriteSheetFile stringByAppendingPathExtension:@"plist"]];
+            // Sprites that didn't fit into a single texture are published on additional pages, which the first page lists
+            int numPages = [Tupac numPagesForOutputName:spriteSheetFile];
+            for (int page = 0; page < numPages; page++)
+            {
+                NSString* pageName = [Tupac pageName:page forOutputName:subPath];
+                [publishedResources addObject:[pageName stringByAppendingPathExtension:@"plist"]];
+                [publishedResources addObject:[pageName stringByAppendingPathExtension:[packer textureExtension]]];
+            }
         }
         
-        [publishedResources addObject:[subPath stringByAppendingPathExtension:@"plist"]];
-        [publishedResources addObject:[subPath stringByAppendingPathExtension:@"png"]];
-        
         if (ssSettings.isDirty) {
             ssSettings.isDirty = NO;
             [projectSettings store];
@@ -792,6 +807,7 @@
             else if ([ext isEqualToString:@"png"]) type = @"image";
             else if ([ext isEqualToString:@"jpg"]) type = @"image";
             else if ([ext isEqualToString:@"jpeg"]) type = @"image";
+            else if ([ext isEqualToString:@"webp"]) type = @"image";
             else if ([ext isEqualToString:@"mp3"]) type = @"sound";
             else if ([ext isEqualToString:@"ccbi"]) type = @"ccbi";
             else if ([ext isEqualToString:@"fnt"]) type = @"fnt";
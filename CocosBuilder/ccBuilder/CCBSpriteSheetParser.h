@@ -31,6 +31,8 @@
 
 + (BOOL) isSpriteSheetFile:(NSString*) file;
 + (NSMutableArray*) findSpriteSheetsAtPath:(NSString*)assetsPath;
++ (NSArray*) pagesOfSheet:(NSString*)absoluteFile;
++ (void) addSpriteFramesWithFile:(NSString*)absoluteFile;
 + (NSMutableArray*) listFramesInSheet:(NSString*)file assetsPath:(NSString*) assetsPath;
 + (NSMutableArray*) listFramesInSheet:(NSString *)absoluteFile;
 + (NSImage*) imageNamed:(NSString*)spriteFile fromSheet:(NSString*)spriteSheetFile;
@@ -69,25 +69,50 @@ static NSInteger strSort(id num1, id num2, void *context)
             if (!isHDFile)
             {
                 [array addObject:file];
-                [[CCSpriteFrameCache sharedSpriteFrameCache] addSpriteFramesWithFile:absFile];
+                [CCBSpriteSheetParser addSpriteFramesWithFile:absFile];
             }
         }
     }
     return array;
 }
 
+// Returns the sheet followed by its other pages. Sprite sheets that don't fit into a single texture list the property lists of their other pages in the metadata of the first one
++ (NSArray*) pagesOfSheet:(NSString*)absoluteFile
+{
+    NSMutableArray* pages = [NSMutableArray arrayWithObject:absoluteFile];
+    
+    NSDictionary* dict = [NSDictionary dictionaryWithContentsOfFile:absoluteFile];
+    NSString* dir = [absoluteFile stringByDeletingLastPathComponent];
+    for (NSString* page in [[dict objectForKey:@"metadata"] objectForKey:@"pages"])
+    {
+        [pages addObject:[dir stringByAppendingPathComponent:page]];
+    }
+    return pages;
+}
+
++ (void) addSpriteFramesWithFile:(NSString*)absoluteFile
+{
+    for (NSString* page in [CCBSpriteSheetParser pagesOfSheet:absoluteFile])
+    {
+        [[CCSpriteFrameCache sharedSpriteFrameCache] addSpriteFramesWithFile:page];
+    }
+}
+
 + (NSMutableArray*) listFramesInSheet:(NSString *)absoluteFile
 {
     NSMutableArray* frames = [NSMutableArray array];
     
     if ([CCBSpriteSheetParser isSpriteSheetFile:absoluteFile])
     {
-        NSMutableDictionary* dict = [NSMutableDictionary dictionaryWithContentsOfFile:absoluteFile];
-        
-        NSDictionary* dictFrames = [dict objectForKey:@"frames"];
-        for (NSString* frameKey in dictFrames)
+        for (NSString* page in [CCBSpriteSheetParser pagesOfSheet:absoluteFile])
         {
-            [frames addObject:frameKey];
+            NSMutableDictionary* dict = [NSMutableDictionary dictionaryWithContentsOfFile:page];
+            
+            NSDictionary* dictFrames = [dict objectForKey:@"frames"];
+            for (NSString* frameKey in dictFrames)
+            {
+                [frames addObject:frameKey];
+            }
         }
     }
     
@@ -98,6 +123,16 @@ static NSInteger strSort(id num1, id num2, void *context)
 
 + (NSImage*) imageNamed:(NSString*)spriteFile fromSheet:(NSString*)spriteSheetFile
 {
+    // The frame may be on another page of the sheet
+    for (NSString* page in [CCBSpriteSheetParser pagesOfSheet:spriteSheetFile])
+    {
+        NSDictionary* pageDict = [NSDictionary dictionaryWithContentsOfFile:page];
+        if ([[pageDict objectForKey:@"frames"] objectForKey:spriteFile])
+        {
+            spriteSheetFile = page;
+            break;
+        }
+    }
 
     NSString* assetsPath = [spriteSheetFile stringByDeletingLastPathComponent];
     
@@ -31,6 +31,7 @@ Draws a skeleton.
 */
 @interface CCSkeleton : CCNodeRGBA<CCBlendProtocol> {
 	Skeleton* _skeleton;
+	SkeletonPose* _pose;
 	Bone* _rootBone;
 	float _timeScale;
 	bool _debugSlots;
@@ -55,6 +56,7 @@ Draws a skeleton.
 - (CCTextureAtlas*) getTextureAtlas:(RegionAttachment*)regionAttachment;
 
 // --- Convenience methods for common Skeleton_* functions.
+/* Updates the world transforms of the bones through a SkeletonPose, several bones at a time. */
 - (void) updateWorldTransform;
 
 - (void) setToSetupPose;
@@ -27,6 +27,7 @@
 #import "spine-cocos2d-iphone.h"
 
 @interface CCSkeleton (Private)
++ (SkeletonData*) readSkeletonDataFile:(NSString*)skeletonDataFile atlas:(Atlas*)atlas scale:(float)scale;
 - (void) initialize:(SkeletonData*)skeletonData ownsSkeletonData:(bool)ownsSkeletonData;
 @end
 
@@ -50,6 +51,25 @@
 	return [[[CCSkeleton alloc] initWithFile:skeletonDataFile atlasFile:atlasFile scale:scale] autorelease];
 }
 
+/* Reads .skel files with SkeletonBinary, which loads much faster than parsing the JSON they're converted from. */
++ (SkeletonData*) readSkeletonDataFile:(NSString*)skeletonDataFile atlas:(Atlas*)atlas scale:(float)scale {
+	SkeletonData* skeletonData;
+	if ([[skeletonDataFile pathExtension] isEqualToString:@"skel"]) {
+		SkeletonBinary* binary = SkeletonBinary_create(atlas);
+		binary->scale = scale;
+		skeletonData = SkeletonBinary_readSkeletonDataFile(binary, [skeletonDataFile UTF8String]);
+		NSAssert(skeletonData, ([NSString stringWithFormat:@"Error reading skeleton data file: %@\nError: %s", skeletonDataFile, binary->error]));
+		SkeletonBinary_dispose(binary);
+	} else {
+		SkeletonJson* json = SkeletonJson_create(atlas);
+		json->scale = scale;
+		skeletonData = SkeletonJson_readSkeletonDataFile(json, [skeletonDataFile UTF8String]);
+		NSAssert(skeletonData, ([NSString stringWithFormat:@"Error reading skeleton data file: %@\nError: %s", skeletonDataFile, json->error]));
+		SkeletonJson_dispose(json);
+	}
+	return skeletonData;
+}
+
 - (void)setAtlas:(Atlas *)atlas
 {
     _atlas = atlas;
@@ -61,6 +81,8 @@
 
 	_skeleton = Skeleton_create(skeletonData);
 	_rootBone = _skeleton->bones[0];
+	if (_pose) SkeletonPose_dispose(_pose);
+	_pose = SkeletonPose_create(_skeleton);
 
 	_blendFunc.src = GL_ONE;
 	_blendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
@@ -87,11 +109,7 @@
 	self = [super init];
 	if (!self) return nil;
 
-	SkeletonJson* json = SkeletonJson_create(atlas);
-	json->scale = scale;
-	SkeletonData* skeletonData = SkeletonJson_readSkeletonDataFile(json, [skeletonDataFile UTF8String]);
-	NSAssert(skeletonData, ([NSString stringWithFormat:@"Error reading skeleton data file: %@\nError: %s", skeletonDataFile, json->error]));
-	SkeletonJson_dispose(json);
+	SkeletonData* skeletonData = [CCSkeleton readSkeletonDataFile:skeletonDataFile atlas:atlas scale:scale];
 	if (!skeletonData) return 0;
 
 	[self initialize:skeletonData ownsSkeletonData:YES];
@@ -107,11 +125,7 @@
 	NSAssert(_atlas, ([NSString stringWithFormat:@"Error reading atlas file: %@", atlasFile]));
 	if (!_atlas) return 0;
 
-	SkeletonJson* json = SkeletonJson_create(_atlas);
-	json->scale = scale;
-	SkeletonData* skeletonData = SkeletonJson_readSkeletonDataFile(json, [skeletonDataFile UTF8String]);
-	NSAssert(skeletonData, ([NSString stringWithFormat:@"Error reading skeleton data file: %@\nError: %s", skeletonDataFile, json->error]));
-	SkeletonJson_dispose(json);
+	SkeletonData* skeletonData = [CCSkeleton readSkeletonDataFile:skeletonDataFile atlas:_atlas scale:scale];
 	if (!skeletonData) return 0;
 
 	[self initialize:skeletonData ownsSkeletonData:YES];
@@ -122,6 +136,7 @@
 - (void) dealloc {
 	if (_ownsSkeletonData) SkeletonData_dispose(_skeleton->data);
 	if (_atlas) Atlas_dispose(_atlas);
+	if (_pose) SkeletonPose_dispose(_pose);
 	Skeleton_dispose(_skeleton);
 	[super dealloc];
 }
@@ -257,7 +272,7 @@
 // --- Convenience methods for Skeleton_* functions.
 
 - (void) updateWorldTransform {
-	Skeleton_updateWorldTransform(_skeleton);
+	SkeletonPose_updateWorldTransform(_pose);
 }
 
 - (void) setToSetupPose {
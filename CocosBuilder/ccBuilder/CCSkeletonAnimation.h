@@ -38,6 +38,10 @@ Draws an animated skeleton, providing a simple API for applying one or more anim
 
 - (void) initialize;
 
+/* Updates the skeletons and animation states of many nodes at once, spread over a thread per processor, as each node would
+ * update itself. The nodes must not also update themselves, so unscheduleUpdate them first. */
++ (void) updateSkeletons:(NSArray*)skeletons delta:(ccTime)deltaTime;
+
 + (id) skeletonWithData:(SkeletonData*)skeletonData ownsSkeletonData:(bool)ownsSkeletonData;
 + (id) skeletonWithFile:(NSString*)skeletonDataFile atlas:(Atlas*)atlas scale:(float)scale;
 + (id) skeletonWithFile:(NSString*)skeletonDataFile atlasFile:(NSString*)atlasFile scale:(float)scale;
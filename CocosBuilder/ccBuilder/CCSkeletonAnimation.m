@@ -34,6 +34,34 @@
 
 @synthesize states = _states;
 
++ (void) updateSkeletons:(NSArray*)skeletons delta:(ccTime)deltaTime {
+	static SkeletonBatch* batch = 0;
+	if (!batch) batch = SkeletonBatch_create(0);
+
+	int count = (int)skeletons.count, stateCount = 0;
+	for (CCSkeletonAnimation* node in skeletons)
+		stateCount += node->_states.count;
+	SkeletonInstance* instances = malloc(sizeof(SkeletonInstance) * count);
+	AnimationState** states = malloc(sizeof(AnimationState*) * stateCount);
+
+	int i = 0;
+	AnimationState** nodeStates = states;
+	for (CCSkeletonAnimation* node in skeletons) {
+		SkeletonInstance* instance = instances + i++;
+		instance->skeleton = node->_skeleton;
+		instance->pose = node->_pose;
+		instance->stateCount = (int)node->_states.count;
+		instance->states = nodeStates;
+		instance->timeScale = node->_timeScale;
+		for (NSValue* value in node->_states)
+			*nodeStates++ = [value pointerValue];
+	}
+	SkeletonBatch_update(batch, instances, count, deltaTime);
+
+	free(states);
+	free(instances);
+}
+
 + (id) skeletonWithData:(SkeletonData*)skeletonData ownsSkeletonData:(bool)ownsSkeletonData {
 	return [[[CCSkeletonAnimation alloc] initWithData:skeletonData ownsSkeletonData:ownsSkeletonData] autorelease];
 }
@@ -100,7 +128,7 @@
 		AnimationState_update(state, deltaTime);
 		AnimationState_apply(state, _skeleton);
 	}
-	Skeleton_updateWorldTransform(_skeleton);
+	SkeletonPose_updateWorldTransform(_pose);
 }
 
 - (void) addAnimationState {
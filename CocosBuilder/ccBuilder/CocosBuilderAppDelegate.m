@@ -3435,6 +3435,15 @@ static BOOL hideAllToNextSeparator;
         wc.textureFileFormatAndroid = ssSettings.textureFileFormatAndroid;
         wc.textureFileFormatHTML5 = ssSettings.textureFileFormatHTML5;
         wc.ditherHTML5 = ssSettings.ditherHTML5;
+        wc.polygonMode = ssSettings.polygonMode;
+        wc.ditherMode = ssSettings.ditherMode;
+        wc.pvrtcQuality = ssSettings.pvrtcQuality;
+        wc.extrude = ssSettings.extrude;
+        wc.alphaBleed = ssSettings.alphaBleed;
+        wc.mipmaps = ssSettings.mipmaps;
+        wc.mipmapFilter = ssSettings.mipmapFilter;
+        wc.webpQuality = ssSettings.webpQuality;
+        wc.paletteColors = ssSettings.paletteColors;
         wc.iOSEnabled = projectSettings.publishEnablediPhone;
         wc.androidEnabled = projectSettings.publishEnabledAndroid;
         wc.HTML5Enabled = projectSettings.publishEnabledHTML5;
@@ -3449,7 +3458,16 @@ static BOOL hideAllToNextSeparator;
                                  (ssSettings.ditherAndroid != wc.ditherAndroid)||
                                  (ssSettings.textureFileFormatAndroid != wc.textureFileFormatAndroid)||
                                  (ssSettings.textureFileFormatHTML5 != wc.textureFileFormatHTML5)||
-                                 (ssSettings.ditherHTML5 != wc.ditherHTML5);
+                                 (ssSettings.ditherHTML5 != wc.ditherHTML5)||
+                                 (ssSettings.polygonMode != wc.polygonMode)||
+                                 (ssSettings.ditherMode != wc.ditherMode)||
+                                 (ssSettings.pvrtcQuality != wc.pvrtcQuality)||
+                                 (ssSettings.extrude != wc.extrude)||
+                                 (ssSettings.alphaBleed != wc.alphaBleed)||
+                                 (ssSettings.mipmaps != wc.mipmaps)||
+                                 (ssSettings.mipmapFilter != wc.mipmapFilter)||
+                                 (ssSettings.webpQuality != wc.webpQuality)||
+                                 (ssSettings.paletteColors != wc.paletteColors);
             if(settingDirty){
                 ssSettings.isDirty = YES;
                 ssSettings.compress = wc.compress;
@@ -3459,6 +3477,15 @@ static BOOL hideAllToNextSeparator;
                 ssSettings.textureFileFormatAndroid = wc.textureFileFormatAndroid;
                 ssSettings.textureFileFormatHTML5 = wc.textureFileFormatHTML5;
                 ssSettings.ditherHTML5 = wc.ditherHTML5;
+                ssSettings.polygonMode = wc.polygonMode;
+                ssSettings.ditherMode = wc.ditherMode;
+                ssSettings.pvrtcQuality = wc.pvrtcQuality;
+                ssSettings.extrude = wc.extrude;
+                ssSettings.alphaBleed = wc.alphaBleed;
+                ssSettings.mipmaps = wc.mipmaps;
+                ssSettings.mipmapFilter = wc.mipmapFilter;
+                ssSettings.webpQuality = wc.webpQuality;
+                ssSettings.paletteColors = wc.paletteColors;
                 [projectSettings store];
             }
         }
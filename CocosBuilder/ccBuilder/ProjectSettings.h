@@ -39,6 +39,15 @@
     BOOL ditherAndroid;
     int textureFileFormatHTML5;
     BOOL ditherHTML5;
+    int ditherMode;
+    BOOL polygonMode;
+    int pvrtcQuality;
+    int extrude;
+    BOOL alphaBleed;
+    BOOL mipmaps;
+    int mipmapFilter;
+    int webpQuality;
+    int paletteColors;
 }
 @property (nonatomic,assign) BOOL isDirty;
 @property (nonatomic,assign) int textureFileFormat;
@@ -48,6 +57,15 @@
 @property (nonatomic,assign) BOOL ditherAndroid;
 @property (nonatomic,assign) int textureFileFormatHTML5;
 @property (nonatomic,assign) BOOL ditherHTML5;
+@property (nonatomic,assign) int ditherMode;
+@property (nonatomic,assign) BOOL polygonMode;
+@property (nonatomic,assign) int pvrtcQuality;
+@property (nonatomic,assign) int extrude;
+@property (nonatomic,assign) BOOL alphaBleed;
+@property (nonatomic,assign) BOOL mipmaps;
+@property (nonatomic,assign) int mipmapFilter;
+@property (nonatomic,assign) int webpQuality;
+@property (nonatomic,assign) int paletteColors;
 
 - (id)initWithSerialization:(id)dict;
 - (id)serialize;
@@ -146,6 +164,7 @@
 @property (nonatomic, readonly) NSString* displayCacheDirectory;
 @property (nonatomic, readonly) NSString* publishCacheDirectory;
 @property (nonatomic, readonly) NSString* tempSpriteSheetCacheDirectory;
+@property (nonatomic, readonly) NSString* spriteSheetCacheDirectory;
 @property (nonatomic, assign) BOOL deviceOrientationPortrait;
 @property (nonatomic, assign) BOOL deviceOrientationUpsideDown;
 @property (nonatomic, assign) BOOL deviceOrientationLandscapeLeft;
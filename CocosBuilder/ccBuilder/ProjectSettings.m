@@ -45,6 +45,15 @@
 @synthesize ditherAndroid;
 @synthesize textureFileFormatHTML5;
 @synthesize ditherHTML5;
+@synthesize ditherMode;
+@synthesize polygonMode;
+@synthesize pvrtcQuality;
+@synthesize extrude;
+@synthesize alphaBleed;
+@synthesize mipmaps;
+@synthesize mipmapFilter;
+@synthesize webpQuality;
+@synthesize paletteColors;
 
 - (id)init
 {
@@ -62,6 +71,16 @@
     
     self.textureFileFormatHTML5 = 0;
     self.ditherHTML5 = YES;
+    self.ditherMode = 0; // Error diffusion
+    
+    self.polygonMode = NO;
+    self.pvrtcQuality = 2; // Best
+    self.extrude = 0;
+    self.alphaBleed = NO;
+    self.mipmaps = NO;
+    self.mipmapFilter = 1; // Kaiser
+    self.webpQuality = 80;
+    self.paletteColors = 256;
     
     return self;
 }
@@ -82,6 +101,26 @@
     
     self.textureFileFormatHTML5 = [[dict objectForKey:@"textureFileFormatHTML5"] intValue];
     self.ditherHTML5 = [[dict objectForKey:@"ditherHTML5"] boolValue];
+    self.ditherMode = [[dict objectForKey:@"ditherMode"] intValue];
+    
+    self.polygonMode = [[dict objectForKey:@"polygonMode"] boolValue];
+    
+    // Sheets saved before the setting existed were compressed with the best quality
+    NSNumber* quality = [dict objectForKey:@"pvrtcQuality"];
+    self.pvrtcQuality = quality ? [quality intValue] : 2;
+    
+    self.extrude = [[dict objectForKey:@"extrude"] intValue];
+    self.alphaBleed = [[dict objectForKey:@"alphaBleed"] boolValue];
+    
+    self.mipmaps = [[dict objectForKey:@"mipmaps"] boolValue];
+    NSNumber* filter = [dict objectForKey:@"mipmapFilter"];
+    self.mipmapFilter = filter ? [filter intValue] : 1;
+    
+    // Sheets saved before the settings existed were converted with cwebp -q 80 and a full palette
+    NSNumber* webp = [dict objectForKey:@"webpQuality"];
+    self.webpQuality = webp ? [webp intValue] : 80;
+    NSNumber* colors = [dict objectForKey:@"paletteColors"];
+    self.paletteColors = colors ? [colors intValue] : 256;
 
     return self;
 }
@@ -101,6 +140,16 @@
     
     [ser setObject:[NSNumber numberWithInt:self.textureFileFormatHTML5] forKey:@"textureFileFormatHTML5"];
     [ser setObject:[NSNumber numberWithBool:self.ditherHTML5] forKey:@"ditherHTML5"];
+    [ser setObject:[NSNumber numberWithInt:self.ditherMode] forKey:@"ditherMode"];
+    
+    [ser setObject:[NSNumber numberWithBool:self.polygonMode] forKey:@"polygonMode"];
+    [ser setObject:[NSNumber numberWithInt:self.pvrtcQuality] forKey:@"pvrtcQuality"];
+    [ser setObject:[NSNumber numberWithInt:self.extrude] forKey:@"extrude"];
+    [ser setObject:[NSNumber numberWithBool:self.alphaBleed] forKey:@"alphaBleed"];
+    [ser setObject:[NSNumber numberWithBool:self.mipmaps] forKey:@"mipmaps"];
+    [ser setObject:[NSNumber numberWithInt:self.mipmapFilter] forKey:@"mipmapFilter"];
+    [ser setObject:[NSNumber numberWithInt:self.webpQuality] forKey:@"webpQuality"];
+    [ser setObject:[NSNumber numberWithInt:self.paletteColors] forKey:@"paletteColors"];
 
     return ser;
 }
@@ -443,6 +492,13 @@
     return [[[paths objectAtIndex:0] stringByAppendingPathComponent:@"com.cocosbuilder.CocosBuilder"] stringByAppendingPathComponent:@"spritesheet"];
 }
 
+// Generated sprite sheets, kept across publishes and keyed on the content of their images
+- (NSString*) spriteSheetCacheDirectory
+{
+    NSArray *paths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES);
+    return [[[[[paths objectAtIndex:0] stringByAppendingPathComponent:@"com.cocosbuilder.CocosBuilder"] stringByAppendingPathComponent:@"publish"]stringByAppendingPathComponent:self.projectPathHashed] stringByAppendingPathComponent:@"spritesheets"];
+}
+
 - (BOOL) store
 {
     return [[self serialize] writeToFile:self.projectPath atomically:YES];
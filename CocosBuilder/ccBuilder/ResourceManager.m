@@ -32,6 +32,7 @@
 #import "ResolutionSetting.h"
 #import "ProjectSettings.h"
 #import "CCBFileUtil.h"
+#import "Tupac.h"
 #import <CoreGraphics/CGImage.h>
 
 #pragma mark RMSpriteFrame
@@ -950,14 +951,7 @@
     {
         CFRelease(colorSpace);
         
-        NSTask* pngTask = [[NSTask alloc] init];
-        [pngTask setLaunchPath:[[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:@"pngquant"]];
-        NSMutableArray* args = [NSMutableArray arrayWithObjects:
-                                @"--force", @"--ext", @".png", dstFile, nil];
-        [pngTask setArguments:args];
-        [pngTask launch];
-        [pngTask waitUntilExit];
-        [pngTask release];
+        [Tupac convertToIndexedPNG:dstFile colors:256 dither:NO];
     }
     
     // Update modification time to match original file
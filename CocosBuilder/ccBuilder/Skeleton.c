@@ -29,12 +29,15 @@
 
 Skeleton* Skeleton_create (SkeletonData* data) {
 	int i, ii;
+	Bone* boneBlock;
 
 	Skeleton* self = NEW(Skeleton);
 	CONST_CAST(SkeletonData*, self->data) = data;
 
+	/* The bones are allocated in one block, in the same order as the bone data, so updating them walks memory in order. */
 	self->boneCount = self->data->boneCount;
 	self->bones = MALLOC(Bone*, self->boneCount);
+	boneBlock = CALLOC(Bone, self->boneCount);
 
 	for (i = 0; i < self->boneCount; ++i) {
 		BoneData* boneData = self->data->bones[i];
@@ -48,7 +51,8 @@ Skeleton* Skeleton_create (SkeletonData* data) {
 				}
 			}
 		}
-		self->bones[i] = Bone_create(boneData, parent);
+		self->bones[i] = boneBlock + i;
+		_Bone_init(self->bones[i], boneData, parent);
 	}
 	CONST_CAST(Bone*, self->root) = self->bones[0];
 
@@ -81,8 +85,7 @@ Skeleton* Skeleton_create (SkeletonData* data) {
 
 void Skeleton_dispose (Skeleton* self) {
 	int i;
-	for (i = 0; i < self->boneCount; ++i)
-		Bone_dispose(self->bones[i]);
+	if (self->boneCount) FREE(self->bones[0]); /* The block of bones. */
 	FREE(self->bones);
 
 	for (i = 0; i < self->slotCount; ++i)
@@ -0,0 +1,226 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2012 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SkeletonBatch.h"
+#include <pthread.h>
+#include <unistd.h>
+#include "extension.h"
+
+/* The instances left to one thread. The thread takes them from the front, and threads that have run out take them from the
+ * back. */
+typedef struct {
+	pthread_mutex_t lock;
+	int begin, end;
+	char padding[64]; /* Keeps the queues of different threads out of the same cache line. */
+} _Queue;
+
+typedef struct _Internal _Internal;
+
+typedef struct {
+	_Internal* batch;
+	int index;
+} _Worker;
+
+struct _Internal {
+	SkeletonBatch super;
+	_Queue* queues;
+	_Worker* workers;
+	pthread_t* threads;
+
+	pthread_mutex_t lock;
+	pthread_cond_t start; /* Signaled when there are instances to update, or the threads should quit. */
+	pthread_cond_t done; /* Signaled when the last worker thread has run out of instances. */
+	int generation; /* Counts the calls to SkeletonBatch_update. */
+	int busyThreads;
+	int/*bool*/quit;
+
+	SkeletonInstance* instances;
+	float delta;
+};
+
+static void _SkeletonBatch_updateInstance (const SkeletonInstance* instance, float delta) {
+	int i;
+	delta *= instance->timeScale;
+	Skeleton_update(instance->skeleton, delta);
+	for (i = 0; i < instance->stateCount; ++i) {
+		AnimationState_update(instance->states[i], delta);
+		AnimationState_apply(instance->states[i], instance->skeleton);
+	}
+	if (instance->pose)
+		SkeletonPose_updateWorldTransform(instance->pose);
+	else
+		Skeleton_updateWorldTransform(instance->skeleton);
+}
+
+/* Returns the next instance of the queue, or -1 if it is empty. */
+static int _Queue_pop (_Queue* self) {
+	int index = -1;
+	pthread_mutex_lock(&self->lock);
+	if (self->begin < self->end) index = self->begin++;
+	pthread_mutex_unlock(&self->lock);
+	return index;
+}
+
+/* Takes the back half of the instances of the first other thread that has any left, keeping the rest in the queue of the
+ * thief. Returns the first instance taken, or -1 if no thread has any left. */
+static int _SkeletonBatch_steal (_Internal* self, int thief) {
+	int i, n = self->super.threadCount;
+	for (i = 1; i < n; ++i) {
+		_Queue* victim = self->queues + (thief + i) % n;
+		int begin, end;
+		pthread_mutex_lock(&victim->lock);
+		end = victim->end;
+		begin = end - (end - victim->begin + 1) / 2;
+		victim->end = begin;
+		pthread_mutex_unlock(&victim->lock);
+		if (begin < end) {
+			_Queue* queue = self->queues + thief;
+			pthread_mutex_lock(&queue->lock);
+			queue->begin = begin + 1;
+			queue->end = end;
+			pthread_mutex_unlock(&queue->lock);
+			return begin;
+		}
+	}
+	return -1;
+}
+
+static void _SkeletonBatch_run (_Internal* self, int worker) {
+	while (1) {
+		int index = _Queue_pop(self->queues + worker);
+		if (index < 0) index = _SkeletonBatch_steal(self, worker);
+		if (index < 0) return;
+		_SkeletonBatch_updateInstance(self->instances + index, self->delta);
+	}
+}
+
+static void* _SkeletonBatch_work (void* argument) {
+	_Worker* worker = (_Worker*)argument;
+	_Internal* self = worker->batch;
+	int generation = 0;
+	pthread_mutex_lock(&self->lock);
+	while (1) {
+		while (self->generation == generation && !self->quit)
+			pthread_cond_wait(&self->start, &self->lock);
+		if (self->quit) break;
+		generation = self->generation;
+		pthread_mutex_unlock(&self->lock);
+
+		_SkeletonBatch_run(self, worker->index);
+
+		pthread_mutex_lock(&self->lock);
+		if (--self->busyThreads == 0) pthread_cond_signal(&self->done);
+	}
+	pthread_mutex_unlock(&self->lock);
+	return 0;
+}
+
+SkeletonBatch* SkeletonBatch_create (int threadCount) {
+	int i;
+	_Internal* internal = NEW(_Internal);
+	SkeletonBatch* self = SUPER(internal);
+
+	if (threadCount <= 0) {
+		long processors = sysconf(_SC_NPROCESSORS_ONLN);
+		threadCount = processors > 0 ? (int)processors : 1;
+	}
+	CONST_CAST(int, self->threadCount) = threadCount;
+
+	internal->queues = CALLOC(_Queue, threadCount);
+	for (i = 0; i < threadCount; ++i)
+		pthread_mutex_init(&internal->queues[i].lock, 0);
+	pthread_mutex_init(&internal->lock, 0);
+	pthread_cond_init(&internal->start, 0);
+	pthread_cond_init(&internal->done, 0);
+
+	/* The thread calling SkeletonBatch_update is the first worker, so one thread less needs to be started. */
+	internal->workers = MALLOC(_Worker, threadCount);
+	internal->threads = MALLOC(pthread_t, threadCount);
+	for (i = 1; i < threadCount; ++i) {
+		internal->workers[i].batch = internal;
+		internal->workers[i].index = i;
+		if (pthread_create(internal->threads + i, 0, _SkeletonBatch_work, internal->workers + i) != 0) {
+			/* Carry on with the threads that did start. */
+			CONST_CAST(int, self->threadCount) = i;
+			break;
+		}
+	}
+	return self;
+}
+
+void SkeletonBatch_dispose (SkeletonBatch* self) {
+	int i;
+	_Internal* internal = SUB_CAST(_Internal, self);
+
+	pthread_mutex_lock(&internal->lock);
+	internal->quit = 1;
+	pthread_cond_broadcast(&internal->start);
+	pthread_mutex_unlock(&internal->lock);
+	for (i = 1; i < self->threadCount; ++i)
+		pthread_join(internal->threads[i], 0);
+
+	pthread_cond_destroy(&internal->done);
+	pthread_cond_destroy(&internal->start);
+	pthread_mutex_destroy(&internal->lock);
+	for (i = 0; i < self->threadCount; ++i)
+		pthread_mutex_destroy(&internal->queues[i].lock);
+	FREE(internal->threads);
+	FREE(internal->workers);
+	FREE(internal->queues);
+	FREE(self);
+}
+
+void SkeletonBatch_update (SkeletonBatch* self, SkeletonInstance* instances, int instanceCount, float delta) {
+	int i, n = self->threadCount;
+	_Internal* internal = SUB_CAST(_Internal, self);
+
+	if (instanceCount <= 0) return;
+	if (n == 1 || instanceCount == 1) {
+		for (i = 0; i < instanceCount; ++i)
+			_SkeletonBatch_updateInstance(instances + i, delta);
+		return;
+	}
+
+	/* Deal out the instances in runs, so neighbouring instances, which are likely to share data, stay on one thread. The
+	 * workers are idle, and see the queues once they have locked the batch to start. */
+	for (i = 0; i < n; ++i) {
+		internal->queues[i].begin = (int)((long)instanceCount * i / n);
+		internal->queues[i].end = (int)((long)instanceCount * (i + 1) / n);
+	}
+	internal->instances = instances;
+	internal->delta = delta;
+
+	pthread_mutex_lock(&internal->lock);
+	internal->busyThreads = n - 1;
+	internal->generation++;
+	pthread_cond_broadcast(&internal->start);
+	pthread_mutex_unlock(&internal->lock);
+
+	_SkeletonBatch_run(internal, 0);
+
+	pthread_mutex_lock(&internal->lock);
+	while (internal->busyThreads)
+		pthread_cond_wait(&internal->done, &internal->lock);
+	pthread_mutex_unlock(&internal->lock);
+}
@@ -0,0 +1,69 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2012 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SPINE_SKELETONBATCH_H_
+#define SPINE_SKELETONBATCH_H_
+
+#include "Skeleton.h"
+#include "SkeletonPose.h"
+#include "AnimationState.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A skeleton and the animation states that pose it, which SkeletonBatch_update advances together. */
+typedef struct {
+	Skeleton* skeleton;
+	SkeletonPose* pose; /* May be 0 to update the world transforms with Skeleton_updateWorldTransform. */
+	int stateCount;
+	AnimationState** states;
+	float timeScale;
+} SkeletonInstance;
+
+/* Updates many skeletons at once on a set of worker threads. */
+typedef struct {
+	int const threadCount;
+} SkeletonBatch;
+
+/* Starts the worker threads.
+ * @param threadCount The number of threads to update on, including the one calling SkeletonBatch_update, or 0 for one per
+ * processor. */
+SkeletonBatch* SkeletonBatch_create (int threadCount);
+void SkeletonBatch_dispose (SkeletonBatch* self);
+
+/* Advances each instance by delta times its timeScale, as CCSkeletonAnimation does: Skeleton_update, then AnimationState_update
+ * and AnimationState_apply for each of its states in order, then the world transforms. The instances are dealt out to the
+ * threads, which take over half of the instances another thread has left when they run out, and all of them have been
+ * updated when this returns.
+ *
+ * Instances may share SkeletonData and AnimationStateData, which are only read, but not skeletons, poses or animation states.
+ * Each instance is then updated exactly as it would be on its own, whichever thread updates it. */
+void SkeletonBatch_update (SkeletonBatch* self, SkeletonInstance* instances, int instanceCount, float delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPINE_SKELETONBATCH_H_ */
@@ -0,0 +1,787 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2012 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SkeletonBinary.h"
+#include <stdio.h>
+#include "Json.h"
+#include "extension.h"
+#include "RegionAttachment.h"
+#include "AtlasAttachmentLoader.h"
+
+static const int VERSION = 1;
+
+typedef enum {
+	TIMELINE_ROTATE, TIMELINE_TRANSLATE, TIMELINE_SCALE, TIMELINE_COLOR, TIMELINE_ATTACHMENT
+} _TimelineType;
+
+typedef enum {
+	CURVE_LINEAR, CURVE_STEPPED, CURVE_BEZIER
+} _CurveType;
+
+typedef struct {
+	SkeletonBinary super;
+	int ownsLoader;
+} _Internal;
+
+SkeletonBinary* SkeletonBinary_createWithLoader (AttachmentLoader* attachmentLoader) {
+	SkeletonBinary* self = SUPER(NEW(_Internal));
+	self->scale = 1;
+	self->attachmentLoader = attachmentLoader;
+	return self;
+}
+
+SkeletonBinary* SkeletonBinary_create (Atlas* atlas) {
+	AtlasAttachmentLoader* attachmentLoader = AtlasAttachmentLoader_create(atlas);
+	SkeletonBinary* self = SkeletonBinary_createWithLoader(SUPER(attachmentLoader));
+	SUB_CAST(_Internal, self) ->ownsLoader = 1;
+	return self;
+}
+
+void SkeletonBinary_dispose (SkeletonBinary* self) {
+	if (SUB_CAST(_Internal, self) ->ownsLoader) AttachmentLoader_dispose(self->attachmentLoader);
+	FREE(self->error);
+	FREE(self);
+}
+
+void _SkeletonBinary_setError (SkeletonBinary* self, const char* value1, const char* value2) {
+	char message[256];
+	int length;
+	FREE(self->error);
+	strcpy(message, value1);
+	length = strlen(value1);
+	if (value2) strncat(message + length, value2, 255 - length);
+	MALLOC_STR(self->error, message);
+}
+
+/**/
+
+/* Reads the binary, noting instead of overrunning when it ends too soon or holds values that are out of range. */
+typedef struct {
+	const unsigned char* cursor;
+	const unsigned char* end;
+	int/*bool*/invalid;
+	const char** strings;
+	int stringCount;
+} _Input;
+
+static int readByte (_Input* input) {
+	if (input->cursor == input->end) {
+		input->invalid = 1;
+		return 0;
+	}
+	return *input->cursor++;
+}
+
+static int readVarint (_Input* input) {
+	unsigned int value = 0;
+	int shift;
+	for (shift = 0; shift < 32; shift += 7) {
+		int b = readByte(input);
+		value |= (unsigned int)(b & 0x7f) << shift;
+		if (!(b & 0x80)) break;
+	}
+	if (shift >= 32 || value > 0x7fffffff) {
+		input->invalid = 1;
+		return 0;
+	}
+	return (int)value;
+}
+
+/* Reads a count of entries that take at least a byte each, so bad counts are caught before anything is allocated for them. */
+static int readCount (_Input* input) {
+	int count = readVarint(input);
+	if (count < 0 || count > input->end - input->cursor) {
+		input->invalid = 1;
+		return 0;
+	}
+	return count;
+}
+
+/* Reads an index of one of count entries. */
+static int readIndex (_Input* input, int count) {
+	int index = readVarint(input);
+	if (index < 0 || index >= count) {
+		input->invalid = 1;
+		return 0;
+	}
+	return index;
+}
+
+static const char* readString (_Input* input) {
+	int index = readIndex(input, input->stringCount + 1);
+	return index ? input->strings[index - 1] : 0;
+}
+
+/* Reads a string that must be there. */
+static const char* readName (_Input* input) {
+	const char* name = readString(input);
+	if (!name) input->invalid = 1;
+	return name ? name : "";
+}
+
+static void readFloats (_Input* input, float* values, int count) {
+	int i;
+	union {
+		unsigned int bits;
+		float value;
+	} item;
+	if (count < 0 || input->end - input->cursor < count * 4) {
+		input->invalid = 1;
+		for (i = 0; i < count; ++i)
+			values[i] = 0;
+		return;
+	}
+	for (i = 0; i < count; ++i, input->cursor += 4) {
+		item.bits = (unsigned int)input->cursor[0] | (unsigned int)input->cursor[1] << 8 | (unsigned int)input->cursor[2] << 16
+				| (unsigned int)input->cursor[3] << 24;
+		values[i] = item.value;
+	}
+}
+
+static float readFloat (_Input* input) {
+	float value;
+	readFloats(input, &value, 1);
+	return value;
+}
+
+static void readCurves (_Input* input, CurveTimeline* timeline, int frameCount) {
+	int i;
+	for (i = 0; i < frameCount - 1; ++i) {
+		switch (readByte(input)) {
+		case CURVE_LINEAR:
+			break;
+		case CURVE_STEPPED:
+			CurveTimeline_setStepped(timeline, i);
+			break;
+		case CURVE_BEZIER: {
+			float curve[4];
+			readFloats(input, curve, 4);
+			CurveTimeline_setCurve(timeline, i, curve[0], curve[1], curve[2], curve[3]);
+			break;
+		}
+		default:
+			input->invalid = 1;
+		}
+	}
+}
+
+static Animation* _SkeletonBinary_readAnimation (SkeletonBinary* self, _Input* input, SkeletonData* skeletonData) {
+	int i, ii;
+	const char* name = readName(input);
+	int timelineCount = readCount(input);
+	Animation* animation = Animation_create(name, timelineCount);
+	animation->timelineCount = 0;
+
+	for (i = 0; i < timelineCount && !input->invalid; ++i) {
+		Timeline* timeline;
+		float duration;
+		int type = readByte(input);
+		int frameCount;
+
+		switch (type) {
+		case TIMELINE_ROTATE: {
+			RotateTimeline* rotateTimeline;
+			int boneIndex = readIndex(input, skeletonData->boneCount);
+			frameCount = readCount(input);
+			if (!frameCount) break;
+			rotateTimeline = RotateTimeline_create(frameCount);
+			rotateTimeline->boneIndex = boneIndex;
+			readFloats(input, rotateTimeline->frames, frameCount * 2);
+			readCurves(input, SUPER(rotateTimeline), frameCount);
+			timeline = SUPER_CAST(Timeline, rotateTimeline);
+			duration = rotateTimeline->frames[frameCount * 2 - 2];
+			break;
+		}
+		case TIMELINE_TRANSLATE:
+		case TIMELINE_SCALE: {
+			TranslateTimeline* translateTimeline;
+			int boneIndex = readIndex(input, skeletonData->boneCount);
+			frameCount = readCount(input);
+			if (!frameCount) break;
+			translateTimeline = type == TIMELINE_SCALE ? ScaleTimeline_create(frameCount) : TranslateTimeline_create(frameCount);
+			translateTimeline->boneIndex = boneIndex;
+			readFloats(input, translateTimeline->frames, frameCount * 3);
+			if (type == TIMELINE_TRANSLATE && self->scale != 1) {
+				for (ii = 0; ii < frameCount; ++ii) {
+					translateTimeline->frames[ii * 3 + 1] *= self->scale;
+					translateTimeline->frames[ii * 3 + 2] *= self->scale;
+				}
+			}
+			readCurves(input, SUPER(translateTimeline), frameCount);
+			timeline = SUPER_CAST(Timeline, translateTimeline);
+			duration = translateTimeline->frames[frameCount * 3 - 3];
+			break;
+		}
+		case TIMELINE_COLOR: {
+			ColorTimeline* colorTimeline;
+			int slotIndex = readIndex(input, skeletonData->slotCount);
+			frameCount = readCount(input);
+			if (!frameCount) break;
+			colorTimeline = ColorTimeline_create(frameCount);
+			colorTimeline->slotIndex = slotIndex;
+			readFloats(input, colorTimeline->frames, frameCount * 5);
+			readCurves(input, SUPER(colorTimeline), frameCount);
+			timeline = SUPER_CAST(Timeline, colorTimeline);
+			duration = colorTimeline->frames[frameCount * 5 - 5];
+			break;
+		}
+		case TIMELINE_ATTACHMENT: {
+			AttachmentTimeline* attachmentTimeline;
+			int slotIndex = readIndex(input, skeletonData->slotCount);
+			frameCount = readCount(input);
+			if (!frameCount) break;
+			attachmentTimeline = AttachmentTimeline_create(frameCount);
+			attachmentTimeline->slotIndex = slotIndex;
+			readFloats(input, attachmentTimeline->frames, frameCount);
+			for (ii = 0; ii < frameCount; ++ii)
+				AttachmentTimeline_setFrame(attachmentTimeline, ii, attachmentTimeline->frames[ii], readString(input));
+			timeline = SUPER(attachmentTimeline);
+			duration = attachmentTimeline->frames[frameCount - 1];
+			break;
+		}
+		default:
+			frameCount = 0;
+		}
+		if (!frameCount) {
+			input->invalid = 1;
+			break;
+		}
+
+		animation->timelines[animation->timelineCount++] = timeline;
+		if (duration > animation->duration) animation->duration = duration;
+	}
+
+	if (self->curveResolution) Animation_bakeCurves(animation, self->curveResolution);
+	return animation;
+}
+
+SkeletonData* SkeletonBinary_readSkeletonDataFile (SkeletonBinary* self, const char* path) {
+	int length;
+	SkeletonData* skeletonData;
+	const char* binary = _Util_readFile(path, &length);
+	if (!binary) {
+		_SkeletonBinary_setError(self, "Unable to read skeleton file: ", path);
+		return 0;
+	}
+	skeletonData = SkeletonBinary_readSkeletonData(self, (const unsigned char*)binary, length);
+	FREE(binary);
+	return skeletonData;
+}
+
+SkeletonData* SkeletonBinary_readSkeletonData (SkeletonBinary* self, const unsigned char* binary, int length) {
+	SkeletonData* skeletonData;
+	_Input input;
+	int i, ii, iii, count;
+
+	FREE(self->error);
+	CONST_CAST(char*, self->error) = 0;
+
+	input.cursor = binary;
+	input.end = binary + length;
+	input.invalid = 0;
+	if (length < 4 || memcmp(binary, "SKEL", 4) != 0) {
+		_SkeletonBinary_setError(self, "Invalid skeleton binary: ", "Not a skeleton binary.");
+		return 0;
+	}
+	input.cursor += 4;
+	if (readVarint(&input) != VERSION) {
+		_SkeletonBinary_setError(self, "Invalid skeleton binary: ", "Unsupported version.");
+		return 0;
+	}
+
+	/* The strings are used where they are, and copied by whatever keeps them. */
+	input.stringCount = readCount(&input);
+	input.strings = MALLOC(const char*, input.stringCount);
+	for (i = 0; i < input.stringCount; ++i) {
+		const unsigned char* end = memchr(input.cursor, 0, input.end - input.cursor);
+		if (!end) {
+			input.invalid = 1;
+			input.stringCount = i;
+			break;
+		}
+		input.strings[i] = (const char*)input.cursor;
+		input.cursor = end + 1;
+	}
+
+	skeletonData = SkeletonData_create();
+
+	count = readCount(&input);
+	skeletonData->bones = MALLOC(BoneData*, count);
+	for (i = 0; i < count && !input.invalid; ++i) {
+		const char* name = readName(&input);
+		int parentIndex = readIndex(&input, i + 1);
+		BoneData* boneData = BoneData_create(name, parentIndex ? skeletonData->bones[parentIndex - 1] : 0);
+		boneData->length = readFloat(&input) * self->scale;
+		boneData->x = readFloat(&input) * self->scale;
+		boneData->y = readFloat(&input) * self->scale;
+		boneData->rotation = readFloat(&input);
+		boneData->scaleX = readFloat(&input);
+		boneData->scaleY = readFloat(&input);
+		skeletonData->bones[i] = boneData;
+		skeletonData->boneCount++;
+	}
+
+	count = readCount(&input);
+	skeletonData->slots = MALLOC(SlotData*, count);
+	for (i = 0; i < count && !input.invalid; ++i) {
+		const char* name = readName(&input);
+		int boneIndex = readIndex(&input, skeletonData->boneCount);
+		SlotData* slotData;
+		const char* attachmentName;
+		if (input.invalid) break;
+		slotData = SlotData_create(name, skeletonData->bones[boneIndex]);
+		slotData->r = readFloat(&input);
+		slotData->g = readFloat(&input);
+		slotData->b = readFloat(&input);
+		slotData->a = readFloat(&input);
+		attachmentName = readString(&input);
+		if (attachmentName) SlotData_setAttachmentName(slotData, attachmentName);
+		skeletonData->slots[i] = slotData;
+		skeletonData->slotCount++;
+	}
+
+	count = readCount(&input);
+	skeletonData->skins = MALLOC(Skin*, count);
+	for (i = 0; i < count && !input.invalid; ++i) {
+		const char* skinName = readName(&input);
+		Skin* skin = Skin_create(skinName);
+		int slotCount = readCount(&input);
+		skeletonData->skins[i] = skin;
+		skeletonData->skinCount++;
+		if (strcmp(skinName, "default") == 0) skeletonData->defaultSkin = skin;
+
+		for (ii = 0; ii < slotCount && !input.invalid; ++ii) {
+			int slotIndex = readIndex(&input, skeletonData->slotCount);
+			int attachmentCount = readCount(&input);
+			for (iii = 0; iii < attachmentCount && !input.invalid; ++iii) {
+				Attachment* attachment;
+				const char* skinAttachmentName = readName(&input);
+				const char* attachmentName = readName(&input);
+				int type = readByte(&input);
+				float values[7];
+				readFloats(&input, values, 7);
+				if (input.invalid) break;
+				if (type != ATTACHMENT_REGION && type != ATTACHMENT_REGION_SEQUENCE) {
+					input.invalid = 1;
+					break;
+				}
+
+				attachment = AttachmentLoader_newAttachment(self->attachmentLoader, skin, (AttachmentType)type, attachmentName);
+				if (!attachment) {
+					if (self->attachmentLoader->error1) {
+						FREE(input.strings);
+						SkeletonData_dispose(skeletonData);
+						_SkeletonBinary_setError(self, self->attachmentLoader->error1, self->attachmentLoader->error2);
+						return 0;
+					}
+					continue;
+				}
+
+				if (attachment->type == ATTACHMENT_REGION || attachment->type == ATTACHMENT_REGION_SEQUENCE) {
+					RegionAttachment* regionAttachment = (RegionAttachment*)attachment;
+					regionAttachment->x = values[0] * self->scale;
+					regionAttachment->y = values[1] * self->scale;
+					regionAttachment->scaleX = values[2];
+					regionAttachment->scaleY = values[3];
+					regionAttachment->rotation = values[4];
+					regionAttachment->width = values[5] * self->scale;
+					regionAttachment->height = values[6] * self->scale;
+					RegionAttachment_updateOffset(regionAttachment);
+				}
+
+				Skin_addAttachment(skin, slotIndex, skinAttachmentName, attachment);
+			}
+		}
+	}
+
+	count = readCount(&input);
+	skeletonData->animations = MALLOC(Animation*, count);
+	for (i = 0; i < count && !input.invalid; ++i) {
+		skeletonData->animations[i] = _SkeletonBinary_readAnimation(self, &input, skeletonData);
+		skeletonData->animationCount++;
+	}
+
+	FREE(input.strings);
+	if (input.invalid) {
+		SkeletonData_dispose(skeletonData);
+		_SkeletonBinary_setError(self, "Invalid skeleton binary: ", "Truncated or out of range data.");
+		return 0;
+	}
+	return skeletonData;
+}
+
+/**/
+
+/* The binary being written, and the strings it refers to. */
+typedef struct {
+	unsigned char* data;
+	int length, capacity;
+	const char** strings;
+	int stringCount, stringCapacity;
+} _Output;
+
+static void writeBytes (_Output* output, const void* bytes, int length) {
+	if (output->length + length > output->capacity) {
+		unsigned char* data;
+		output->capacity = (output->length + length) * 2;
+		data = MALLOC(unsigned char, output->capacity);
+		if (output->data) memcpy(data, output->data, output->length);
+		FREE(output->data);
+		output->data = data;
+	}
+	memcpy(output->data + output->length, bytes, length);
+	output->length += length;
+}
+
+static void writeByte (_Output* output, int value) {
+	unsigned char b = (unsigned char)value;
+	writeBytes(output, &b, 1);
+}
+
+static void writeVarint (_Output* output, int value) {
+	unsigned int remaining = (unsigned int)value;
+	while (remaining >= 0x80) {
+		writeByte(output, (remaining & 0x7f) | 0x80);
+		remaining >>= 7;
+	}
+	writeByte(output, remaining);
+}
+
+static void writeFloat (_Output* output, float value) {
+	unsigned char bytes[4];
+	union {
+		unsigned int bits;
+		float value;
+	} item;
+	item.value = value;
+	bytes[0] = (unsigned char)item.bits;
+	bytes[1] = (unsigned char)(item.bits >> 8);
+	bytes[2] = (unsigned char)(item.bits >> 16);
+	bytes[3] = (unsigned char)(item.bits >> 24);
+	writeBytes(output, bytes, 4);
+}
+
+/* Writes the index of a string in the string table plus 1, adding it to the table if it isn't there yet, or 0 for none. */
+static void writeString (_Output* output, const char* value) {
+	int i;
+	if (!value) {
+		writeVarint(output, 0);
+		return;
+	}
+	for (i = 0; i < output->stringCount; ++i)
+		if (strcmp(output->strings[i], value) == 0) break;
+	if (i == output->stringCount) {
+		if (output->stringCount == output->stringCapacity) {
+			const char** strings;
+			output->stringCapacity = output->stringCapacity * 2 + 16;
+			strings = MALLOC(const char*, output->stringCapacity);
+			if (output->strings) memcpy(strings, output->strings, sizeof(const char*) * output->stringCount);
+			FREE(output->strings);
+			output->strings = strings;
+		}
+		output->strings[output->stringCount++] = value;
+	}
+	writeVarint(output, i + 1);
+}
+
+static int findName (Json* items, const char* name) {
+	int i = 0;
+	Json* item;
+	for (item = items ? items->child : 0; item; item = item->next, ++i)
+		if (name && strcmp(Json_getString(item, "name", ""), name) == 0) return i;
+	return -1;
+}
+
+static float toColor (const char* value, int index) {
+	char digits[3];
+	char *error;
+	int color;
+
+	if (strlen(value) != 8) return -1;
+	value += index * 2;
+
+	digits[0] = *value;
+	digits[1] = *(value + 1);
+	digits[2] = '\0';
+	color = strtoul(digits, &error, 16);
+	if (*error != 0) return -1;
+	return color / (float)255;
+}
+
+static void writeCurves (_Output* output, Json* timelineArray) {
+	Json* frame;
+	for (frame = timelineArray->child; frame && frame->next; frame = frame->next) {
+		Json* curve = Json_getItem(frame, "curve");
+		if (curve && curve->type == Json_String && strcmp(curve->valuestring, "stepped") == 0)
+			writeByte(output, CURVE_STEPPED);
+		else if (curve && curve->type == Json_Array) {
+			writeByte(output, CURVE_BEZIER);
+			writeFloat(output, Json_getItemAt(curve, 0)->valuefloat);
+			writeFloat(output, Json_getItemAt(curve, 1)->valuefloat);
+			writeFloat(output, Json_getItemAt(curve, 2)->valuefloat);
+			writeFloat(output, Json_getItemAt(curve, 3)->valuefloat);
+		} else
+			writeByte(output, CURVE_LINEAR);
+	}
+}
+
+/* Returns the error, or 0. */
+static const char* _SkeletonBinary_writeAnimation (_Output* output, Json* root, Json* bones, Json* slots,
+		const char** errorName) {
+	Json* boneMaps = Json_getItem(root, "bones");
+	Json* slotMaps = Json_getItem(root, "slots");
+	Json *map, *timelineArray, *frame;
+	int timelineCount = 0;
+
+	for (map = boneMaps ? boneMaps->child : 0; map; map = map->next)
+		timelineCount += Json_getSize(map);
+	for (map = slotMaps ? slotMaps->child : 0; map; map = map->next)
+		timelineCount += Json_getSize(map);
+	writeString(output, root->name);
+	writeVarint(output, timelineCount);
+
+	for (map = boneMaps ? boneMaps->child : 0; map; map = map->next) {
+		int boneIndex = findName(bones, map->name);
+		if (boneIndex == -1) {
+			*errorName = map->name;
+			return "Bone not found: ";
+		}
+		for (timelineArray = map->child; timelineArray; timelineArray = timelineArray->next) {
+			const char* timelineType = timelineArray->name;
+			int frameCount = Json_getSize(timelineArray);
+			if (!frameCount) {
+				*errorName = timelineType;
+				return "Timeline has no frames: ";
+			}
+			if (strcmp(timelineType, "rotate") == 0) {
+				writeByte(output, TIMELINE_ROTATE);
+				writeVarint(output, boneIndex);
+				writeVarint(output, frameCount);
+				for (frame = timelineArray->child; frame; frame = frame->next) {
+					writeFloat(output, Json_getFloat(frame, "time", 0));
+					writeFloat(output, Json_getFloat(frame, "angle", 0));
+				}
+			} else if (strcmp(timelineType, "translate") == 0 || strcmp(timelineType, "scale") == 0) {
+				writeByte(output, strcmp(timelineType, "scale") == 0 ? TIMELINE_SCALE : TIMELINE_TRANSLATE);
+				writeVarint(output, boneIndex);
+				writeVarint(output, frameCount);
+				for (frame = timelineArray->child; frame; frame = frame->next) {
+					writeFloat(output, Json_getFloat(frame, "time", 0));
+					writeFloat(output, Json_getFloat(frame, "x", 0));
+					writeFloat(output, Json_getFloat(frame, "y", 0));
+				}
+			} else {
+				*errorName = timelineType;
+				return "Invalid timeline type for a bone: ";
+			}
+			writeCurves(output, timelineArray);
+		}
+	}
+
+	for (map = slotMaps ? slotMaps->child : 0; map; map = map->next) {
+		int slotIndex = findName(slots, map->name);
+		if (slotIndex == -1) {
+			*errorName = map->name;
+			return "Slot not found: ";
+		}
+		for (timelineArray = map->child; timelineArray; timelineArray = timelineArray->next) {
+			const char* timelineType = timelineArray->name;
+			int frameCount = Json_getSize(timelineArray);
+			if (!frameCount) {
+				*errorName = timelineType;
+				return "Timeline has no frames: ";
+			}
+			if (strcmp(timelineType, "color") == 0) {
+				writeByte(output, TIMELINE_COLOR);
+				writeVarint(output, slotIndex);
+				writeVarint(output, frameCount);
+				for (frame = timelineArray->child; frame; frame = frame->next) {
+					const char* s = Json_getString(frame, "color", "ffffffff");
+					writeFloat(output, Json_getFloat(frame, "time", 0));
+					writeFloat(output, toColor(s, 0));
+					writeFloat(output, toColor(s, 1));
+					writeFloat(output, toColor(s, 2));
+					writeFloat(output, toColor(s, 3));
+				}
+				writeCurves(output, timelineArray);
+			} else if (strcmp(timelineType, "attachment") == 0) {
+				writeByte(output, TIMELINE_ATTACHMENT);
+				writeVarint(output, slotIndex);
+				writeVarint(output, frameCount);
+				for (frame = timelineArray->child; frame; frame = frame->next)
+					writeFloat(output, Json_getFloat(frame, "time", 0));
+				for (frame = timelineArray->child; frame; frame = frame->next) {
+					Json* name = Json_getItem(frame, "name");
+					writeString(output, name && name->type == Json_String ? name->valuestring : 0);
+				}
+			} else {
+				*errorName = timelineType;
+				return "Invalid timeline type for a slot: ";
+			}
+		}
+	}
+	return 0;
+}
+
+unsigned char* SkeletonBinary_convertJson (SkeletonBinary* self, const char* json, int* length) {
+	_Output body, output;
+	Json *root, *bones, *slots, *skins, *animations, *map, *slotMap, *attachmentMap;
+	const char* error = 0;
+	const char* errorName = 0;
+	int i;
+
+	FREE(self->error);
+	CONST_CAST(char*, self->error) = 0;
+
+	root = Json_create(json);
+	if (!root) {
+		_SkeletonBinary_setError(self, "Invalid skeleton JSON: ", Json_getError());
+		return 0;
+	}
+	memset(&body, 0, sizeof(body));
+	bones = Json_getItem(root, "bones");
+	slots = Json_getItem(root, "slots");
+	skins = Json_getItem(root, "skins");
+	animations = Json_getItem(root, "animations");
+
+	/* A parent comes before its children, as the JSON loader finds it among the bones read so far. */
+	writeVarint(&body, bones ? Json_getSize(bones) : 0);
+	for (map = bones ? bones->child : 0, i = 0; map && !error; map = map->next, ++i) {
+		const char* parentName = Json_getString(map, "parent", 0);
+		int parentIndex = parentName ? findName(bones, parentName) : -1;
+		if (parentName && (parentIndex == -1 || parentIndex >= i)) {
+			error = "Parent bone not found: ";
+			errorName = parentName;
+		}
+		writeString(&body, Json_getString(map, "name", 0));
+		writeVarint(&body, parentIndex + 1);
+		writeFloat(&body, Json_getFloat(map, "length", 0));
+		writeFloat(&body, Json_getFloat(map, "x", 0));
+		writeFloat(&body, Json_getFloat(map, "y", 0));
+		writeFloat(&body, Json_getFloat(map, "rotation", 0));
+		writeFloat(&body, Json_getFloat(map, "scaleX", 1));
+		writeFloat(&body, Json_getFloat(map, "scaleY", 1));
+	}
+
+	writeVarint(&body, slots ? Json_getSize(slots) : 0);
+	for (map = slots ? slots->child : 0; map && !error; map = map->next) {
+		const char* boneName = Json_getString(map, "bone", 0);
+		const char* color = Json_getString(map, "color", 0);
+		Json* attachmentItem = Json_getItem(map, "attachment");
+		int boneIndex = findName(bones, boneName);
+		if (boneIndex == -1) {
+			error = "Slot bone not found: ";
+			errorName = boneName;
+		}
+		writeString(&body, Json_getString(map, "name", 0));
+		writeVarint(&body, boneIndex);
+		for (i = 0; i < 4; ++i)
+			writeFloat(&body, color ? toColor(color, i) : 1);
+		writeString(&body, attachmentItem ? attachmentItem->valuestring : 0);
+	}
+
+	writeVarint(&body, skins ? Json_getSize(skins) : 0);
+	for (map = skins ? skins->child : 0; map && !error; map = map->next) {
+		writeString(&body, map->name);
+		writeVarint(&body, Json_getSize(map));
+		for (slotMap = map->child; slotMap && !error; slotMap = slotMap->next) {
+			int slotIndex = findName(slots, slotMap->name);
+			if (slotIndex == -1) {
+				error = "Skin slot not found: ";
+				errorName = slotMap->name;
+			}
+			writeVarint(&body, slotIndex);
+			writeVarint(&body, Json_getSize(slotMap));
+			for (attachmentMap = slotMap->child; attachmentMap && !error; attachmentMap = attachmentMap->next) {
+				const char* typeString = Json_getString(attachmentMap, "type", "region");
+				writeString(&body, attachmentMap->name);
+				writeString(&body, Json_getString(attachmentMap, "name", attachmentMap->name));
+				if (strcmp(typeString, "region") == 0)
+					writeByte(&body, ATTACHMENT_REGION);
+				else if (strcmp(typeString, "regionSequence") == 0)
+					writeByte(&body, ATTACHMENT_REGION_SEQUENCE);
+				else {
+					error = "Unknown attachment type: ";
+					errorName = typeString;
+				}
+				writeFloat(&body, Json_getFloat(attachmentMap, "x", 0));
+				writeFloat(&body, Json_getFloat(attachmentMap, "y", 0));
+				writeFloat(&body, Json_getFloat(attachmentMap, "scaleX", 1));
+				writeFloat(&body, Json_getFloat(attachmentMap, "scaleY", 1));
+				writeFloat(&body, Json_getFloat(attachmentMap, "rotation", 0));
+				writeFloat(&body, Json_getFloat(attachmentMap, "width", 32));
+				writeFloat(&body, Json_getFloat(attachmentMap, "height", 32));
+			}
+		}
+	}
+
+	writeVarint(&body, animations ? Json_getSize(animations) : 0);
+	for (map = animations ? animations->child : 0; map && !error; map = map->next)
+		error = _SkeletonBinary_writeAnimation(&body, map, bones, slots, &errorName);
+
+	if (error) {
+		_SkeletonBinary_setError(self, error, errorName);
+		FREE(body.strings);
+		FREE(body.data);
+		Json_dispose(root);
+		return 0;
+	}
+
+	/* The string table goes before the body that refers to it. */
+	memset(&output, 0, sizeof(output));
+	writeBytes(&output, "SKEL", 4);
+	writeVarint(&output, VERSION);
+	writeVarint(&output, body.stringCount);
+	for (i = 0; i < body.stringCount; ++i)
+		writeBytes(&output, body.strings[i], strlen(body.strings[i]) + 1);
+	writeBytes(&output, body.data, body.length);
+
+	FREE(body.strings);
+	FREE(body.data);
+	Json_dispose(root);
+	*length = output.length;
+	return output.data;
+}
+
+int/*bool*/SkeletonBinary_convertJsonFile (SkeletonBinary* self, const char* jsonPath, const char* binaryPath) {
+	int length;
+	unsigned char* binary;
+	FILE* file;
+	int/*bool*/success;
+	const char* json = _Util_readFile(jsonPath, &length);
+	if (!json) {
+		_SkeletonBinary_setError(self, "Unable to read skeleton file: ", jsonPath);
+		return 0;
+	}
+	binary = SkeletonBinary_convertJson(self, json, &length);
+	FREE(json);
+	if (!binary) return 0;
+
+	file = fopen(binaryPath, "wb");
+	success = file && fwrite(binary, 1, length, file) == (size_t)length;
+	if (file && fclose(file) != 0) success = 0;
+	FREE(binary);
+	if (!success) _SkeletonBinary_setError(self, "Unable to write skeleton binary: ", binaryPath);
+	return success;
+}
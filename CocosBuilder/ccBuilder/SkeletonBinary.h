@@ -0,0 +1,70 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2012 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SPINE_SKELETONBINARY_H_
+#define SPINE_SKELETONBINARY_H_
+
+#include "Attachment.h"
+#include "AttachmentLoader.h"
+#include "SkeletonData.h"
+#include "Atlas.h"
+#include "Animation.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Reads skeleton data from .skel files, a binary form of skeleton JSON that loads without parsing text or looking anything up
+ * by name. SkeletonBinary_convertJson writes them.
+ *
+ * The file starts with "SKEL" and a version, then a table of the strings of the skeleton, each ending with a 0. Counts and
+ * indices are varints of 7 bits a byte, lowest first, and strings are their index in the table plus 1, or 0 for none. Floats
+ * are 4 bytes, little endian, and the frames of each timeline are stored as the floats of its frames array. */
+typedef struct {
+	float scale;
+	int curveResolution; /* When not 0, the curves of the animations read are baked. See CurveTimeline_bakeCurves. */
+	AttachmentLoader* attachmentLoader;
+	const char* const error;
+} SkeletonBinary;
+
+SkeletonBinary* SkeletonBinary_createWithLoader (AttachmentLoader* attachmentLoader);
+SkeletonBinary* SkeletonBinary_create (Atlas* atlas);
+void SkeletonBinary_dispose (SkeletonBinary* self);
+
+/* @param binary Only read while loading, so it may be a mapped file. */
+SkeletonData* SkeletonBinary_readSkeletonData (SkeletonBinary* self, const unsigned char* binary, int length);
+SkeletonData* SkeletonBinary_readSkeletonDataFile (SkeletonBinary* self, const char* path);
+
+/* Converts skeleton JSON to the binary form, which SkeletonBinary_readSkeletonData reads into the same skeleton data
+ * SkeletonJson_readSkeletonData reads from the JSON. The scale and attachment loader aren't used: they apply when reading.
+ * @param length Set to the length of the binary.
+ * @return The binary, to be freed with FREE, or 0 if the JSON is invalid. */
+unsigned char* SkeletonBinary_convertJson (SkeletonBinary* self, const char* json, int* length);
+int/*bool*/SkeletonBinary_convertJsonFile (SkeletonBinary* self, const char* jsonPath, const char* binaryPath);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPINE_SKELETONBINARY_H_ */
@@ -226,6 +226,7 @@ static Animation* _SkeletonJson_readAnimation (SkeletonJson* self, Json* root, S
 		}
 	}
 
+	if (self->curveResolution) Animation_bakeCurves(animation, self->curveResolution);
 	return animation;
 }
 
@@ -38,6 +38,7 @@ extern "C" {
 
 typedef struct {
 	float scale;
+	int curveResolution; /* When not 0, the curves of the animations read are baked. See CurveTimeline_bakeCurves. */
 	AttachmentLoader* attachmentLoader;
 	const char* const error;
 } SkeletonJson;
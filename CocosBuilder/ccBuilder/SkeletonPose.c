@@ -0,0 +1,303 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2012 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "SkeletonPose.h"
+#include "extension.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* SKELETON_POSE_BATCH floats, and the arithmetic SkeletonPose_computeWorldTransforms does on them. */
+#if defined(__SSE2__)
+typedef __m128 Floats;
+
+static Floats load4 (const float* p) { return _mm_load_ps(p); }
+static void store4 (float* p, Floats v) { _mm_store_ps(p, v); }
+static Floats splat4 (float v) { return _mm_set1_ps(v); }
+static Floats gather4 (const float* p, const int* indices) {
+	return _mm_setr_ps(p[indices[0]], p[indices[1]], p[indices[2]], p[indices[3]]);
+}
+static Floats add4 (Floats a, Floats b) { return _mm_add_ps(a, b); }
+static Floats sub4 (Floats a, Floats b) { return _mm_sub_ps(a, b); }
+static Floats mul4 (Floats a, Floats b) { return _mm_mul_ps(a, b); }
+static Floats round4 (Floats v) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(v)); }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+typedef float32x4_t Floats;
+
+static Floats load4 (const float* p) { return vld1q_f32(p); }
+static void store4 (float* p, Floats v) { vst1q_f32(p, v); }
+static Floats splat4 (float v) { return vdupq_n_f32(v); }
+static Floats gather4 (const float* p, const int* indices) {
+	float gathered[4];
+	gathered[0] = p[indices[0]];
+	gathered[1] = p[indices[1]];
+	gathered[2] = p[indices[2]];
+	gathered[3] = p[indices[3]];
+	return vld1q_f32(gathered);
+}
+static Floats add4 (Floats a, Floats b) { return vaddq_f32(a, b); }
+static Floats sub4 (Floats a, Floats b) { return vsubq_f32(a, b); }
+static Floats mul4 (Floats a, Floats b) { return vmulq_f32(a, b); }
+static Floats round4 (Floats v) {
+	/* Adds a half with the sign of v, as the conversion truncates. */
+	uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(v), vdupq_n_u32(0x80000000));
+	Floats half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), sign));
+	return vcvtq_f32_s32(vcvtq_s32_f32(vaddq_f32(v, half)));
+}
+#else
+typedef struct {
+	float v[4];
+} Floats;
+
+static Floats load4 (const float* p) { Floats r; r.v[0] = p[0]; r.v[1] = p[1]; r.v[2] = p[2]; r.v[3] = p[3]; return r; }
+static void store4 (float* p, Floats v) { p[0] = v.v[0]; p[1] = v.v[1]; p[2] = v.v[2]; p[3] = v.v[3]; }
+static Floats splat4 (float v) { Floats r; r.v[0] = r.v[1] = r.v[2] = r.v[3] = v; return r; }
+static Floats gather4 (const float* p, const int* indices) {
+	Floats r;
+	int i;
+	for (i = 0; i < 4; ++i)
+		r.v[i] = p[indices[i]];
+	return r;
+}
+static Floats add4 (Floats a, Floats b) { int i; for (i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+static Floats sub4 (Floats a, Floats b) { int i; for (i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+static Floats mul4 (Floats a, Floats b) { int i; for (i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+static Floats round4 (Floats v) { int i; for (i = 0; i < 4; ++i) v.v[i] = (float)(int)(v.v[i] + (v.v[i] < 0 ? -0.5f : 0.5f)); return v; }
+#endif
+
+/* The sines and cosines of angles in degrees, without branches. The angle is reduced to within half a turn either way, so
+ * that a quarter of it is within an eighth of a turn, where short Taylor series are accurate to float precision. The double
+ * angle formulas then give the sine and cosine of the whole. */
+static void sinCos4 (Floats degrees, Floats* sine, Floats* cosine) {
+	Floats turns = round4(mul4(degrees, splat4(1.0f / 360)));
+	Floats x = mul4(sub4(degrees, mul4(turns, splat4(360))), splat4((float)(3.1415926535897932385 / 180 / 4)));
+	Floats x2 = mul4(x, x);
+	Floats s, c;
+	int i;
+	s = splat4(1.0f / 362880);
+	s = add4(mul4(s, x2), splat4(-1.0f / 5040));
+	s = add4(mul4(s, x2), splat4(1.0f / 120));
+	s = add4(mul4(s, x2), splat4(-1.0f / 6));
+	s = add4(mul4(mul4(s, x2), x), x);
+	c = splat4(1.0f / 40320);
+	c = add4(mul4(c, x2), splat4(-1.0f / 720));
+	c = add4(mul4(c, x2), splat4(1.0f / 24));
+	c = add4(mul4(c, x2), splat4(-1.0f / 2));
+	c = add4(mul4(c, x2), splat4(1));
+	for (i = 0; i < 2; ++i) {
+		Floats doubleSine = mul4(splat4(2), mul4(s, c));
+		c = mul4(sub4(c, s), add4(c, s));
+		s = doubleSine;
+	}
+	*sine = s;
+	*cosine = c;
+}
+
+/* Computes the matrices of a batch from its world rotations and scales. */
+static void computeMatrices4 (SkeletonPose* self, int i, Floats signX, Floats signY) {
+	Floats sine, cosine;
+	Floats worldScaleX = load4(self->worldScaleX + i);
+	Floats worldScaleY = load4(self->worldScaleY + i);
+	sinCos4(load4(self->worldRotation + i), &sine, &cosine);
+	store4(self->m00 + i, mul4(mul4(cosine, worldScaleX), signX));
+	store4(self->m01 + i, mul4(mul4(sine, worldScaleY), sub4(splat4(0), signX)));
+	store4(self->m10 + i, mul4(mul4(sine, worldScaleX), signY));
+	store4(self->m11 + i, mul4(mul4(cosine, worldScaleY), signY));
+}
+
+/**/
+
+typedef struct {
+	SkeletonPose super;
+	void* arrays; /* The block the float arrays are allocated in, before aligning them for SIMD loads. */
+} _Internal;
+
+static const int FLOAT_ARRAY_COUNT = 14;
+
+SkeletonPose* SkeletonPose_create (Skeleton* skeleton) {
+	int i, depth, entry;
+	int* depths;
+	int* entryOfBone;
+	float* arrays;
+	_Internal* internal = NEW(_Internal);
+	SkeletonPose* self = SUPER(internal);
+	CONST_CAST(Skeleton*, self->skeleton) = skeleton;
+
+	/* Find the depth of each bone. */
+	depths = MALLOC(int, skeleton->boneCount);
+	for (i = 0; i < skeleton->boneCount; ++i) {
+		Bone* parent = skeleton->bones[i]->parent;
+		depths[i] = 0;
+		while (parent) {
+			depths[i]++;
+			parent = parent->parent;
+		}
+		if (depths[i] + 1 > self->depthCount) CONST_CAST(int, self->depthCount) = depths[i] + 1;
+	}
+
+	/* Count the entries of each depth, padded to a whole batch. */
+	CONST_CAST(int*, self->depthStarts) = CALLOC(int, self->depthCount + 1);
+	for (i = 0; i < skeleton->boneCount; ++i)
+		self->depthStarts[depths[i] + 1]++;
+	for (depth = 0; depth < self->depthCount; ++depth) {
+		int count = (self->depthStarts[depth + 1] + SKELETON_POSE_BATCH - 1) / SKELETON_POSE_BATCH * SKELETON_POSE_BATCH;
+		self->depthStarts[depth + 1] = self->depthStarts[depth] + count;
+	}
+	CONST_CAST(int, self->entryCount) = self->depthStarts[self->depthCount];
+
+	/* Allocate the float arrays in one block, each aligned for SIMD loads. */
+	internal->arrays = MALLOC(char, sizeof(float) * self->entryCount * FLOAT_ARRAY_COUNT + 15);
+	arrays = (float*)(((size_t)internal->arrays + 15) & ~(size_t)15);
+	CONST_CAST(float*, self->x) = arrays;
+	CONST_CAST(float*, self->y) = arrays + self->entryCount;
+	CONST_CAST(float*, self->rotation) = arrays + self->entryCount * 2;
+	CONST_CAST(float*, self->scaleX) = arrays + self->entryCount * 3;
+	CONST_CAST(float*, self->scaleY) = arrays + self->entryCount * 4;
+	CONST_CAST(float*, self->m00) = arrays + self->entryCount * 5;
+	CONST_CAST(float*, self->m01) = arrays + self->entryCount * 6;
+	CONST_CAST(float*, self->worldX) = arrays + self->entryCount * 7;
+	CONST_CAST(float*, self->m10) = arrays + self->entryCount * 8;
+	CONST_CAST(float*, self->m11) = arrays + self->entryCount * 9;
+	CONST_CAST(float*, self->worldY) = arrays + self->entryCount * 10;
+	CONST_CAST(float*, self->worldRotation) = arrays + self->entryCount * 11;
+	CONST_CAST(float*, self->worldScaleX) = arrays + self->entryCount * 12;
+	CONST_CAST(float*, self->worldScaleY) = arrays + self->entryCount * 13;
+	memset(arrays, 0, sizeof(float) * self->entryCount * FLOAT_ARRAY_COUNT);
+
+	/* Place the bones of each depth in the order of the skeleton, then pad the depth with entries that scale by 1. */
+	CONST_CAST(int*, self->boneIndices) = MALLOC(int, self->entryCount);
+	CONST_CAST(int*, self->parentEntries) = MALLOC(int, self->entryCount);
+	entryOfBone = MALLOC(int, skeleton->boneCount);
+	for (depth = 0; depth < self->depthCount; ++depth) {
+		entry = self->depthStarts[depth];
+		for (i = 0; i < skeleton->boneCount; ++i) {
+			Bone* parent = skeleton->bones[i]->parent;
+			if (depths[i] != depth) continue;
+			entryOfBone[i] = entry;
+			self->boneIndices[entry] = i;
+			self->parentEntries[entry] = parent ? entryOfBone[parent - skeleton->bones[0]] : -1;
+			entry++;
+		}
+		for (; entry < self->depthStarts[depth + 1]; ++entry) {
+			self->boneIndices[entry] = -1;
+			self->parentEntries[entry] = self->parentEntries[self->depthStarts[depth]];
+			self->scaleX[entry] = 1;
+			self->scaleY[entry] = 1;
+		}
+	}
+	FREE(entryOfBone);
+	FREE(depths);
+
+	return self;
+}
+
+void SkeletonPose_dispose (SkeletonPose* self) {
+	FREE(SUB_CAST(_Internal, self)->arrays);
+	FREE(self->boneIndices);
+	FREE(self->parentEntries);
+	FREE(self->depthStarts);
+	FREE(self);
+}
+
+void SkeletonPose_getLocalTransforms (SkeletonPose* self) {
+	int i;
+	for (i = 0; i < self->entryCount; ++i) {
+		Bone* bone;
+		if (self->boneIndices[i] < 0) continue;
+		bone = self->skeleton->bones[self->boneIndices[i]];
+		self->x[i] = bone->x;
+		self->y[i] = bone->y;
+		self->rotation[i] = bone->rotation;
+		self->scaleX[i] = bone->scaleX;
+		self->scaleY[i] = bone->scaleY;
+	}
+}
+
+void SkeletonPose_computeWorldTransforms (SkeletonPose* self) {
+	int i;
+	int rootCount = self->depthCount ? self->depthStarts[1] : 0;
+	int flipY = (self->skeleton->flipY != 0) != (Bone_isYDown() != 0);
+	Floats signX = splat4(self->skeleton->flipX ? -1.0f : 1.0f);
+	Floats signY = splat4(flipY ? -1.0f : 1.0f);
+
+	/* World rotations and scales only depend on those of the parent, which is in an earlier depth and so already computed. */
+	for (i = 0; i < rootCount; i += SKELETON_POSE_BATCH) {
+		store4(self->worldScaleX + i, load4(self->scaleX + i));
+		store4(self->worldScaleY + i, load4(self->scaleY + i));
+		store4(self->worldRotation + i, load4(self->rotation + i));
+	}
+	for (; i < self->entryCount; i += SKELETON_POSE_BATCH) {
+		const int* parents = self->parentEntries + i;
+		store4(self->worldScaleX + i, mul4(gather4(self->worldScaleX, parents), load4(self->scaleX + i)));
+		store4(self->worldScaleY + i, mul4(gather4(self->worldScaleY, parents), load4(self->scaleY + i)));
+		store4(self->worldRotation + i, add4(gather4(self->worldRotation, parents), load4(self->rotation + i)));
+	}
+
+	/* The matrices then don't depend on each other, so the sines and cosines of consecutive batches can overlap. */
+	for (i = 0; i < self->entryCount; i += SKELETON_POSE_BATCH)
+		computeMatrices4(self, i, signX, signY);
+
+	/* World positions depend on the matrix and position of the parent. */
+	for (i = 0; i < rootCount; i += SKELETON_POSE_BATCH) {
+		/* As in Bone_updateWorldTransform, flipX flips the y of a root as well. */
+		store4(self->worldX + i, mul4(load4(self->x + i), signX));
+		store4(self->worldY + i, mul4(load4(self->y + i), signX));
+	}
+	for (; i < self->entryCount; i += SKELETON_POSE_BATCH) {
+		const int* parents = self->parentEntries + i;
+		Floats x = load4(self->x + i);
+		Floats y = load4(self->y + i);
+		store4(self->worldX + i,
+				add4(add4(mul4(x, gather4(self->m00, parents)), mul4(y, gather4(self->m01, parents))), gather4(self->worldX, parents)));
+		store4(self->worldY + i,
+				add4(add4(mul4(x, gather4(self->m10, parents)), mul4(y, gather4(self->m11, parents))), gather4(self->worldY, parents)));
+	}
+}
+
+void SkeletonPose_setWorldTransforms (const SkeletonPose* self) {
+	int i;
+	for (i = 0; i < self->entryCount; ++i) {
+		Bone* bone;
+		if (self->boneIndices[i] < 0) continue;
+		bone = self->skeleton->bones[self->boneIndices[i]];
+		CONST_CAST(float, bone->m00) = self->m00[i];
+		CONST_CAST(float, bone->m01) = self->m01[i];
+		CONST_CAST(float, bone->worldX) = self->worldX[i];
+		CONST_CAST(float, bone->m10) = self->m10[i];
+		CONST_CAST(float, bone->m11) = self->m11[i];
+		CONST_CAST(float, bone->worldY) = self->worldY[i];
+		CONST_CAST(float, bone->worldRotation) = self->worldRotation[i];
+		CONST_CAST(float, bone->worldScaleX) = self->worldScaleX[i];
+		CONST_CAST(float, bone->worldScaleY) = self->worldScaleY[i];
+	}
+}
+
+void SkeletonPose_updateWorldTransform (SkeletonPose* self) {
+	SkeletonPose_getLocalTransforms(self);
+	SkeletonPose_computeWorldTransforms(self);
+	SkeletonPose_setWorldTransforms(self);
+}
@@ -0,0 +1,93 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2012 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SPINE_SKELETONPOSE_H_
+#define SPINE_SKELETONPOSE_H_
+
+#include "Skeleton.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The number of bones SkeletonPose_computeWorldTransforms updates at a time. */
+#define SKELETON_POSE_BATCH 4
+
+/* The transforms of the bones of a skeleton, kept in arrays with one entry per bone rather than in the bones themselves, so
+ * the world transforms of several bones can be computed at once with SIMD instructions.
+ *
+ * The entries are sorted by the depth of the bone in the hierarchy, so every parent comes before its children and the bones
+ * of one depth don't depend on each other. Each depth is padded to a multiple of SKELETON_POSE_BATCH entries; the padding
+ * isn't a bone and is never copied to one. */
+typedef struct {
+	Skeleton* const skeleton;
+
+	int const entryCount;
+	int* const boneIndices; /* The index in the skeleton of the bone of each entry, or -1 for padding. */
+	int* const parentEntries; /* The entry of the parent of each bone, or -1 for a root. */
+
+	int const depthCount;
+	int* const depthStarts; /* The first entry of each depth, and entryCount after the last. */
+
+	/* Local transforms. */
+	float* const x;
+	float* const y;
+	float* const rotation;
+	float* const scaleX;
+	float* const scaleY;
+
+	/* World transforms. */
+	float* const m00;
+	float* const m01;
+	float* const worldX;
+	float* const m10;
+	float* const m11;
+	float* const worldY;
+	float* const worldRotation;
+	float* const worldScaleX;
+	float* const worldScaleY;
+} SkeletonPose;
+
+SkeletonPose* SkeletonPose_create (Skeleton* skeleton);
+void SkeletonPose_dispose (SkeletonPose* self);
+
+/* Copies the local transforms of the bones of the skeleton, which animations set, into the pose. */
+void SkeletonPose_getLocalTransforms (SkeletonPose* self);
+
+/* Computes the world transforms of the pose from its local transforms, as Bone_updateWorldTransform does, using the flip of
+ * the skeleton. Sines and cosines are approximated to within about 1e-6. */
+void SkeletonPose_computeWorldTransforms (SkeletonPose* self);
+
+/* Copies the world transforms of the pose into the bones of the skeleton, where slots and attachments read them. */
+void SkeletonPose_setWorldTransforms (const SkeletonPose* self);
+
+/* Updates the world transforms of the bones of the skeleton through the pose. Can be used instead of
+ * Skeleton_updateWorldTransform. */
+void SkeletonPose_updateWorldTransform (SkeletonPose* self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPINE_SKELETONPOSE_H_ */
@@ -17,6 +17,15 @@
     BOOL ditherAndroid;
     int  textureFileFormatHTML5;
     BOOL ditherHTML5;
+    BOOL polygonMode;
+    int  ditherMode;
+    int  pvrtcQuality;
+    int  extrude;
+    BOOL alphaBleed;
+    BOOL mipmaps;
+    int  mipmapFilter;
+    int  webpQuality;
+    int  paletteColors;
     
     IBOutlet NSButton *iosDither;
     IBOutlet NSButton *iosCompress;
@@ -36,6 +45,15 @@
 @property (nonatomic,assign) BOOL ditherAndroid;
 @property (nonatomic,assign) int textureFileFormatHTML5;
 @property (nonatomic,assign) BOOL ditherHTML5;
+@property (nonatomic,assign) BOOL polygonMode;
+@property (nonatomic,assign) int ditherMode;
+@property (nonatomic,assign) int pvrtcQuality;
+@property (nonatomic,assign) int extrude;
+@property (nonatomic,assign) BOOL alphaBleed;
+@property (nonatomic,assign) BOOL mipmaps;
+@property (nonatomic,assign) int mipmapFilter;
+@property (nonatomic,assign) int webpQuality;
+@property (nonatomic,assign) int paletteColors;
 @property (nonatomic,assign) BOOL iOSEnabled;
 @property (nonatomic,assign) BOOL androidEnabled;
 @property (nonatomic,assign) BOOL HTML5Enabled;
@@ -25,6 +25,15 @@
 @synthesize androidEnabled;
 @synthesize HTML5Enabled;
 @synthesize ditherHTML5;
+@synthesize polygonMode;
+@synthesize ditherMode;
+@synthesize pvrtcQuality;
+@synthesize extrude;
+@synthesize alphaBleed;
+@synthesize mipmaps;
+@synthesize mipmapFilter;
+@synthesize webpQuality;
+@synthesize paletteColors;
 
 - (id)initWithWindow:(NSWindow *)window
 {
@@ -28,6 +28,7 @@
 #import "CCBWriterInternal.h"
 #import "ResourceManager.h"
 #import "CCBFileUtil.h"
+#import "CCBSpriteSheetParser.h"
 #import "CCNode+NodeInfo.h"
 
 @implementation TexturePropertySetter
@@ -48,7 +49,7 @@
             // To resolution independent image
             spriteSheetFile = [CCBFileUtil toResolutionIndependentFile:spriteSheetFile];
             
-            [[CCSpriteFrameCache sharedSpriteFrameCache] addSpriteFramesWithFile:spriteSheetFile];
+            [CCBSpriteSheetParser addSpriteFramesWithFile:spriteSheetFile];
             
             spriteFrame = [[CCSpriteFrameCache sharedSpriteFrameCache] spriteFrameByName:spriteFile];
         }
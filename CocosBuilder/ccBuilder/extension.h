@@ -55,8 +55,8 @@
 #define SPINE_EXTENSION_H_
 
 /* All allocation uses these. */
-#define MALLOC(TYPE,COUNT) ((TYPE*)_malloc(sizeof(TYPE) * COUNT))
-#define CALLOC(TYPE,COUNT) ((TYPE*)_calloc(1, sizeof(TYPE) * COUNT))
+#define MALLOC(TYPE,COUNT) ((TYPE*)_malloc(sizeof(TYPE) * (COUNT)))
+#define CALLOC(TYPE,COUNT) ((TYPE*)_calloc(1, sizeof(TYPE) * (COUNT)))
 #define NEW(TYPE) CALLOC(TYPE,1)
 
 /* Gets the direct super class. Type safe. */
@@ -115,6 +115,11 @@ char* _readFile (const char* path, int* length);
 
 /**/
 
+/* Initializes a bone in memory that is zeroed, such as one of the bones a skeleton allocates in a single block. */
+void _Bone_init (Bone* self, BoneData* data, Bone* parent);
+
+/**/
+
 void _AttachmentLoader_init (AttachmentLoader* self, /**/
 		void (*dispose) (AttachmentLoader* self), /**/
 		Attachment* (*newAttachment) (AttachmentLoader* self, Skin* skin, AttachmentType type, const char* name));
@@ -132,14 +137,14 @@ void _Attachment_deinit (Attachment* self);
 
 void _Timeline_init (Timeline* self, /**/
 		void (*dispose) (Timeline* self), /**/
-		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha));
+		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha, int* frameCursor));
 void _Timeline_deinit (Timeline* self);
 
 /**/
 
 void _CurveTimeline_init (CurveTimeline* self, int frameCount, /**/
 		void (*dispose) (Timeline* self), /**/
-		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha));
+		void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha, int* frameCursor));
 void _CurveTimeline_deinit (CurveTimeline* self);
 
 #ifdef __cplusplus
@@ -37,8 +37,11 @@
 #include "BoneData.h"
 #include "RegionAttachment.h"
 #include "Skeleton.h"
+#include "SkeletonBatch.h"
+#include "SkeletonBinary.h"
 #include "SkeletonData.h"
 #include "SkeletonJson.h"
+#include "SkeletonPose.h"
 #include "Skin.h"
 #include "Slot.h"
 #include "SlotData.h"
@@ -0,0 +1,90 @@
+/** @file FreeRectIndex.cpp
+
+	@brief A size-bucketed index over the free rectangles of a MaxRectsBinPack.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cassert>
+
+#include "FreeRectIndex.h"
+
+FreeRectIndex::FreeRectIndex()
+{
+	Clear();
+}
+
+void FreeRectIndex::Clear()
+{
+	for(int cw = 0; cw < NumSizeClasses; ++cw)
+	{
+		for(int ch = 0; ch < NumSizeClasses; ++ch)
+			buckets[cw][ch].clear();
+		usedRows[cw] = 0;
+	}
+}
+
+int FreeRectIndex::SizeClass(int length)
+{
+	int sizeClass = 0;
+	while(length > 1 && sizeClass < NumSizeClasses - 1)
+	{
+		length >>= 1;
+		++sizeClass;
+	}
+	return sizeClass;
+}
+
+void FreeRectIndex::Add(const TPRect &r)
+{
+	int cw = SizeClass(r.width);
+	int ch = SizeClass(r.height);
+
+	buckets[cw][ch].push_back(r);
+	usedRows[cw] |= 1u << ch;
+}
+
+void FreeRectIndex::Remove(const TPRect &r)
+{
+	int cw = SizeClass(r.width);
+	int ch = SizeClass(r.height);
+
+	std::vector<TPRect> &bucket = buckets[cw][ch];
+	for(size_t i = 0; i < bucket.size(); ++i)
+		if (bucket[i].idx == r.idx)
+		{
+			bucket[i] = bucket.back();
+			bucket.pop_back();
+			if (bucket.empty())
+				usedRows[cw] &= ~(1u << ch);
+			return;
+		}
+
+	assert(false && "Removing a free rectangle that is not in the index.");
+}
+
+void FreeRectIndex::FindCandidates(int width, int height, std::vector<Span> &dst) const
+{
+	dst.clear();
+
+	// A free rectangle that is at least as large as the query is never in a smaller size class,
+	// so only the buckets at or above the query's size class in both dimensions can fit it.
+	int cw = SizeClass(width);
+	int ch = SizeClass(height);
+
+	for(int w = (cw < ch ? cw : ch); w < NumSizeClasses; ++w)
+	{
+		unsigned int mask = 0;
+		if (w >= cw)
+			mask |= ~0u << ch; // Upright.
+		if (w >= ch)
+			mask |= ~0u << cw; // Rotated.
+
+		unsigned int rows = usedRows[w] & mask;
+		for(int h = 0; rows != 0; ++h, rows >>= 1)
+			if (rows & 1)
+			{
+				Span span = { &buckets[w][h][0], buckets[w][h].size() };
+				dst.push_back(span);
+			}
+	}
+}
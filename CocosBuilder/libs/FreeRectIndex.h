@@ -0,0 +1,54 @@
+/** @file FreeRectIndex.h
+
+	@brief A size-bucketed index over the free rectangles of a MaxRectsBinPack.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Rect.h"
+
+/** FreeRectIndex groups free rectangles into buckets keyed on the power-of-two size class of
+	their width and height, so that a query for a given rectangle size only has to look at the
+	buckets that can hold it in at least one orientation. The index stores copies of the free
+	rectangles and uses TPRect::idx as the identity of a rectangle, so the idx values of the
+	rectangles added must be unique. The order of the rectangles within a bucket is not stable. */
+class FreeRectIndex
+{
+public:
+	/// A contiguous run of free rectangles, as returned by FindCandidates.
+	struct Span
+	{
+		const TPRect *rects;
+		size_t count;
+	};
+
+	FreeRectIndex();
+
+	/// Removes all rectangles from the index.
+	void Clear();
+
+	/// Adds a free rectangle to the index.
+	void Add(const TPRect &r);
+
+	/// Removes the free rectangle with the same size and idx as r from the index.
+	void Remove(const TPRect &r);
+
+	/// Collects the buckets that may contain a free rectangle into which a width x height
+	/// rectangle fits, either upright or rotated. Rectangles in the returned spans still need
+	/// to be tested individually.
+	void FindCandidates(int width, int height, std::vector<Span> &dst) const;
+
+private:
+	enum { NumSizeClasses = 16 };
+
+	static int SizeClass(int length);
+
+	std::vector<TPRect> buckets[NumSizeClasses][NumSizeClasses];
+
+	/// Bit i of usedRows[cw] is set if buckets[cw][i] is non-empty.
+	unsigned int usedRows[NumSizeClasses];
+};
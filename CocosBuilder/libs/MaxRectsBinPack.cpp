@@ -7,8 +7,12 @@
 */
 #include <utility>
 #include <iostream>
+#include <limits>
+#include <algorithm>
 
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 
 #include "MaxRectsBinPack.h"
 
@@ -16,11 +20,16 @@ using namespace std;
 
 MaxRectsBinPack::MaxRectsBinPack()
 :binWidth(0),
-binHeight(0)
+binHeight(0),
+nextFreeRectOrder(0),
+useFreeRectIndex(false),
+lastFreeRectOrder(0)
 {
 }
 
 MaxRectsBinPack::MaxRectsBinPack(int width, int height)
+:useFreeRectIndex(false),
+lastFreeRectOrder(0)
 {
 	Init(width, height);
 }
@@ -39,7 +48,63 @@ void MaxRectsBinPack::Init(int width, int height)
 	usedRectangles.clear();
 
 	freeRectangles.clear();
-	freeRectangles.push_back(n);
+	freeRectIndex.Clear();
+	nextFreeRectOrder = 0;
+	AddFreeRect(n);
+}
+
+void MaxRectsBinPack::SetUseFreeRectIndex(bool enable)
+{
+	if (enable == useFreeRectIndex)
+		return;
+
+	useFreeRectIndex = enable;
+
+	freeRectIndex.Clear();
+	if (useFreeRectIndex)
+		for(size_t i = 0; i < freeRectangles.size(); ++i)
+			freeRectIndex.Add(freeRectangles[i]);
+}
+
+void MaxRectsBinPack::AddFreeRect(TPRect freeRect)
+{
+	freeRect.idx = nextFreeRectOrder++;
+	freeRectangles.push_back(freeRect);
+	if (useFreeRectIndex)
+		freeRectIndex.Add(freeRect);
+}
+
+void MaxRectsBinPack::RemoveFreeRect(size_t i)
+{
+	removedFreeRectOrders.push_back(freeRectangles[i].idx);
+	if (useFreeRectIndex)
+		freeRectIndex.Remove(freeRectangles[i]);
+	freeRectangles[i] = freeRectangles.back();
+	freeRectangles.pop_back();
+}
+
+void MaxRectsBinPack::RemoveFreeRectsAtPositions()
+{
+	// Remove from the back so that moving the last free rectangle never moves one that is still to be removed.
+	std::sort(freeRectPositions.begin(), freeRectPositions.end());
+	for(size_t i = freeRectPositions.size(); i > 0; --i)
+		RemoveFreeRect(freeRectPositions[i-1]);
+}
+
+void MaxRectsBinPack::FindCandidateFreeRects(int width, int height) const
+{
+	if (useFreeRectIndex)
+	{
+		freeRectIndex.FindCandidates(width, height, candidateFreeRects);
+		return;
+	}
+
+	candidateFreeRects.clear();
+	if (!freeRectangles.empty())
+	{
+		FreeRectIndex::Span span = { &freeRectangles[0], freeRectangles.size() };
+		candidateFreeRects.push_back(span);
+	}
 }
 
 TPRect MaxRectsBinPack::Insert(int width, int height, FreeRectChoiceHeuristic method)
@@ -47,6 +112,7 @@ TPRect MaxRectsBinPack::Insert(int width, int height, FreeRectChoiceHeuristic me
 	TPRect newNode;
 	int score1; // Unused in this function. We don't need to know the score after finding the position.
 	int score2;
+	FindCandidateFreeRects(width, height);
 	switch(method)
 	{
 		case RectBestShortSideFit: newNode = FindPositionForNewNodeBestShortSideFit(width, height, score1, score2); break;
@@ -59,20 +125,7 @@ TPRect MaxRectsBinPack::Insert(int width, int height, FreeRectChoiceHeuristic me
 	if (newNode.height == 0)
 		return newNode;
 
-	size_t numRectanglesToProcess = freeRectangles.size();
-	for(size_t i = 0; i < numRectanglesToProcess; ++i)
-	{
-		if (SplitFreeNode(freeRectangles[i], newNode))
-		{
-			freeRectangles.erase(freeRectangles.begin() + i);
-			--i;
-			--numRectanglesToProcess;
-		}
-	}
-
-	PruneFreeList();
-
-	usedRectangles.push_back(newNode);
+	PlaceRect(newNode);
 	return newNode;
 }
 
@@ -80,6 +133,19 @@ void MaxRectsBinPack::Insert(std::vector<TPRectSize> &rects, std::vector<TPRect>
 {
 	dst.clear();
 
+	// The contact point score depends on the used rectangles, so it changes with every placement.
+	bool cacheScores = (method != RectContactPointRule);
+
+	std::vector<CachedScore> cache(rects.size());
+	if (cacheScores)
+		for(size_t i = 0; i < rects.size(); ++i)
+		{
+			cache[i].node = ScoreRect(rects[i].width, rects[i].height, method, cache[i].score1, cache[i].score2, rects[i].idx);
+			cache[i].freeRectOrder = lastFreeRectOrder;
+		}
+
+	std::vector<TPRect> newFreeRects;
+
 	while(rects.size() > 0)
 	{
 		int bestScore1 = std::numeric_limits<int>::max();
@@ -89,15 +155,17 @@ void MaxRectsBinPack::Insert(std::vector<TPRectSize> &rects, std::vector<TPRect>
 
 		for(size_t i = 0; i < rects.size(); ++i)
 		{
-			int score1;
-			int score2;
-			TPRect newNode = ScoreRect(rects[i].width, rects[i].height, method, score1, score2, rects[i].idx);
+			if (!cacheScores)
+				cache[i].node = ScoreRect(rects[i].width, rects[i].height, method, cache[i].score1, cache[i].score2, rects[i].idx);
+
+			int score1 = cache[i].score1;
+			int score2 = cache[i].score2;
 
 			if (score1 < bestScore1 || (score1 == bestScore1 && score2 < bestScore2))
 			{
 				bestScore1 = score1;
 				bestScore2 = score2;
-				bestNode = newNode;
+				bestNode = cache[i].node;
 				bestRectIndex = i;
 			}
 		}
@@ -105,32 +173,117 @@ void MaxRectsBinPack::Insert(std::vector<TPRectSize> &rects, std::vector<TPRect>
 		if (bestRectIndex == -1)
 			return;
 
+		int firstNewFreeRectOrder = nextFreeRectOrder;
+
 		PlaceRect(bestNode);
-        dst.push_back(bestNode);
+		dst.push_back(bestNode);
 		rects.erase(rects.begin() + bestRectIndex);
+		cache.erase(cache.begin() + bestRectIndex);
+
+		if (!cacheScores)
+			continue;
+
+		newFreeRects.clear();
+		for(size_t i = 0; i < freeRectangles.size(); ++i)
+			if (freeRectangles[i].idx >= firstNewFreeRectOrder)
+				newFreeRects.push_back(freeRectangles[i]);
+
+		std::sort(removedFreeRectOrders.begin(), removedFreeRectOrders.end());
+
+		for(size_t i = 0; i < rects.size(); ++i)
+			RescoreRect(rects[i], cache[i], method, newFreeRects);
 	}
 }
 
-void MaxRectsBinPack::PlaceRect(const TPRect &node)
+void MaxRectsBinPack::RescoreRect(const TPRectSize &rect, CachedScore &cached, FreeRectChoiceHeuristic method,
+	const std::vector<TPRect> &newFreeRects) const
+{
+	// If the free rectangle the cached placement uses is gone, the rectangle needs a full rescore.
+	if (std::binary_search(removedFreeRectOrders.begin(), removedFreeRectOrders.end(), cached.freeRectOrder))
+	{
+		cached.node = ScoreRect(rect.width, rect.height, method, cached.score1, cached.score2, rect.idx);
+		cached.freeRectOrder = lastFreeRectOrder;
+		return;
+	}
+
+	// Otherwise the cached placement is still the best among the free rectangles that already existed,
+	// and only the new ones can beat it. They were all created after the existing ones, so a tie keeps
+	// the cached placement, as a scan over all free rectangles would.
+	if (newFreeRects.empty())
+		return;
+
+	candidateFreeRects.clear();
+	FreeRectIndex::Span span = { &newFreeRects[0], newFreeRects.size() };
+	candidateFreeRects.push_back(span);
+
+	int score1;
+	int score2;
+	TPRect newNode = ScoreRectInCandidates(rect.width, rect.height, method, score1, score2, rect.idx);
+
+	if (score1 < cached.score1 || (score1 == cached.score1 && score2 < cached.score2))
+	{
+		cached.node = newNode;
+		cached.score1 = score1;
+		cached.score2 = score2;
+		cached.freeRectOrder = lastFreeRectOrder;
+	}
+}
+
+namespace
 {
-	size_t numRectanglesToProcess = freeRectangles.size();
-	for(size_t i = 0; i < numRectanglesToProcess; ++i)
+	/// Orders indices into a list of free rectangles by the creation order of the free rectangles.
+	struct FreeRectOrderLess
 	{
-		if (SplitFreeNode(freeRectangles[i], node))
+		const std::vector<TPRect> &freeRects;
+
+		bool operator()(size_t a, size_t b) const
 		{
-			freeRectangles.erase(freeRectangles.begin() + i);
-			--i;
-			--numRectanglesToProcess;
+			return freeRects[a].idx < freeRects[b].idx;
 		}
-	}
+	};
+}
 
-	PruneFreeList();
+void MaxRectsBinPack::PlaceRect(const TPRect &node)
+{
+	int firstNewFreeRectOrder = SplitFreeRects(node);
+
+	PruneFreeList(firstNewFreeRectOrder);
 
 	usedRectangles.push_back(node);
 	//		dst.push_back(bestNode); ///\todo Refactor so that this compiles.
 }
 
+int MaxRectsBinPack::SplitFreeRects(const TPRect &node)
+{
+	removedFreeRectOrders.clear();
+
+	int firstNewFreeRectOrder = nextFreeRectOrder;
+
+	// Split the free rectangles the node overlaps in creation order, so that the new free rectangles are
+	// created in the same order no matter how freeRectangles is ordered.
+	freeRectPositions.clear();
+	for(size_t i = 0; i < freeRectangles.size(); ++i)
+		if (!DisjointRectCollection::Disjoint(freeRectangles[i], node))
+			freeRectPositions.push_back(i);
+
+	FreeRectOrderLess orderLess = { freeRectangles };
+	std::sort(freeRectPositions.begin(), freeRectPositions.end(), orderLess);
+
+	for(size_t i = 0; i < freeRectPositions.size(); ++i)
+		SplitFreeNode(freeRectangles[freeRectPositions[i]], node);
+
+	RemoveFreeRectsAtPositions();
+
+	return firstNewFreeRectOrder;
+}
+
 TPRect MaxRectsBinPack::ScoreRect(int width, int height, FreeRectChoiceHeuristic method, int &score1, int &score2, int idx) const
+{
+	FindCandidateFreeRects(width, height);
+	return ScoreRectInCandidates(width, height, method, score1, score2, idx);
+}
+
+TPRect MaxRectsBinPack::ScoreRectInCandidates(int width, int height, FreeRectChoiceHeuristic method, int &score1, int &score2, int idx) const
 {
 	TPRect newNode;
 	score1 = std::numeric_limits<int>::max();
@@ -175,37 +328,47 @@ TPRect MaxRectsBinPack::FindPositionForNewNodeBottomLeft(int width, int height,
 	memset(&bestNode, 0, sizeof(TPRect));
 
 	bestY = std::numeric_limits<int>::max();
+	int bestOrder = std::numeric_limits<int>::max();
 
-	for(size_t i = 0; i < freeRectangles.size(); ++i)
+	for(size_t c = 0; c < candidateFreeRects.size(); ++c)
 	{
-		// Try to place the rectangle in upright (non-flipped) orientation.
-		if (freeRectangles[i].width >= width && freeRectangles[i].height >= height)
+		const TPRect *freeRects = candidateFreeRects[c].rects;
+		for(size_t i = 0; i < candidateFreeRects[c].count; ++i)
 		{
-			int topSideY = freeRectangles[i].y + height;
-			if (topSideY < bestY || (topSideY == bestY && freeRectangles[i].x < bestX))
+			// Try to place the rectangle in upright (non-flipped) orientation.
+			if (freeRects[i].width >= width && freeRects[i].height >= height)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = width;
-				bestNode.height = height;
-				bestY = topSideY;
-				bestX = freeRectangles[i].x;
+				int topSideY = freeRects[i].y + height;
+				if (topSideY < bestY || (topSideY == bestY && freeRects[i].x < bestX) ||
+					(topSideY == bestY && freeRects[i].x == bestX && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = width;
+					bestNode.height = height;
+					bestY = topSideY;
+					bestX = freeRects[i].x;
+					bestOrder = freeRects[i].idx;
+				}
 			}
-		}
-		if (freeRectangles[i].width >= height && freeRectangles[i].height >= width)
-		{
-			int topSideY = freeRectangles[i].y + width;
-			if (topSideY < bestY || (topSideY == bestY && freeRectangles[i].x < bestX))
+			if (freeRects[i].width >= height && freeRects[i].height >= width)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = height;
-				bestNode.height = width;
-				bestY = topSideY;
-				bestX = freeRectangles[i].x;
+				int topSideY = freeRects[i].y + width;
+				if (topSideY < bestY || (topSideY == bestY && freeRects[i].x < bestX) ||
+					(topSideY == bestY && freeRects[i].x == bestX && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = height;
+					bestNode.height = width;
+					bestY = topSideY;
+					bestX = freeRects[i].x;
+					bestOrder = freeRects[i].idx;
+				}
 			}
 		}
 	}
+	lastFreeRectOrder = bestOrder;
 	return bestNode;
 }
 
@@ -216,46 +379,56 @@ TPRect MaxRectsBinPack::FindPositionForNewNodeBestShortSideFit(int width, int he
 	memset(&bestNode, 0, sizeof(TPRect));
 
 	bestShortSideFit = std::numeric_limits<int>::max();
+	int bestOrder = std::numeric_limits<int>::max();
 
-	for(size_t i = 0; i < freeRectangles.size(); ++i)
+	for(size_t c = 0; c < candidateFreeRects.size(); ++c)
 	{
-		// Try to place the rectangle in upright (non-flipped) orientation.
-		if (freeRectangles[i].width >= width && freeRectangles[i].height >= height)
+		const TPRect *freeRects = candidateFreeRects[c].rects;
+		for(size_t i = 0; i < candidateFreeRects[c].count; ++i)
 		{
-			int leftoverHoriz = abs(freeRectangles[i].width - width);
-			int leftoverVert = abs(freeRectangles[i].height - height);
-			int shortSideFit = min(leftoverHoriz, leftoverVert);
-			int longSideFit = max(leftoverHoriz, leftoverVert);
-
-			if (shortSideFit < bestShortSideFit || (shortSideFit == bestShortSideFit && longSideFit < bestLongSideFit))
+			// Try to place the rectangle in upright (non-flipped) orientation.
+			if (freeRects[i].width >= width && freeRects[i].height >= height)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = width;
-				bestNode.height = height;
-				bestShortSideFit = shortSideFit;
-				bestLongSideFit = longSideFit;
+				int leftoverHoriz = abs(freeRects[i].width - width);
+				int leftoverVert = abs(freeRects[i].height - height);
+				int shortSideFit = min(leftoverHoriz, leftoverVert);
+				int longSideFit = max(leftoverHoriz, leftoverVert);
+
+				if (shortSideFit < bestShortSideFit || (shortSideFit == bestShortSideFit && longSideFit < bestLongSideFit) ||
+					(shortSideFit == bestShortSideFit && longSideFit == bestLongSideFit && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = width;
+					bestNode.height = height;
+					bestShortSideFit = shortSideFit;
+					bestLongSideFit = longSideFit;
+					bestOrder = freeRects[i].idx;
+				}
 			}
-		}
-
-		if (freeRectangles[i].width >= height && freeRectangles[i].height >= width)
-		{
-			int flippedLeftoverHoriz = abs(freeRectangles[i].width - height);
-			int flippedLeftoverVert = abs(freeRectangles[i].height - width);
-			int flippedShortSideFit = min(flippedLeftoverHoriz, flippedLeftoverVert);
-			int flippedLongSideFit = max(flippedLeftoverHoriz, flippedLeftoverVert);
 
-			if (flippedShortSideFit < bestShortSideFit || (flippedShortSideFit == bestShortSideFit && flippedLongSideFit < bestLongSideFit))
+			if (freeRects[i].width >= height && freeRects[i].height >= width)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = height;
-				bestNode.height = width;
-				bestShortSideFit = flippedShortSideFit;
-				bestLongSideFit = flippedLongSideFit;
+				int flippedLeftoverHoriz = abs(freeRects[i].width - height);
+				int flippedLeftoverVert = abs(freeRects[i].height - width);
+				int flippedShortSideFit = min(flippedLeftoverHoriz, flippedLeftoverVert);
+				int flippedLongSideFit = max(flippedLeftoverHoriz, flippedLeftoverVert);
+
+				if (flippedShortSideFit < bestShortSideFit || (flippedShortSideFit == bestShortSideFit && flippedLongSideFit < bestLongSideFit) ||
+					(flippedShortSideFit == bestShortSideFit && flippedLongSideFit == bestLongSideFit && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = height;
+					bestNode.height = width;
+					bestShortSideFit = flippedShortSideFit;
+					bestLongSideFit = flippedLongSideFit;
+					bestOrder = freeRects[i].idx;
+				}
 			}
 		}
 	}
+	lastFreeRectOrder = bestOrder;
 	return bestNode;
 }
 
@@ -266,46 +439,56 @@ TPRect MaxRectsBinPack::FindPositionForNewNodeBestLongSideFit(int width, int hei
 	memset(&bestNode, 0, sizeof(TPRect));
 
 	bestLongSideFit = std::numeric_limits<int>::max();
+	int bestOrder = std::numeric_limits<int>::max();
 
-	for(size_t i = 0; i < freeRectangles.size(); ++i)
+	for(size_t c = 0; c < candidateFreeRects.size(); ++c)
 	{
-		// Try to place the rectangle in upright (non-flipped) orientation.
-		if (freeRectangles[i].width >= width && freeRectangles[i].height >= height)
+		const TPRect *freeRects = candidateFreeRects[c].rects;
+		for(size_t i = 0; i < candidateFreeRects[c].count; ++i)
 		{
-			int leftoverHoriz = abs(freeRectangles[i].width - width);
-			int leftoverVert = abs(freeRectangles[i].height - height);
-			int shortSideFit = min(leftoverHoriz, leftoverVert);
-			int longSideFit = max(leftoverHoriz, leftoverVert);
-
-			if (longSideFit < bestLongSideFit || (longSideFit == bestLongSideFit && shortSideFit < bestShortSideFit))
+			// Try to place the rectangle in upright (non-flipped) orientation.
+			if (freeRects[i].width >= width && freeRects[i].height >= height)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = width;
-				bestNode.height = height;
-				bestShortSideFit = shortSideFit;
-				bestLongSideFit = longSideFit;
+				int leftoverHoriz = abs(freeRects[i].width - width);
+				int leftoverVert = abs(freeRects[i].height - height);
+				int shortSideFit = min(leftoverHoriz, leftoverVert);
+				int longSideFit = max(leftoverHoriz, leftoverVert);
+
+				if (longSideFit < bestLongSideFit || (longSideFit == bestLongSideFit && shortSideFit < bestShortSideFit) ||
+					(longSideFit == bestLongSideFit && shortSideFit == bestShortSideFit && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = width;
+					bestNode.height = height;
+					bestShortSideFit = shortSideFit;
+					bestLongSideFit = longSideFit;
+					bestOrder = freeRects[i].idx;
+				}
 			}
-		}
 
-		if (freeRectangles[i].width >= height && freeRectangles[i].height >= width)
-		{
-			int leftoverHoriz = abs(freeRectangles[i].width - height);
-			int leftoverVert = abs(freeRectangles[i].height - width);
-			int shortSideFit = min(leftoverHoriz, leftoverVert);
-			int longSideFit = max(leftoverHoriz, leftoverVert);
-
-			if (longSideFit < bestLongSideFit || (longSideFit == bestLongSideFit && shortSideFit < bestShortSideFit))
+			if (freeRects[i].width >= height && freeRects[i].height >= width)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = height;
-				bestNode.height = width;
-				bestShortSideFit = shortSideFit;
-				bestLongSideFit = longSideFit;
+				int leftoverHoriz = abs(freeRects[i].width - height);
+				int leftoverVert = abs(freeRects[i].height - width);
+				int shortSideFit = min(leftoverHoriz, leftoverVert);
+				int longSideFit = max(leftoverHoriz, leftoverVert);
+
+				if (longSideFit < bestLongSideFit || (longSideFit == bestLongSideFit && shortSideFit < bestShortSideFit) ||
+					(longSideFit == bestLongSideFit && shortSideFit == bestShortSideFit && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = height;
+					bestNode.height = width;
+					bestShortSideFit = shortSideFit;
+					bestLongSideFit = longSideFit;
+					bestOrder = freeRects[i].idx;
+				}
 			}
 		}
 	}
+	lastFreeRectOrder = bestOrder;
 	return bestNode;
 }
 
@@ -316,46 +499,56 @@ TPRect MaxRectsBinPack::FindPositionForNewNodeBestAreaFit(int width, int height,
 	memset(&bestNode, 0, sizeof(TPRect));
 
 	bestAreaFit = std::numeric_limits<int>::max();
+	int bestOrder = std::numeric_limits<int>::max();
 
-	for(size_t i = 0; i < freeRectangles.size(); ++i)
+	for(size_t c = 0; c < candidateFreeRects.size(); ++c)
 	{
-		int areaFit = freeRectangles[i].width * freeRectangles[i].height - width * height;
-
-		// Try to place the rectangle in upright (non-flipped) orientation.
-		if (freeRectangles[i].width >= width && freeRectangles[i].height >= height)
+		const TPRect *freeRects = candidateFreeRects[c].rects;
+		for(size_t i = 0; i < candidateFreeRects[c].count; ++i)
 		{
-			int leftoverHoriz = abs(freeRectangles[i].width - width);
-			int leftoverVert = abs(freeRectangles[i].height - height);
-			int shortSideFit = min(leftoverHoriz, leftoverVert);
+			int areaFit = freeRects[i].width * freeRects[i].height - width * height;
 
-			if (areaFit < bestAreaFit || (areaFit == bestAreaFit && shortSideFit < bestShortSideFit))
+			// Try to place the rectangle in upright (non-flipped) orientation.
+			if (freeRects[i].width >= width && freeRects[i].height >= height)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = width;
-				bestNode.height = height;
-				bestShortSideFit = shortSideFit;
-				bestAreaFit = areaFit;
+				int leftoverHoriz = abs(freeRects[i].width - width);
+				int leftoverVert = abs(freeRects[i].height - height);
+				int shortSideFit = min(leftoverHoriz, leftoverVert);
+
+				if (areaFit < bestAreaFit || (areaFit == bestAreaFit && shortSideFit < bestShortSideFit) ||
+					(areaFit == bestAreaFit && shortSideFit == bestShortSideFit && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = width;
+					bestNode.height = height;
+					bestShortSideFit = shortSideFit;
+					bestAreaFit = areaFit;
+					bestOrder = freeRects[i].idx;
+				}
 			}
-		}
-
-		if (freeRectangles[i].width >= height && freeRectangles[i].height >= width)
-		{
-			int leftoverHoriz = abs(freeRectangles[i].width - height);
-			int leftoverVert = abs(freeRectangles[i].height - width);
-			int shortSideFit = min(leftoverHoriz, leftoverVert);
 
-			if (areaFit < bestAreaFit || (areaFit == bestAreaFit && shortSideFit < bestShortSideFit))
+			if (freeRects[i].width >= height && freeRects[i].height >= width)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = height;
-				bestNode.height = width;
-				bestShortSideFit = shortSideFit;
-				bestAreaFit = areaFit;
+				int leftoverHoriz = abs(freeRects[i].width - height);
+				int leftoverVert = abs(freeRects[i].height - width);
+				int shortSideFit = min(leftoverHoriz, leftoverVert);
+
+				if (areaFit < bestAreaFit || (areaFit == bestAreaFit && shortSideFit < bestShortSideFit) ||
+					(areaFit == bestAreaFit && shortSideFit == bestShortSideFit && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = height;
+					bestNode.height = width;
+					bestShortSideFit = shortSideFit;
+					bestAreaFit = areaFit;
+					bestOrder = freeRects[i].idx;
+				}
 			}
 		}
 	}
+	lastFreeRectOrder = bestOrder;
 	return bestNode;
 }
 
@@ -392,35 +585,43 @@ TPRect MaxRectsBinPack::FindPositionForNewNodeContactPoint(int width, int height
 	memset(&bestNode, 0, sizeof(TPRect));
 
 	bestContactScore = -1;
+	int bestOrder = std::numeric_limits<int>::max();
 
-	for(size_t i = 0; i < freeRectangles.size(); ++i)
+	for(size_t c = 0; c < candidateFreeRects.size(); ++c)
 	{
-		// Try to place the rectangle in upright (non-flipped) orientation.
-		if (freeRectangles[i].width >= width && freeRectangles[i].height >= height)
+		const TPRect *freeRects = candidateFreeRects[c].rects;
+		for(size_t i = 0; i < candidateFreeRects[c].count; ++i)
 		{
-			int score = ContactPointScoreNode(freeRectangles[i].x, freeRectangles[i].y, width, height);
-			if (score > bestContactScore)
+			// Try to place the rectangle in upright (non-flipped) orientation.
+			if (freeRects[i].width >= width && freeRects[i].height >= height)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = width;
-				bestNode.height = height;
-				bestContactScore = score;
+				int score = ContactPointScoreNode(freeRects[i].x, freeRects[i].y, width, height);
+				if (score > bestContactScore || (score == bestContactScore && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = width;
+					bestNode.height = height;
+					bestContactScore = score;
+					bestOrder = freeRects[i].idx;
+				}
 			}
-		}
-		if (freeRectangles[i].width >= height && freeRectangles[i].height >= width)
-		{
-			int score = ContactPointScoreNode(freeRectangles[i].x, freeRectangles[i].y, width, height);
-			if (score > bestContactScore)
+			if (freeRects[i].width >= height && freeRects[i].height >= width)
 			{
-				bestNode.x = freeRectangles[i].x;
-				bestNode.y = freeRectangles[i].y;
-				bestNode.width = height;
-				bestNode.height = width;
-				bestContactScore = score;
+				int score = ContactPointScoreNode(freeRects[i].x, freeRects[i].y, width, height);
+				if (score > bestContactScore || (score == bestContactScore && freeRects[i].idx < bestOrder))
+				{
+					bestNode.x = freeRects[i].x;
+					bestNode.y = freeRects[i].y;
+					bestNode.width = height;
+					bestNode.height = width;
+					bestContactScore = score;
+					bestOrder = freeRects[i].idx;
+				}
 			}
 		}
 	}
+	lastFreeRectOrder = bestOrder;
 	return bestNode;
 }
 
@@ -438,7 +639,7 @@ bool MaxRectsBinPack::SplitFreeNode(TPRect freeNode, const TPRect &usedNode)
 		{
 			TPRect newNode = freeNode;
 			newNode.height = usedNode.y - newNode.y;
-			freeRectangles.push_back(newNode);
+			AddFreeRect(newNode);
 		}
 
 		// New node at the bottom side of the used node.
@@ -447,7 +648,7 @@ bool MaxRectsBinPack::SplitFreeNode(TPRect freeNode, const TPRect &usedNode)
 			TPRect newNode = freeNode;
 			newNode.y = usedNode.y + usedNode.height;
 			newNode.height = freeNode.y + freeNode.height - (usedNode.y + usedNode.height);
-			freeRectangles.push_back(newNode);
+			AddFreeRect(newNode);
 		}
 	}
 
@@ -458,7 +659,7 @@ bool MaxRectsBinPack::SplitFreeNode(TPRect freeNode, const TPRect &usedNode)
 		{
 			TPRect newNode = freeNode;
 			newNode.width = usedNode.x - newNode.x;
-			freeRectangles.push_back(newNode);
+			AddFreeRect(newNode);
 		}
 
 		// New node at the right side of the used node.
@@ -467,48 +668,53 @@ bool MaxRectsBinPack::SplitFreeNode(TPRect freeNode, const TPRect &usedNode)
 			TPRect newNode = freeNode;
 			newNode.x = usedNode.x + usedNode.width;
 			newNode.width = freeNode.x + freeNode.width - (usedNode.x + usedNode.width);
-			freeRectangles.push_back(newNode);
+			AddFreeRect(newNode);
 		}
 	}
 
 	return true;
 }
 
-void MaxRectsBinPack::PruneFreeList()
+void MaxRectsBinPack::PruneFreeList(int firstNewFreeRectOrder)
 {
-	/* 
-	///  Would be nice to do something like this, to avoid a Theta(n^2) loop through each pair.
-	///  But unfortunately it doesn't quite cut it, since we also want to detect containment. 
-	///  Perhaps there's another way to do this faster than Theta(n^2).
-
-	if (freeRectangles.size() > 0)
-		clb::sort::QuickSort(&freeRectangles[0], freeRectangles.size(), NodeSortCmp);
-
-	for(size_t i = 0; i < freeRectangles.size()-1; ++i)
-		if (freeRectangles[i].x == freeRectangles[i+1].x &&
-		    freeRectangles[i].y == freeRectangles[i+1].y &&
-		    freeRectangles[i].width == freeRectangles[i+1].width &&
-		    freeRectangles[i].height == freeRectangles[i+1].height)
-		{
-			freeRectangles.erase(freeRectangles.begin() + i);
-			--i;
-		}
-	*/
+	// The free rectangles created by the last split are usually few, so they are collected first and each
+	// one is then tested against the existing free rectangles that are large enough to contain it.
+	std::vector<TPRect> &newFreeRects = prunedFreeRects;
+	newFreeRects.clear();
+	for(size_t i = 0; i < freeRectangles.size(); ++i)
+		if (freeRectangles[i].idx >= firstNewFreeRectOrder)
+			newFreeRects.push_back(freeRectangles[i]);
 
-	/// Go through each pair and remove any rectangle that is redundant.
+	freeRectPositions.clear();
 	for(size_t i = 0; i < freeRectangles.size(); ++i)
-		for(size_t j = i+1; j < freeRectangles.size(); ++j)
+	{
+		const TPRect &freeRect = freeRectangles[i];
+		if (freeRect.idx < firstNewFreeRectOrder)
+			continue;
+
+		bool redundant = false;
+
+		// Of two identical free rectangles the one created first is removed.
+		for(size_t j = 0; j < newFreeRects.size() && !redundant; ++j)
+			if (newFreeRects[j].idx != freeRect.idx && IsContainedIn(freeRect, newFreeRects[j]) &&
+				(freeRect.idx < newFreeRects[j].idx || !IsContainedIn(newFreeRects[j], freeRect)))
+				redundant = true;
+
+		FindCandidateFreeRects(freeRect.width, freeRect.height);
+		for(size_t c = 0; c < candidateFreeRects.size() && !redundant; ++c)
 		{
-			if (IsContainedIn(freeRectangles[i], freeRectangles[j]))
-			{
-				freeRectangles.erase(freeRectangles.begin()+i);
-				--i;
-				break;
-			}
-			if (IsContainedIn(freeRectangles[j], freeRectangles[i]))
-			{
-				freeRectangles.erase(freeRectangles.begin()+j);
-				--j;
-			}
+			const TPRect *freeRects = candidateFreeRects[c].rects;
+			for(size_t j = 0; j < candidateFreeRects[c].count; ++j)
+				if (freeRects[j].idx < firstNewFreeRectOrder && IsContainedIn(freeRect, freeRects[j]))
+				{
+					redundant = true;
+					break;
+				}
 		}
+
+		if (redundant)
+			freeRectPositions.push_back(i);
+	}
+
+	RemoveFreeRectsAtPositions();
 }
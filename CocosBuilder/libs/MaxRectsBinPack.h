@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "Rect.h"
+#include "FreeRectIndex.h"
 
 /** MaxRectsBinPack implements the MAXRECTS data structure and different bin packing algorithms that 
 	use this structure. */
@@ -40,6 +41,8 @@ public:
 	/// @param rects The list of rectangles to insert. This vector will be destroyed in the process.
 	/// @param dst [out] This list will contain the packed rectangles. The indices will not correspond to that of rects.
 	/// @param method The rectangle placement rule to use when packing.
+	/// Except for RectContactPointRule, the best placement of every remaining rectangle is cached between
+	/// iterations and only rescored against the free rectangles changed by the last placement.
 	void Insert(std::vector<TPRectSize> &rects, std::vector<TPRect> &dst, FreeRectChoiceHeuristic method);
 
 	/// Inserts a single rectangle into the bin, possibly rotated.
@@ -48,12 +51,63 @@ public:
 	/// Computes the ratio of used surface area to the total bin area.
 	float Occupancy() const;
 
+	/// Enables or disables the size-bucketed free rectangle index. With the index enabled, finding
+	/// the position for a new rectangle only looks at the free rectangles that are large enough
+	/// to hold it, which pays off for large bins with many free rectangles. The placements
+	/// produced are the same with and without the index.
+	void SetUseFreeRectIndex(bool enable);
+
 private:
 	int binWidth;
 	int binHeight;
 
 	std::vector<TPRect> usedRectangles;
+
+	/// The free rectangles. TPRect::idx of a free rectangle holds its creation order, which is
+	/// used to break ties between equally scored free rectangles.
 	std::vector<TPRect> freeRectangles;
+	int nextFreeRectOrder;
+
+	bool useFreeRectIndex;
+	FreeRectIndex freeRectIndex;
+
+	/// Scratch list of the free rectangles to test, filled in by FindCandidateFreeRects.
+	mutable std::vector<FreeRectIndex::Span> candidateFreeRects;
+
+	/// The creation order of the free rectangle chosen by the last FindPositionForNewNode* call,
+	/// or std::numeric_limits<int>::max() if the rectangle did not fit.
+	mutable int lastFreeRectOrder;
+
+	/// The creation orders of the free rectangles removed by the last PlaceRect call.
+	std::vector<int> removedFreeRectOrders;
+
+	/// The best placement found for a rectangle that is waiting to be inserted in batch mode.
+	struct CachedScore
+	{
+		TPRect node;
+		int score1;
+		int score2;
+		int freeRectOrder;
+	};
+
+	/// Adds a new free rectangle, assigning it the next creation order.
+	void AddFreeRect(TPRect freeRect);
+
+	/// Removes the free rectangle at the given index of freeRectangles by moving the last free rectangle
+	/// into its place, so the order of freeRectangles does not follow the creation order.
+	void RemoveFreeRect(size_t i);
+
+	/// Scratch list of indices into freeRectangles, used by PlaceRect and PruneFreeList.
+	std::vector<size_t> freeRectPositions;
+
+	/// Scratch list of the free rectangles created by the last split, used by PruneFreeList.
+	std::vector<TPRect> prunedFreeRects;
+
+	/// Removes the free rectangles at the indices in freeRectPositions.
+	void RemoveFreeRectsAtPositions();
+
+	/// Fills candidateFreeRects with the free rectangles a width x height rectangle may fit into.
+	void FindCandidateFreeRects(int width, int height) const;
 
 	/// Computes the placement score for placing the given rectangle with the given method.
 	/// @param score1 [out] The primary placement score will be outputted here.
@@ -61,12 +115,25 @@ private:
 	/// @return This struct identifies where the rectangle would be placed if it were placed.
 	TPRect ScoreRect(int width, int height, FreeRectChoiceHeuristic method, int &score1, int &score2, int idx) const;
 
+	/// Like ScoreRect, but only considers the free rectangles currently in candidateFreeRects.
+	TPRect ScoreRectInCandidates(int width, int height, FreeRectChoiceHeuristic method, int &score1, int &score2, int idx) const;
+
+	/// Updates the cached placement of a rectangle after the last PlaceRect call.
+	/// @param newFreeRects The free rectangles that were created by the last PlaceRect call.
+	void RescoreRect(const TPRectSize &rect, CachedScore &cached, FreeRectChoiceHeuristic method,
+		const std::vector<TPRect> &newFreeRects) const;
+
 	/// Places the given rectangle into the bin.
 	void PlaceRect(const TPRect &node);
 
+	/// Splits the free rectangles the given rectangle overlaps, without pruning the free list.
+	/// @return The creation order of the first free rectangle created by the split.
+	int SplitFreeRects(const TPRect &node);
+
 	/// Computes the placement score for the -CP variant.
 	int ContactPointScoreNode(int x, int y, int width, int height) const;
 
+	/// The FindPositionForNewNode* functions scan the free rectangles in candidateFreeRects.
 	TPRect FindPositionForNewNodeBottomLeft(int width, int height, int &bestY, int &bestX) const;
 	TPRect FindPositionForNewNodeBestShortSideFit(int width, int height, int &bestShortSideFit, int &bestLongSideFit) const;
 	TPRect FindPositionForNewNodeBestLongSideFit(int width, int height, int &bestShortSideFit, int &bestLongSideFit) const;
@@ -76,6 +143,11 @@ private:
 	/// @return True if the free node was split.
 	bool SplitFreeNode(TPRect freeNode, const TPRect &usedNode);
 
-	/// Goes through the free rectangle list and removes any redundant entries.
-	void PruneFreeList();
+	/// Goes through the free rectangles created since firstNewFreeRectOrder and removes the ones that are redundant.
+	/// The free rectangles that existed before are never contained in each other or in a new one, so only the
+	/// new free rectangles need to be checked.
+	void PruneFreeList(int firstNewFreeRectOrder);
+
+	/// Times the steps of PlaceRect apart from each other, in tupac-benchmark.
+	friend class MaxRectsBinPackProfiler;
 };
@@ -0,0 +1,183 @@
+/** @file AlphaBleed.cpp
+
+	@brief Fills the margins around the frames of a sprite sheet, so that bilinear filtering does not
+	blend the edges of the frames with black.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "AlphaBleed.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	/// Sets out[i] = a[i] + b[i] + c[i]. The sums of BleedAlpha are at most 9 * 255, so they fit.
+	void AddThree(const unsigned short *a, const unsigned short *b, const unsigned short *c, unsigned short *out, size_t n)
+	{
+		size_t i = 0;
+#if defined(__SSE2__)
+		for(; i + 8 <= n; i += 8)
+		{
+			__m128i sum = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+			sum = _mm_add_epi16(sum, _mm_loadu_si128((const __m128i*)(c + i)));
+			_mm_storeu_si128((__m128i*)(out + i), sum);
+		}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+		for(; i + 8 <= n; i += 8)
+			vst1q_u16(out + i, vaddq_u16(vaddq_u16(vld1q_u16(a + i), vld1q_u16(b + i)), vld1q_u16(c + i)));
+#endif
+		for(; i < n; ++i)
+			out[i] = (unsigned short)(a[i] + b[i] + c[i]);
+	}
+
+	/// A pixel that a pass of BleedAlpha gives a color.
+	struct BledPixel
+	{
+		int x;
+		int y;
+		unsigned char color[3];
+	};
+
+	struct FrameMarginFiller
+	{
+		const std::vector<TPRect> *rects;
+		int margin;
+		int extrude;
+		int bleedPasses;
+		RGBAImage *atlas;
+
+		void operator()(int i)
+		{
+			const TPRect &rect = (*rects)[i];
+			if (extrude > 0)
+			{
+				TPRect frame = rect;
+				frame.x += margin;
+				frame.y += margin;
+				frame.width -= margin * 2;
+				frame.height -= margin * 2;
+				ExtrudeFrame(*atlas, frame, extrude);
+			}
+			if (bleedPasses > 0)
+				BleedAlpha(*atlas, rect, bleedPasses);
+		}
+	};
+}
+
+void ExtrudeFrame(RGBAImage &atlas, const TPRect &frame, int extrude)
+{
+	if (extrude <= 0 || frame.width <= 0 || frame.height <= 0)
+		return;
+
+	// Repeat the left and right columns, then the top and bottom rows including the new corners
+	for(int y = 0; y < frame.height; ++y)
+	{
+		unsigned char *left = atlas.Row(frame.y + y) + frame.x*4;
+		unsigned char *right = left + (frame.width - 1)*4;
+		for(int i = 1; i <= extrude; ++i)
+		{
+			memcpy(left - i*4, left, 4);
+			memcpy(right + i*4, right, 4);
+		}
+	}
+
+	int x = frame.x - extrude;
+	size_t rowSize = (size_t)(frame.width + extrude*2) * 4;
+	for(int i = 1; i <= extrude; ++i)
+	{
+		memcpy(atlas.Row(frame.y - i) + x*4, atlas.Row(frame.y) + x*4, rowSize);
+		memcpy(atlas.Row(frame.y + frame.height - 1 + i) + x*4, atlas.Row(frame.y + frame.height - 1) + x*4, rowSize);
+	}
+}
+
+void BleedAlpha(RGBAImage &atlas, const TPRect &rect, int passes)
+{
+	if (rect.width <= 0 || rect.height <= 0)
+		return;
+
+	// Every pixel of the rectangle holds its color and a weight of 1 if it has a color, or all zeros
+	// if it is transparent, with a row and column of zeros around the rectangle. The 3x3 box sums of
+	// this give the summed colors and the number of colored neighbours of each pixel.
+	int stride = (rect.width + 2) * 4;
+	std::vector<unsigned short> weighted((size_t)stride * (rect.height + 2), 0);
+	for(int y = 0; y < rect.height; ++y)
+	{
+		const unsigned char *p = atlas.Row(rect.y + y) + rect.x*4;
+		unsigned short *w = &weighted[(size_t)(y + 1) * stride + 4];
+		for(int x = 0; x < rect.width; ++x, p += 4, w += 4)
+			if (p[3])
+			{
+				w[0] = p[0];
+				w[1] = p[1];
+				w[2] = p[2];
+				w[3] = 1;
+			}
+	}
+
+	int rowSize = rect.width * 4;
+	std::vector<unsigned short> rowSums((size_t)rowSize * (rect.height + 2), 0);
+	std::vector<unsigned short> boxSums(rowSize);
+	std::vector<BledPixel> bled;
+
+	for(int pass = 0; pass < passes; ++pass)
+	{
+		for(int y = 0; y < rect.height; ++y)
+		{
+			const unsigned short *w = &weighted[(size_t)(y + 1) * stride];
+			AddThree(w, w + 4, w + 8, &rowSums[(size_t)(y + 1) * rowSize], rowSize);
+		}
+
+		bled.clear();
+		for(int y = 0; y < rect.height; ++y)
+		{
+			const unsigned short *sums = &rowSums[(size_t)y * rowSize];
+			AddThree(sums, sums + rowSize, sums + rowSize*2, &boxSums[0], rowSize);
+
+			const unsigned short *w = &weighted[(size_t)(y + 1) * stride + 4];
+			for(int x = 0; x < rect.width; ++x)
+			{
+				const unsigned short *sum = &boxSums[x*4];
+				int count = sum[3];
+				if (w[x*4 + 3] || !count)
+					continue;
+
+				BledPixel pixel;
+				pixel.x = x;
+				pixel.y = y;
+				for(int c = 0; c < 3; ++c)
+					pixel.color[c] = (unsigned char)((sum[c] + count/2) / count);
+				bled.push_back(pixel);
+			}
+		}
+
+		if (bled.empty())
+			break;
+
+		// Only the pixels colored in earlier passes count as neighbours, so apply the colors afterwards
+		for(size_t i = 0; i < bled.size(); ++i)
+		{
+			const BledPixel &pixel = bled[i];
+			unsigned char *p = atlas.Row(rect.y + pixel.y) + (rect.x + pixel.x)*4;
+			unsigned short *w = &weighted[(size_t)(pixel.y + 1) * stride + (pixel.x + 1)*4];
+			for(int c = 0; c < 3; ++c)
+			{
+				p[c] = pixel.color[c];
+				w[c] = pixel.color[c];
+			}
+			w[3] = 1;
+		}
+	}
+}
+
+void FillFrameMargins(const std::vector<TPRect> &rects, int margin, int extrude, int bleedPasses, RGBAImage &atlas, int numThreads)
+{
+	FrameMarginFiller filler = { &rects, margin, extrude, bleedPasses, &atlas };
+	ParallelFor((int)rects.size(), filler, numThreads);
+}
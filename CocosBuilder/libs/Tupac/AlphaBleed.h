@@ -0,0 +1,31 @@
+/** @file AlphaBleed.h
+
+	@brief Fills the margins around the frames of a sprite sheet, so that bilinear filtering does not
+	blend the edges of the frames with black.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "AtlasCompositor.h"
+
+/// Repeats the outermost pixels of a frame outwards, including their alpha.
+/// @param frame The rectangle the frame was drawn into.
+/// @param extrude The number of pixels to repeat the edges by. There must be that many pixels of room
+///   around the frame.
+void ExtrudeFrame(RGBAImage &atlas, const TPRect &frame, int extrude);
+
+/// Gives transparent pixels the average color of their neighbours that are not transparent, spreading
+/// outwards by one pixel per pass. Alpha is not changed, so the pixels stay transparent.
+/// @param rect The part of the atlas to work in. Pixels outside of it are neither read nor written.
+void BleedAlpha(RGBAImage &atlas, const TPRect &rect, int passes);
+
+/// Extrudes and bleeds every packed frame of an atlas, the frames in parallel.
+/// @param rects The packed rectangles, as passed to ComposeAtlas.
+/// @param margin The distance from the edges of each rectangle to its frame.
+/// @param extrude The number of pixels to extrude the frames by, at most margin.
+/// @param bleedPasses The number of passes of BleedAlpha over each rectangle, or 0 to not bleed.
+/// @param numThreads The largest number of threads to use, or 0 to use all processors.
+void FillFrameMargins(const std::vector<TPRect> &rects, int margin, int extrude, int bleedPasses, RGBAImage &atlas, int numThreads = 0);
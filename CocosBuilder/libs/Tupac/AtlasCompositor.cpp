@@ -0,0 +1,269 @@
+/** @file AtlasCompositor.cpp
+
+	@brief Platform independent pixel operations used to build sprite sheets: trimming transparent
+	borders and drawing the packed frames into the atlas texture.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "AtlasCompositor.h"
+
+namespace
+{
+	/// The size of the square tiles BlitImageRotated works in. A tile of source rows and one of
+	/// destination rows both stay in the cache while the tile is transposed.
+	const int RotateTileSize = 16;
+
+	// BlockHasAlpha tests AlphaBlockSize consecutive pixels at once for a non-zero alpha. Read as a
+	// little endian 32 bit word, the alpha of an RGBA pixel is the high byte.
+#if defined(__AVX2__)
+	const int AlphaBlockSize = 8;
+
+	inline bool BlockHasAlpha(const unsigned char *pixels)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)pixels);
+		return !_mm256_testz_si256(v, _mm256_set1_epi32((int)0xFF000000));
+	}
+#elif defined(__SSE2__)
+	const int AlphaBlockSize = 4;
+
+	inline bool BlockHasAlpha(const unsigned char *pixels)
+	{
+		__m128i alpha = _mm_and_si128(_mm_loadu_si128((const __m128i*)pixels), _mm_set1_epi32((int)0xFF000000));
+		return _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) != 0xFFFF;
+	}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	const int AlphaBlockSize = 4;
+
+	inline bool BlockHasAlpha(const unsigned char *pixels)
+	{
+		uint32x4_t alpha = vandq_u32(vreinterpretq_u32_u8(vld1q_u8(pixels)), vdupq_n_u32(0xFF000000));
+		uint32x2_t any = vorr_u32(vget_low_u32(alpha), vget_high_u32(alpha));
+		return (vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) != 0;
+	}
+#else
+	const int AlphaBlockSize = 1;
+
+	inline bool BlockHasAlpha(const unsigned char *pixels)
+	{
+		return pixels[3] != 0;
+	}
+#endif
+
+	/// Returns the 64 bit FNV-1a hash of the trimmed pixels of a frame.
+	uint64_t HashFrame(const AtlasFrame &frame)
+	{
+		const TPRect &r = frame.trimRect;
+		uint64_t hash = 14695981039346656037ULL;
+
+		uint32_t size[2] = { (uint32_t)r.width, (uint32_t)r.height };
+		const unsigned char *sizeBytes = (const unsigned char*)size;
+		for(size_t i = 0; i < sizeof(size); ++i)
+			hash = (hash ^ sizeBytes[i]) * 1099511628211ULL;
+
+		for(int y = 0; y < r.height; ++y)
+		{
+			const unsigned char *p = frame.image->Row(r.y + y) + r.x*4;
+			const unsigned char *end = p + r.width*4;
+			for(; p != end; ++p)
+				hash = (hash ^ *p) * 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	bool FramesEqual(const AtlasFrame &a, const AtlasFrame &b)
+	{
+		if (a.trimRect.width != b.trimRect.width || a.trimRect.height != b.trimRect.height)
+			return false;
+
+		for(int y = 0; y < a.trimRect.height; ++y)
+			if (memcmp(a.image->Row(a.trimRect.y + y) + a.trimRect.x*4,
+				b.image->Row(b.trimRect.y + y) + b.trimRect.x*4, (size_t)a.trimRect.width * 4) != 0)
+				return false;
+		return true;
+	}
+}
+
+int FirstOpaquePixel(const unsigned char *row, int begin, int end)
+{
+	int x = begin;
+	while(x + AlphaBlockSize <= end && !BlockHasAlpha(row + x*4))
+		x += AlphaBlockSize;
+	while(x < end && row[x*4 + 3] == 0)
+		++x;
+	return x;
+}
+
+int LastOpaquePixel(const unsigned char *row, int begin, int end)
+{
+	int x = end;
+	while(x - AlphaBlockSize >= begin && !BlockHasAlpha(row + (x - AlphaBlockSize)*4))
+		x -= AlphaBlockSize;
+	while(x > begin && row[(x-1)*4 + 3] == 0)
+		--x;
+	return x - 1;
+}
+
+void RGBAImage::Init(int width_, int height_)
+{
+	width = width_;
+	height = height_;
+	pixels.assign((size_t)width * height * 4, 0);
+}
+
+TPRect TrimmedRect(const RGBAImage &image)
+{
+	int left = image.width;
+	int right = -1;
+	int top = 0;
+	int bottom = -1;
+
+	// Find all four bounds in one pass over the rows. Once a row with an opaque pixel has been found,
+	// only the pixels left and right of the bounds found so far can widen them, and the pixels between
+	// the bounds only need to be searched up to the first opaque one to tell whether the row moves the
+	// bottom bound.
+	for(int y = 0; y < image.height; ++y)
+	{
+		const unsigned char *row = image.Row(y);
+
+		if (right < 0)
+		{
+			int first = FirstOpaquePixel(row, 0, image.width);
+			if (first == image.width)
+				continue;
+
+			left = first;
+			right = LastOpaquePixel(row, first, image.width);
+			top = bottom = y;
+			continue;
+		}
+
+		bool opaque = false;
+
+		int first = FirstOpaquePixel(row, 0, left);
+		if (first < left)
+		{
+			left = first;
+			opaque = true;
+		}
+
+		int last = LastOpaquePixel(row, right + 1, image.width);
+		if (last > right)
+		{
+			right = last;
+			opaque = true;
+		}
+
+		if (opaque || FirstOpaquePixel(row, left, right + 1) <= right)
+			bottom = y;
+	}
+
+	TPRect r;
+	memset(&r, 0, sizeof(TPRect));
+	r.width = 1;
+	r.height = 1;
+
+	if (right < 0)
+		return r;
+
+	r.x = left;
+	r.y = top;
+	r.width = right - left + 1;
+	r.height = bottom - top + 1;
+	return r;
+}
+
+void FindDuplicateFrames(const std::vector<AtlasFrame> &frames, std::vector<int> &original)
+{
+	original.resize(frames.size());
+
+	// The frames seen so far that are not duplicates, by the hash of their pixels. Frames with equal hashes
+	// are compared pixel by pixel, so hash collisions never merge different frames.
+	typedef std::map<uint64_t, std::vector<int> > FrameMap;
+	FrameMap uniqueFrames;
+
+	for(size_t i = 0; i < frames.size(); ++i)
+	{
+		std::vector<int> &candidates = uniqueFrames[HashFrame(frames[i])];
+
+		original[i] = (int)i;
+		for(size_t j = 0; j < candidates.size(); ++j)
+			if (FramesEqual(frames[candidates[j]], frames[i]))
+			{
+				original[i] = candidates[j];
+				break;
+			}
+
+		if (original[i] == (int)i)
+			candidates.push_back((int)i);
+	}
+}
+
+void BlitImage(const RGBAImage &src, int srcX, int srcY, int width, int height, RGBAImage &dst, int dstX, int dstY)
+{
+	for(int y = 0; y < height; ++y)
+		memcpy(dst.Row(dstY + y) + dstX*4, src.Row(srcY + y) + srcX*4, (size_t)width * 4);
+}
+
+void BlitImageRotated(const RGBAImage &src, int srcX, int srcY, int width, int height, RGBAImage &dst, int dstX, int dstY)
+{
+	// Rotating clockwise moves the source pixel at (x, y) to (height-1-y, x) in the destination block.
+	for(int tileY = 0; tileY < height; tileY += RotateTileSize)
+		for(int tileX = 0; tileX < width; tileX += RotateTileSize)
+		{
+			int tileBottom = std::min(tileY + RotateTileSize, height);
+			int tileRight = std::min(tileX + RotateTileSize, width);
+
+			for(int x = tileX; x < tileRight; ++x)
+			{
+				unsigned char *dstRow = dst.Row(dstY + x) + dstX*4;
+				for(int y = tileY; y < tileBottom; ++y)
+					memcpy(dstRow + (height-1-y)*4, src.Row(srcY + y) + (srcX + x)*4, 4);
+			}
+		}
+}
+
+void ComposeAtlas(const std::vector<AtlasFrame> &frames, const std::vector<TPRect> &rects, int padding, RGBAImage &atlas)
+{
+	for(size_t i = 0; i < rects.size(); ++i)
+	{
+		const AtlasFrame &frame = frames[rects[i].idx];
+		const TPRect &trim = frame.trimRect;
+
+		int x = rects[i].x + padding;
+		int y = rects[i].y + padding;
+
+		if (rects[i].rotated)
+			BlitImageRotated(*frame.image, trim.x, trim.y, trim.width, trim.height, atlas, x, y);
+		else
+			BlitImage(*frame.image, trim.x, trim.y, trim.width, trim.height, atlas, x, y);
+	}
+}
+
+void PremultiplyAlpha(RGBAImage &image)
+{
+	for(size_t i = 0; i < image.pixels.size(); i += 4)
+	{
+		unsigned char *p = &image.pixels[i];
+		int a = p[3];
+		if (a == 255)
+			continue;
+		for(int c = 0; c < 3; ++c)
+		{
+			int x = p[c] * a + 128;
+			p[c] = (unsigned char)((x + (x >> 8)) >> 8);
+		}
+	}
+}
@@ -0,0 +1,74 @@
+/** @file AtlasCompositor.h
+
+	@brief Platform independent pixel operations used to build sprite sheets: trimming transparent
+	borders and drawing the packed frames into the atlas texture.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "Rect.h"
+
+/// An 8 bit per channel RGBA image. Rows are stored top to bottom, without padding, and the color
+/// channels are not premultiplied by alpha.
+struct RGBAImage
+{
+	int width;
+	int height;
+	std::vector<unsigned char> pixels;
+
+	RGBAImage() : width(0), height(0) {}
+
+	/// Resizes the image to width x height and clears all pixels to transparent black.
+	void Init(int width, int height);
+
+	unsigned char *Row(int y) { return &pixels[(size_t)y * width * 4]; }
+	const unsigned char *Row(int y) const { return &pixels[(size_t)y * width * 4]; }
+};
+
+/// A frame to draw into a sprite sheet.
+struct AtlasFrame
+{
+	/// The source image of the frame.
+	const RGBAImage *image;
+
+	/// The part of the source image that is drawn, as returned by TrimmedRect.
+	TPRect trimRect;
+};
+
+/// Returns the first pixel in [begin, end) of a row that is not fully transparent, or end if there is none.
+int FirstOpaquePixel(const unsigned char *row, int begin, int end);
+
+/// Returns the last pixel in [begin, end) of a row that is not fully transparent, or begin-1 if there is none.
+int LastOpaquePixel(const unsigned char *row, int begin, int end);
+
+/// Finds the smallest rectangle that contains all pixels of the image that are not fully transparent.
+/// A fully transparent image is trimmed to its top left pixel.
+TPRect TrimmedRect(const RGBAImage &image);
+
+/// Finds frames whose trimmed pixels are identical to those of another frame, so they only need to be
+/// drawn into the sprite sheet once.
+/// @param original [out] For each frame, the index of the first frame with the same trimmed size and
+///   pixels. This is the frame's own index if no earlier frame matches it.
+void FindDuplicateFrames(const std::vector<AtlasFrame> &frames, std::vector<int> &original);
+
+/// Copies a width x height block of pixels from src at (srcX, srcY) to dst at (dstX, dstY).
+void BlitImage(const RGBAImage &src, int srcX, int srcY, int width, int height, RGBAImage &dst, int dstX, int dstY);
+
+/// Copies a width x height block of pixels from src at (srcX, srcY) to dst at (dstX, dstY), rotated by
+/// 90 degrees clockwise, so the block takes up height x width pixels in dst. This is the orientation
+/// cocos2d expects for frames that are marked as rotated.
+void BlitImageRotated(const RGBAImage &src, int srcX, int srcY, int width, int height, RGBAImage &dst, int dstX, int dstY);
+
+/// Draws packed frames into an atlas.
+/// @param frames The frames, indexed by the TPRect::idx of the packed rectangles.
+/// @param rects The packed rectangles. Each is the trimmed size of its frame plus padding on all sides,
+///   with width and height swapped if it is rotated.
+/// @param padding The number of transparent pixels around each frame.
+/// @param atlas [out] The atlas, which must already have its final size.
+void ComposeAtlas(const std::vector<AtlasFrame> &frames, const std::vector<TPRect> &rects, int padding, RGBAImage &atlas);
+
+/// Multiplies the color channels of every pixel by its alpha, rounding to the closest value.
+void PremultiplyAlpha(RGBAImage &image);
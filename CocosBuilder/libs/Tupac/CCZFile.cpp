@@ -0,0 +1,275 @@
+/** @file CCZFile.cpp
+
+	@brief Reads and writes ccz files, the zlib compressed container cocos2d loads textures from: a
+	"CCZ!" header followed by a zlib stream.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include <zlib.h>
+
+#include "CCZFile.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	/// The size of the header: the signature, the compression type, the version, a reserved field and
+	/// the uncompressed size, all stored big endian.
+	const size_t CCZHeaderSize = 16;
+
+	const unsigned short CCZCompressionZlib = 0;
+	const unsigned short CCZVersion = 2;
+
+	/// The size of the buffers data is streamed through.
+	const size_t StreamBufferSize = 64 * 1024;
+
+	/// The size of the blocks that are deflated concurrently. Every block but the first is primed with
+	/// the preceding window of data, so splitting costs little compression.
+	const size_t DeflateBlockSize = 128 * 1024;
+	const size_t DeflateWindowSize = 32 * 1024;
+
+	void WriteBigEndian(unsigned char *p, unsigned int v, int numBytes)
+	{
+		for(int i = 0; i < numBytes; ++i)
+			p[i] = (unsigned char)(v >> (8 * (numBytes - 1 - i)));
+	}
+
+	unsigned int ReadBigEndian(const unsigned char *p, int numBytes)
+	{
+		unsigned int v = 0;
+		for(int i = 0; i < numBytes; ++i)
+			v = (v << 8) | p[i];
+		return v;
+	}
+
+	void EncodeHeader(size_t size, unsigned char *header)
+	{
+		memcpy(header, "CCZ!", 4);
+		WriteBigEndian(header + 4, CCZCompressionZlib, 2);
+		WriteBigEndian(header + 6, CCZVersion, 2);
+		WriteBigEndian(header + 8, 0, 4);
+		WriteBigEndian(header + 12, (unsigned int)size, 4);
+	}
+
+	/// @return The uncompressed size, or -1 if the header is not that of a zlib compressed ccz file.
+	long DecodeHeader(const unsigned char *header)
+	{
+		if (memcmp(header, "CCZ!", 4) != 0)
+			return -1;
+		if (ReadBigEndian(header + 4, 2) != CCZCompressionZlib || ReadBigEndian(header + 6, 2) > CCZVersion)
+			return -1;
+		return (long)ReadBigEndian(header + 12, 4);
+	}
+
+	/// Deflates the data as a single zlib stream, writing it to the file as it is produced.
+	bool WriteDeflated(FILE *file, const unsigned char *data, size_t size, int compressionLevel)
+	{
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		if (deflateInit(&stream, compressionLevel) != Z_OK)
+			return false;
+
+		std::vector<unsigned char> buffer(StreamBufferSize);
+		stream.next_in = (Bytef*)data;
+		stream.avail_in = (uInt)size;
+
+		bool ok = true;
+		int result;
+		do
+		{
+			stream.next_out = &buffer[0];
+			stream.avail_out = (uInt)buffer.size();
+			result = deflate(&stream, Z_FINISH);
+
+			size_t produced = buffer.size() - stream.avail_out;
+			if (result == Z_STREAM_ERROR || fwrite(&buffer[0], 1, produced, file) != produced)
+				ok = false;
+		}
+		while(ok && result != Z_STREAM_END);
+
+		deflateEnd(&stream);
+		return ok;
+	}
+
+	/// Deflates the blocks of the data independently, as raw deflate data that can be concatenated.
+	struct DeflateBlocks
+	{
+		const unsigned char *data;
+		size_t size;
+		int compressionLevel;
+		std::vector<std::vector<unsigned char> > blocks;
+		std::vector<uLong> checksums;
+		volatile bool failed;
+
+		void operator()(int i)
+		{
+			size_t begin = i * DeflateBlockSize;
+			size_t length = std::min(DeflateBlockSize, size - begin);
+			bool last = (begin + length == size);
+
+			z_stream stream;
+			memset(&stream, 0, sizeof(stream));
+			if (deflateInit2(&stream, compressionLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			{
+				failed = true;
+				return;
+			}
+
+			if (begin > 0)
+			{
+				size_t window = std::min(begin, DeflateWindowSize);
+				deflateSetDictionary(&stream, data + begin - window, (uInt)window);
+			}
+
+			// A sync flush ends every block but the last on a byte boundary, so the blocks can be joined
+			std::vector<unsigned char> &block = blocks[i];
+			block.resize(deflateBound(&stream, (uLong)length) + 16);
+			stream.next_in = (Bytef*)data + begin;
+			stream.avail_in = (uInt)length;
+			stream.next_out = &block[0];
+			stream.avail_out = (uInt)block.size();
+
+			int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+			if ((last && result != Z_STREAM_END) || (!last && (result != Z_OK || stream.avail_in != 0)))
+				failed = true;
+
+			block.resize(block.size() - stream.avail_out);
+			checksums[i] = adler32(adler32(0, 0, 0), data + begin, (uInt)length);
+			deflateEnd(&stream);
+		}
+	};
+
+	/// Deflates the data in blocks on several threads and writes them to the file as one zlib stream.
+	bool WriteDeflatedConcurrently(FILE *file, const unsigned char *data, size_t size, int compressionLevel, int numThreads)
+	{
+		int numBlocks = (int)((size + DeflateBlockSize - 1) / DeflateBlockSize);
+
+		DeflateBlocks deflater;
+		deflater.data = data;
+		deflater.size = size;
+		deflater.compressionLevel = compressionLevel;
+		deflater.blocks.resize(numBlocks);
+		deflater.checksums.resize(numBlocks);
+		deflater.failed = false;
+		ParallelFor(numBlocks, deflater, numThreads);
+
+		if (deflater.failed)
+			return false;
+
+		// The zlib header for a 32K window, with the compression level hint zlib would write
+		unsigned char header[2] = { 0x78, 0x9C };
+		if (compressionLevel >= 0 && compressionLevel < 2)
+			header[1] = 0x01;
+		else if (compressionLevel >= 2 && compressionLevel < 6)
+			header[1] = 0x5E;
+		else if (compressionLevel > 6)
+			header[1] = 0xDA;
+
+		uLong checksum = adler32(0, 0, 0);
+		bool ok = fwrite(header, 1, 2, file) == 2;
+		for(int i = 0; i < numBlocks && ok; ++i)
+		{
+			const std::vector<unsigned char> &block = deflater.blocks[i];
+			ok = fwrite(&block[0], 1, block.size(), file) == block.size();
+
+			size_t length = std::min(DeflateBlockSize, size - i * DeflateBlockSize);
+			checksum = adler32_combine(checksum, deflater.checksums[i], (z_off_t)length);
+		}
+
+		unsigned char trailer[4];
+		WriteBigEndian(trailer, (unsigned int)checksum, 4);
+		return ok && fwrite(trailer, 1, 4, file) == 4;
+	}
+}
+
+bool SaveCCZ(const char *filename, const unsigned char *data, size_t size, int compressionLevel, int numThreads)
+{
+	FILE *file = fopen(filename, "wb");
+	if (!file)
+		return false;
+
+	unsigned char header[CCZHeaderSize];
+	EncodeHeader(size, header);
+	bool ok = fwrite(header, 1, CCZHeaderSize, file) == CCZHeaderSize;
+
+	if (ok)
+	{
+		if (numThreads > 1 && size > DeflateBlockSize)
+			ok = WriteDeflatedConcurrently(file, data, size, compressionLevel, numThreads);
+		else
+			ok = WriteDeflated(file, data, size, compressionLevel);
+	}
+
+	return fclose(file) == 0 && ok;
+}
+
+bool DecodeCCZ(const unsigned char *ccz, size_t size, std::vector<unsigned char> &data)
+{
+	if (size < CCZHeaderSize)
+		return false;
+
+	long length = DecodeHeader(ccz);
+	if (length < 0)
+		return false;
+
+	// zlib rejects a null output buffer even when there is nothing to inflate into it.
+	unsigned char empty;
+	data.resize(length);
+	uLongf dataLength = (uLongf)length;
+	if (uncompress(length > 0 ? &data[0] : &empty, &dataLength, ccz + CCZHeaderSize, (uLong)(size - CCZHeaderSize)) != Z_OK)
+		return false;
+
+	return dataLength == (uLongf)length;
+}
+
+bool LoadCCZ(const char *filename, std::vector<unsigned char> &data)
+{
+	FILE *file = fopen(filename, "rb");
+	if (!file)
+		return false;
+
+	unsigned char header[CCZHeaderSize];
+	long length = -1;
+	if (fread(header, 1, CCZHeaderSize, file) == CCZHeaderSize)
+		length = DecodeHeader(header);
+	if (length < 0)
+	{
+		fclose(file);
+		return false;
+	}
+
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (inflateInit(&stream) != Z_OK)
+	{
+		fclose(file);
+		return false;
+	}
+
+	unsigned char empty;
+	data.resize(length);
+	stream.next_out = length > 0 ? &data[0] : &empty;
+	stream.avail_out = (uInt)length;
+
+	std::vector<unsigned char> buffer(StreamBufferSize);
+	int result = Z_OK;
+	while(result == Z_OK)
+	{
+		if (stream.avail_in == 0)
+		{
+			stream.avail_in = (uInt)fread(&buffer[0], 1, buffer.size(), file);
+			stream.next_in = &buffer[0];
+			if (stream.avail_in == 0)
+				break;
+		}
+		result = inflate(&stream, Z_NO_FLUSH);
+	}
+
+	bool ok = (result == Z_STREAM_END && stream.total_out == (uLong)length);
+	inflateEnd(&stream);
+	fclose(file);
+	return ok;
+}
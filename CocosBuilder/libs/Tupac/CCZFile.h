@@ -0,0 +1,28 @@
+/** @file CCZFile.h
+
+	@brief Reads and writes ccz files, the zlib compressed container cocos2d loads textures from: a
+	"CCZ!" header followed by a zlib stream.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+/// Compresses data and writes it to a ccz file. The compressed data goes straight to the file, without
+/// an intermediate copy of the whole file in memory.
+/// @param compressionLevel The zlib compression level, from 0 (none) to 9 (best).
+/// @param numThreads The number of threads to compress with. With more than one thread the data is split
+///   into blocks that are deflated concurrently and joined into one zlib stream, which makes the file a
+///   little larger.
+/// @return False if the file could not be written.
+bool SaveCCZ(const char *filename, const unsigned char *data, size_t size, int compressionLevel = 9, int numThreads = 1);
+
+/// Decodes a ccz file held in memory.
+/// @return False if the data is not a valid zlib compressed ccz file.
+bool DecodeCCZ(const unsigned char *ccz, size_t size, std::vector<unsigned char> &data);
+
+/// Reads and decodes a ccz file, inflating it while it is read.
+/// @return False if the file cannot be read or is not a valid zlib compressed ccz file.
+bool LoadCCZ(const char *filename, std::vector<unsigned char> &data);
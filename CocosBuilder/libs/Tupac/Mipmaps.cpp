@@ -0,0 +1,283 @@
+/** @file Mipmaps.cpp
+
+	@brief Computes the mipmap levels of sprite sheets.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "Mipmaps.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	/// Premultiplied red, green and blue in linear light, and alpha, all from 0 to 1.
+#if defined(__SSE2__)
+	typedef __m128 LinearPixel;
+
+	inline LinearPixel Zero() { return _mm_setzero_ps(); }
+	inline LinearPixel Load(const float *p) { return _mm_loadu_ps(p); }
+	inline void Store(float *p, LinearPixel v) { _mm_storeu_ps(p, v); }
+	inline LinearPixel MultiplyAdd(LinearPixel sum, LinearPixel v, float weight) { return _mm_add_ps(sum, _mm_mul_ps(v, _mm_set1_ps(weight))); }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	typedef float32x4_t LinearPixel;
+
+	inline LinearPixel Zero() { return vdupq_n_f32(0); }
+	inline LinearPixel Load(const float *p) { return vld1q_f32(p); }
+	inline void Store(float *p, LinearPixel v) { vst1q_f32(p, v); }
+	inline LinearPixel MultiplyAdd(LinearPixel sum, LinearPixel v, float weight) { return vmlaq_n_f32(sum, v, weight); }
+#else
+	struct LinearPixel
+	{
+		float v[4];
+	};
+
+	inline LinearPixel Zero() { LinearPixel p = { { 0, 0, 0, 0 } }; return p; }
+	inline LinearPixel Load(const float *p) { LinearPixel v = { { p[0], p[1], p[2], p[3] } }; return v; }
+	inline void Store(float *p, LinearPixel v) { for(int i = 0; i < 4; ++i) p[i] = v.v[i]; }
+	inline LinearPixel MultiplyAdd(LinearPixel sum, LinearPixel v, float weight)
+	{
+		for(int i = 0; i < 4; ++i)
+			sum.v[i] += v.v[i] * weight;
+		return sum;
+	}
+#endif
+
+	/// The number of entries of the table that converts linear light to sRGB.
+	const int LinearSteps = 4096;
+
+	/// Conversions between sRGB and linear light, by table.
+	class ColorSpace
+	{
+	public:
+		ColorSpace()
+		{
+			for(int i = 0; i < 256; ++i)
+			{
+				double c = i / 255.0;
+				toLinear[i] = (float)((c <= 0.04045) ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+			}
+			for(int i = 0; i < LinearSteps; ++i)
+			{
+				double c = i / (double)(LinearSteps - 1);
+				double s = (c <= 0.0031308) ? c * 12.92 : 1.055 * pow(c, 1 / 2.4) - 0.055;
+				toSRGB[i] = (unsigned char)(s * 255 + 0.5);
+			}
+		}
+
+		float ToLinear(unsigned char c) const
+		{
+			return toLinear[c];
+		}
+
+		unsigned char ToSRGB(float c) const
+		{
+			int i = (int)(c * (LinearSteps - 1) + 0.5f);
+			return toSRGB[std::max(0, std::min(i, LinearSteps - 1))];
+		}
+
+	private:
+		float toLinear[256];
+		unsigned char toSRGB[LinearSteps];
+	};
+
+	/// The modified Bessel function of the first kind of order 0, for the Kaiser window.
+	double BesselI0(double x)
+	{
+		double sum = 1, term = 1;
+		for(int k = 1; k < 32 && term > sum * 1e-12; ++k)
+		{
+			term *= (x / (2 * k)) * (x / (2 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	/// The weights of the source pixels along one axis. A destination pixel d is filtered from the
+	/// source pixels 2*d + first to 2*d + first + count - 1.
+	struct Kernel
+	{
+		int first;
+		int count;
+		float weights[6];
+	};
+
+	Kernel MakeKernel(MipmapFilter filter)
+	{
+		Kernel kernel;
+		if (filter == MipmapFilterBox)
+		{
+			kernel.first = 0;
+			kernel.count = 2;
+			kernel.weights[0] = kernel.weights[1] = 0.5f;
+			return kernel;
+		}
+
+		// A sinc at the cutoff of the smaller level, windowed to 3 pixels of it with alpha = 4
+		const double width = 1.5, alpha = 4;
+		kernel.first = -2;
+		kernel.count = 6;
+		double sum = 0, weights[6];
+		for(int i = 0; i < kernel.count; ++i)
+		{
+			double t = (i - 2.5) / 2;
+			double sinc = sin(M_PI * t) / (M_PI * t);
+			double x = t / width;
+			weights[i] = sinc * BesselI0(alpha * sqrt(1 - x*x)) / BesselI0(alpha);
+			sum += weights[i];
+		}
+		for(int i = 0; i < kernel.count; ++i)
+			kernel.weights[i] = (float)(weights[i] / sum);
+		return kernel;
+	}
+
+	/// One level of the mipmap chain, in linear light.
+	struct LinearImage
+	{
+		int width;
+		int height;
+		std::vector<float> pixels;
+
+		const float *Pixel(int x, int y) const
+		{
+			return &pixels[((size_t)y * width + x) * 4];
+		}
+	};
+
+	/// The index of the region covering each pixel of the base image, or -1.
+	struct RegionMap
+	{
+		int width;
+		int height;
+		std::vector<int> regions;
+	};
+
+	struct LinearConverter
+	{
+		const RGBAImage *image;
+		const ColorSpace *colorSpace;
+		LinearImage *linear;
+
+		void operator()(int y)
+		{
+			const unsigned char *p = image->Row(y);
+			float *out = &linear->pixels[(size_t)y * image->width * 4];
+			for(int x = 0; x < image->width; ++x, p += 4, out += 4)
+			{
+				float alpha = p[3] / 255.0f;
+				for(int c = 0; c < 3; ++c)
+					out[c] = colorSpace->ToLinear(p[c]) * alpha;
+				out[3] = alpha;
+			}
+		}
+	};
+
+	struct Downsampler
+	{
+		const LinearImage *source;
+		const RegionMap *regionMap;
+		const std::vector<TPRect> *regions;
+		const Kernel *kernel;
+		const ColorSpace *colorSpace;
+		LinearImage *linear;
+		RGBAImage *level;
+
+		void operator()(int y)
+		{
+			// The sizes of the pixels of both levels, in pixels of the base image
+			int sourceScaleX = regionMap->width / source->width, sourceScaleY = regionMap->height / source->height;
+			int scaleX = regionMap->width / linear->width, scaleY = regionMap->height / linear->height;
+
+			float *out = &linear->pixels[(size_t)y * linear->width * 4];
+			unsigned char *p = level->Row(y);
+			for(int x = 0; x < linear->width; ++x, out += 4, p += 4)
+			{
+				// Clamp the filter to the source pixels of the region the center of the pixel lies in
+				int minX = 0, minY = 0, maxX = source->width - 1, maxY = source->height - 1;
+				int region = regionMap->regions[(size_t)(y * scaleY + scaleY/2) * regionMap->width + x * scaleX + scaleX/2];
+				if (region >= 0)
+				{
+					const TPRect &rect = (*regions)[region];
+					minX = rect.x / sourceScaleX;
+					minY = rect.y / sourceScaleY;
+					maxX = std::max(minX, (rect.x + rect.width + sourceScaleX - 1) / sourceScaleX - 1);
+					maxY = std::max(minY, (rect.y + rect.height + sourceScaleY - 1) / sourceScaleY - 1);
+				}
+
+				LinearPixel sum = Zero();
+				for(int j = 0; j < kernel->count; ++j)
+				{
+					int sy = std::max(minY, std::min(y*2 + kernel->first + j, maxY));
+					LinearPixel row = Zero();
+					for(int i = 0; i < kernel->count; ++i)
+					{
+						int sx = std::max(minX, std::min(x*2 + kernel->first + i, maxX));
+						row = MultiplyAdd(row, Load(source->Pixel(sx, sy)), kernel->weights[i]);
+					}
+					sum = MultiplyAdd(sum, row, kernel->weights[j]);
+				}
+				Store(out, sum);
+
+				// The negative lobes of the Kaiser filter can overshoot, so clamp the colors
+				float alpha = std::max(0.0f, std::min(out[3], 1.0f));
+				for(int c = 0; c < 3; ++c)
+					p[c] = (alpha > 0) ? colorSpace->ToSRGB(out[c] / alpha) : 0;
+				p[3] = (unsigned char)(alpha * 255 + 0.5f);
+			}
+		}
+	};
+}
+
+void GenerateMipmaps(const RGBAImage &image, const std::vector<TPRect> &regions, MipmapFilter filter, std::vector<RGBAImage> &levels, int numThreads)
+{
+	static const ColorSpace colorSpace;
+	Kernel kernel = MakeKernel(filter);
+
+	RegionMap regionMap;
+	regionMap.width = image.width;
+	regionMap.height = image.height;
+	regionMap.regions.assign((size_t)image.width * image.height, -1);
+	for(size_t i = 0; i < regions.size(); ++i)
+	{
+		const TPRect &rect = regions[i];
+		for(int y = std::max(rect.y, 0); y < std::min(rect.y + rect.height, image.height); ++y)
+			for(int x = std::max(rect.x, 0); x < std::min(rect.x + rect.width, image.width); ++x)
+				regionMap.regions[(size_t)y * image.width + x] = (int)i;
+	}
+
+	// Each level is filtered from the linear light of the one before, so the rounding of the
+	// 8 bit levels does not add up
+	LinearImage source;
+	source.width = image.width;
+	source.height = image.height;
+	source.pixels.resize((size_t)image.width * image.height * 4);
+	LinearConverter converter = { &image, &colorSpace, &source };
+	ParallelFor(image.height, converter, numThreads);
+
+	levels.clear();
+	while(source.width > 1 || source.height > 1)
+	{
+		LinearImage linear;
+		linear.width = std::max(source.width / 2, 1);
+		linear.height = std::max(source.height / 2, 1);
+		linear.pixels.resize((size_t)linear.width * linear.height * 4);
+
+		levels.push_back(RGBAImage());
+		RGBAImage &level = levels.back();
+		level.Init(linear.width, linear.height);
+
+		Downsampler downsampler = { &source, &regionMap, &regions, &kernel, &colorSpace, &linear, &level };
+		ParallelFor(linear.height, downsampler, numThreads);
+
+		source.width = linear.width;
+		source.height = linear.height;
+		source.pixels.swap(linear.pixels);
+	}
+}
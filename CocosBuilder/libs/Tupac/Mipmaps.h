@@ -0,0 +1,28 @@
+/** @file Mipmaps.h
+
+	@brief Computes the mipmap levels of sprite sheets.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "AtlasCompositor.h"
+
+enum MipmapFilter
+{
+	MipmapFilterBox, ///< Averages 2x2 pixels. Fast, but a little blurry and prone to aliasing.
+	MipmapFilterKaiser ///< A Kaiser windowed sinc over 6x6 pixels, which keeps more detail.
+};
+
+/// Computes the mipmap levels of an image, from half its size down to 1x1.
+/// Colors are filtered in linear light and weighted by alpha, so thin opaque details neither darken
+/// nor disappear. Fully transparent pixels of the levels are black.
+/// @param image The image, with power of two sizes and colors not premultiplied by alpha.
+/// @param regions Rectangles of the image that are filtered separately, such as the packed rectangles
+///   of a sprite sheet. A pixel of a level is only filtered from the region its center lies in, so the
+///   frames don't bleed into each other. Pixels outside of all regions are filtered from the whole image.
+/// @param levels [out] The levels, largest first.
+/// @param numThreads The largest number of threads to use, or 0 to use all processors.
+void GenerateMipmaps(const RGBAImage &image, const std::vector<TPRect> &regions, MipmapFilter filter, std::vector<RGBAImage> &levels, int numThreads = 0);
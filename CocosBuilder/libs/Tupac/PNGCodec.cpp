@@ -0,0 +1,518 @@
+/** @file PNGCodec.cpp
+
+	@brief Reads and writes PNG files using zlib, without depending on the platform image libraries.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <zlib.h>
+
+#include "PNGCodec.h"
+
+namespace
+{
+	const unsigned char PNGSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	enum
+	{
+		ColorTypeGray = 0,
+		ColorTypeRGB = 2,
+		ColorTypePalette = 3,
+		ColorTypeGrayAlpha = 4,
+		ColorTypeRGBA = 6
+	};
+
+	/// The Adam7 interlacing passes: the first pixel and the distance between pixels of each pass.
+	const int Adam7StartX[7] = { 0, 4, 0, 2, 0, 1, 0 };
+	const int Adam7StartY[7] = { 0, 0, 4, 0, 2, 0, 1 };
+	const int Adam7StepX[7] = { 8, 8, 4, 4, 2, 2, 1 };
+	const int Adam7StepY[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+	unsigned int ReadUInt32(const unsigned char *p)
+	{
+		return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+	}
+
+	void WriteUInt32(unsigned char *p, unsigned int v)
+	{
+		p[0] = (unsigned char)(v >> 24);
+		p[1] = (unsigned char)(v >> 16);
+		p[2] = (unsigned char)(v >> 8);
+		p[3] = (unsigned char)v;
+	}
+
+	int PaethPredictor(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = abs(p - a);
+		int pb = abs(p - b);
+		int pc = abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return a;
+		if (pb <= pc)
+			return b;
+		return c;
+	}
+
+	/// Reverses the filter of one row in place.
+	/// @param prev The previous unfiltered row of the same pass, or 0 for the first row.
+	/// @param bpp The number of bytes per complete pixel, rounded up to one.
+	bool UnfilterRow(int filter, unsigned char *row, const unsigned char *prev, size_t rowBytes, int bpp)
+	{
+		switch(filter)
+		{
+		case 0:
+			break;
+		case 1:
+			for(size_t i = bpp; i < rowBytes; ++i)
+				row[i] += row[i - bpp];
+			break;
+		case 2:
+			if (prev)
+				for(size_t i = 0; i < rowBytes; ++i)
+					row[i] += prev[i];
+			break;
+		case 3:
+			for(size_t i = 0; i < rowBytes; ++i)
+			{
+				int left = i >= (size_t)bpp ? row[i - bpp] : 0;
+				int up = prev ? prev[i] : 0;
+				row[i] += (unsigned char)((left + up) / 2);
+			}
+			break;
+		case 4:
+			for(size_t i = 0; i < rowBytes; ++i)
+			{
+				int left = i >= (size_t)bpp ? row[i - bpp] : 0;
+				int up = prev ? prev[i] : 0;
+				int upLeft = (prev && i >= (size_t)bpp) ? prev[i - bpp] : 0;
+				row[i] += (unsigned char)PaethPredictor(left, up, upLeft);
+			}
+			break;
+		default:
+			return false;
+		}
+		return true;
+	}
+
+	/// Returns sample number index of a row with the given bit depth, without scaling it.
+	unsigned int GetSample(const unsigned char *row, int index, int bitDepth)
+	{
+		if (bitDepth == 8)
+			return row[index];
+		if (bitDepth == 16)
+			return ((unsigned int)row[index*2] << 8) | row[index*2 + 1];
+
+		int bit = index * bitDepth;
+		int shift = 8 - bitDepth - (bit & 7);
+		return (row[bit >> 3] >> shift) & ((1 << bitDepth) - 1);
+	}
+
+	/// Scales a sample of the given bit depth to 8 bits.
+	unsigned char ScaleSample(unsigned int v, int bitDepth)
+	{
+		if (bitDepth == 8)
+			return (unsigned char)v;
+		if (bitDepth == 16)
+			return (unsigned char)(v >> 8);
+		return (unsigned char)(v * 255 / ((1 << bitDepth) - 1));
+	}
+
+	struct PNGHeader
+	{
+		int width;
+		int height;
+		int bitDepth;
+		int colorType;
+		int interlace;
+		int channels;
+	};
+
+	/// Converts one unfiltered row of a pass to RGBA and stores its pixels in the image.
+	void StoreRow(const PNGHeader &header, const unsigned char *row, int passWidth, int y, int startX, int stepX,
+		const unsigned char *palette, const unsigned char *paletteAlpha, const unsigned int *colorKey, bool hasColorKey,
+		RGBAImage &image)
+	{
+		unsigned char *dst = image.Row(y);
+		int bitDepth = header.bitDepth;
+
+		for(int i = 0; i < passWidth; ++i)
+		{
+			unsigned char *p = dst + (startX + i*stepX) * 4;
+			switch(header.colorType)
+			{
+			case ColorTypeGray:
+				{
+					unsigned int v = GetSample(row, i, bitDepth);
+					p[0] = p[1] = p[2] = ScaleSample(v, bitDepth);
+					p[3] = (hasColorKey && v == colorKey[0]) ? 0 : 255;
+				}
+				break;
+			case ColorTypeRGB:
+				{
+					unsigned int r = GetSample(row, i*3, bitDepth);
+					unsigned int g = GetSample(row, i*3 + 1, bitDepth);
+					unsigned int b = GetSample(row, i*3 + 2, bitDepth);
+					p[0] = ScaleSample(r, bitDepth);
+					p[1] = ScaleSample(g, bitDepth);
+					p[2] = ScaleSample(b, bitDepth);
+					p[3] = (hasColorKey && r == colorKey[0] && g == colorKey[1] && b == colorKey[2]) ? 0 : 255;
+				}
+				break;
+			case ColorTypePalette:
+				{
+					unsigned int index = GetSample(row, i, bitDepth);
+					p[0] = palette[index*3];
+					p[1] = palette[index*3 + 1];
+					p[2] = palette[index*3 + 2];
+					p[3] = paletteAlpha[index];
+				}
+				break;
+			case ColorTypeGrayAlpha:
+				p[0] = p[1] = p[2] = ScaleSample(GetSample(row, i*2, bitDepth), bitDepth);
+				p[3] = ScaleSample(GetSample(row, i*2 + 1, bitDepth), bitDepth);
+				break;
+			case ColorTypeRGBA:
+				p[0] = ScaleSample(GetSample(row, i*4, bitDepth), bitDepth);
+				p[1] = ScaleSample(GetSample(row, i*4 + 1, bitDepth), bitDepth);
+				p[2] = ScaleSample(GetSample(row, i*4 + 2, bitDepth), bitDepth);
+				p[3] = ScaleSample(GetSample(row, i*4 + 3, bitDepth), bitDepth);
+				break;
+			}
+		}
+	}
+
+	bool ValidHeader(const PNGHeader &header)
+	{
+		if (header.width <= 0 || header.height <= 0 || header.interlace > 1)
+			return false;
+
+		int d = header.bitDepth;
+		switch(header.colorType)
+		{
+		case ColorTypeGray: return d == 1 || d == 2 || d == 4 || d == 8 || d == 16;
+		case ColorTypePalette: return d == 1 || d == 2 || d == 4 || d == 8;
+		case ColorTypeRGB:
+		case ColorTypeGrayAlpha:
+		case ColorTypeRGBA: return d == 8 || d == 16;
+		default: return false;
+		}
+	}
+
+	void AppendChunk(std::vector<unsigned char> &data, const char *type, const unsigned char *chunkData, size_t size)
+	{
+		unsigned char header[8];
+		WriteUInt32(header, (unsigned int)size);
+		memcpy(header + 4, type, 4);
+		data.insert(data.end(), header, header + 8);
+		if (size > 0)
+			data.insert(data.end(), chunkData, chunkData + size);
+
+		uLong crc = crc32(0, header + 4, 4);
+		if (size > 0)
+			crc = crc32(crc, chunkData, (uInt)size);
+
+		unsigned char crcBytes[4];
+		WriteUInt32(crcBytes, (unsigned int)crc);
+		data.insert(data.end(), crcBytes, crcBytes + 4);
+	}
+
+	/// Compresses the filtered rows and assembles the PNG file.
+	/// @param palette The RGB colors of a palette image, 3 bytes each.
+	/// @param transparency The alpha values of the first colors of the palette, if any are translucent.
+	void AssemblePNG(int width, int height, int bitDepth, int colorType, const std::vector<unsigned char> &filtered,
+		const std::vector<unsigned char> &palette, const std::vector<unsigned char> &transparency,
+		int compressionLevel, std::vector<unsigned char> &data)
+	{
+		uLongf compressedSize = compressBound((uLong)filtered.size());
+		std::vector<unsigned char> compressed(compressedSize);
+		compress2(&compressed[0], &compressedSize, filtered.empty() ? 0 : &filtered[0], (uLong)filtered.size(), compressionLevel);
+
+		unsigned char ihdr[13];
+		WriteUInt32(ihdr, width);
+		WriteUInt32(ihdr + 4, height);
+		ihdr[8] = (unsigned char)bitDepth;
+		ihdr[9] = (unsigned char)colorType;
+		ihdr[10] = 0; // Deflate compression
+		ihdr[11] = 0; // Adaptive filtering
+		ihdr[12] = 0; // No interlacing
+
+		data.assign(PNGSignature, PNGSignature + 8);
+		AppendChunk(data, "IHDR", ihdr, sizeof(ihdr));
+		if (!palette.empty())
+			AppendChunk(data, "PLTE", &palette[0], palette.size());
+		if (!transparency.empty())
+			AppendChunk(data, "tRNS", &transparency[0], transparency.size());
+		AppendChunk(data, "IDAT", &compressed[0], compressedSize);
+		AppendChunk(data, "IEND", 0, 0);
+	}
+
+	bool WriteFile(const char *filename, const std::vector<unsigned char> &data)
+	{
+		FILE *file = fopen(filename, "wb");
+		if (!file)
+			return false;
+
+		bool written = fwrite(&data[0], 1, data.size(), file) == data.size();
+		return fclose(file) == 0 && written;
+	}
+
+	/// Filters one row of RGBA pixels, picking the filter with the smallest sum of absolute differences.
+	void FilterRow(const unsigned char *row, const unsigned char *prev, size_t rowBytes, unsigned char *out,
+		std::vector<unsigned char> &scratch)
+	{
+		const int bpp = 4;
+		scratch.resize(rowBytes);
+
+		unsigned long bestSum = 0;
+		for(int filter = 0; filter < 5; ++filter)
+		{
+			unsigned long sum = 0;
+			for(size_t i = 0; i < rowBytes; ++i)
+			{
+				int left = i >= (size_t)bpp ? row[i - bpp] : 0;
+				int up = prev ? prev[i] : 0;
+				int upLeft = (prev && i >= (size_t)bpp) ? prev[i - bpp] : 0;
+
+				int predicted = 0;
+				switch(filter)
+				{
+				case 1: predicted = left; break;
+				case 2: predicted = up; break;
+				case 3: predicted = (left + up) / 2; break;
+				case 4: predicted = PaethPredictor(left, up, upLeft); break;
+				}
+
+				unsigned char v = (unsigned char)(row[i] - predicted);
+				scratch[i] = v;
+				sum += v < 128 ? v : 256 - v;
+			}
+
+			if (filter == 0 || sum < bestSum)
+			{
+				bestSum = sum;
+				out[0] = (unsigned char)filter;
+				memcpy(out + 1, &scratch[0], rowBytes);
+			}
+		}
+	}
+}
+
+bool DecodePNG(const unsigned char *data, size_t size, RGBAImage &image)
+{
+	if (size < 8 || memcmp(data, PNGSignature, 8) != 0)
+		return false;
+
+	PNGHeader header;
+	memset(&header, 0, sizeof(header));
+	bool hasHeader = false;
+
+	unsigned char palette[256*3];
+	unsigned char paletteAlpha[256];
+	memset(palette, 0, sizeof(palette));
+	memset(paletteAlpha, 255, sizeof(paletteAlpha));
+
+	unsigned int colorKey[3] = { 0, 0, 0 };
+	bool hasColorKey = false;
+
+	std::vector<unsigned char> compressed;
+
+	size_t pos = 8;
+	while(pos + 12 <= size)
+	{
+		unsigned int length = ReadUInt32(data + pos);
+		const unsigned char *type = data + pos + 4;
+		const unsigned char *chunk = data + pos + 8;
+		if (length > size - pos - 12)
+			return false;
+
+		if (memcmp(type, "IHDR", 4) == 0 && length >= 13)
+		{
+			header.width = (int)ReadUInt32(chunk);
+			header.height = (int)ReadUInt32(chunk + 4);
+			header.bitDepth = chunk[8];
+			header.colorType = chunk[9];
+			header.interlace = chunk[12];
+			hasHeader = true;
+		}
+		else if (memcmp(type, "PLTE", 4) == 0)
+		{
+			memcpy(palette, chunk, length < sizeof(palette) ? length : sizeof(palette));
+		}
+		else if (memcmp(type, "tRNS", 4) == 0)
+		{
+			if (header.colorType == ColorTypePalette)
+				memcpy(paletteAlpha, chunk, length < sizeof(paletteAlpha) ? length : sizeof(paletteAlpha));
+			else if (header.colorType == ColorTypeGray && length >= 2)
+			{
+				colorKey[0] = ((unsigned int)chunk[0] << 8) | chunk[1];
+				hasColorKey = true;
+			}
+			else if (header.colorType == ColorTypeRGB && length >= 6)
+			{
+				for(int i = 0; i < 3; ++i)
+					colorKey[i] = ((unsigned int)chunk[i*2] << 8) | chunk[i*2 + 1];
+				hasColorKey = true;
+			}
+		}
+		else if (memcmp(type, "IDAT", 4) == 0)
+		{
+			compressed.insert(compressed.end(), chunk, chunk + length);
+		}
+		else if (memcmp(type, "IEND", 4) == 0)
+		{
+			break;
+		}
+
+		pos += 12 + length;
+	}
+
+	if (!hasHeader || !ValidHeader(header) || compressed.empty())
+		return false;
+
+	switch(header.colorType)
+	{
+	case ColorTypeGray: header.channels = 1; break;
+	case ColorTypeRGB: header.channels = 3; break;
+	case ColorTypePalette: header.channels = 1; break;
+	case ColorTypeGrayAlpha: header.channels = 2; break;
+	case ColorTypeRGBA: header.channels = 4; break;
+	}
+
+	int bitsPerPixel = header.channels * header.bitDepth;
+	int bpp = bitsPerPixel >= 8 ? bitsPerPixel / 8 : 1;
+	int numPasses = header.interlace ? 7 : 1;
+
+	// Work out the size of the filtered data of all passes.
+	size_t rawSize = 0;
+	for(int pass = 0; pass < numPasses; ++pass)
+	{
+		int startX = header.interlace ? Adam7StartX[pass] : 0;
+		int startY = header.interlace ? Adam7StartY[pass] : 0;
+		int stepX = header.interlace ? Adam7StepX[pass] : 1;
+		int stepY = header.interlace ? Adam7StepY[pass] : 1;
+		if (startX >= header.width || startY >= header.height)
+			continue;
+
+		size_t passWidth = (header.width - startX + stepX - 1) / stepX;
+		size_t passHeight = (header.height - startY + stepY - 1) / stepY;
+		rawSize += passHeight * (1 + (passWidth * bitsPerPixel + 7) / 8);
+	}
+
+	std::vector<unsigned char> raw(rawSize);
+	uLongf rawLength = (uLongf)rawSize;
+	int result = uncompress(&raw[0], &rawLength, &compressed[0], (uLong)compressed.size());
+	if ((result != Z_OK && result != Z_BUF_ERROR) || rawLength != rawSize)
+		return false;
+
+	image.Init(header.width, header.height);
+
+	unsigned char *rowData = &raw[0];
+	for(int pass = 0; pass < numPasses; ++pass)
+	{
+		int startX = header.interlace ? Adam7StartX[pass] : 0;
+		int startY = header.interlace ? Adam7StartY[pass] : 0;
+		int stepX = header.interlace ? Adam7StepX[pass] : 1;
+		int stepY = header.interlace ? Adam7StepY[pass] : 1;
+		if (startX >= header.width || startY >= header.height)
+			continue;
+
+		int passWidth = (header.width - startX + stepX - 1) / stepX;
+		int passHeight = (header.height - startY + stepY - 1) / stepY;
+		size_t rowBytes = ((size_t)passWidth * bitsPerPixel + 7) / 8;
+
+		const unsigned char *prev = 0;
+		for(int y = 0; y < passHeight; ++y)
+		{
+			unsigned char *row = rowData + 1;
+			if (!UnfilterRow(rowData[0], row, prev, rowBytes, bpp))
+				return false;
+
+			StoreRow(header, row, passWidth, startY + y*stepY, startX, stepX, palette, paletteAlpha, colorKey, hasColorKey, image);
+
+			prev = row;
+			rowData += 1 + rowBytes;
+		}
+	}
+
+	return true;
+}
+
+bool LoadPNG(const char *filename, RGBAImage &image)
+{
+	FILE *file = fopen(filename, "rb");
+	if (!file)
+		return false;
+
+	std::vector<unsigned char> data;
+	unsigned char buffer[65536];
+	size_t read;
+	while((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		data.insert(data.end(), buffer, buffer + read);
+	fclose(file);
+
+	return !data.empty() && DecodePNG(&data[0], data.size(), image);
+}
+
+void EncodePNG(const RGBAImage &image, std::vector<unsigned char> &data, int compressionLevel)
+{
+	size_t rowBytes = (size_t)image.width * 4;
+
+	std::vector<unsigned char> filtered(image.height * (rowBytes + 1));
+	std::vector<unsigned char> scratch;
+	for(int y = 0; y < image.height; ++y)
+		FilterRow(image.Row(y), y > 0 ? image.Row(y - 1) : 0, rowBytes, &filtered[y * (rowBytes + 1)], scratch);
+
+	AssemblePNG(image.width, image.height, 8, ColorTypeRGBA, filtered, std::vector<unsigned char>(),
+		std::vector<unsigned char>(), compressionLevel, data);
+}
+
+bool SavePNG(const char *filename, const RGBAImage &image, int compressionLevel)
+{
+	std::vector<unsigned char> data;
+	EncodePNG(image, data, compressionLevel);
+	return WriteFile(filename, data);
+}
+
+void EncodePNG(const IndexedImage &image, std::vector<unsigned char> &data, int compressionLevel)
+{
+	int numColors = image.NumColors();
+	int bitDepth = numColors <= 2 ? 1 : numColors <= 4 ? 2 : numColors <= 16 ? 4 : 8;
+
+	// Palette images compress best without filtering, so every row starts with filter type 0
+	size_t rowBytes = ((size_t)image.width * bitDepth + 7) / 8;
+	std::vector<unsigned char> filtered(image.height * (rowBytes + 1), 0);
+	for(int y = 0; y < image.height; ++y)
+	{
+		const unsigned char *indices = &image.indices[(size_t)y * image.width];
+		unsigned char *out = &filtered[y * (rowBytes + 1) + 1];
+		for(int x = 0; x < image.width; ++x)
+		{
+			int bit = x * bitDepth;
+			out[bit / 8] |= (unsigned char)(indices[x] << (8 - bitDepth - bit % 8));
+		}
+	}
+
+	std::vector<unsigned char> palette, transparency;
+	for(int i = 0; i < numColors; ++i)
+	{
+		const unsigned char *color = &image.palette[i*4];
+		palette.insert(palette.end(), color, color + 3);
+		if (color[3] != 255)
+			transparency.resize(i + 1, 255);
+		if (!transparency.empty() && i < (int)transparency.size())
+			transparency[i] = color[3];
+	}
+
+	AssemblePNG(image.width, image.height, bitDepth, ColorTypePalette, filtered, palette, transparency, compressionLevel, data);
+}
+
+bool SavePNG(const char *filename, const IndexedImage &image, int compressionLevel)
+{
+	std::vector<unsigned char> data;
+	EncodePNG(image, data, compressionLevel);
+	return WriteFile(filename, data);
+}
@@ -0,0 +1,37 @@
+/** @file PNGCodec.h
+
+	@brief Reads and writes PNG files using zlib, without depending on the platform image libraries.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "AtlasCompositor.h"
+#include "PaletteQuantizer.h"
+
+/// Decodes a PNG file held in memory into an RGBA image. All standard color types, bit depths and
+/// interlacing are supported. Gray and palette images are expanded to RGBA, 16 bit channels are
+/// reduced to 8 bits and a tRNS chunk is turned into alpha. Color profiles and gamma are ignored.
+/// @return False if the data is not a valid PNG file.
+bool DecodePNG(const unsigned char *data, size_t size, RGBAImage &image);
+
+/// Reads and decodes a PNG file. @see DecodePNG.
+bool LoadPNG(const char *filename, RGBAImage &image);
+
+/// Encodes an RGBA image as an 8 bit per channel RGBA PNG file.
+/// @param compressionLevel The zlib compression level, from 0 (none) to 9 (best).
+void EncodePNG(const RGBAImage &image, std::vector<unsigned char> &data, int compressionLevel = 9);
+
+/// Encodes an RGBA image and writes it to a PNG file. @see EncodePNG.
+/// @return False if the file could not be written.
+bool SavePNG(const char *filename, const RGBAImage &image, int compressionLevel = 9);
+
+/// Encodes a palette image as a PNG file with the fewest bits per pixel that hold its palette indices.
+/// Translucent colors are stored in a transparency chunk.
+void EncodePNG(const IndexedImage &image, std::vector<unsigned char> &data, int compressionLevel = 9);
+
+/// Encodes a palette image and writes it to a PNG file. @see EncodePNG.
+/// @return False if the file could not be written.
+bool SavePNG(const char *filename, const IndexedImage &image, int compressionLevel = 9);
@@ -0,0 +1,100 @@
+/** @file PVRFile.cpp
+
+	@brief Writes textures in the legacy (version 2) PVR file format read by cocos2d.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cstdio>
+#include <cstring>
+
+#include "PVRFile.h"
+
+namespace
+{
+	/// Set in PVRTexHeader::flags if the texture has an alpha channel.
+	const uint32_t PVRTextureFlagAlpha = 0x8000;
+
+	/// Set in PVRTexHeader::flags if the texture has mipmap levels.
+	const uint32_t PVRTextureFlagMipmap = 0x0100;
+
+	/// 'PVR!' in little endian byte order.
+	const uint32_t PVRTag = 0x21525650;
+
+	void WriteUInt32(unsigned char *p, uint32_t v)
+	{
+		p[0] = (unsigned char)v;
+		p[1] = (unsigned char)(v >> 8);
+		p[2] = (unsigned char)(v >> 16);
+		p[3] = (unsigned char)(v >> 24);
+	}
+}
+
+void EncodePVR(int width, int height, PVRPixelType pixelType, const std::vector<unsigned char> &data, std::vector<unsigned char> &pvr, int numMipmaps)
+{
+	PVRTexHeader header;
+	memset(&header, 0, sizeof(header));
+
+	header.headerLength = sizeof(PVRTexHeader);
+	header.width = width;
+	header.height = height;
+	header.numMipmaps = numMipmaps;
+	header.flags = pixelType;
+	header.dataLength = (uint32_t)data.size();
+	header.pvrTag = PVRTag;
+	header.numSurfs = 1;
+
+	switch(pixelType)
+	{
+	case PVRPixelTypeRGBA4444:
+		header.bpp = 16;
+		header.bitmaskRed = 0xF000;
+		header.bitmaskGreen = 0x0F00;
+		header.bitmaskBlue = 0x00F0;
+		header.bitmaskAlpha = 0x000F;
+		break;
+	case PVRPixelTypeRGBA8888:
+		header.bpp = 32;
+		header.bitmaskRed = 0x000000FF;
+		header.bitmaskGreen = 0x0000FF00;
+		header.bitmaskBlue = 0x00FF0000;
+		header.bitmaskAlpha = 0xFF000000;
+		break;
+	case PVRPixelTypeRGB565:
+		header.bpp = 16;
+		header.bitmaskRed = 0xF800;
+		header.bitmaskGreen = 0x07E0;
+		header.bitmaskBlue = 0x001F;
+		break;
+	case PVRPixelTypePVRTC2:
+		header.bpp = 2;
+		header.bitmaskAlpha = 1;
+		break;
+	case PVRPixelTypePVRTC4:
+		header.bpp = 4;
+		header.bitmaskAlpha = 1;
+		break;
+	}
+
+	if (header.bitmaskAlpha)
+		header.flags |= PVRTextureFlagAlpha;
+	if (numMipmaps > 0)
+		header.flags |= PVRTextureFlagMipmap;
+
+	const uint32_t *fields = (const uint32_t*)&header;
+	pvr.resize(sizeof(PVRTexHeader) + data.size());
+	for(size_t i = 0; i < sizeof(PVRTexHeader) / sizeof(uint32_t); ++i)
+		WriteUInt32(&pvr[i * sizeof(uint32_t)], fields[i]);
+
+	if (!data.empty())
+		memcpy(&pvr[sizeof(PVRTexHeader)], &data[0], data.size());
+}
+
+bool SaveFile(const char *filename, const std::vector<unsigned char> &data)
+{
+	FILE *file = fopen(filename, "wb");
+	if (!file)
+		return false;
+
+	bool written = data.empty() || fwrite(&data[0], 1, data.size(), file) == data.size();
+	return fclose(file) == 0 && written;
+}
@@ -0,0 +1,47 @@
+/** @file PVRFile.h
+
+	@brief Writes textures in the legacy (version 2) PVR file format read by cocos2d.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+typedef struct _PVRTexHeader
+{
+    uint32_t headerLength;
+    uint32_t height;
+    uint32_t width;
+    uint32_t numMipmaps;
+    uint32_t flags;
+    uint32_t dataLength;
+    uint32_t bpp;
+    uint32_t bitmaskRed;
+    uint32_t bitmaskGreen;
+    uint32_t bitmaskBlue;
+    uint32_t bitmaskAlpha;
+    uint32_t pvrTag;
+    uint32_t numSurfs;
+} PVRTexHeader;
+
+/// The pixel types of the legacy PVR format, stored in the low byte of PVRTexHeader::flags.
+enum PVRPixelType
+{
+	PVRPixelTypeRGBA4444 = 0x10,
+	PVRPixelTypeRGBA8888 = 0x12,
+	PVRPixelTypeRGB565 = 0x13,
+	PVRPixelTypePVRTC2 = 0x18,
+	PVRPixelTypePVRTC4 = 0x19
+};
+
+/// Encodes a legacy PVR file holding a single surface. The header fields are stored in little endian
+/// byte order, and so must the texels of the 16 bit pixel types be.
+/// @param data The texel data, from the top row down, followed by that of the mipmap levels if any.
+/// @param numMipmaps The number of mipmap levels after the full size one, each half the size of the last.
+void EncodePVR(int width, int height, PVRPixelType pixelType, const std::vector<unsigned char> &data, std::vector<unsigned char> &pvr, int numMipmaps = 0);
+
+/// Writes a buffer to a file.
+/// @return False if the file could not be written.
+bool SaveFile(const char *filename, const std::vector<unsigned char> &data);
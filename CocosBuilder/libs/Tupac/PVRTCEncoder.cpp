@@ -0,0 +1,564 @@
+/** @file PVRTCEncoder.cpp
+
+	@brief Encodes and decodes PVRTC1 compressed textures, 2 and 4 bits per pixel, as read by the
+	PowerVR GPUs of iOS devices.
+
+	Every block stores two colors, A and B, and a modulation value per pixel. The GPU upscales the A
+	and B colors of the blocks bilinearly, with the color of a block at its center, and blends the
+	upscaled colors of each pixel by its modulation value. A block therefore affects the pixels of its
+	eight neighbours too, but not those of blocks two rows or columns away. The encoder uses that to
+	refine the colors of all blocks with even or odd coordinates at once.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "PVRTCEncoder.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	/// Set in the color word if color A or color B is opaque, which gives it more color bits.
+	const uint32_t OpaqueColorA = 0x8000;
+	const uint32_t OpaqueColorB = 0x80000000;
+
+	/// The smallest alpha stored as opaque. Translucent colors have 3 alpha bits, up to 238.
+	const int OpaqueAlpha = 247;
+
+	/// The largest number of refinement passes of PVRTCQualityBest, and the relative improvement of the
+	/// error below which it stops early.
+	const int MaxBestRefinements = 16;
+	const double MinBestImprovement = 0.001;
+
+	/// The modulation values of the four 2 bit modulation codes in 4 bpp blocks, in eighths.
+	const int ModulationWeights[4] = { 0, 3, 5, 8 };
+
+	/// The size of the blocks and the number of blocks in each direction. These are powers of two, so
+	/// wrapping coordinates around the texture is a mask.
+	struct BlockGrid
+	{
+		bool twoBpp;
+		int blockWidth;
+		int blockHeight;
+		int numX;
+		int numY;
+
+		BlockGrid(int width, int height, bool twoBitsPerPixel)
+			: twoBpp(twoBitsPerPixel), blockWidth(twoBitsPerPixel ? 8 : 4), blockHeight(4),
+			numX(width / blockWidth), numY(height / blockHeight) {}
+
+		int Index(int bx, int by) const { return (by & (numY - 1)) * numX + (bx & (numX - 1)); }
+
+		/// The index of a block in the data, in the twiddled (Morton) order with the y bits in the even
+		/// positions. If the grid is not square, the extra bits of the longer side come last.
+		size_t TwiddledIndex(int bx, int by) const
+		{
+			size_t index = 0;
+			int shift = 0;
+			for(int bit = 1; bit < std::min(numX, numY); bit <<= 1, ++shift)
+			{
+				if (by & bit)
+					index |= (size_t)1 << (2*shift);
+				if (bx & bit)
+					index |= (size_t)1 << (2*shift + 1);
+			}
+			size_t rest = (numX > numY ? bx : by) >> shift;
+			return index | (rest << (2*shift));
+		}
+	};
+
+	bool IsPowerOfTwo(int n)
+	{
+		return n > 0 && (n & (n - 1)) == 0;
+	}
+
+	bool IsValidSize(int width, int height)
+	{
+		return IsPowerOfTwo(width) && IsPowerOfTwo(height);
+	}
+
+	/// The GPU needs a grid of at least 2x2 blocks, so smaller textures, such as the smallest mipmap
+	/// levels, are stored in that many blocks. Only the top left of the decoded blocks is used.
+	BlockGrid StoredGrid(int width, int height, bool twoBitsPerPixel)
+	{
+		BlockGrid grid(width, height, twoBitsPerPixel);
+		return BlockGrid(std::max(width, grid.blockWidth * 2), std::max(height, grid.blockHeight * 2), twoBitsPerPixel);
+	}
+
+	struct Block
+	{
+		uint32_t modulation;
+		uint32_t colors;
+
+		/// Colors A and B as the GPU unpacks them: 5 bits for red, green and blue, 4 bits for alpha.
+		int a[4];
+		int b[4];
+
+		/// Colors A and B on the 0 to 255 scale, for the least squares fit.
+		float linearA[4];
+		float linearB[4];
+	};
+
+	inline int Expand4To5(int v) { return (v << 1) | (v >> 3); }
+	inline int Expand3To5(int v) { return (v << 2) | (v >> 1); }
+
+	void UnpackColorA(uint32_t colors, int *c)
+	{
+		if (colors & OpaqueColorA)
+		{
+			c[0] = (colors >> 10) & 31;
+			c[1] = (colors >> 5) & 31;
+			c[2] = Expand4To5((colors >> 1) & 15);
+			c[3] = 15;
+		}
+		else
+		{
+			c[0] = Expand4To5((colors >> 8) & 15);
+			c[1] = Expand4To5((colors >> 4) & 15);
+			c[2] = Expand3To5((colors >> 1) & 7);
+			c[3] = ((colors >> 12) & 7) << 1;
+		}
+	}
+
+	void UnpackColorB(uint32_t colors, int *c)
+	{
+		if (colors & OpaqueColorB)
+		{
+			c[0] = (colors >> 26) & 31;
+			c[1] = (colors >> 21) & 31;
+			c[2] = (colors >> 16) & 31;
+			c[3] = 15;
+		}
+		else
+		{
+			c[0] = Expand4To5((colors >> 24) & 15);
+			c[1] = Expand4To5((colors >> 20) & 15);
+			c[2] = Expand4To5((colors >> 16) & 15);
+			c[3] = ((colors >> 28) & 7) << 1;
+		}
+	}
+
+	void UnpackColors(Block &block)
+	{
+		UnpackColorA(block.colors, block.a);
+		UnpackColorB(block.colors, block.b);
+		for(int c = 0; c < 4; ++c)
+		{
+			float scale = (c < 3) ? 255.0f / 31 : 17.0f;
+			block.linearA[c] = block.a[c] * scale;
+			block.linearB[c] = block.b[c] * scale;
+		}
+	}
+
+	/// Rounds v * maxValue / 255 to the closest integer in [0, maxValue].
+	inline int QuantizeChannel(float v, int maxValue)
+	{
+		int q = (int)floor(v * maxValue / 255 + 0.5f);
+		return std::max(0, std::min(q, maxValue));
+	}
+
+	/// Packs color A into bits 1-15 of the color word, as opaque RGB 554 or translucent ARGB 3443.
+	uint32_t PackColorA(const float *c)
+	{
+		if (c[3] >= OpaqueAlpha)
+			return OpaqueColorA | QuantizeChannel(c[0], 31) << 10 | QuantizeChannel(c[1], 31) << 5 | QuantizeChannel(c[2], 15) << 1;
+
+		int alpha = std::max(0, std::min((int)floor(c[3] / 34 + 0.5f), 7));
+		return alpha << 12 | QuantizeChannel(c[0], 15) << 8 | QuantizeChannel(c[1], 15) << 4 | QuantizeChannel(c[2], 7) << 1;
+	}
+
+	/// Packs color B into bits 16-31 of the color word, as opaque RGB 555 or translucent ARGB 3444.
+	uint32_t PackColorB(const float *c)
+	{
+		if (c[3] >= OpaqueAlpha)
+			return OpaqueColorB | QuantizeChannel(c[0], 31) << 26 | QuantizeChannel(c[1], 31) << 21 | QuantizeChannel(c[2], 31) << 16;
+
+		uint32_t alpha = std::max(0, std::min((int)floor(c[3] / 34 + 0.5f), 7));
+		return alpha << 28 | QuantizeChannel(c[0], 15) << 24 | QuantizeChannel(c[1], 15) << 20 | QuantizeChannel(c[2], 15) << 16;
+	}
+
+	/// The four blocks whose colors are interpolated at a pixel, and their weights, which sum up to the
+	/// area of a block.
+	struct Neighbourhood
+	{
+		const Block *blocks[4];
+		int weights[4];
+	};
+
+	void FindNeighbourhood(const BlockGrid &grid, const Block *blocks, int px, int py, Neighbourhood &n)
+	{
+		int w = grid.blockWidth, h = grid.blockHeight;
+		int rx = px - w/2, ry = py - h/2;
+		int bx = (rx >= 0) ? rx / w : -1;
+		int by = (ry >= 0) ? ry / h : -1;
+		int x = rx - bx * w, y = ry - by * h;
+
+		n.blocks[0] = &blocks[grid.Index(bx, by)];
+		n.blocks[1] = &blocks[grid.Index(bx + 1, by)];
+		n.blocks[2] = &blocks[grid.Index(bx, by + 1)];
+		n.blocks[3] = &blocks[grid.Index(bx + 1, by + 1)];
+		n.weights[0] = (w - x) * (h - y);
+		n.weights[1] = x * (h - y);
+		n.weights[2] = (w - x) * y;
+		n.weights[3] = x * y;
+	}
+
+	/// Converts a color interpolated with weights summing up to the block area to 8 bits, rounding the
+	/// way the GPU does.
+	inline int ExpandInterpolated(int v, bool alpha, bool twoBpp)
+	{
+		if (twoBpp)
+			return alpha ? (v >> 5) + (v >> 1) : (v >> 7) + (v >> 2);
+		return alpha ? (v >> 4) + v : (v >> 6) + (v >> 1);
+	}
+
+	/// Computes the upscaled colors A and B of a pixel, exactly as the GPU does.
+	void InterpolateColors(const BlockGrid &grid, const Neighbourhood &n, int *colorA, int *colorB)
+	{
+		for(int c = 0; c < 4; ++c)
+		{
+			int a = 0, b = 0;
+			for(int i = 0; i < 4; ++i)
+			{
+				a += n.blocks[i]->a[c] * n.weights[i];
+				b += n.blocks[i]->b[c] * n.weights[i];
+			}
+			colorA[c] = ExpandInterpolated(a, c == 3, grid.twoBpp);
+			colorB[c] = ExpandInterpolated(b, c == 3, grid.twoBpp);
+		}
+	}
+
+	/// Returns the modulation value of a pixel of a block, in eighths.
+	inline int ModulationValue(const BlockGrid &grid, const Block &block, int x, int y)
+	{
+		if (grid.twoBpp)
+			return ((block.modulation >> (y * 8 + x)) & 1) * 8;
+		return ModulationWeights[(block.modulation >> (2 * (y * 4 + x))) & 3];
+	}
+
+	inline int Blend(int a, int b, int modulation)
+	{
+		return (a * (8 - modulation) + b * modulation) / 8;
+	}
+
+	class Encoder
+	{
+	public:
+		Encoder(const RGBAImage &image_, bool twoBitsPerPixel)
+			: image(image_), grid(image_.width, image_.height, twoBitsPerPixel),
+			blocks(grid.numX * grid.numY), rowErrors(grid.numY, 0) {}
+
+		/// Takes colors A and B of a block from the bounding box of its pixels.
+		void InitializeBlock(int bx, int by)
+		{
+			float low[4] = { 255, 255, 255, 255 };
+			float high[4] = { 0, 0, 0, 0 };
+			for(int y = 0; y < grid.blockHeight; ++y)
+			{
+				const unsigned char *p = image.Row(by * grid.blockHeight + y) + bx * grid.blockWidth * 4;
+				for(int x = 0; x < grid.blockWidth * 4; ++x)
+				{
+					low[x & 3] = std::min(low[x & 3], (float)p[x]);
+					high[x & 3] = std::max(high[x & 3], (float)p[x]);
+				}
+			}
+
+			Block &block = blocks[grid.Index(bx, by)];
+			block.modulation = 0;
+			block.colors = PackColorA(low) | PackColorB(high);
+			UnpackColors(block);
+		}
+
+		/// Picks the modulation value of every pixel of a block that best matches the image.
+		/// @return The sum of the squared errors of the decoded pixels.
+		double ModulateBlock(int bx, int by)
+		{
+			Block &block = blocks[grid.Index(bx, by)];
+			uint32_t modulation = 0;
+			double error = 0;
+
+			for(int y = 0; y < grid.blockHeight; ++y)
+			{
+				int py = by * grid.blockHeight + y;
+				const unsigned char *row = image.Row(py);
+				for(int x = 0; x < grid.blockWidth; ++x)
+				{
+					int px = bx * grid.blockWidth + x;
+					const unsigned char *p = row + px * 4;
+
+					Neighbourhood n;
+					FindNeighbourhood(grid, &blocks[0], px, py, n);
+					int colorA[4], colorB[4];
+					InterpolateColors(grid, n, colorA, colorB);
+
+					int numCodes = grid.twoBpp ? 2 : 4;
+					int bestCode = 0, bestError = 0x7FFFFFFF;
+					for(int code = 0; code < numCodes; ++code)
+					{
+						int modulation = grid.twoBpp ? code * 8 : ModulationWeights[code];
+						int codeError = 0;
+						for(int c = 0; c < 4; ++c)
+						{
+							int d = Blend(colorA[c], colorB[c], modulation) - p[c];
+							codeError += d * d;
+						}
+						if (codeError < bestError)
+						{
+							bestError = codeError;
+							bestCode = code;
+						}
+					}
+
+					if (grid.twoBpp)
+						modulation |= (uint32_t)bestCode << (y * 8 + x);
+					else
+						modulation |= (uint32_t)bestCode << (2 * (y * 4 + x));
+					error += bestError;
+				}
+			}
+
+			block.modulation = modulation;
+			return error;
+		}
+
+		/// Replaces colors A and B of a block by the least squares fit to the pixels it affects, keeping
+		/// the modulation values and the colors of the other blocks.
+		void RefineBlock(int bx, int by)
+		{
+			int w = grid.blockWidth, h = grid.blockHeight;
+			int cx = bx * w + w/2, cy = by * h + h/2;
+			Block &block = blocks[grid.Index(bx, by)];
+
+			// Normal equations of the fit: [aa ab; ab bb] * [A B] = [ar br]
+			double aa = 0, ab = 0, bb = 0;
+			double ar[4] = { 0, 0, 0, 0 }, br[4] = { 0, 0, 0, 0 };
+
+			for(int dy = -h + 1; dy < h; ++dy)
+			{
+				int py = (cy + dy) & (image.height - 1);
+				const unsigned char *row = image.Row(py);
+				for(int dx = -w + 1; dx < w; ++dx)
+				{
+					int px = (cx + dx) & (image.width - 1);
+					const Block &pixelBlock = blocks[grid.Index(px / w, py / h)];
+					float m = ModulationValue(grid, pixelBlock, px % w, py % h) / 8.0f;
+
+					Neighbourhood n;
+					FindNeighbourhood(grid, &blocks[0], px, py, n);
+
+					// The weight of this block at the pixel, and of its colors A and B
+					float weight = (float)((w - abs(dx)) * (h - abs(dy))) / (w * h);
+					float weightA = weight * (1 - m), weightB = weight * m;
+					aa += weightA * weightA;
+					ab += weightA * weightB;
+					bb += weightB * weightB;
+
+					for(int c = 0; c < 4; ++c)
+					{
+						// What is left of the pixel after the contribution of the other blocks
+						float decoded = 0;
+						for(int i = 0; i < 4; ++i)
+						{
+							const Block *neighbour = n.blocks[i];
+							decoded += n.weights[i] * (neighbour->linearA[c] * (1 - m) + neighbour->linearB[c] * m);
+						}
+						decoded /= (w * h);
+						float residual = row[px*4 + c] - decoded + weightA * block.linearA[c] + weightB * block.linearB[c];
+						ar[c] += weightA * residual;
+						br[c] += weightB * residual;
+					}
+				}
+			}
+
+			// Pull the colors slightly towards their current values, so blocks whose pixels all have the
+			// same modulation value keep a well defined solution.
+			double damping = 1e-4 * (aa + bb) + 1e-6;
+			aa += damping;
+			bb += damping;
+			double det = aa * bb - ab * ab;
+
+			float colorA[4], colorB[4];
+			for(int c = 0; c < 4; ++c)
+			{
+				double rhsA = ar[c] + damping * block.linearA[c];
+				double rhsB = br[c] + damping * block.linearB[c];
+				colorA[c] = (float)std::max(0.0, std::min((bb * rhsA - ab * rhsB) / det, 255.0));
+				colorB[c] = (float)std::max(0.0, std::min((aa * rhsB - ab * rhsA) / det, 255.0));
+			}
+
+			block.colors = PackColorA(colorA) | PackColorB(colorB);
+			UnpackColors(block);
+		}
+
+		/// @return The sum of the squared errors of the decoded pixels.
+		double Encode(PVRTCQuality quality, int numThreads)
+		{
+			Initializer initializer = { this };
+			ParallelFor(grid.numY, initializer, numThreads);
+			double error = Modulate(numThreads);
+
+			int numRefinements = (quality == PVRTCQualityFast) ? 0 : (quality == PVRTCQualityNormal) ? 2 : MaxBestRefinements;
+			for(int i = 0; i < numRefinements; ++i)
+			{
+				// Blocks two rows or columns apart do not affect the same pixels, so each of the four
+				// groups of blocks with the same coordinate parities can be refined concurrently
+				for(int phase = 0; phase < 4; ++phase)
+				{
+					Refiner refiner = { this, phase & 1, phase >> 1 };
+					ParallelFor(grid.numY / 2, refiner, numThreads);
+				}
+
+				double previousError = error;
+				error = Modulate(numThreads);
+				if (quality == PVRTCQualityBest && error >= previousError * (1 - MinBestImprovement))
+					break;
+			}
+			return error;
+		}
+
+		double Modulate(int numThreads)
+		{
+			Modulator modulator = { this };
+			ParallelFor(grid.numY, modulator, numThreads);
+
+			double error = 0;
+			for(int by = 0; by < grid.numY; ++by)
+				error += rowErrors[by];
+			return error;
+		}
+
+		void Write(std::vector<unsigned char> &data) const
+		{
+			data.assign(PVRTCDataSize(image.width, image.height, grid.twoBpp), 0);
+			for(int by = 0; by < grid.numY; ++by)
+				for(int bx = 0; bx < grid.numX; ++bx)
+				{
+					const Block &block = blocks[grid.Index(bx, by)];
+					unsigned char *p = &data[grid.TwiddledIndex(bx, by) * 8];
+					for(int i = 0; i < 4; ++i)
+					{
+						p[i] = (unsigned char)(block.modulation >> (8 * i));
+						p[i + 4] = (unsigned char)(block.colors >> (8 * i));
+					}
+				}
+		}
+
+	private:
+		struct Initializer
+		{
+			Encoder *encoder;
+
+			void operator()(int by)
+			{
+				for(int bx = 0; bx < encoder->grid.numX; ++bx)
+					encoder->InitializeBlock(bx, by);
+			}
+		};
+
+		struct Modulator
+		{
+			Encoder *encoder;
+
+			void operator()(int by)
+			{
+				double error = 0;
+				for(int bx = 0; bx < encoder->grid.numX; ++bx)
+					error += encoder->ModulateBlock(bx, by);
+				encoder->rowErrors[by] = error;
+			}
+		};
+
+		/// Refines the blocks of every other row and column, starting at (phaseX, phaseY).
+		struct Refiner
+		{
+			Encoder *encoder;
+			int phaseX;
+			int phaseY;
+
+			void operator()(int i)
+			{
+				for(int bx = phaseX; bx < encoder->grid.numX; bx += 2)
+					encoder->RefineBlock(bx, i * 2 + phaseY);
+			}
+		};
+
+		const RGBAImage &image;
+		BlockGrid grid;
+		std::vector<Block> blocks;
+		std::vector<double> rowErrors;
+	};
+}
+
+size_t PVRTCDataSize(int width, int height, bool twoBitsPerPixel)
+{
+	BlockGrid grid = StoredGrid(width, height, twoBitsPerPixel);
+	return (size_t)grid.numX * grid.numY * 8;
+}
+
+double EncodePVRTC(const RGBAImage &image, bool twoBitsPerPixel, PVRTCQuality quality, std::vector<unsigned char> &data, int numThreads)
+{
+	if (!IsValidSize(image.width, image.height))
+		return -1;
+
+	// Repeat images smaller than the stored blocks, which wraps around them as the GPU does
+	BlockGrid grid = StoredGrid(image.width, image.height, twoBitsPerPixel);
+	int width = grid.numX * grid.blockWidth, height = grid.numY * grid.blockHeight;
+	if (width != image.width || height != image.height)
+	{
+		RGBAImage tiled;
+		tiled.Init(width, height);
+		for(int y = 0; y < height; ++y)
+			for(int x = 0; x < width; x += image.width)
+				memcpy(tiled.Row(y) + x*4, image.Row(y % image.height), image.width * 4);
+		return EncodePVRTC(tiled, twoBitsPerPixel, quality, data, numThreads);
+	}
+
+	Encoder encoder(image, twoBitsPerPixel);
+	double meanSquaredError = encoder.Encode(quality, numThreads) / ((double)image.width * image.height * 4);
+	encoder.Write(data);
+
+	if (meanSquaredError <= 0)
+		return INFINITY;
+	return 10 * log10(255.0 * 255.0 / meanSquaredError);
+}
+
+bool DecodePVRTC(const unsigned char *data, size_t size, int width, int height, bool twoBitsPerPixel, RGBAImage &image)
+{
+	if (!IsValidSize(width, height) || size < PVRTCDataSize(width, height, twoBitsPerPixel))
+		return false;
+
+	BlockGrid grid = StoredGrid(width, height, twoBitsPerPixel);
+	std::vector<Block> blocks(grid.numX * grid.numY);
+	for(int by = 0; by < grid.numY; ++by)
+		for(int bx = 0; bx < grid.numX; ++bx)
+		{
+			Block &block = blocks[grid.Index(bx, by)];
+			const unsigned char *p = data + grid.TwiddledIndex(bx, by) * 8;
+			block.modulation = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+			block.colors = p[4] | p[5] << 8 | p[6] << 16 | (uint32_t)p[7] << 24;
+			UnpackColors(block);
+		}
+
+	image.Init(width, height);
+	for(int py = 0; py < height; ++py)
+	{
+		unsigned char *row = image.Row(py);
+		for(int px = 0; px < width; ++px)
+		{
+			Neighbourhood n;
+			FindNeighbourhood(grid, &blocks[0], px, py, n);
+			int colorA[4], colorB[4];
+			InterpolateColors(grid, n, colorA, colorB);
+
+			const Block &block = blocks[grid.Index(px / grid.blockWidth, py / grid.blockHeight)];
+			int modulation = ModulationValue(grid, block, px % grid.blockWidth, py % grid.blockHeight);
+			for(int c = 0; c < 4; ++c)
+				row[px*4 + c] = (unsigned char)Blend(colorA[c], colorB[c], modulation);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,39 @@
+/** @file PVRTCEncoder.h
+
+	@brief Encodes and decodes PVRTC1 compressed textures, 2 and 4 bits per pixel, as read by the
+	PowerVR GPUs of iOS devices.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "AtlasCompositor.h"
+
+/// How much time EncodePVRTC spends on improving the colors of the blocks.
+enum PVRTCQuality
+{
+	PVRTCQualityFast, ///< Takes the colors of each block from its bounding box, without refining them.
+	PVRTCQualityNormal, ///< Refines the colors twice.
+	PVRTCQualityBest ///< Refines the colors until the error stops improving, at most 16 times.
+};
+
+/// Returns the size of the PVRTC data of a texture: 8 bytes per block, and at least 2x2 blocks.
+size_t PVRTCDataSize(int width, int height, bool twoBitsPerPixel);
+
+/// Compresses an image to PVRTC1 data, the blocks stored in the twiddled order the GPU reads them in.
+/// The image is split into rows of blocks that are encoded concurrently. Colors bleed across the
+/// edges of the texture, so the data is meant to be sampled with wrapping texture coordinates.
+/// @param image The image, with a power of two width and height. Images smaller than 2x2 blocks, 8x8
+///   pixels for 4 bpp and 16x8 pixels for 2 bpp, are repeated to fill that many blocks.
+/// @param twoBitsPerPixel Encodes 8x4 pixel blocks with 2 bits per pixel if set, otherwise 4x4 pixel
+///   blocks with 4 bits per pixel.
+/// @param numThreads The largest number of threads to encode with, or 0 to use all processors.
+/// @return The peak signal to noise ratio of the decoded texture against the image, in dB, or a
+///   negative number if the image has an invalid size.
+double EncodePVRTC(const RGBAImage &image, bool twoBitsPerPixel, PVRTCQuality quality, std::vector<unsigned char> &data, int numThreads = 0);
+
+/// Decodes PVRTC1 data to an image, with the same results as the GPU.
+/// @return False if the size is not a power of two or the data is too short.
+bool DecodePVRTC(const unsigned char *data, size_t size, int width, int height, bool twoBitsPerPixel, RGBAImage &image);
@@ -0,0 +1,361 @@
+/** @file PackingSearch.cpp
+
+	@brief Searches for the smallest bin a set of rectangles can be packed into, trying several
+	MaxRectsBinPack heuristics and insertion orders in parallel.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <algorithm>
+
+#include "PackingSearch.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	/// The smallest width and height of a bin.
+	const int MinBinSize = 8;
+
+	/// Orders rectangles for one of the one-at-a-time PackingOrders, largest first.
+	struct RectSizeGreater
+	{
+		PackingOrder order;
+
+		long Key(const TPRectSize &r) const
+		{
+			switch(order)
+			{
+			case PackingOrderArea: return (long)r.width * r.height;
+			case PackingOrderLongSide: return std::max(r.width, r.height);
+			case PackingOrderPerimeter: return (long)r.width + r.height;
+			default: return 0;
+			}
+		}
+
+		bool operator()(const TPRectSize &a, const TPRectSize &b) const
+		{
+			long keyA = Key(a);
+			long keyB = Key(b);
+			if (keyA != keyB)
+				return keyA > keyB;
+			return a.idx < b.idx;
+		}
+	};
+
+	/// A bin size together with the strategy to pack into it.
+	struct PackingJob
+	{
+		int width;
+		int height;
+		PackingStrategy strategy;
+	};
+
+	/// Runs one PackingJob per ParallelFor iteration.
+	struct PackingJobRunner
+	{
+		const std::vector<TPRectSize> *rects;
+		const std::vector<PackingJob> *jobs;
+		std::vector<PackingResult> *results;
+		std::vector<char> *fitted;
+
+		void operator()(int i)
+		{
+			const PackingJob &job = (*jobs)[i];
+			(*fitted)[i] = PackingSearch::PackWithStrategy(*rects, job.width, job.height, job.strategy, (*results)[i]);
+		}
+	};
+
+	long BinArea(const std::pair<int, int> &size)
+	{
+		return (long)size.first * size.second;
+	}
+
+	/// The area of the bounding box of the packed rectangles, which is less than the bin area when the packing
+	/// leaves a strip along the right or bottom edge empty.
+	long UsedArea(const PackingResult &result)
+	{
+		int right = 0;
+		int bottom = 0;
+		for(size_t i = 0; i < result.rects.size(); ++i)
+		{
+			right = std::max(right, result.rects[i].x + result.rects[i].width);
+			bottom = std::max(bottom, result.rects[i].y + result.rects[i].height);
+		}
+		return (long)right * bottom;
+	}
+
+	/// Ranks two packings: the higher occupancy wins, then the squarer bin, then the smaller bounding box of
+	/// the packed rectangles. All bins of one area hold the same rectangles at the same occupancy, so only
+	/// the last two tell them apart.
+	bool IsBetterPacking(const PackingResult &a, const PackingResult &b)
+	{
+		if (a.occupancy != b.occupancy)
+			return a.occupancy > b.occupancy;
+
+		// The sides are powers of two, so the ratio of the long side to the short one is exact.
+		int aspectA = std::max(a.width, a.height) / std::max(1, std::min(a.width, a.height));
+		int aspectB = std::max(b.width, b.height) / std::max(1, std::min(b.width, b.height));
+		if (aspectA != aspectB)
+			return aspectA < aspectB;
+
+		return UsedArea(a) < UsedArea(b);
+	}
+
+	/// Orders bin sizes by area, and sizes of the same area by width.
+	struct BinSizeLess
+	{
+		bool operator()(const std::pair<int, int> &a, const std::pair<int, int> &b) const
+		{
+			if (BinArea(a) != BinArea(b))
+				return BinArea(a) < BinArea(b);
+			return a.first < b.first;
+		}
+	};
+}
+
+PackingSearch::PackingSearch()
+:maxSize(2048),
+square(false),
+numThreads(0)
+{
+	const MaxRectsBinPack::FreeRectChoiceHeuristic heuristics[] =
+	{
+		MaxRectsBinPack::RectBestShortSideFit,
+		MaxRectsBinPack::RectBestLongSideFit,
+		MaxRectsBinPack::RectBestAreaFit,
+		MaxRectsBinPack::RectBottomLeftRule
+	};
+	const PackingOrder orders[] = { PackingOrderBatch, PackingOrderArea, PackingOrderLongSide, PackingOrderPerimeter };
+
+	for(size_t o = 0; o < sizeof(orders) / sizeof(orders[0]); ++o)
+		for(size_t h = 0; h < sizeof(heuristics) / sizeof(heuristics[0]); ++h)
+		{
+			PackingStrategy strategy;
+			strategy.heuristic = heuristics[h];
+			strategy.order = orders[o];
+			strategies.push_back(strategy);
+		}
+}
+
+void PackingSearch::SetMaxSize(int maxSize_)
+{
+	maxSize = maxSize_;
+}
+
+void PackingSearch::SetSquare(bool square_)
+{
+	square = square_;
+}
+
+void PackingSearch::SetStrategies(const std::vector<PackingStrategy> &strategies_)
+{
+	strategies = strategies_;
+}
+
+void PackingSearch::SetNumThreads(int numThreads_)
+{
+	numThreads = numThreads_;
+}
+
+bool PackingSearch::PackWithStrategy(const std::vector<TPRectSize> &rects, int width, int height,
+	const PackingStrategy &strategy, PackingResult &result)
+{
+	MaxRectsBinPack bin(width, height);
+	bin.SetUseFreeRectIndex(true);
+
+	result.width = width;
+	result.height = height;
+	result.strategy = strategy;
+	result.rects.clear();
+
+	if (strategy.order == PackingOrderBatch)
+	{
+		std::vector<TPRectSize> inRects = rects;
+		bin.Insert(inRects, result.rects, strategy.heuristic);
+	}
+	else
+	{
+		std::vector<TPRectSize> inRects = rects;
+		RectSizeGreater greater = { strategy.order };
+		std::sort(inRects.begin(), inRects.end(), greater);
+
+		for(size_t i = 0; i < inRects.size(); ++i)
+		{
+			TPRect node = bin.Insert(inRects[i].width, inRects[i].height, strategy.heuristic);
+			if (node.height == 0)
+				continue;
+
+			node.idx = inRects[i].idx;
+			node.rotated = (inRects[i].width != node.width);
+			result.rects.push_back(node);
+		}
+	}
+
+	result.occupancy = bin.Occupancy();
+	return result.rects.size() == rects.size();
+}
+
+int PackingSearch::PackSizes(const std::vector<TPRectSize> &rects, const std::vector<int> &widths,
+	const std::vector<int> &heights, std::vector<PackingResult> &results) const
+{
+	std::vector<PackingJob> jobs;
+	for(size_t s = 0; s < widths.size(); ++s)
+		for(size_t i = 0; i < strategies.size(); ++i)
+		{
+			PackingJob job;
+			job.width = widths[s];
+			job.height = heights[s];
+			job.strategy = strategies[i];
+			jobs.push_back(job);
+		}
+
+	results.resize(jobs.size());
+	std::vector<char> fitted(jobs.size(), 0);
+
+	PackingJobRunner runner = { &rects, &jobs, &results, &fitted };
+	ParallelFor((int)jobs.size(), runner, numThreads);
+
+	int best = -1;
+	for(size_t i = 0; i < jobs.size(); ++i)
+		if (fitted[i] && (best == -1 || IsBetterPacking(results[i], results[best])))
+			best = (int)i;
+	return best;
+}
+
+bool PackingSearch::Pack(const std::vector<TPRectSize> &rects, PackingResult &result) const
+{
+	// Every rectangle must fit in the bin in some orientation, and the bin can't be smaller than their total area.
+	int maxShortSide = 0;
+	int maxLongSide = 0;
+	long totalArea = 0;
+	for(size_t i = 0; i < rects.size(); ++i)
+	{
+		maxShortSide = std::max(maxShortSide, std::min(rects[i].width, rects[i].height));
+		maxLongSide = std::max(maxLongSide, std::max(rects[i].width, rects[i].height));
+		totalArea += (long)rects[i].width * rects[i].height;
+	}
+
+	int largestSize = MinBinSize;
+	while(largestSize * 2 <= maxSize)
+		largestSize *= 2;
+
+	std::vector<std::pair<int, int> > sizes;
+	for(int w = MinBinSize; w <= maxSize; w *= 2)
+		for(int h = MinBinSize; h <= maxSize; h *= 2)
+		{
+			if (square && w != h)
+				continue;
+			if (std::min(w, h) < maxShortSide || std::max(w, h) < maxLongSide || (long)w * h < totalArea)
+				continue;
+			sizes.push_back(std::make_pair(w, h));
+		}
+	std::sort(sizes.begin(), sizes.end(), BinSizeLess());
+
+	// Group the sizes by area, packing all sizes of the same area concurrently.
+	std::vector<size_t> levels;
+	for(size_t i = 0; i < sizes.size(); ++i)
+		if (i == 0 || BinArea(sizes[i-1]) != BinArea(sizes[i]))
+			levels.push_back(i);
+	levels.push_back(sizes.size());
+
+	// Bisect on the area. A set of rectangles that fits into some area almost always fits into a larger
+	// one too, so this needs a logarithmic number of packing passes instead of trying every area in turn.
+	std::vector<PackingResult> results;
+	bool found = false;
+	int lo = 0;
+	int hi = (int)levels.size() - 2;
+	while(lo <= hi)
+	{
+		int mid = (lo + hi) / 2;
+
+		std::vector<int> widths;
+		std::vector<int> heights;
+		for(size_t i = levels[mid]; i < levels[mid+1]; ++i)
+		{
+			widths.push_back(sizes[i].first);
+			heights.push_back(sizes[i].second);
+		}
+
+		int best = PackSizes(rects, widths, heights, results);
+		if (best != -1)
+		{
+			result = results[best];
+			found = true;
+			hi = mid - 1;
+		}
+		else
+			lo = mid + 1;
+	}
+
+	if (found)
+		return true;
+
+	// Nothing fits, so place as much as possible into the largest bin. When the bisection got to try the largest
+	// bin, its packings are the ones left in results.
+	if (sizes.empty() || sizes.back().first != largestSize || sizes.back().second != largestSize)
+	{
+		std::vector<int> widths(1, largestSize);
+		std::vector<int> heights(1, largestSize);
+		PackSizes(rects, widths, heights, results);
+	}
+
+	result.width = largestSize;
+	result.height = largestSize;
+	result.rects.clear();
+	result.occupancy = 0;
+	if (results.empty())
+		return false;
+
+	size_t best = 0;
+	for(size_t i = 1; i < results.size(); ++i)
+		if (IsBetterPacking(results[i], results[best]))
+			best = i;
+	result = results[best];
+	return false;
+}
+
+bool PackingSearch::PackPages(const std::vector<TPRectSize> &rects, std::vector<PackingResult> &pages) const
+{
+	pages.clear();
+
+	int largestSize = MinBinSize;
+	while(largestSize * 2 <= maxSize)
+		largestSize *= 2;
+
+	// Rectangles that don't fit into the largest bin can't go on any page.
+	std::vector<TPRectSize> remaining;
+	for(size_t i = 0; i < rects.size(); ++i)
+		if (std::min(rects[i].width, rects[i].height) <= largestSize && std::max(rects[i].width, rects[i].height) <= largestSize)
+			remaining.push_back(rects[i]);
+	bool allPacked = (remaining.size() == rects.size());
+
+	// Fill full size pages until the rest fits on a single, possibly smaller, page. Without any rectangles
+	// that is a single page of the smallest size, so a sprite sheet without images is still written.
+	do
+	{
+		pages.push_back(PackingResult());
+		PackingResult &page = pages.back();
+
+		if (Pack(remaining, page))
+			break;
+
+		if (page.rects.empty())
+		{
+			pages.pop_back();
+			allPacked = false;
+			break;
+		}
+
+		std::vector<char> placed(rects.size(), 0);
+		for(size_t i = 0; i < page.rects.size(); ++i)
+			placed[page.rects[i].idx] = 1;
+
+		std::vector<TPRectSize> rest;
+		for(size_t i = 0; i < remaining.size(); ++i)
+			if (!placed[remaining[i].idx])
+				rest.push_back(remaining[i]);
+		remaining.swap(rest);
+	}
+	while(!remaining.empty());
+
+	return allPacked;
+}
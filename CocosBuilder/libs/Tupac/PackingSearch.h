@@ -0,0 +1,104 @@
+/** @file PackingSearch.h
+
+	@brief Searches for the smallest bin a set of rectangles can be packed into, trying several
+	MaxRectsBinPack heuristics and insertion orders in parallel.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "Rect.h"
+#include "MaxRectsBinPack.h"
+
+/// Specifies the order in which a packing strategy inserts the rectangles into the bin.
+enum PackingOrder
+{
+	PackingOrderBatch, ///< Lets MaxRectsBinPack pick the best scoring rectangle to insert next.
+	PackingOrderArea, ///< Inserts the rectangles one at a time, largest area first.
+	PackingOrderLongSide, ///< Inserts the rectangles one at a time, longest side first.
+	PackingOrderPerimeter ///< Inserts the rectangles one at a time, largest perimeter first.
+};
+
+/// A way of packing rectangles into a bin.
+struct PackingStrategy
+{
+	MaxRectsBinPack::FreeRectChoiceHeuristic heuristic;
+	PackingOrder order;
+};
+
+/// The outcome of packing a set of rectangles into a bin.
+struct PackingResult
+{
+	int width;
+	int height;
+
+	/// The packed rectangles. TPRect::idx is the idx of the TPRectSize the rectangle was created from.
+	std::vector<TPRect> rects;
+
+	/// The ratio of the packed area to the bin area, as returned by MaxRectsBinPack::Occupancy.
+	float occupancy;
+
+	PackingStrategy strategy;
+};
+
+/** PackingSearch finds the smallest power-of-two sized bin that a set of rectangles can be packed into.
+	The bin sizes between the smallest area that can hold the rectangles and the largest size allowed
+	are bisected on their area. For every area tried, all sizes of that area are packed with all
+	strategies concurrently, which with the default strategies and a maximum size of 4096 is up to
+	10 sizes times 16 strategies per bisection step. */
+class PackingSearch
+{
+public:
+	PackingSearch();
+
+	/// Sets the largest width and height the bin may have. Defaults to 2048.
+	void SetMaxSize(int maxSize);
+
+	/// Restricts the search to square bins, as needed for PVRTC textures. Defaults to false.
+	void SetSquare(bool square);
+
+	/// Sets the strategies to try, in order of preference. The default tries every FreeRectChoiceHeuristic
+	/// but RectContactPointRule with every PackingOrder, starting with RectBestShortSideFit in batch mode.
+	/// RectContactPointRule scores every placement against all packed rectangles, which makes it several
+	/// times slower than the others for many small rectangles, so it is only tried when set here. It can't
+	/// be used in batch mode, where it would rescore every rectangle after every placement.
+	void SetStrategies(const std::vector<PackingStrategy> &strategies);
+
+	/// Sets the largest number of threads to pack with, or 0 to use all processors. Defaults to 0.
+	void SetNumThreads(int numThreads);
+
+	/// Packs the rectangles into the smallest bin found.
+	/// @param result [out] The chosen packing. Of the strategies that fit all rectangles into a bin of the
+	///   smallest area found, the one with the highest occupancy wins. As all bins of that area have the same
+	///   occupancy, ties go to the squarest size, then to the packing whose rectangles cover the smallest
+	///   bounding box, then to the narrower size and the strategy listed first.
+	/// @return True if all rectangles fitted. If not, result holds the packing with the highest occupancy
+	///   in a bin of the largest power-of-two size allowed.
+	bool Pack(const std::vector<TPRectSize> &rects, PackingResult &result) const;
+
+	/// Packs the rectangles into as many bins as needed. Every bin but the last is of the largest size
+	/// allowed and filled with the packing of the highest occupancy found; the last bin is the smallest
+	/// one the remaining rectangles fit into.
+	/// @param pages [out] The packing of each bin, at least one even if there are no rectangles to pack.
+	///   TPRect::idx must be in [0, rects.size()).
+	/// @return True if all rectangles were packed, false if some are larger than the largest bin allowed.
+	bool PackPages(const std::vector<TPRectSize> &rects, std::vector<PackingResult> &pages) const;
+
+	/// Packs the rectangles into a bin of the given size using a single strategy.
+	/// @return True if all rectangles fitted.
+	static bool PackWithStrategy(const std::vector<TPRectSize> &rects, int width, int height,
+		const PackingStrategy &strategy, PackingResult &result);
+
+private:
+	int maxSize;
+	bool square;
+	int numThreads;
+	std::vector<PackingStrategy> strategies;
+
+	/// Packs the rectangles into each of the given bin sizes with every strategy, concurrently.
+	/// @return The index into results of the best packing that fits all rectangles, or -1 if none does.
+	int PackSizes(const std::vector<TPRectSize> &rects, const std::vector<int> &widths,
+		const std::vector<int> &heights, std::vector<PackingResult> &results) const;
+};
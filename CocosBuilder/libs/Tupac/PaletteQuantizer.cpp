@@ -0,0 +1,340 @@
+/** @file PaletteQuantizer.cpp
+
+	@brief Reduces images to at most 256 colors, for 8 bit PNG files.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <stdint.h>
+#include <algorithm>
+
+#include "PaletteQuantizer.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	/// The histogram keeps 5 bits of each premultiplied channel, with the exact mean of every bucket.
+	const int HistogramBits = 5;
+	const int NumBuckets = 1 << (HistogramBits * 4);
+
+	/// The largest number of k-means passes, which stop early once no color changes its cluster.
+	const int MaxRefinements = 8;
+
+	/// The number of histogram colors assigned to clusters per ParallelFor iteration.
+	const int ColorsPerChunk = 4096;
+
+	int Bucket(const int *color)
+	{
+		int shift = 8 - HistogramBits;
+		return (color[0] >> shift) << (HistogramBits*3) | (color[1] >> shift) << (HistogramBits*2)
+			| (color[2] >> shift) << HistogramBits | (color[3] >> shift);
+	}
+
+	void Premultiply(const unsigned char *p, int *color)
+	{
+		for(int c = 0; c < 3; ++c)
+			color[c] = (p[c] * p[3] + 127) / 255;
+		color[3] = p[3];
+	}
+
+	/// A distinct color of the image, premultiplied, and the number of pixels of it.
+	struct HistogramColor
+	{
+		float color[4];
+		float count;
+	};
+
+	template<class Color>
+	int NearestColor(const Color *color, const std::vector<float> &palette)
+	{
+		int best = 0;
+		float bestDistance = 0;
+		for(int i = 0; i < (int)palette.size() / 4; ++i)
+		{
+			const float *p = &palette[i*4];
+			float distance = 0;
+			for(int c = 0; c < 4; ++c)
+				distance += (color[c] - p[c]) * (color[c] - p[c]);
+			if (i == 0 || distance < bestDistance)
+			{
+				best = i;
+				bestDistance = distance;
+			}
+		}
+		return best;
+	}
+
+	/// A set of histogram colors that median cut represents by one palette color.
+	struct Box
+	{
+		int begin;
+		int end;
+		double error; ///< The summed squared distances of the pixels to the mean.
+		int channel; ///< The channel with the largest variance, which the box is split along.
+	};
+
+	Box MakeBox(const std::vector<HistogramColor> &colors, int begin, int end)
+	{
+		Box box = { begin, end, 0, 0 };
+		double count = 0, sum[4] = { 0, 0, 0, 0 }, squares[4] = { 0, 0, 0, 0 };
+		for(int i = begin; i < end; ++i)
+		{
+			const HistogramColor &h = colors[i];
+			count += h.count;
+			for(int c = 0; c < 4; ++c)
+			{
+				sum[c] += h.color[c] * h.count;
+				squares[c] += (double)h.color[c] * h.color[c] * h.count;
+			}
+		}
+
+		double largest = -1;
+		for(int c = 0; c < 4; ++c)
+		{
+			double error = squares[c] - sum[c] * sum[c] / count;
+			box.error += error;
+			if (error > largest)
+			{
+				largest = error;
+				box.channel = c;
+			}
+		}
+		return box;
+	}
+
+	struct ChannelLess
+	{
+		int channel;
+
+		bool operator()(const HistogramColor &a, const HistogramColor &b) const
+		{
+			return a.color[channel] < b.color[channel];
+		}
+	};
+
+	/// Splits the box with the largest error at the median of its widest channel until there are enough.
+	void MedianCut(std::vector<HistogramColor> &colors, int maxColors, std::vector<Box> &boxes)
+	{
+		boxes.clear();
+		if (colors.empty())
+			return;
+		boxes.push_back(MakeBox(colors, 0, (int)colors.size()));
+
+		while((int)boxes.size() < maxColors)
+		{
+			int widest = 0;
+			for(int i = 1; i < (int)boxes.size(); ++i)
+				if (boxes[i].error > boxes[widest].error)
+					widest = i;
+			Box box = boxes[widest];
+			if (box.error <= 0 || box.end - box.begin < 2)
+				break;
+
+			ChannelLess less = { box.channel };
+			std::sort(colors.begin() + box.begin, colors.begin() + box.end, less);
+
+			double total = 0, half = 0;
+			for(int i = box.begin; i < box.end; ++i)
+				total += colors[i].count;
+			int split = box.begin + 1;
+			for(; split < box.end - 1; ++split)
+			{
+				half += colors[split - 1].count;
+				if (half * 2 >= total)
+					break;
+			}
+
+			boxes[widest] = MakeBox(colors, box.begin, split);
+			boxes.push_back(MakeBox(colors, split, box.end));
+		}
+	}
+
+	struct ClusterAssigner
+	{
+		const std::vector<HistogramColor> *colors;
+		const std::vector<float> *palette;
+		std::vector<int> *clusters;
+		std::vector<char> *changed;
+
+		void operator()(int chunk)
+		{
+			int end = std::min((int)colors->size(), (chunk + 1) * ColorsPerChunk);
+			(*changed)[chunk] = 0;
+			for(int i = chunk * ColorsPerChunk; i < end; ++i)
+			{
+				int cluster = NearestColor((*colors)[i].color, *palette);
+				if (cluster != (*clusters)[i])
+				{
+					(*clusters)[i] = cluster;
+					(*changed)[chunk] = 1;
+				}
+			}
+		}
+	};
+
+	/// Moves each palette color to the mean of the histogram colors nearest to it.
+	void RefinePalette(const std::vector<HistogramColor> &colors, std::vector<float> &palette, int numThreads)
+	{
+		int numChunks = ((int)colors.size() + ColorsPerChunk - 1) / ColorsPerChunk;
+		std::vector<int> clusters(colors.size(), -1);
+		std::vector<char> changed(numChunks);
+
+		for(int pass = 0; pass < MaxRefinements; ++pass)
+		{
+			ClusterAssigner assigner = { &colors, &palette, &clusters, &changed };
+			ParallelFor(numChunks, assigner, numThreads);
+			if (std::find(changed.begin(), changed.end(), 1) == changed.end())
+				break;
+
+			int numColors = (int)palette.size() / 4;
+			std::vector<double> sums(numColors * 5, 0);
+			for(size_t i = 0; i < colors.size(); ++i)
+			{
+				double *sum = &sums[clusters[i] * 5];
+				for(int c = 0; c < 4; ++c)
+					sum[c] += colors[i].color[c] * colors[i].count;
+				sum[4] += colors[i].count;
+			}
+			for(int i = 0; i < numColors; ++i)
+				if (sums[i*5 + 4] > 0)
+					for(int c = 0; c < 4; ++c)
+						palette[i*4 + c] = (float)(sums[i*5 + c] / sums[i*5 + 4]);
+		}
+	}
+}
+
+void QuantizePalette(const RGBAImage &image, int maxColors, bool dither, IndexedImage &indexed, int numThreads)
+{
+	maxColors = std::max(2, std::min(maxColors, 256));
+	size_t numPixels = (size_t)image.width * image.height;
+
+	// Gather the distinct colors, apart from fully transparent ones which get a palette color of their own
+	std::vector<int> bucketColors(NumBuckets, -1);
+	std::vector<uint64_t> sums;
+	bool hasTransparent = false;
+	for(size_t i = 0; i < numPixels; ++i)
+	{
+		const unsigned char *p = &image.pixels[i*4];
+		if (!p[3])
+		{
+			hasTransparent = true;
+			continue;
+		}
+
+		int color[4];
+		Premultiply(p, color);
+		int &index = bucketColors[Bucket(color)];
+		if (index < 0)
+		{
+			index = (int)sums.size() / 5;
+			sums.resize(sums.size() + 5, 0);
+		}
+		uint64_t *sum = &sums[index * 5];
+		for(int c = 0; c < 4; ++c)
+			sum[c] += color[c];
+		sum[4]++;
+	}
+
+	std::vector<HistogramColor> colors(sums.size() / 5);
+	for(size_t i = 0; i < colors.size(); ++i)
+	{
+		const uint64_t *sum = &sums[i * 5];
+		for(int c = 0; c < 4; ++c)
+			colors[i].color[c] = (float)sum[c] / sum[4];
+		colors[i].count = (float)sum[4];
+	}
+
+	std::vector<Box> boxes;
+	MedianCut(colors, maxColors - (hasTransparent ? 1 : 0), boxes);
+
+	std::vector<float> palette;
+	for(size_t i = 0; i < boxes.size(); ++i)
+	{
+		double sum[4] = { 0, 0, 0, 0 }, count = 0;
+		for(int j = boxes[i].begin; j < boxes[i].end; ++j)
+		{
+			for(int c = 0; c < 4; ++c)
+				sum[c] += colors[j].color[c] * colors[j].count;
+			count += colors[j].count;
+		}
+		for(int c = 0; c < 4; ++c)
+			palette.push_back((float)(sum[c] / count));
+	}
+	RefinePalette(colors, palette, numThreads);
+
+	// Round the palette, keeping the translucent colors first
+	std::vector<unsigned char> premultiplied;
+	if (hasTransparent || palette.empty())
+		premultiplied.resize(4, 0);
+	for(size_t i = 0; i < palette.size(); i += 4)
+	{
+		int alpha = std::max(1, std::min((int)(palette[i + 3] + 0.5f), 255));
+		for(int c = 0; c < 3; ++c)
+			premultiplied.push_back((unsigned char)std::max(0, std::min((int)(palette[i + c] + 0.5f), alpha)));
+		premultiplied.push_back((unsigned char)alpha);
+	}
+	int numColors = (int)premultiplied.size() / 4;
+	std::vector<int> order;
+	for(int pass = 0; pass < 2; ++pass)
+		for(int i = 0; i < numColors; ++i)
+			if ((premultiplied[i*4 + 3] == 255) == (pass == 1))
+				order.push_back(i);
+
+	palette.resize(numColors * 4);
+	indexed.palette.resize(numColors * 4);
+	for(int i = 0; i < numColors; ++i)
+	{
+		const unsigned char *p = &premultiplied[order[i] * 4];
+		unsigned char *out = &indexed.palette[i*4];
+		for(int c = 0; c < 4; ++c)
+			palette[i*4 + c] = p[c];
+		for(int c = 0; c < 3; ++c)
+			out[c] = p[3] ? (unsigned char)std::min((p[c] * 255 + p[3]/2) / p[3], 255) : 0;
+		out[3] = p[3];
+	}
+
+	// Map the pixels, looking up the nearest palette color once per histogram bucket
+	indexed.width = image.width;
+	indexed.height = image.height;
+	indexed.indices.resize(numPixels);
+	std::vector<short> nearest(NumBuckets, -1);
+	std::vector<float> errors((size_t)(image.width + 2) * 4 * 2, 0);
+	for(int y = 0; y < image.height; ++y)
+	{
+		// Floyd-Steinberg error diffusion into this row and the next
+		float *error = &errors[(size_t)(y & 1) * (image.width + 2) * 4 + 4];
+		float *nextError = &errors[(size_t)((y + 1) & 1) * (image.width + 2) * 4 + 4];
+		std::fill(nextError - 4, nextError + (image.width + 1) * 4, 0.0f);
+
+		const unsigned char *p = image.Row(y);
+		unsigned char *out = &indexed.indices[(size_t)y * image.width];
+		for(int x = 0; x < image.width; ++x, p += 4, error += 4, nextError += 4)
+		{
+			if (!p[3])
+			{
+				out[x] = 0;
+				continue;
+			}
+
+			int color[4];
+			Premultiply(p, color);
+			if (dither)
+				for(int c = 0; c < 4; ++c)
+					color[c] = std::max(0, std::min((int)(color[c] + error[c] + 0.5f), 255));
+
+			short &index = nearest[Bucket(color)];
+			if (index < 0)
+				index = (short)NearestColor(color, palette);
+			out[x] = (unsigned char)index;
+
+			if (dither)
+				for(int c = 0; c < 4; ++c)
+				{
+					float e = color[c] - palette[index*4 + c];
+					error[c + 4] += e * 7 / 16;
+					nextError[c - 4] += e * 3 / 16;
+					nextError[c] += e * 5 / 16;
+					nextError[c + 4] += e / 16;
+				}
+		}
+	}
+}
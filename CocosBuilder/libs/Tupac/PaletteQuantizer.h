@@ -0,0 +1,31 @@
+/** @file PaletteQuantizer.h
+
+	@brief Reduces images to at most 256 colors, for 8 bit PNG files.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "AtlasCompositor.h"
+
+/// An image of palette indices, one byte per pixel. Rows are stored top to bottom, without padding.
+struct IndexedImage
+{
+	int width;
+	int height;
+	std::vector<unsigned char> palette; ///< RGBA colors, 4 bytes each, not premultiplied by alpha.
+	std::vector<unsigned char> indices;
+
+	int NumColors() const { return (int)palette.size() / 4; }
+};
+
+/// Finds a palette for an image and maps its pixels to it.
+/// The palette is found by median cut on a histogram of the colors premultiplied by alpha, then refined
+/// by k-means. Fully transparent pixels all map to a single transparent color, and the translucent
+/// colors come first in the palette so the PNG transparency chunk is short.
+/// @param maxColors The largest number of colors of the palette, from 2 to 256.
+/// @param dither Diffuses the error of each pixel to its neighbours, which hides banding in gradients.
+/// @param numThreads The largest number of threads to refine the palette with, or 0 to use all processors.
+void QuantizePalette(const RGBAImage &image, int maxColors, bool dither, IndexedImage &indexed, int numThreads = 0);
@@ -0,0 +1,75 @@
+/** @file ParallelFor.h
+
+	@brief Runs the iterations of a loop on a set of worker threads. The threads are started by every call
+	and joined before it returns, rather than kept in a pool, which costs some tens of microseconds a call.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <vector>
+
+/// Returns the number of worker threads ParallelFor uses, which is the number of online processors.
+inline int ParallelForThreadCount()
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
+
+template<class Body>
+struct ParallelForState
+{
+	Body *body;
+	int count;
+	volatile int next;
+
+	static void *Run(void *arg)
+	{
+		ParallelForState *state = (ParallelForState *)arg;
+		for(;;)
+		{
+			int i = __sync_fetch_and_add(&state->next, 1);
+			if (i >= state->count)
+				break;
+			(*state->body)(i);
+		}
+		return 0;
+	}
+};
+
+/// Calls body(i) for every i in [0, count). The calls are spread over the worker threads and the
+/// calling thread, in no particular order, and all of them have returned when ParallelFor returns.
+/// Iterations must not depend on each other; each should only write to its own part of the output.
+/// @param maxThreads The largest number of threads to use, including the calling thread, or 0 to use
+///   ParallelForThreadCount threads.
+template<class Body>
+void ParallelFor(int count, Body &body, int maxThreads = 0)
+{
+	ParallelForState<Body> state;
+	state.body = &body;
+	state.count = count;
+	state.next = 0;
+
+	int numThreads = ParallelForThreadCount();
+	if (maxThreads > 0 && numThreads > maxThreads)
+		numThreads = maxThreads;
+	if (numThreads > count)
+		numThreads = count;
+
+	// The calling thread works too, so one thread less needs to be started.
+	std::vector<pthread_t> threads;
+	for(int i = 1; i < numThreads; ++i)
+	{
+		pthread_t thread;
+		if (pthread_create(&thread, 0, &ParallelForState<Body>::Run, &state) == 0)
+			threads.push_back(thread);
+	}
+
+	ParallelForState<Body>::Run(&state);
+
+	for(size_t i = 0; i < threads.size(); ++i)
+		pthread_join(threads[i], 0);
+}
@@ -0,0 +1,36 @@
+/** @file SHA256.h
+
+	@brief Computes SHA-256 digests, used to identify the inputs of sprite sheets by their content.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+class SHA256
+{
+public:
+	static const int DigestSize = 32;
+
+	SHA256();
+
+	/// Adds data to the digest.
+	void Update(const void *data, size_t size);
+
+	/// Finishes the digest. The object must not be updated afterwards.
+	void Final(unsigned char digest[DigestSize]);
+
+	/// Finishes the digest and returns it as a lower case hexadecimal string.
+	std::string FinalHex();
+
+private:
+	void ProcessBlock(const unsigned char *block);
+
+	uint32_t state[8];
+	uint64_t length;
+	unsigned char buffer[64];
+	size_t bufferSize;
+};
@@ -0,0 +1,220 @@
+/** @file SpritePolygon.cpp
+
+	@brief Outlines the opaque pixels of a sprite with a small convex polygon, so that a runtime can draw
+	the sprite as a triangle mesh instead of a quad and skip most of its transparent pixels.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cmath>
+#include <algorithm>
+
+#include "SpritePolygon.h"
+
+namespace
+{
+	/// The polygon is only used if it covers less than this part of the trimmed rectangle. Otherwise
+	/// the extra vertices cost more than the transparent pixels they save.
+	const double MaxPolygonCoverage = 0.9;
+
+	long long Cross(const PolygonVertex &o, const PolygonVertex &a, const PolygonVertex &b)
+	{
+		return (long long)(a.x - o.x) * (b.y - o.y) - (long long)(a.y - o.y) * (b.x - o.x);
+	}
+
+	bool VertexLess(const PolygonVertex &a, const PolygonVertex &b)
+	{
+		return a.x < b.x || (a.x == b.x && a.y < b.y);
+	}
+
+	bool VertexEqual(const PolygonVertex &a, const PolygonVertex &b)
+	{
+		return a.x == b.x && a.y == b.y;
+	}
+
+	/// Computes the convex hull of the points with Andrew's monotone chain algorithm. Collinear points
+	/// are left out. The points are sorted in place.
+	void ConvexHull(std::vector<PolygonVertex> &points, std::vector<PolygonVertex> &hull)
+	{
+		std::sort(points.begin(), points.end(), VertexLess);
+		points.erase(std::unique(points.begin(), points.end(), VertexEqual), points.end());
+
+		hull.clear();
+		if (points.size() < 3)
+		{
+			hull = points;
+			return;
+		}
+
+		hull.resize(points.size() * 2);
+		size_t k = 0;
+		for(size_t i = 0; i < points.size(); ++i)
+		{
+			while(k >= 2 && Cross(hull[k-2], hull[k-1], points[i]) <= 0)
+				--k;
+			hull[k++] = points[i];
+		}
+		for(size_t i = points.size() - 1, lower = k + 1; i > 0; --i)
+		{
+			while(k >= lower && Cross(hull[k-2], hull[k-1], points[i-1]) <= 0)
+				--k;
+			hull[k++] = points[i-1];
+		}
+		hull.resize(k - 1);
+	}
+
+	/// Returns twice the signed area of the polygon, which is positive for the hulls built by ConvexHull.
+	long long DoubleArea(const std::vector<PolygonVertex> &polygon)
+	{
+		long long area = 0;
+		for(size_t i = 0; i < polygon.size(); ++i)
+		{
+			const PolygonVertex &a = polygon[i];
+			const PolygonVertex &b = polygon[(i + 1) % polygon.size()];
+			area += (long long)a.x * b.y - (long long)a.y * b.x;
+		}
+		return area;
+	}
+
+	/// Works out where the edges before and after edge i meet if they are extended, which removes edge i
+	/// from the polygon. The corner is rounded to a pixel corner that keeps the polygon convex and
+	/// containing the current one.
+	/// @param addedArea [out] Twice the area the polygon grows by.
+	/// @return False if the edges diverge or no such corner lies within the width x height rectangle.
+	bool ExtendEdges(const std::vector<PolygonVertex> &polygon, size_t i, int width, int height, PolygonVertex &corner, long long &addedArea)
+	{
+		size_t n = polygon.size();
+		const PolygonVertex &before = polygon[(i + n - 2) % n];
+		const PolygonVertex &a = polygon[(i + n - 1) % n];
+		const PolygonVertex &b = polygon[i];
+		const PolygonVertex &c = polygon[(i + 1) % n];
+		const PolygonVertex &d = polygon[(i + 2) % n];
+		const PolygonVertex &after = polygon[(i + 3) % n];
+
+		// Solve b + t*(b - a) = c + u*(c - d) for t, u >= 0
+		double rx = b.x - a.x, ry = b.y - a.y;
+		double sx = c.x - d.x, sy = c.y - d.y;
+		double denom = rx * sy - ry * sx;
+		if (fabs(denom) < 1e-9)
+			return false;
+
+		double t = ((c.x - b.x) * sy - (c.y - b.y) * sx) / denom;
+		double u = ((c.x - b.x) * ry - (c.y - b.y) * rx) / denom;
+		if (t < 0 || u < 0)
+			return false;
+
+		double x = b.x + t * rx;
+		double y = b.y + t * ry;
+
+		long long oldArea = (long long)a.x * b.y - (long long)a.y * b.x + (long long)b.x * c.y - (long long)b.y * c.x
+			+ (long long)c.x * d.y - (long long)c.y * d.x;
+
+		bool found = false;
+		for(int j = 0; j < 4; ++j)
+		{
+			PolygonVertex p;
+			p.x = (j & 1) ? (int)ceil(x) : (int)floor(x);
+			p.y = (j & 2) ? (int)ceil(y) : (int)floor(y);
+			if (p.x < 0 || p.y < 0 || p.x > width || p.y > height)
+				continue;
+
+			// The new edges must keep b and c inside, and the polygon must stay convex
+			if (Cross(a, p, b) < 0 || Cross(p, d, c) < 0)
+				continue;
+			if (Cross(before, a, p) < 0 || Cross(a, p, d) <= 0 || Cross(p, d, after) < 0)
+				continue;
+
+			long long area = (long long)a.x * p.y - (long long)a.y * p.x + (long long)p.x * d.y - (long long)p.y * d.x - oldArea;
+			if (!found || area < addedArea)
+			{
+				found = true;
+				corner = p;
+				addedArea = area;
+			}
+		}
+		return found;
+	}
+
+	void SetRectangle(int width, int height, SpritePolygon &polygon)
+	{
+		polygon.vertices.resize(4);
+		polygon.vertices[0].x = 0;
+		polygon.vertices[0].y = 0;
+		polygon.vertices[1].x = 0;
+		polygon.vertices[1].y = height;
+		polygon.vertices[2].x = width;
+		polygon.vertices[2].y = height;
+		polygon.vertices[3].x = width;
+		polygon.vertices[3].y = 0;
+	}
+}
+
+void TraceSpritePolygon(const RGBAImage &image, const TPRect &trimRect, int maxVertices, SpritePolygon &polygon)
+{
+	int width = trimRect.width;
+	int height = trimRect.height;
+
+	// The hull of the outer corners of the leftmost and rightmost opaque pixel of every row contains all
+	// opaque pixels.
+	std::vector<PolygonVertex> points;
+	for(int y = 0; y < height; ++y)
+	{
+		const unsigned char *row = image.Row(trimRect.y + y);
+		int left = FirstOpaquePixel(row, trimRect.x, trimRect.x + width);
+		if (left == trimRect.x + width)
+			continue;
+		int right = LastOpaquePixel(row, left, trimRect.x + width) + 1;
+
+		PolygonVertex corners[4] = { { left, y }, { left, y + 1 }, { right, y }, { right, y + 1 } };
+		for(int i = 0; i < 4; ++i)
+		{
+			corners[i].x -= trimRect.x;
+			points.push_back(corners[i]);
+		}
+	}
+
+	std::vector<PolygonVertex> hull;
+	ConvexHull(points, hull);
+
+	// Remove the edge whose removal adds the least area until the polygon is small enough
+	std::vector<PolygonVertex> &reduced = hull;
+	while(reduced.size() > (size_t)maxVertices)
+	{
+		size_t bestEdge = reduced.size();
+		PolygonVertex bestCorner = { 0, 0 };
+		long long bestArea = 0;
+
+		for(size_t i = 0; i < reduced.size(); ++i)
+		{
+			PolygonVertex corner;
+			long long area = 0;
+			if (ExtendEdges(reduced, i, width, height, corner, area) && (bestEdge == reduced.size() || area < bestArea))
+			{
+				bestEdge = i;
+				bestCorner = corner;
+				bestArea = area;
+			}
+		}
+
+		if (bestEdge == reduced.size())
+			break;
+
+		reduced[bestEdge] = bestCorner;
+		reduced.erase(reduced.begin() + (bestEdge + 1) % reduced.size());
+	}
+
+	polygon.triangles.clear();
+
+	if (reduced.size() < 3 || reduced.size() > (size_t)maxVertices
+		|| DoubleArea(reduced) >= MaxPolygonCoverage * 2 * width * height)
+		SetRectangle(width, height, polygon);
+	else
+		polygon.vertices = reduced;
+
+	// A convex polygon is split into a fan of triangles around its first vertex
+	for(int i = 1; i + 1 < (int)polygon.vertices.size(); ++i)
+	{
+		polygon.triangles.push_back(0);
+		polygon.triangles.push_back(i);
+		polygon.triangles.push_back(i + 1);
+	}
+}
@@ -0,0 +1,36 @@
+/** @file SpritePolygon.h
+
+	@brief Outlines the opaque pixels of a sprite with a small convex polygon, so that a runtime can draw
+	the sprite as a triangle mesh instead of a quad and skip most of its transparent pixels.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "AtlasCompositor.h"
+
+struct PolygonVertex
+{
+	int x;
+	int y;
+};
+
+/// A convex polygon that contains all pixels of a sprite that are not fully transparent.
+struct SpritePolygon
+{
+	/// The vertices in order around the polygon, in pixel corner coordinates relative to the top left
+	/// corner of the trimmed rectangle of the sprite.
+	std::vector<PolygonVertex> vertices;
+
+	/// Indices into vertices, three per triangle.
+	std::vector<int> triangles;
+};
+
+/// Computes the convex hull of the pixels of an image that are not fully transparent and reduces it to at
+/// most maxVertices vertices by extending edges, which only ever grows the polygon. If that fails, or the
+/// polygon would cover most of the trimmed rectangle anyway, the polygon is the trimmed rectangle itself.
+/// @param trimRect The trimmed rectangle of the image, as returned by TrimmedRect.
+/// @param maxVertices The largest number of vertices the polygon may have, at least 4.
+void TraceSpritePolygon(const RGBAImage &image, const TPRect &trimRect, int maxVertices, SpritePolygon &polygon);
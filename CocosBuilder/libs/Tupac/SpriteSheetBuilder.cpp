@@ -0,0 +1,434 @@
+/** @file SpriteSheetBuilder.cpp
+
+	@brief Builds cocos2d sprite sheets from PNG images: trims, deduplicates and packs the images onto
+	as many pages as needed, and writes the texture and property list of every page. Both the Tupac
+	class and the tupac command line tool build their sprite sheets with it.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cstdarg>
+#include <cstdio>
+#include <algorithm>
+
+#include "SpriteSheetBuilder.h"
+#include "AtlasCompositor.h"
+#include "AlphaBleed.h"
+#include "PNGCodec.h"
+#include "PaletteQuantizer.h"
+#include "WebPEncoder.h"
+#include "SpritePolygon.h"
+#include "TextureQuantizer.h"
+#include "PVRFile.h"
+#include "CCZFile.h"
+#include "ParallelFor.h"
+#include "SpriteSheetPlist.h"
+
+namespace
+{
+	/// The largest number of vertices of the polygons sprites are outlined with in polygon mode.
+	const int MaxPolygonVertices = 8;
+
+	/// The zlib compression level of ccz files.
+	const int CCZCompressionLevel = 9;
+
+	std::string FormatMessage(const char *format, ...)
+	{
+		char message[1024];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(message, sizeof(message), format, args);
+		va_end(args);
+		return message;
+	}
+
+	std::string LastPathComponent(const std::string &path)
+	{
+		size_t slash = path.rfind('/');
+		return slash == std::string::npos ? path : path.substr(slash + 1);
+	}
+
+	bool ImageNameLess(const SpriteSheetImage &a, const SpriteSheetImage &b)
+	{
+		return a.name < b.name;
+	}
+
+	/// The images of a sprite sheet, which the pages draw their frames from.
+	struct SheetImages
+	{
+		std::vector<SpriteSheetImage> images;
+		std::vector<RGBAImage> pixels;
+		std::vector<AtlasFrame> frames;
+
+		/// For every image that is packed, the indices of the images with the same trimmed pixels.
+		std::vector<std::vector<int> > aliases;
+
+		/// In polygon mode, the outline of every image that is packed.
+		std::vector<SpritePolygon> polygons;
+	};
+
+	/// The files and messages of one page, which are written concurrently with the others.
+	struct PageOutput
+	{
+		std::vector<std::string> files;
+		std::vector<std::string> errors;
+		std::vector<std::string> notices;
+	};
+
+	/// Converts an image to the texels of a PVR pixel format and appends them to the texture data. The image
+	/// is premultiplied in place, as cocos2d expects PVR textures to have premultiplied alpha.
+	/// @param logName The name the quality of PVRTC compression is reported under, or empty to not report it.
+	PVRPixelType AppendTexels(RGBAImage &image, const SpriteSheetSettings &settings, int numThreads,
+		const std::string &logName, std::vector<unsigned char> &data, PageOutput &output)
+	{
+		PremultiplyAlpha(image);
+
+		std::vector<unsigned char> texels;
+		PVRPixelType pixelType;
+		DitherMode dither = settings.dither ? settings.ditherMode : DitherNone;
+
+		if (settings.imageFormat == SpriteSheetImageFormatPVRTC4 || settings.imageFormat == SpriteSheetImageFormatPVRTC2)
+		{
+			bool twoBpp = settings.imageFormat == SpriteSheetImageFormatPVRTC2;
+			double psnr = EncodePVRTC(image, twoBpp, settings.pvrtcQuality, texels, numThreads);
+			pixelType = twoBpp ? PVRPixelTypePVRTC2 : PVRPixelTypePVRTC4;
+
+			if (!logName.empty())
+				output.notices.push_back(FormatMessage("Compressed %s to PVRTC %d bpp, PSNR %.2f dB", logName.c_str(), twoBpp ? 2 : 4, psnr));
+		}
+		else if (settings.imageFormat == SpriteSheetImageFormatPVRRGBA8888)
+		{
+			texels.swap(image.pixels);
+			pixelType = PVRPixelTypeRGBA8888;
+		}
+		else if (settings.imageFormat == SpriteSheetImageFormatPVRRGBA4444)
+		{
+			QuantizeImage(image, TexelFormatRGBA4444, dither, texels);
+			pixelType = PVRPixelTypeRGBA4444;
+		}
+		else
+		{
+			QuantizeImage(image, TexelFormatRGB565, dither, texels);
+			pixelType = PVRPixelTypeRGB565;
+		}
+
+		if (data.empty())
+			data.swap(texels);
+		else
+			data.insert(data.end(), texels.begin(), texels.end());
+		return pixelType;
+	}
+
+	/// Draws a page and writes its texture.
+	/// @param textureFileName [out] The name the property list refers to the texture by.
+	/// @return False if the texture could not be written.
+	bool WriteTexture(const PackingResult &page, const SheetImages &sheet, const SpriteSheetSettings &settings,
+		const std::string &pageName, int numThreads, std::string &textureFileName, PageOutput &output)
+	{
+		RGBAImage atlas;
+		atlas.Init(page.width, page.height);
+		ComposeAtlas(sheet.frames, page.rects, settings.FrameMargin(), atlas);
+
+		// Fill the margins of the frames, so that filtering doesn't blend their edges with black
+		if (settings.extrude > 0 || settings.alphaBleed)
+		{
+			int bleedPasses = settings.alphaBleed ? std::max(settings.FrameMargin(), 1) : 0;
+			FillFrameMargins(page.rects, settings.FrameMargin(), settings.extrude, bleedPasses, atlas, numThreads);
+		}
+
+		std::string filename = pageName + ".png";
+		textureFileName = filename;
+		bool saved;
+
+		if (settings.IsPVR())
+		{
+			// Filter the mipmaps before premultiplying, each frame only from its own packed rectangle
+			std::vector<RGBAImage> mipmaps;
+			if (settings.mipmaps)
+				GenerateMipmaps(atlas, page.rects, settings.mipmapFilter, mipmaps, numThreads);
+
+			std::vector<unsigned char> texels;
+			PVRPixelType pixelType = AppendTexels(atlas, settings, numThreads, LastPathComponent(pageName), texels, output);
+			for(size_t i = 0; i < mipmaps.size(); ++i)
+				AppendTexels(mipmaps[i], settings, numThreads, std::string(), texels, output);
+
+			std::vector<unsigned char> pvr;
+			EncodePVR(page.width, page.height, pixelType, texels, pvr, (int)mipmaps.size());
+
+			filename = textureFileName = pageName + (settings.compress ? ".pvr.ccz" : ".pvr");
+			if (settings.compress)
+				saved = SaveCCZ(filename.c_str(), &pvr[0], pvr.size(), CCZCompressionLevel, numThreads);
+			else
+				saved = SaveFile(filename.c_str(), pvr);
+		}
+		else if (settings.imageFormat == SpriteSheetImageFormatPNG8Bit)
+		{
+			IndexedImage indexed;
+			QuantizePalette(atlas, settings.paletteColors, settings.dither, indexed, numThreads);
+			saved = SavePNG(filename.c_str(), indexed);
+		}
+		else if (settings.imageFormat == SpriteSheetImageFormatWebP)
+		{
+			// No png file is written, but the property list keeps referring to the png name
+			filename = pageName + ".webp";
+			saved = SaveWebP(filename.c_str(), atlas, settings.webpQuality);
+		}
+		else
+		{
+			saved = SavePNG(filename.c_str(), atlas);
+		}
+
+		if (saved)
+			output.files.push_back(filename);
+		else
+			output.errors.push_back("Failed writing " + filename);
+		textureFileName = LastPathComponent(textureFileName);
+		return saved;
+	}
+
+	/// Lists the frames of a page for its property list. The packed image and its duplicates share the frame,
+	/// but keep their own offsets and sizes.
+	void ListFrames(const PackingResult &page, const SheetImages &sheet, const SpriteSheetSettings &settings,
+		std::vector<SpriteSheetFrame> &sheetFrames)
+	{
+		int margin = settings.FrameMargin();
+		for(size_t i = 0; i < page.rects.size(); ++i)
+		{
+			const TPRect &rect = page.rects[i];
+			SpriteSheetFrame frame;
+			frame.textureRect.x = rect.x + margin;
+			frame.textureRect.y = rect.y + margin;
+			frame.textureRect.width = rect.width - margin * 2;
+			frame.textureRect.height = rect.height - margin * 2;
+			frame.rotated = rect.rotated;
+			if (rect.rotated)
+				std::swap(frame.textureRect.width, frame.textureRect.height);
+
+			const std::vector<int> &aliases = sheet.aliases[rect.idx];
+			for(int aliasIndex = -1; aliasIndex < (int)aliases.size(); ++aliasIndex)
+			{
+				int image = (aliasIndex < 0) ? rect.idx : aliases[aliasIndex];
+				const TPRect &trim = sheet.frames[image].trimRect;
+				const RGBAImage &pixels = sheet.pixels[image];
+				frame.name = sheet.images[image].name;
+				frame.offsetX = (int)(trim.x + trim.width / 2.0 - pixels.width / 2);
+				frame.offsetY = (int)(-trim.y - trim.height / 2.0 + pixels.height / 2);
+				frame.sourceColorRect = trim;
+				frame.sourceWidth = pixels.width;
+				frame.sourceHeight = pixels.height;
+
+				// List the duplicates with the packed image
+				frame.aliases.clear();
+				if (aliasIndex < 0)
+					for(size_t j = 0; j < aliases.size(); ++j)
+						frame.aliases.push_back(sheet.images[aliases[j]].name);
+
+				// Vertices are relative to the untrimmed image, texture coordinates to the sheet
+				frame.vertices.clear();
+				frame.verticesUV.clear();
+				frame.triangles.clear();
+				if (settings.polygonMode)
+				{
+					const SpritePolygon &polygon = sheet.polygons[rect.idx];
+					const TPRect &texture = frame.textureRect;
+					for(size_t v = 0; v < polygon.vertices.size(); ++v)
+					{
+						int x = polygon.vertices[v].x;
+						int y = polygon.vertices[v].y;
+						frame.vertices.push_back(trim.x + x);
+						frame.vertices.push_back(trim.y + y);
+						frame.verticesUV.push_back(rect.rotated ? texture.x + texture.height - y : texture.x + x);
+						frame.verticesUV.push_back(rect.rotated ? texture.y + x : texture.y + y);
+					}
+					frame.triangles = polygon.triangles;
+				}
+				sheetFrames.push_back(frame);
+			}
+		}
+	}
+
+	/// Draws and writes one page per ParallelFor iteration.
+	struct PageWriter
+	{
+		const std::vector<PackingResult> *pages;
+		const SheetImages *sheet;
+		const SpriteSheetSettings *settings;
+		const std::string *outputName;
+		int threadsPerPage;
+		std::vector<PageOutput> outputs;
+
+		void operator()(int i)
+		{
+			const PackingResult &page = (*pages)[i];
+			PageOutput &output = outputs[i];
+			std::string pageName = SpriteSheetBuilder::PageName(*outputName, i);
+
+			SpriteSheetMetadata metadata;
+			WriteTexture(page, *sheet, *settings, pageName, threadsPerPage, metadata.textureFileName, output);
+			metadata.width = page.width;
+			metadata.height = page.height;
+			metadata.format = settings->polygonMode ? 3 : 2;
+
+			// Runtimes only know the name of the first page, so it lists the others
+			if (i == 0)
+				for(size_t page = 1; page < pages->size(); ++page)
+					metadata.pages.push_back(LastPathComponent(SpriteSheetBuilder::PageName(*outputName, (int)page)) + ".plist");
+
+			std::vector<SpriteSheetFrame> frames;
+			ListFrames(page, *sheet, *settings, frames);
+
+			std::string plistPath = pageName + ".plist";
+			if (SaveSpriteSheetPlist(plistPath.c_str(), frames, metadata))
+				output.files.insert(output.files.begin(), plistPath);
+			else
+				output.errors.push_back("Failed writing " + plistPath);
+		}
+	};
+}
+
+SpriteSheetSettings::SpriteSheetSettings()
+:imageFormat(SpriteSheetImageFormatPNG),
+maxSize(2048),
+padding(1),
+extrude(0),
+alphaBleed(false),
+dither(false),
+ditherMode(DitherErrorDiffusion),
+compress(false),
+polygonMode(false),
+pvrtcQuality(PVRTCQualityBest),
+mipmaps(false),
+mipmapFilter(MipmapFilterKaiser),
+webpQuality(80),
+paletteColors(256),
+numThreads(0)
+{
+}
+
+bool SpriteSheetSettings::IsPVR() const
+{
+	return imageFormat >= SpriteSheetImageFormatPVRRGBA8888 && imageFormat <= SpriteSheetImageFormatPVRTC2;
+}
+
+int SpriteSheetSettings::FrameMargin() const
+{
+	return padding + extrude;
+}
+
+SpriteSheetBuilder::SpriteSheetBuilder(const SpriteSheetSettings &settings)
+:settings(settings),
+numPages(0)
+{
+}
+
+std::string SpriteSheetBuilder::PageName(const std::string &outputName, int page)
+{
+	if (page == 0)
+		return outputName;
+	char suffix[16];
+	sprintf(suffix, "-%d", page);
+	return outputName + suffix;
+}
+
+void SpriteSheetBuilder::RemovePages(const std::string &outputName, int firstPage)
+{
+	const char *extensions[] = { ".plist", ".png", ".webp", ".pvr", ".pvr.ccz" };
+	for(int page = std::max(firstPage, 1);; ++page)
+	{
+		std::string pageName = PageName(outputName, page);
+		bool removed = false;
+		for(size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); ++i)
+			if (remove((pageName + extensions[i]).c_str()) == 0)
+				removed = true;
+		if (!removed)
+			break;
+	}
+}
+
+bool SpriteSheetBuilder::Build(const std::vector<SpriteSheetImage> &images, const std::string &outputName)
+{
+	numPages = 0;
+	files.clear();
+	errors.clear();
+	notices.clear();
+
+	SheetImages sheet;
+	sheet.images = images;
+	std::stable_sort(sheet.images.begin(), sheet.images.end(), ImageNameLess);
+
+	// Load the images and trim their transparent borders
+	size_t count = sheet.images.size();
+	sheet.pixels.resize(count);
+	sheet.frames.resize(count);
+	for(size_t i = 0; i < count; ++i)
+	{
+		if (!LoadPNG(sheet.images[i].path.c_str(), sheet.pixels[i]))
+		{
+			errors.push_back("Failed reading image " + sheet.images[i].path);
+			sheet.pixels[i].Init(1, 1);
+		}
+		sheet.frames[i].image = &sheet.pixels[i];
+		sheet.frames[i].trimRect = TrimmedRect(sheet.pixels[i]);
+	}
+
+	// Pack images with identical trimmed pixels once, and export the duplicates as aliases of the same frame
+	std::vector<int> originals;
+	FindDuplicateFrames(sheet.frames, originals);
+
+	sheet.aliases.resize(count);
+	for(size_t i = 0; i < count; ++i)
+		if (originals[i] != (int)i)
+			sheet.aliases[originals[i]].push_back((int)i);
+
+	// Outline the sprites with polygons, so that fewer transparent pixels are drawn
+	sheet.polygons.resize(count);
+	if (settings.polygonMode)
+		for(size_t i = 0; i < count; ++i)
+			if (originals[i] == (int)i)
+				TraceSpritePolygon(sheet.pixels[i], sheet.frames[i].trimRect, MaxPolygonVertices, sheet.polygons[i]);
+
+	std::vector<TPRectSize> inRects;
+	for(size_t i = 0; i < count; ++i)
+	{
+		if (originals[i] != (int)i)
+			continue;
+		TPRectSize inRect;
+		inRect.width = sheet.frames[i].trimRect.width + settings.FrameMargin() * 2;
+		inRect.height = sheet.frames[i].trimRect.height + settings.FrameMargin() * 2;
+		inRect.idx = (int)i;
+		inRects.push_back(inRect);
+	}
+
+	// Pack using max rects, trying all heuristics and sizes concurrently, and spill over into additional
+	// pages if the images don't fit into a single texture
+	PackingSearch search;
+	search.SetMaxSize(settings.maxSize);
+	search.SetNumThreads(settings.numThreads);
+	search.SetSquare(settings.imageFormat == SpriteSheetImageFormatPVRTC4 || settings.imageFormat == SpriteSheetImageFormatPVRTC2);
+	if (!settings.strategies.empty())
+		search.SetStrategies(settings.strategies);
+
+	std::vector<PackingResult> pages;
+	if (!search.PackPages(inRects, pages))
+		errors.push_back("Some images in " + outputName + " are larger than the maximum size and were left out");
+	numPages = (int)pages.size();
+	RemovePages(outputName, numPages);
+
+	// Draw and write the pages concurrently. A single page is given all the threads instead
+	PageWriter writer;
+	writer.pages = &pages;
+	writer.sheet = &sheet;
+	writer.settings = &settings;
+	writer.outputName = &outputName;
+	writer.threadsPerPage = numPages > 1 ? 1 : settings.numThreads;
+	writer.outputs.resize(pages.size());
+	ParallelFor(numPages, writer, settings.numThreads);
+
+	for(size_t i = 0; i < writer.outputs.size(); ++i)
+	{
+		const PageOutput &output = writer.outputs[i];
+		files.insert(files.end(), output.files.begin(), output.files.end());
+		errors.insert(errors.end(), output.errors.begin(), output.errors.end());
+		notices.insert(notices.end(), output.notices.begin(), output.notices.end());
+	}
+	return errors.empty();
+}
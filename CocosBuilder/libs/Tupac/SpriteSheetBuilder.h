@@ -0,0 +1,118 @@
+/** @file SpriteSheetBuilder.h
+
+	@brief Builds cocos2d sprite sheets from PNG images: trims, deduplicates and packs the images onto
+	as many pages as needed, and writes the texture and property list of every page. Both the Tupac
+	class and the tupac command line tool build their sprite sheets with it.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "PackingSearch.h"
+#include "Mipmaps.h"
+#include "PVRTCEncoder.h"
+#include "TextureQuantizer.h"
+
+/// The formats a sprite sheet texture can be written in, in the order of the kTupacImageFormat constants.
+enum SpriteSheetImageFormat
+{
+	SpriteSheetImageFormatPNG,
+	SpriteSheetImageFormatPNG8Bit,
+	SpriteSheetImageFormatPVRRGBA8888,
+	SpriteSheetImageFormatPVRRGBA4444,
+	SpriteSheetImageFormatPVRRGB565,
+	SpriteSheetImageFormatPVRTC4,
+	SpriteSheetImageFormatPVRTC2,
+	SpriteSheetImageFormatWebP
+};
+
+/// The settings a sprite sheet is built with. The defaults are those of the Tupac class.
+struct SpriteSheetSettings
+{
+	SpriteSheetSettings();
+
+	SpriteSheetImageFormat imageFormat;
+	int maxSize; ///< The largest width and height of a page.
+	int padding; ///< Transparent pixels around each frame.
+	int extrude; ///< Pixels the edges of each frame are repeated outwards by, in addition to the padding.
+	bool alphaBleed;
+	bool dither;
+
+	/// How 16 bit PVR textures are dithered if dither is set. 8 bit PNGs are always dithered by error diffusion.
+	DitherMode ditherMode;
+
+	bool compress; ///< Writes PVR textures as pvr.ccz files.
+	bool polygonMode; ///< Outlines the frames with polygons and writes format 3 property lists.
+	PVRTCQuality pvrtcQuality;
+	bool mipmaps;
+	MipmapFilter mipmapFilter;
+	int webpQuality;
+	int paletteColors;
+
+	/// The strategies to pack with, or none for the defaults of PackingSearch.
+	std::vector<PackingStrategy> strategies;
+
+	/// The largest number of threads to use, or 0 to use all processors.
+	int numThreads;
+
+	bool IsPVR() const;
+
+	/// Distance from the edges of the packed rectangles to the frames.
+	int FrameMargin() const;
+};
+
+/// An image to put into a sprite sheet.
+struct SpriteSheetImage
+{
+	std::string path;
+
+	/// The name of the frame in the property list.
+	std::string name;
+};
+
+/** SpriteSheetBuilder builds a sprite sheet. The frames are ordered by name, so the same images give
+	the same sprite sheet no matter in which order they are listed. */
+class SpriteSheetBuilder
+{
+public:
+	SpriteSheetBuilder(const SpriteSheetSettings &settings);
+
+	/// Builds a sprite sheet and writes its files. The pages are drawn and written concurrently, and the
+	/// property list of the first page lists those of the others under "pages" in its metadata. A sprite
+	/// sheet without images is written as a single empty page.
+	/// Images that can't be read are replaced by a transparent pixel, so the sprite sheet still has a
+	/// frame of their name.
+	/// @param outputName The path of the first page, without extension. @see PageName.
+	/// @return False if an image could not be read or was larger than a page, or a file could not be written.
+	bool Build(const std::vector<SpriteSheetImage> &images, const std::string &outputName);
+
+	/// The number of pages written by the last Build.
+	int NumPages() const { return numPages; }
+
+	/// The paths of the files written by the last Build, the property list and texture of every page.
+	const std::vector<std::string> &Files() const { return files; }
+
+	/// What went wrong in the last Build, one message per problem.
+	const std::vector<std::string> &Errors() const { return errors; }
+
+	/// Information about the last Build, such as the quality of the compressed textures.
+	const std::vector<std::string> &Notices() const { return notices; }
+
+	/// Returns the path of a page of a sprite sheet without extension: the output name for the first
+	/// page, and the output name followed by "-" and the page number for the others.
+	static std::string PageName(const std::string &outputName, int page);
+
+	/// Removes the property lists and textures of the pages from firstPage on, which an earlier build of
+	/// the sprite sheet with more pages left behind. Stops at the first page that has no files.
+	static void RemovePages(const std::string &outputName, int firstPage);
+
+private:
+	SpriteSheetSettings settings;
+	int numPages;
+	std::vector<std::string> files;
+	std::vector<std::string> errors;
+	std::vector<std::string> notices;
+};
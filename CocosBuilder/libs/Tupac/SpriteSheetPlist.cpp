@@ -0,0 +1,237 @@
+/** @file SpriteSheetPlist.cpp
+
+	@brief Writes the property list that describes the frames of a sprite sheet to cocos2d, without
+	depending on Foundation.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cstdio>
+#include <algorithm>
+
+#include "SpriteSheetPlist.h"
+
+namespace
+{
+	/// Appends the elements of an XML property list, indenting each by its depth.
+	class PlistWriter
+	{
+	public:
+		PlistWriter(std::string &xml) : xml(xml), depth(0)
+		{
+			xml += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+				"<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n"
+				"<plist version=\"1.0\">\n";
+		}
+
+		~PlistWriter()
+		{
+			xml += "</plist>\n";
+		}
+
+		/// Opens a dict or array, or writes an empty one if it has no elements.
+		void Begin(const char *element, bool empty)
+		{
+			Indent();
+			xml += empty ? std::string("<") + element + "/>\n" : std::string("<") + element + ">\n";
+			if (!empty)
+				++depth;
+		}
+
+		void End(const char *element)
+		{
+			--depth;
+			Indent();
+			xml += std::string("</") + element + ">\n";
+		}
+
+		void Key(const std::string &key)
+		{
+			Element("key", key);
+		}
+
+		void String(const std::string &value)
+		{
+			Element("string", value);
+		}
+
+		void Integer(int value)
+		{
+			char text[16];
+			sprintf(text, "%d", value);
+			Element("integer", text);
+		}
+
+		void Bool(bool value)
+		{
+			Indent();
+			xml += value ? "<true/>\n" : "<false/>\n";
+		}
+
+	private:
+		std::string &xml;
+		int depth;
+
+		void Indent()
+		{
+			xml.append(depth, '\t');
+		}
+
+		void Element(const char *element, const std::string &text)
+		{
+			Indent();
+			xml += std::string("<") + element + ">";
+			for(size_t i = 0; i < text.size(); ++i)
+			{
+				if (text[i] == '&') xml += "&amp;";
+				else if (text[i] == '<') xml += "&lt;";
+				else if (text[i] == '>') xml += "&gt;";
+				else xml += text[i];
+			}
+			xml += std::string("</") + element + ">\n";
+		}
+	};
+
+	/// Formats a point or size the way NSStringFromPoint and NSStringFromSize do.
+	std::string PairString(int a, int b)
+	{
+		char text[32];
+		sprintf(text, "{%d, %d}", a, b);
+		return text;
+	}
+
+	/// Formats a rectangle the way NSStringFromRect does.
+	std::string RectString(const TPRect &rect)
+	{
+		return "{" + PairString(rect.x, rect.y) + ", " + PairString(rect.width, rect.height) + "}";
+	}
+
+	/// Formats a list of integers separated by spaces.
+	std::string IntegerListString(const std::vector<int> &values)
+	{
+		std::string text;
+		for(size_t i = 0; i < values.size(); ++i)
+		{
+			char number[16];
+			sprintf(number, i ? " %d" : "%d", values[i]);
+			text += number;
+		}
+		return text;
+	}
+
+	void WriteAliases(PlistWriter &writer, const SpriteSheetFrame &frame)
+	{
+		writer.Key("aliases");
+		writer.Begin("array", frame.aliases.empty());
+		for(size_t j = 0; j < frame.aliases.size(); ++j)
+			writer.String(frame.aliases[j]);
+		if (!frame.aliases.empty())
+			writer.End("array");
+	}
+
+	/// Writes the keys of a format 2 frame, which is drawn as a rectangle.
+	void WriteFrame(PlistWriter &writer, const SpriteSheetFrame &frame)
+	{
+		if (!frame.aliases.empty())
+			WriteAliases(writer, frame);
+		writer.Key("frame");
+		writer.String(RectString(frame.textureRect));
+		writer.Key("offset");
+		writer.String(PairString(frame.offsetX, frame.offsetY));
+		writer.Key("rotated");
+		writer.Bool(frame.rotated);
+		writer.Key("sourceColorRect");
+		writer.String(RectString(frame.sourceColorRect));
+		writer.Key("sourceSize");
+		writer.String(PairString(frame.sourceWidth, frame.sourceHeight));
+	}
+
+	/// Writes the keys of a format 3 frame, which is drawn as a polygon.
+	void WritePolygonFrame(PlistWriter &writer, const SpriteSheetFrame &frame)
+	{
+		WriteAliases(writer, frame);
+		writer.Key("spriteOffset");
+		writer.String(PairString(frame.offsetX, frame.offsetY));
+		writer.Key("spriteSize");
+		writer.String(PairString(frame.textureRect.width, frame.textureRect.height));
+		writer.Key("spriteSourceSize");
+		writer.String(PairString(frame.sourceWidth, frame.sourceHeight));
+		writer.Key("textureRect");
+		writer.String(RectString(frame.textureRect));
+		writer.Key("textureRotated");
+		writer.Bool(frame.rotated);
+		writer.Key("triangles");
+		writer.String(IntegerListString(frame.triangles));
+		writer.Key("vertices");
+		writer.String(IntegerListString(frame.vertices));
+		writer.Key("verticesUV");
+		writer.String(IntegerListString(frame.verticesUV));
+	}
+
+	bool NameLess(const SpriteSheetFrame *a, const SpriteSheetFrame *b)
+	{
+		return a->name < b->name;
+	}
+}
+
+void EncodeSpriteSheetPlist(const std::vector<SpriteSheetFrame> &frames, const SpriteSheetMetadata &metadata, std::string &plist)
+{
+	// Property lists list the keys of a dictionary in order
+	std::vector<const SpriteSheetFrame *> sorted(frames.size());
+	for(size_t i = 0; i < frames.size(); ++i)
+		sorted[i] = &frames[i];
+	std::sort(sorted.begin(), sorted.end(), NameLess);
+
+	plist.clear();
+	{
+		PlistWriter writer(plist);
+		writer.Begin("dict", false);
+
+		writer.Key("frames");
+		writer.Begin("dict", sorted.empty());
+		for(size_t i = 0; i < sorted.size(); ++i)
+		{
+			const SpriteSheetFrame &frame = *sorted[i];
+			writer.Key(frame.name);
+			writer.Begin("dict", false);
+			if (metadata.format >= 3)
+				WritePolygonFrame(writer, frame);
+			else
+				WriteFrame(writer, frame);
+			writer.End("dict");
+		}
+		if (!sorted.empty())
+			writer.End("dict");
+
+		writer.Key("metadata");
+		writer.Begin("dict", false);
+		writer.Key("format");
+		writer.Integer(metadata.format);
+		if (!metadata.pages.empty())
+		{
+			writer.Key("pages");
+			writer.Begin("array", false);
+			for(size_t i = 0; i < metadata.pages.size(); ++i)
+				writer.String(metadata.pages[i]);
+			writer.End("array");
+		}
+		writer.Key("size");
+		writer.String(PairString(metadata.width, metadata.height));
+		writer.Key("textureFileName");
+		writer.String(metadata.textureFileName);
+		writer.End("dict");
+
+		writer.End("dict");
+	}
+}
+
+bool SaveSpriteSheetPlist(const char *filename, const std::vector<SpriteSheetFrame> &frames, const SpriteSheetMetadata &metadata)
+{
+	std::string plist;
+	EncodeSpriteSheetPlist(frames, metadata, plist);
+
+	FILE *file = fopen(filename, "wb");
+	if (!file)
+		return false;
+	bool success = fwrite(plist.data(), 1, plist.size(), file) == plist.size();
+	return fclose(file) == 0 && success;
+}
@@ -0,0 +1,67 @@
+/** @file SpriteSheetPlist.h
+
+	@brief Writes the property list that describes the frames of a sprite sheet to cocos2d, without
+	depending on Foundation.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Rect.h"
+
+/// A frame of a sprite sheet, as listed in a cocos2d format 2 or 3 property list.
+struct SpriteSheetFrame
+{
+	/// The name sprites look the frame up by.
+	std::string name;
+
+	/// The names of images with the same pixels, which are drawn into the sprite sheet once.
+	std::vector<std::string> aliases;
+
+	/// The frame in the sprite sheet. The width and height are those of the frame before it is rotated.
+	TPRect textureRect;
+	bool rotated;
+
+	/// The offset of the center of the trimmed image from the center of the source image, y up.
+	int offsetX;
+	int offsetY;
+
+	/// The trimmed part of the source image, y down.
+	TPRect sourceColorRect;
+	int sourceWidth;
+	int sourceHeight;
+
+	/// The polygon the frame is drawn with in format 3: the x and y of every vertex relative to the source
+	/// image, their x and y in the sprite sheet, and three vertex indices per triangle.
+	std::vector<int> vertices;
+	std::vector<int> verticesUV;
+	std::vector<int> triangles;
+};
+
+/// What a property list says about the sprite sheet as a whole.
+struct SpriteSheetMetadata
+{
+	/// The name of the texture, relative to the property list.
+	std::string textureFileName;
+	int width;
+	int height;
+
+	/// 2, or 3 if the frames are drawn with polygons.
+	int format;
+
+	/// The property lists of the other pages of the sprite sheet, relative to this one. Only the first
+	/// page lists them, so that loading it can load the whole sprite sheet.
+	std::vector<std::string> pages;
+};
+
+/// Encodes the frames of a sprite sheet as an XML property list in cocos2d format 2 or 3. The output is
+/// the same as that of writing the equivalent NSDictionary to a file: the keys are sorted and nested
+/// elements are indented by tabs.
+void EncodeSpriteSheetPlist(const std::vector<SpriteSheetFrame> &frames, const SpriteSheetMetadata &metadata, std::string &plist);
+
+/// Encodes the frames of a sprite sheet and writes them to a file. @see EncodeSpriteSheetPlist.
+/// @return False if the file could not be written.
+bool SaveSpriteSheetPlist(const char *filename, const std::vector<SpriteSheetFrame> &frames, const SpriteSheetMetadata &metadata);
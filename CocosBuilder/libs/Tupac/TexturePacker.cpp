@@ -1,5 +1,8 @@
 #include "TexturePacker.h"
 #include <assert.h>
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
 
 namespace TEXTURE_PACKER
 {
@@ -62,6 +65,14 @@ namespace TEXTURE_PACKER
             mPlaced = true;
         }
         
+        // Textures are placed longest edge first, and of those with the same longest edge, the one with the most area first.
+        bool placedBefore(const Texture &t) const
+        {
+            if ( mLongestEdge != t.mLongestEdge )
+                return mLongestEdge > t.mLongestEdge;
+            return mArea > t.mArea;
+        }
+        
         int mWidth;
         int mHeight;
         int mX;
@@ -82,11 +93,8 @@ namespace TEXTURE_PACKER
             mY = y;
             mWidth = wid;
             mHeight = hit;
-            mNext = 0;
         }
         
-        Node *getNext(void) const { return mNext; };
-        
         bool fits(int wid,int hit,int &edgeCount) const
         {
             bool ret = false;
@@ -136,62 +144,291 @@ namespace TEXTURE_PACKER
             r.set(mX,mY,mX+mWidth-1,mY+mHeight-1);
         }
         
-        void validate(Node *n)
+        void validate(const Node &n) const
         {
             Rect r1;
             Rect r2;
             getRect(r1);
-            n->getRect(r2);
+            n.getRect(r2);
             assert( !r1.intersects(r2) );
         }
         
-        bool merge(const Node &n)
+        int mX;
+        int mY;
+        int mWidth;
+        int mHeight;
+    };
+    
+    // Sorts free nodes by column, so that nodes stacked on top of each other with the same left and right edges are neighbours.
+    static bool columnOrder(const Node &a,const Node &b)
+    {
+        if ( a.mX != b.mX )
+            return a.mX < b.mX;
+        if ( a.mWidth != b.mWidth )
+            return a.mWidth < b.mWidth;
+        return a.mY < b.mY;
+    }
+    
+    // Sorts free nodes by row, so that nodes side by side with the same top and bottom edges are neighbours.
+    static bool rowOrder(const Node &a,const Node &b)
+    {
+        if ( a.mY != b.mY )
+            return a.mY < b.mY;
+        if ( a.mHeight != b.mHeight )
+            return a.mHeight < b.mHeight;
+        return a.mX < b.mX;
+    }
+    
+    // Sorts texture indices into the order the textures are placed in.
+    class PlacementOrder
+    {
+    public:
+        PlacementOrder(const std::vector<Texture> &textures) : mTextures(textures)
         {
-            bool ret = false;
+        }
+        
+        bool operator()(int a,int b) const
+        {
+            return mTextures[a].placedBefore(mTextures[b]);
+        }
+    
+    private:
+        const std::vector<Texture> &mTextures;
+    };
+    
+    static int nextPow2(int v)
+    {
+        int p = 1;
+        while ( p < v )
+        {
+            p = p*2;
+        }
+        return p;
+    }
+    
+    // The free space of the rectangle the textures are packed into. The free nodes are kept in one array, so placing
+    // a texture is a linear search and a bin can be copied to try placing another texture without disturbing it.
+    class Bin
+    {
+    public:
+        Bin(void)
+        {
+            mWidth = 0;
+            mHeight = 0;
+            mUsedHeight = 0;
+        }
+        
+        void begin(int width,int height)
+        {
+            mWidth = width;
+            mHeight = height;
+            mUsedHeight = 0;
+            mFree.clear();
+            mFree.push_back(Node(0,0,width,height));
+        }
+        
+        // For the texture with the longest edge we place it according to this criteria.
+        //   (1) If it is a perfect match, we always accept it as it causes the least amount of fragmentation.
+        //   (2) A match of one edge with the minimum area left over after the split.
+        //   (3) No edges match, so look for the node which leaves the least amount of area left over after the split.
+        void place(Texture &t)
+        {
+            int edgeCount = 0;
+            int index = findNode(t,edgeCount);
+            while ( index < 0 ) // the height we guessed was too small, so grow it until the texture fits.
+            {
+                grow();
+                index = findNode(t,edgeCount);
+            }
             
-            Rect r1;
-            Rect r2;
+            Node &bestFit = mFree[index];
+            switch ( edgeCount )
+            {
+                case 0:
+                {
+                    // Lay the long edge down if the node is wide enough, otherwise stand it up.
+                    bool flipped;
+                    if ( t.mLongestEdge <= bestFit.mWidth )
+                    {
+                        flipped = t.mHeight > t.mWidth;
+                    }
+                    else
+                    {
+                        assert( t.mLongestEdge <= bestFit.mHeight );
+                        flipped = t.mHeight < t.mWidth;
+                    }
+                    
+                    int wid = flipped ? t.mHeight : t.mWidth;
+                    int hit = flipped ? t.mWidth : t.mHeight;
+                    
+                    t.place(bestFit.mX,bestFit.mY,flipped); // place it.
+                    
+                    Node below(bestFit.mX,bestFit.mY+hit,bestFit.mWidth,bestFit.mHeight-hit);
+                    
+                    bestFit.mX+=wid;
+                    bestFit.mWidth-=wid;
+                    bestFit.mHeight = hit;
+                    mFree.push_back(below);
+                }
+                    break;
+                case 1:
+                {
+                    if ( t.mWidth == bestFit.mWidth )
+                    {
+                        t.place(bestFit.mX,bestFit.mY,false);
+                        bestFit.mY+=t.mHeight;
+                        bestFit.mHeight-=t.mHeight;
+                    }
+                    else if ( t.mHeight == bestFit.mHeight )
+                    {
+                        t.place(bestFit.mX,bestFit.mY,false);
+                        bestFit.mX+=t.mWidth;
+                        bestFit.mWidth-=t.mWidth;
+                    }
+                    else if ( t.mWidth == bestFit.mHeight )
+                    {
+                        t.place(bestFit.mX,bestFit.mY,true);
+                        bestFit.mX+=t.mHeight;
+                        bestFit.mWidth-=t.mHeight;
+                    }
+                    else if ( t.mHeight == bestFit.mWidth )
+                    {
+                        t.place(bestFit.mX,bestFit.mY,true);
+                        bestFit.mY+=t.mWidth;
+                        bestFit.mHeight-=t.mWidth;
+                    }
+                }
+                    break;
+                case 2:
+                {
+                    bool flipped = t.mWidth != bestFit.mWidth || t.mHeight != bestFit.mHeight;
+                    t.place(bestFit.mX,bestFit.mY,flipped);
+                    bestFit = mFree.back();
+                    mFree.pop_back();
+                }
+                    break;
+            }
             
-            getRect(r1);
-            n.getRect(r2);
-            r1.mX2++;
-            r1.mY2++;
-            r2.mX2++;
-            r2.mY2++;
+            int y = t.mY + (t.mFlipped ? t.mWidth : t.mHeight);
+            if ( y > mUsedHeight )
+                mUsedHeight = y;
             
-            // if we share the top edge then..
-            if ( r1.mX1 == r2.mX1 && r1.mX2 == r2.mX2 && r1.mY1 == r2.mY2 )
+            mergeNodes();
+            validate();
+        }
+        
+        int mWidth;
+        int mHeight;
+        int mUsedHeight; // the bottom edge of the lowest texture placed so far
+    
+    private:
+        // Returns the first free node the texture is a perfect match for, otherwise the one furthest up and to the left, or -1 if it fits in none.
+        int findNode(const Texture &t,int &edgeCount) const
+        {
+            int bestFit = -1;
+            for (size_t i=0; i<mFree.size(); i++)
             {
-                mY = n.mY;
-                mHeight+=n.mHeight;
-                ret = true;
+                const Node &search = mFree[i];
+                int ec;
+                if ( search.fits(t.mWidth,t.mHeight,ec) ) // see if the texture will fit into this slot, and if so how many edges does it share.
+                {
+                    if ( ec == 2 )
+                    {
+                        edgeCount = ec;
+                        return (int)i;
+                    }
+                    if ( bestFit < 0 ||
+                        search.mY < mFree[bestFit].mY ||
+                        (search.mY == mFree[bestFit].mY && search.mX < mFree[bestFit].mX) )
+                    {
+                        bestFit = (int)i;
+                        edgeCount = ec;
+                    }
+                }
             }
-            else if ( r1.mX1 == r2.mX1 && r1.mX2 == r2.mX2 && r1.mY2 == r2.mY1 ) // if we share the bottom edge
+            return bestFit;
+        }
+        
+        // Adds a strip as tall as the bin is wide to the bottom, which fits any texture with its long edge laid down.
+        void grow(void)
+        {
+            mFree.push_back(Node(0,mHeight,mWidth,mWidth));
+            mHeight+=mWidth;
+            mergeNodes();
+        }
+        
+        // Merges free nodes that share a whole edge. Each direction is one sweep over the nodes sorted so that mergeable
+        // nodes are neighbours; a merge in one direction can allow one in the other, so we keep going until a sweep finds none.
+        void mergeNodes(void)
+        {
+            for (;;)
             {
-                mHeight+=n.mHeight;
-                ret = true;
+                mergeColumns();
+                if ( !mergeRows() )
+                    break;
             }
-            else if ( r1.mY1 == r2.mY1 && r1.mY2 == r2.mY1 && r1.mX1 == r2.mX2 ) // if we share the left edge
+        }
+        
+        bool mergeColumns(void)
+        {
+            std::sort(mFree.begin(),mFree.end(),columnOrder);
+            size_t count = 0;
+            for (size_t i=0; i<mFree.size(); i++)
             {
-                mX = n.mX;
-                mWidth+=n.mWidth;
-                ret = true;
+                const Node &n = mFree[i];
+                if ( count )
+                {
+                    Node &last = mFree[count-1];
+                    if ( last.mX == n.mX && last.mWidth == n.mWidth && last.mY+last.mHeight == n.mY ) // if we share the bottom edge
+                    {
+                        last.mHeight+=n.mHeight;
+                        continue;
+                    }
+                }
+                mFree[count++] = n;
             }
-            else if ( r1.mY1 == r2.mY1 && r1.mY2 == r2.mY1 && r1.mX2 == r2.mX1 ) // if we share the left edge
+            bool merged = count < mFree.size();
+            mFree.resize(count,Node(0,0,0,0));
+            return merged;
+        }
+        
+        bool mergeRows(void)
+        {
+            std::sort(mFree.begin(),mFree.end(),rowOrder);
+            size_t count = 0;
+            for (size_t i=0; i<mFree.size(); i++)
             {
-                mWidth+=n.mWidth;
-                ret = true;
+                const Node &n = mFree[i];
+                if ( count )
+                {
+                    Node &last = mFree[count-1];
+                    if ( last.mY == n.mY && last.mHeight == n.mHeight && last.mX+last.mWidth == n.mX ) // if we share the right edge
+                    {
+                        last.mWidth+=n.mWidth;
+                        continue;
+                    }
+                }
+                mFree[count++] = n;
             }
-            
-            return ret;
+            bool merged = count < mFree.size();
+            mFree.resize(count,Node(0,0,0,0));
+            return merged;
         }
         
+        void validate(void) const
+        {
+#ifdef _DEBUG
+            for (size_t i=0; i<mFree.size(); i++)
+            {
+                for (size_t j=i+1; j<mFree.size(); j++)
+                {
+                    mFree[i].validate(mFree[j]);
+                }
+            }
+#endif
+        }
         
-        Node *mNext;
-        int mX;
-        int mY;
-        int mWidth;
-        int mHeight;
+        std::vector< Node > mFree;
     };
     
     class MyTexturePacker : public TexturePacker
@@ -200,11 +437,12 @@ namespace TEXTURE_PACKER
         MyTexturePacker(void)
         {
             mTextureCount = 0;
-            mTextures = 0;
-            mLongestEdge = 0;
             mTotalArea = 0;
             mTextureIndex = 0;
-            mFreeList = 0;
+            mFitValid = false;
+            mFitPowerOfTwo = false;
+            mFitBorder = false;
+            mFitArea = 0;
         }
         ~MyTexturePacker(void)
         {
@@ -214,44 +452,57 @@ namespace TEXTURE_PACKER
         void reset(void)
         {
             mTextureCount = 0;
-            delete []mTextures;
-            mTextures = 0;
-            mLongestEdge = 0;
+            mTextures.clear();
             mTotalArea = 0;
             mTextureIndex = 0;
-            if ( mFreeList )
-            {
-                Node *next = mFreeList;
-                while ( next )
-                {
-                    Node *kill = next;
-                    next = next->getNext();
-                    delete kill;
-                }
-            }
+            mFitValid = false;
         }
         
+        // The textures added so far are packed once and kept, along with what was left of the free space, so that
+        // asking about one texture after another doesn't repack them all each time.
         virtual bool  wouldTextureFit(int wid, int hit,
                                       bool forcePowerOfTwo,bool onePixelBorder,
                                       int max_wid, int max_hit)
         {
-            // Inefficient way to go about this.
-            TEXTURE_PACKER::TexturePacker *tp = TEXTURE_PACKER::createTexturePacker();
-            tp->setTextureCount(getTextureCount() + 1);
-            
-            // Add the existing textures
-            for(size_t idx = 0; idx < getTextureCount(); idx++)
+            if ( mFitValid && (mFitPowerOfTwo != forcePowerOfTwo || mFitBorder != onePixelBorder) )
             {
-                tp->addTexture(mTextures[idx].mWidth, mTextures[idx].mHeight);
+                mFitValid = false;
+            }
+            if ( !mFitValid && mTextureIndex > 0 )
+            {
+                std::vector< Texture > textures(mTextures.begin(),mTextures.begin()+mTextureIndex);
+                int last = packBin(textures,mTotalArea,forcePowerOfTwo,onePixelBorder,mFitBin);
+                mFitLast = textures[last];
+                mFitArea = mTotalArea;
+                mFitPowerOfTwo = forcePowerOfTwo;
+                mFitBorder = onePixelBorder;
+                mFitValid = true;
             }
             
-            // Add the new texture
-            tp->addTexture(wid, hit);
+            int border = onePixelBorder ? 2 : 0;
+            Texture t;
+            t.set(wid+border,hit+border);
             
-            // Pack it
             int new_width = 0, new_height = 0;
-            tp->packTextures(new_width, new_height, forcePowerOfTwo, onePixelBorder);
-            delete (tp);
+            if ( continuesFit(t,mTotalArea+wid*hit) )
+            {
+                Bin bin = mFitBin;
+                bin.place(t);
+                new_width = bin.mWidth;
+                new_height = getHeight(bin,forcePowerOfTwo,onePixelBorder);
+            }
+            else
+            {
+                std::vector< Texture > textures(mTextures.begin(),mTextures.begin()+mTextureIndex);
+                Texture added;
+                added.set(wid,hit);
+                textures.push_back(added);
+                
+                Bin bin;
+                packBin(textures,mTotalArea+wid*hit,forcePowerOfTwo,onePixelBorder,bin);
+                new_width = bin.mWidth;
+                new_height = getHeight(bin,forcePowerOfTwo,onePixelBorder);
+            }
             
             return (new_width <= max_wid && new_height <= max_hit);
         }
@@ -260,7 +511,7 @@ namespace TEXTURE_PACKER
         {
             reset();
             mTextureCount = tcount;
-            mTextures = new Texture[tcount];
+            mTextures.resize(tcount);
         }
         
         virtual void  addTexture(int wid,int hit)  // add textures 0 - n
@@ -270,9 +521,24 @@ namespace TEXTURE_PACKER
             {
                 mTextures[mTextureIndex].set(wid,hit);
                 mTextureIndex++;
-                if ( wid > mLongestEdge )  mLongestEdge = wid;
-                if ( hit > mLongestEdge )  mLongestEdge = hit;
                 mTotalArea+=(wid*hit);
+                
+                if ( mFitValid )
+                {
+                    int border = mFitBorder ? 2 : 0;
+                    Texture t;
+                    t.set(wid+border,hit+border);
+                    if ( continuesFit(t,mTotalArea) )
+                    {
+                        mFitBin.place(t);
+                        mFitLast = t;
+                        mFitArea = mTotalArea;
+                    }
+                    else
+                    {
+                        mFitValid = false;
+                    }
+                }
             }
         }
         
@@ -281,327 +547,33 @@ namespace TEXTURE_PACKER
             return mTextureIndex;
         }
         
-        virtual void newFree(int x,int y,int wid,int hit)
-        {
-            Node *node = new Node(x,y,wid,hit);
-            node->mNext = mFreeList;
-            mFreeList = node;
-        }
-        
-        int nextPow2(int v) const
-        {
-            int p = 1;
-            while ( p < v )
-            {
-                p = p*2;
-            }
-            return p;
-        }
-        
         virtual int packTextures(int &width,int &height,bool forcePowerOfTwo,bool onePixelBorder)  // pack the textures, the return code is the amount of wasted/unused area.
         {
             width = 0;
             height = 0;
             
-            if ( onePixelBorder )
-            {
-                for (int i=0; i < getTextureCount(); i++)
-                {
-                    Texture &t = mTextures[i];
-                    t.mWidth+=2;
-                    t.mHeight+=2;
-                }
-                mLongestEdge+=2;
-            }
-            
-            if ( forcePowerOfTwo )
+            if ( mTextureIndex == 0 )
             {
-                mLongestEdge = nextPow2(mLongestEdge);
+                return 0;
             }
             
-            width  = mLongestEdge;              // The width is no more than the longest edge of any rectangle passed in
-            int count = mTotalArea / (mLongestEdge*mLongestEdge);
-            height = (count+2)*mLongestEdge;            // We guess that the height is no more than twice the longest edge.  On exit, this will get shrunk down to the actual tallest height.
-            
-            mDebugCount = 0;
-            newFree(0,0,width,height);
-            
-            // We must place each texture
-            for (int i=0; i<getTextureCount(); i++)
-            {
-                
-                int index = 0;
-                int longestEdge = 0;
-                int mostArea = 0;
-                
-                // We first search for the texture with the longest edge, placing it first.
-                // And the most area...
-                for (int j=0; j<getTextureCount(); j++)
-                {
-                    
-                    Texture &t = mTextures[j];
-                    
-                    if ( !t.isPlaced() ) // if this texture has not already been placed.
-                    {
-                        if ( t.mLongestEdge > longestEdge )
-                        {
-                            mostArea = t.mArea;
-                            longestEdge = t.mLongestEdge;
-                            index = j;
-                        }
-                        else if ( t.mLongestEdge == longestEdge ) // if the same length, keep the one with the most area.
-                        {
-                            if ( t.mArea > mostArea )
-                            {
-                                mostArea = t.mArea;
-                                index = j;
-                            }
-                        }
-                    }
-                }
-                
-                // For the texture with the longest edge we place it according to this criteria.
-                //   (1) If it is a perfect match, we always accept it as it causes the least amount of fragmentation.
-                //   (2) A match of one edge with the minimum area left over after the split.
-                //   (3) No edges match, so look for the node which leaves the least amount of area left over after the split.
-                Texture &t = mTextures[index];
-                
-                int leastY = 0x7FFFFFFF;
-                int leastX = 0x7FFFFFFF;
-                
-                Node *previousBestFit = 0;
-                Node *bestFit = 0;
-                Node *previous = 0;
-                Node *search = mFreeList;
-                int edgeCount = 0;
-                
-                // Walk the singly linked list of free nodes
-                // see if it will fit into any currently free space
-                while ( search )
-                {
-                    int ec;
-                    if ( search->fits(t.mWidth,t.mHeight,ec) ) // see if the texture will fit into this slot, and if so how many edges does it share.
-                    {
-                        if ( ec == 2 )
-                        {
-                            previousBestFit = previous;     // record the pointer previous to this one (used to patch the linked list)
-                            bestFit = search; // record the best fit.
-                            edgeCount = ec;
-                            break;
-                        }
-                        if ( search->mY < leastY )
-                        {
-                            leastY = search->mY;
-                            leastX = search->mX;
-                            previousBestFit = previous;
-                            bestFit = search;
-                            edgeCount = ec;
-                        }
-                        else if ( search->mY == leastY && search->mX < leastX )
-                        {
-                            leastX = search->mX;
-                            previousBestFit = previous;
-                            bestFit = search;
-                            edgeCount = ec;
-                        }
-                    }
-                    previous = search;
-                    search = search->mNext;
-                }
-                
-                assert( bestFit ); // we should always find a fit location!
-                
-                if ( bestFit )
-                {
-                    validate();
-                    
-                    switch ( edgeCount )
-                    {
-                        case 0:
-                            if ( t.mLongestEdge <= bestFit->mWidth )
-                            {
-                                bool flipped = false;
-                                
-                                int wid = t.mWidth;
-                                int hit = t.mHeight;
-                                
-                                if ( hit > wid )
-                                {
-                                    wid = t.mHeight;
-                                    hit = t.mWidth;
-                                    flipped = true;
-                                }
-                                
-                                t.place(bestFit->mX,bestFit->mY,flipped); // place it.
-                                
-                                newFree(bestFit->mX,bestFit->mY+hit,bestFit->mWidth,bestFit->mHeight-hit);
-                                
-                                bestFit->mX+=wid;
-                                bestFit->mWidth-=wid;
-                                bestFit->mHeight = hit;
-                                validate();
-                            }
-                            else
-                            {
-                                
-                                assert( t.mLongestEdge <= bestFit->mHeight );
-                                
-                                bool flipped = false;
-                                
-                                int wid = t.mWidth;
-                                int hit = t.mHeight;
-                                
-                                if ( hit < wid )
-                                {
-                                    wid = t.mHeight;
-                                    hit = t.mWidth;
-                                    flipped = true;
-                                }
-                                
-                                t.place(bestFit->mX,bestFit->mY,flipped); // place it.
-                                
-                                newFree(bestFit->mX,bestFit->mY+hit,bestFit->mWidth,bestFit->mHeight-hit);
-                                
-                                bestFit->mX+=wid;
-                                bestFit->mWidth-=wid;
-                                bestFit->mHeight = hit;
-                                validate();
-                            }
-                            break;
-                        case 1:
-                        {
-                            if ( t.mWidth == bestFit->mWidth )
-                            {
-                                t.place(bestFit->mX,bestFit->mY,false);
-                                bestFit->mY+=t.mHeight;
-                                bestFit->mHeight-=t.mHeight;
-                                validate();
-                            }
-                            else if ( t.mHeight == bestFit->mHeight )
-                            {
-                                t.place(bestFit->mX,bestFit->mY,false);
-                                bestFit->mX+=t.mWidth;
-                                bestFit->mWidth-=t.mWidth;
-                                validate();
-                            }
-                            else if ( t.mWidth == bestFit->mHeight )
-                            {
-                                t.place(bestFit->mX,bestFit->mY,true);
-                                bestFit->mX+=t.mHeight;
-                                bestFit->mWidth-=t.mHeight;
-                                validate();
-                            }
-                            else if ( t.mHeight == bestFit->mWidth )
-                            {
-                                t.place(bestFit->mX,bestFit->mY,true);
-                                bestFit->mY+=t.mWidth;
-                                bestFit->mHeight-=t.mWidth;
-                                validate();
-                            }
-                        }
-                            break;
-                        case 2:
-                        {
-                            bool flipped = t.mWidth != bestFit->mWidth || t.mHeight != bestFit->mHeight;
-                            t.place(bestFit->mX,bestFit->mY,flipped);
-                            if ( previousBestFit )
-                            {
-                                previousBestFit->mNext = bestFit->mNext;
-                            }
-                            else
-                            {
-                                mFreeList = bestFit->mNext;
-                            }
-                            delete bestFit;
-                            validate();
-                        }
-                            break;
-                    }
-                    while ( mergeNodes() ); // keep merging nodes as much as we can...
-                }
-            }
+            std::vector< Texture > textures(mTextures.begin(),mTextures.begin()+mTextureIndex);
+            Bin bin;
+            packBin(textures,mTotalArea,forcePowerOfTwo,onePixelBorder,bin);
             
-            height = 0;
-            for (int i=0; i<getTextureCount(); i++)
+            int border = onePixelBorder ? 1 : 0;
+            for (int i=0; i<mTextureIndex; i++)
             {
-                Texture &t = mTextures[i];
-                if ( onePixelBorder )
-                {
-                    t.mWidth-=2;
-                    t.mHeight-=2;
-                    t.mX++;
-                    t.mY++;
-                }
-                
-                int y;
-                if (t.mFlipped)
-                {
-                    y = t.mY + t.mWidth;
-                }
-                else
-                {
-                    y = t.mY + t.mHeight;
-                }	  
-                
-                if ( y > height )
-                    height = y;
+                const Texture &t = textures[i];
+                mTextures[i].place(t.mX+border,t.mY+border,t.mFlipped);
             }
             
-            if ( forcePowerOfTwo )
-            {
-                height = nextPow2(height);
-            }
+            width = bin.mWidth;
+            height = getHeight(bin,forcePowerOfTwo,onePixelBorder);
             
             return (width*height)-mTotalArea;
         }
         
-        bool mergeNodes(void)
-        {
-            Node *f = mFreeList;
-            while ( f )
-            {
-                Node *prev = 0;
-                Node *c = mFreeList;
-                while ( c )
-                {
-                    if ( f != c )
-                    {
-                        if ( f->merge(*c) )
-                        {
-                            assert(prev);
-                            prev->mNext = c->mNext;
-                            delete c;
-                            return true;
-                        }
-                    }
-                    prev = c;
-                    c = c->mNext;
-                }
-                f = f->mNext;
-            }
-            return false;
-        }
-        
-        void validate(void)
-        {
-#ifdef _DEBUG
-            Node *f = mFreeList;
-            while ( f )
-            {
-                Node *c = mFreeList;
-                while ( c )
-                {
-                    if ( f != c )
-                    {
-                        f->validate(c);
-                    }
-                    c = c->mNext;
-                }
-                f = f->mNext;
-            }
-#endif
-        }
-        
         virtual bool  getTextureLocation(int index,int &x,int &y,int &wid,int &hit)
         {
             bool ret = false;
@@ -629,19 +601,88 @@ namespace TEXTURE_PACKER
             
             return ret;
         }
+    
+
+    private:
+        // Packs the textures into the bin, adding the border to them, and returns the index of the one placed last.
+        // The width is no more than the longest edge of any texture, and we guess that the height is no more than twice
+        // the longest edge beyond what the total area needs; the bin grows if the guess is too small.
+        static int packBin(std::vector< Texture > &textures,int totalArea,bool forcePowerOfTwo,bool onePixelBorder,Bin &bin)
+        {
+            int longestEdge = 0;
+            std::vector< int > order(textures.size());
+            for (size_t i=0; i<textures.size(); i++)
+            {
+                Texture &t = textures[i];
+                if ( onePixelBorder )
+                {
+                    t.set(t.mWidth+2,t.mHeight+2);
+                }
+                if ( t.mLongestEdge > longestEdge )
+                    longestEdge = t.mLongestEdge;
+                order[i] = (int)i;
+            }
+            
+            if ( forcePowerOfTwo )
+            {
+                longestEdge = nextPow2(longestEdge);
+            }
+            
+            // Sort the textures once rather than searching for the next one to place each time.
+            std::stable_sort(order.begin(),order.end(),PlacementOrder(textures));
+            
+            int count = totalArea / (longestEdge*longestEdge);
+            bin.begin(longestEdge,(count+2)*longestEdge);
+            for (size_t i=0; i<order.size(); i++)
+            {
+                bin.place(textures[order[i]]);
+            }
+            
+            return order.back();
+        }
+        
+        // The height of the packed textures, leaving out the border below the lowest one.
+        static int getHeight(const Bin &bin,bool forcePowerOfTwo,bool onePixelBorder)
+        {
+            int height = bin.mUsedHeight;
+            if ( onePixelBorder )
+            {
+                height--;
+            }
+            if ( forcePowerOfTwo )
+            {
+                height = nextPow2(height);
+            }
+            return height;
+        }
         
+        // True if packing one more texture would place the others exactly as the kept packing did and then place it last,
+        // which is when it comes after all of them in the placement order and it doesn't change the height we guess.
+        bool continuesFit(const Texture &t,int totalArea) const
+        {
+            if ( !mFitValid || t.placedBefore(mFitLast) )
+            {
+                return false;
+            }
+            int edge = mFitBin.mWidth;
+            return totalArea / (edge*edge) == mFitArea / (edge*edge);
+        }
         
-    private:
-        int    mDebugCount;
-        Node    *mFreeList;
         int    mTextureIndex;
         int    mTextureCount;
-        Texture *mTextures;
-        int    mLongestEdge;
+        std::vector< Texture > mTextures;
         int    mTotalArea;
+        
+        // The textures added so far, packed for wouldTextureFit.
+        bool    mFitValid;
+        bool    mFitPowerOfTwo;
+        bool    mFitBorder;
+        Bin     mFitBin;
+        Texture mFitLast;
+        int     mFitArea;
     };
     
-    
+
     TexturePacker * createTexturePacker(void)
     {
         MyTexturePacker *m = new MyTexturePacker;
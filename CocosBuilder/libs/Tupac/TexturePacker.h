@@ -64,7 +64,8 @@
 //
 // Step #1 : Find the longest edge and total area of all source textures.
 // Step #2 : Create a single large rectangle big enough to fit all textures; round up to the nearest power of two if necessary.
-// Step #3 : Place each texture, first by finding the texture with the largest area and longest edge that has not yet been placed.
+//             If it turns out to be too small, it grows downwards.
+// Step #3 : Sort the textures by longest edge and then largest area, and place each in that order.
 // Step #4 :  .. Look through the free nodes list and if a free node is exactly the same size, then use it.
 //               Otherwise, find a free node that is furthest down and to the left of the co-ordinate space (growing up and too the right)
 //               Always insert the node so that the long edge lays down, preventing as much as possible the texture-atlas from growing vertically.
@@ -72,6 +73,7 @@
 // Step #5 : If the texture we are inserting shares an edge with the free node, then simply shrink the free node down to make up the difference.
 // Step #6 : If the texture doesn't share any edge then split the rectangle in two, allocating a new free node and adding to the node list.
 // Step #7 : See if any nodes can be combined back into one; do this until no more rectangles can be collapsed.
+//             Sorting the free nodes by column and by row puts the ones that can be combined next to each other.
 // Step #8 : Repeat until all textures have been inserted.
 // Step #9 : Find the maximum height we ended up using and return that as the actual height.  Clamp the height to the nearest power of two if needed.
 // Step #10 : Iterate through the results and copy your textures to a single large texture-atlas.
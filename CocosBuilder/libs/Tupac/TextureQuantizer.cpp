@@ -0,0 +1,219 @@
+/** @file TextureQuantizer.cpp
+
+	@brief Converts RGBA images to 16 bit per pixel texture formats, optionally with dithering.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "TextureQuantizer.h"
+
+namespace
+{
+	/// The number of bits of each RGBA channel and where they go in the texel.
+	struct TexelLayout
+	{
+		int bits[4];
+		int shift[4];
+	};
+
+	const TexelLayout TexelLayouts[2] =
+	{
+		{ { 4, 4, 4, 4 }, { 12, 8, 4, 0 } }, // TexelFormatRGBA4444
+		{ { 5, 6, 5, 0 }, { 11, 5, 0, 0 } } // TexelFormatRGB565
+	};
+
+	const int Bayer4x4[4][4] =
+	{
+		{ 0, 8, 2, 10 },
+		{ 12, 4, 14, 6 },
+		{ 3, 11, 1, 9 },
+		{ 15, 7, 13, 5 }
+	};
+
+	/// Rounds v * maxValue / 255 to the closest integer, for v in [0, 255].
+	inline int QuantizeChannel(int v, int maxValue)
+	{
+		int x = v * maxValue + 128;
+		return (x + (x >> 8)) >> 8;
+	}
+
+	/// The inverse of QuantizeChannel.
+	inline int ExpandChannel(int q, int maxValue)
+	{
+		return (q * 255 + maxValue / 2) / maxValue;
+	}
+
+	/// The offsets ordered dithering adds to each channel, indexed by [y & 3][x & 3][channel]. They range
+	/// over one quantization step, centered on zero, so 0 and 255 are never rounded to another value.
+	struct DitherOffsets
+	{
+		short offsets[4][4][4];
+
+		DitherOffsets(const TexelLayout &layout, bool ordered)
+		{
+			for(int y = 0; y < 4; ++y)
+				for(int x = 0; x < 4; ++x)
+					for(int c = 0; c < 4; ++c)
+					{
+						int maxValue = (1 << layout.bits[c]) - 1;
+						double step = maxValue > 0 ? 255.0 / maxValue : 0;
+						double threshold = (Bayer4x4[y][x] + 0.5) / 16 - 0.5;
+						offsets[y][x][c] = ordered ? (short)floor(threshold * step + 0.5) : 0;
+					}
+		}
+	};
+
+	/// Quantizes pixels [begin, end) of a row, adding the dither offsets of the row.
+	void QuantizeRow(const unsigned char *src, int begin, int end, const TexelLayout &layout,
+		const short (*offsets)[4], unsigned char *dst)
+	{
+		for(int x = begin; x < end; ++x)
+		{
+			const unsigned char *p = src + x*4;
+			unsigned int texel = 0;
+			for(int c = 0; c < 4; ++c)
+			{
+				int maxValue = (1 << layout.bits[c]) - 1;
+				int v = std::max(0, std::min(p[c] + offsets[x & 3][c], 255));
+				texel |= QuantizeChannel(v, maxValue) << layout.shift[c];
+			}
+			dst[x*2] = (unsigned char)texel;
+			dst[x*2 + 1] = (unsigned char)(texel >> 8);
+		}
+	}
+
+#if defined(__SSE2__)
+	/// Quantizes two pixels, unpacked to 16 bits per channel, and leaves each texel in the low 16 bits
+	/// of its 64 bit half.
+	inline __m128i QuantizePixelPair(__m128i v, __m128i offsets, __m128i maxValues, __m128i shifts)
+	{
+		v = _mm_add_epi16(v, offsets);
+		v = _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), _mm_set1_epi16(255));
+
+		__m128i x = _mm_add_epi16(_mm_mullo_epi16(v, maxValues), _mm_set1_epi16(128));
+		__m128i q = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+
+		// Shift each channel into place by multiplying with a power of two, then OR the channels together
+		q = _mm_mullo_epi16(q, shifts);
+		q = _mm_or_si128(q, _mm_srli_epi32(q, 16));
+		q = _mm_or_si128(q, _mm_srli_epi64(q, 32));
+
+		// Move the texels to the low 32 bits
+		q = _mm_shuffle_epi32(q, _MM_SHUFFLE(3, 1, 2, 0));
+		return _mm_shufflelo_epi16(q, _MM_SHUFFLE(3, 1, 2, 0));
+	}
+
+	/// Quantizes the pixels of a row four at a time.
+	/// @return The number of pixels quantized, a multiple of four.
+	int QuantizeRowSSE2(const unsigned char *src, int width, const TexelLayout &layout, const short (*offsets)[4], unsigned char *dst)
+	{
+		short maxValue[4], shift[4];
+		for(int c = 0; c < 4; ++c)
+		{
+			maxValue[c] = (short)((1 << layout.bits[c]) - 1);
+			shift[c] = (short)(1 << layout.shift[c]);
+		}
+
+		__m128i maxValues = _mm_setr_epi16(maxValue[0], maxValue[1], maxValue[2], maxValue[3], maxValue[0], maxValue[1], maxValue[2], maxValue[3]);
+		__m128i shifts = _mm_setr_epi16(shift[0], shift[1], shift[2], shift[3], shift[0], shift[1], shift[2], shift[3]);
+		__m128i offsetsLow = _mm_loadu_si128((const __m128i*)offsets[0]);
+		__m128i offsetsHigh = _mm_loadu_si128((const __m128i*)offsets[2]);
+		__m128i zero = _mm_setzero_si128();
+
+		int x = 0;
+		for(; x + 4 <= width; x += 4)
+		{
+			__m128i pixels = _mm_loadu_si128((const __m128i*)(src + x*4));
+			__m128i low = QuantizePixelPair(_mm_unpacklo_epi8(pixels, zero), offsetsLow, maxValues, shifts);
+			__m128i high = QuantizePixelPair(_mm_unpackhi_epi8(pixels, zero), offsetsHigh, maxValues, shifts);
+			_mm_storel_epi64((__m128i*)(dst + x*2), _mm_unpacklo_epi32(low, high));
+		}
+		return x;
+	}
+#endif
+
+	void QuantizeErrorDiffusion(const RGBAImage &image, const TexelLayout &layout, unsigned char *dst)
+	{
+		// The errors carried to the current and the next row, in 1/16ths, with a pixel of padding on both sides
+		size_t rowLength = (image.width + 2) * 4;
+		std::vector<int> errors(rowLength * 2, 0);
+		int *current = &errors[4];
+		int *next = &errors[rowLength + 4];
+
+		for(int y = 0; y < image.height; ++y)
+		{
+			const unsigned char *src = image.Row(y);
+			std::fill(next - 4, next - 4 + rowLength, 0);
+
+			for(int x = 0; x < image.width; ++x)
+			{
+				unsigned int texel = 0;
+				for(int c = 0; c < 4; ++c)
+				{
+					if (!layout.bits[c])
+						continue;
+
+					int maxValue = (1 << layout.bits[c]) - 1;
+					int v = src[x*4 + c];
+					bool exact = (c == 3 && (v == 0 || v == 255));
+					if (!exact)
+					{
+						int e = current[x*4 + c];
+						v = std::max(0, std::min(v + (e >= 0 ? e + 8 : e - 8) / 16, 255));
+					}
+
+					int q = QuantizeChannel(v, maxValue);
+					texel |= q << layout.shift[c];
+
+					if (exact)
+						continue;
+
+					int error = v - ExpandChannel(q, maxValue);
+					current[(x+1)*4 + c] += error * 7;
+					next[(x-1)*4 + c] += error * 3;
+					next[x*4 + c] += error * 5;
+					next[(x+1)*4 + c] += error;
+				}
+				dst[x*2] = (unsigned char)texel;
+				dst[x*2 + 1] = (unsigned char)(texel >> 8);
+			}
+
+			dst += image.width * 2;
+			std::swap(current, next);
+		}
+	}
+}
+
+void QuantizeImage(const RGBAImage &image, TexelFormat format, DitherMode dither, std::vector<unsigned char> &texels)
+{
+	const TexelLayout &layout = TexelLayouts[format];
+	texels.resize((size_t)image.width * image.height * 2);
+	if (texels.empty())
+		return;
+
+	if (dither == DitherErrorDiffusion)
+	{
+		QuantizeErrorDiffusion(image, layout, &texels[0]);
+		return;
+	}
+
+	DitherOffsets offsets(layout, dither == DitherOrdered);
+	for(int y = 0; y < image.height; ++y)
+	{
+		const unsigned char *src = image.Row(y);
+		unsigned char *dst = &texels[(size_t)y * image.width * 2];
+		const short (*rowOffsets)[4] = offsets.offsets[y & 3];
+
+		int x = 0;
+#if defined(__SSE2__)
+		x = QuantizeRowSSE2(src, image.width, layout, rowOffsets, dst);
+#endif
+		QuantizeRow(src, x, image.width, layout, rowOffsets, dst);
+	}
+}
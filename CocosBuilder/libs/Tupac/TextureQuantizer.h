@@ -0,0 +1,30 @@
+/** @file TextureQuantizer.h
+
+	@brief Converts RGBA images to 16 bit per pixel texture formats, optionally with dithering.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "AtlasCompositor.h"
+
+/// The 16 bit texel formats QuantizeImage can convert to.
+enum TexelFormat
+{
+	TexelFormatRGBA4444, ///< 4 bits for each channel, red in the high bits.
+	TexelFormatRGB565 ///< 5 bits for red and blue and 6 for green, red in the high bits. Alpha is dropped.
+};
+
+enum DitherMode
+{
+	DitherNone, ///< Rounds every channel to the closest value.
+	DitherOrdered, ///< Adds a 4x4 Bayer threshold pattern before rounding. Fast, but leaves a regular pattern.
+	DitherErrorDiffusion ///< Spreads the rounding error to the neighbouring pixels (Floyd-Steinberg).
+};
+
+/// Converts an image to 16 bit texels.
+/// @param texels [out] The texels in little endian byte order, from the top row down.
+/// Alpha values of 0 and 255 are never changed by dithering, so transparent borders stay transparent.
+void QuantizeImage(const RGBAImage &image, TexelFormat format, DitherMode dither, std::vector<unsigned char> &texels);
@@ -19,6 +19,22 @@ enum {
     kTupacImageFormatWEBP
 };
 
+enum {
+    kTupacPVRTCQualityFast,
+    kTupacPVRTCQualityNormal,
+    kTupacPVRTCQualityBest
+};
+
+enum {
+    kTupacMipmapFilterBox,
+    kTupacMipmapFilterKaiser
+};
+
+enum {
+    kTupacDitherErrorDiffusion,
+    kTupacDitherOrdered
+};
+
 @interface Tupac : NSObject 
 
 @property(nonatomic) BOOL border;
@@ -30,11 +46,41 @@ enum {
 @property(nonatomic,copy) NSString* directoryPrefix;
 @property(nonatomic,assign) int maxTextureSize;
 @property(nonatomic,assign) int padding;
+// Number of pixels the edges of each frame are repeated outwards by, in addition to the padding
+@property(nonatomic,assign) int extrude;
+// Gives the transparent pixels around and inside frames the color of their neighbours, so filtering doesn't darken the edges
+@property(nonatomic,assign) BOOL alphaBleed;
 @property(nonatomic,assign) BOOL dither;
+// How 16 bit PVR textures are dithered, 8 bit PNG sprite sheets are always dithered by error diffusion
+@property(nonatomic,assign) int ditherMode;
 @property(nonatomic,assign) BOOL compress;
+@property(nonatomic,assign) BOOL polygonMode;
+@property(nonatomic,assign) int pvrtcQuality;
+// Stores mipmaps in PVR textures, filtered so that frames don't bleed into each other. Other formats can't hold mipmaps
+@property(nonatomic,assign) BOOL mipmaps;
+@property(nonatomic,assign) int mipmapFilter;
+// Quality of WebP sprite sheets from 0 to 100, as cwebp -q takes it. At 100 the sheets are lossless
+@property(nonatomic,assign) int webpQuality;
+// Largest number of colors of 8 bit PNG sprite sheets, from 2 to 256
+@property(nonatomic,assign) int paletteColors;
+// Directory of previously generated sprite sheets, keyed on the content of their images and the settings. No cache is used if it is NULL
+@property(nonatomic,copy) NSString* cacheDirectory;
+@property(nonatomic,readonly) int numPages;
 
 + (Tupac*) tupac;
 
+// Returns the name of a page of a sprite sheet, the first page uses the output name as is
++ (NSString*) pageName:(int)page forOutputName:(NSString*)name;
+
+// Returns the number of pages of a generated sprite sheet, which its first page lists, or 0 if there is no sprite sheet
++ (int) numPagesForOutputName:(NSString*)name;
+
+// Extension of the texture files written in the image format: png, webp, pvr or pvr.ccz
+- (NSString*) textureExtension;
+
+// Reduces a PNG file to a palette of at most the given number of colors, overwriting it
++ (BOOL) convertToIndexedPNG:(NSString*)file colors:(int)colors dither:(BOOL)dither;
+
 - (void) createTextureAtlasFromDirectoryPaths:(NSArray *)dirs;
 - (void)createTextureAtlas;
 
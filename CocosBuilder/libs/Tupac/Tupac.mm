@@ -7,49 +7,28 @@
 //
 
 #import "Tupac.h"
-#import "MaxRectsBinPack.h"
+#import "SpriteSheetBuilder.h"
+#import "PNGCodec.h"
+#import "PaletteQuantizer.h"
+#import "SHA256.h"
 #import "vector"
 
 #import <Cocoa/Cocoa.h>
-#import <QuartzCore/QuartzCore.h>
-#import <CoreGraphics/CGImage.h>
 
-#import "pvrtc.h"
+// Part of the cache key, increase it when the same images and settings produce different sprite sheets
+#define kTupacCacheVersion 5
 
-unsigned long upper_power_of_two(unsigned long v)
-{
-    v--;
-    v |= v >> 1;
-    v |= v >> 2;
-    v |= v >> 4;
-    v |= v >> 8;
-    v |= v >> 16;
-    v++;
-    return v;
-}
+// Number of sprite sheets kept in the cache, the least recently used ones are removed first
+#define kTupacCacheMaxEntries 256
 
-typedef struct _PVRTexHeader
-{
-    uint32_t headerLength;
-    uint32_t height;
-    uint32_t width;
-    uint32_t numMipmaps;
-    uint32_t flags;
-    uint32_t dataLength;
-    uint32_t bpp;
-    uint32_t bitmaskRed;
-    uint32_t bitmaskGreen;
-    uint32_t bitmaskBlue;
-    uint32_t bitmaskAlpha;
-    uint32_t pvrTag;
-    uint32_t numSurfs;
-} PVRTexHeader;
+// Name of the file listing the files of a sprite sheet in the cache
+#define kTupacCacheManifest @"manifest.plist"
 
 
 @implementation Tupac {
 }
 
-@synthesize scale=scale_, border=border_, filenames=filenames_, outputName=outputName_, outputFormat=outputFormat_, imageFormat=imageFormat_, directoryPrefix=directoryPrefix_, maxTextureSize=maxTextureSize_, padding=padding_, dither=dither_, compress=compress_;
+@synthesize scale=scale_, border=border_, filenames=filenames_, outputName=outputName_, outputFormat=outputFormat_, imageFormat=imageFormat_, directoryPrefix=directoryPrefix_, maxTextureSize=maxTextureSize_, padding=padding_, extrude=extrude_, alphaBleed=alphaBleed_, dither=dither_, ditherMode=ditherMode_, compress=compress_, polygonMode=polygonMode_, pvrtcQuality=pvrtcQuality_, mipmaps=mipmaps_, mipmapFilter=mipmapFilter_, webpQuality=webpQuality_, paletteColors=paletteColors_, cacheDirectory=cacheDirectory_, numPages=numPages_;
 
 + (Tupac*) tupac
 {
@@ -66,6 +45,10 @@ typedef struct _PVRTexHeader
         self.outputFormat = TupacOutputFormatCocos2D;
         self.maxTextureSize = 2048;
         self.padding = 1;
+        self.pvrtcQuality = kTupacPVRTCQualityBest;
+        self.mipmapFilter = kTupacMipmapFilterKaiser;
+        self.webpQuality = 80;
+        self.paletteColors = 256;
     }
     return self;
 }
@@ -75,90 +58,11 @@ typedef struct _PVRTexHeader
     [filenames_ release];
     [outputName_ release];
     [outputFormat_ release];
+    [cacheDirectory_ release];
     
     [super dealloc];
 }
 
-- (NSRect) trimmedRectForImage:(CGImageRef)image
-{
-    int w = (int)CGImageGetWidth(image);
-    int h = (int)CGImageGetHeight(image);
-    
-    int bytesPerRow = (int)CGImageGetBytesPerRow(image);
-    int pixelsPerRow = bytesPerRow/4;
-    
-    CGImageGetDataProvider((CGImageRef)image);
-    CFDataRef imageData = CGDataProviderCopyData(CGImageGetDataProvider(image));
-    const UInt32 *pixels = (const UInt32*)CFDataGetBytePtr(imageData);
-    
-    // Search from left
-    int x;
-    for (x = 0; x < w; x++)
-    {
-        BOOL emptyRow = YES;
-        for (int y = 0; y < h; y++)
-        {
-            if (pixels[y*pixelsPerRow+x] & 0xff000000)
-            {
-                emptyRow = NO;
-            }
-        }
-        if (!emptyRow) break;
-    }
-    
-    // Search from right
-    int xRight;
-    for (xRight = w-1; xRight >= 0; xRight--)
-    {
-        BOOL emptyRow = YES;
-        for (int y = 0; y < h; y++)
-        {
-            if (pixels[y*pixelsPerRow+xRight] & 0xff000000)
-            {
-                emptyRow = NO;
-            }
-        }
-        if (!emptyRow) break;
-    }
-    
-    // Search from bottom
-    int y;
-    for (y = 0; y < h; y++)
-    {
-        BOOL emptyRow = YES;
-        for (int x = 0; x < w; x++)
-        {
-            if (pixels[y*pixelsPerRow+x] & 0xff000000)
-            {
-                emptyRow = NO;
-            }
-        }
-        if (!emptyRow) break;
-    }
-    
-    // Search from top
-    int yTop;
-    for (yTop = h-1; yTop >=0; yTop--)
-    {
-        BOOL emptyRow = YES;
-        for (int x = 0; x < w; x++)
-        {
-            if (pixels[yTop*pixelsPerRow+x] & 0xff000000)
-            {
-                emptyRow = NO;
-            }
-        }
-        if (!emptyRow) break;
-    }
-    
-    int wTrimmed = xRight-x+1;
-    int hTrimmed = yTop-y+1;
-    
-    CFRelease(imageData);
-    
-    return NSMakeRect(x, y, wTrimmed, hTrimmed);
-}
-
 - (void)createTextureAtlas
 {
     // Create output directory if it doesn't exist
@@ -169,364 +73,227 @@ typedef struct _PVRTexHeader
         [fm createDirectoryAtPath:outputDir withIntermediateDirectories:YES attributes:NULL error:NULL];
     }
     
-    // Load images and retrieve information about them
-    NSMutableArray *images = [NSMutableArray arrayWithCapacity:self.filenames.count];
-    NSMutableArray *imageInfos = [NSMutableArray arrayWithCapacity:self.filenames.count];
-    
-    CGColorSpaceRef colorSpace = NULL;
-    BOOL createdColorSpace = NO;
-        
-    for (NSString *filename in self.filenames)
+    // Reuse the sprite sheet if it was generated from the same images and settings before
+    NSString* cacheKey = NULL;
+    if (self.cacheDirectory)
     {
-        // Load CGImage
-        CGDataProviderRef dataProvider = CGDataProviderCreateWithFilename([filename cStringUsingEncoding:NSUTF8StringEncoding]);
-        CGImageRef srcImage = CGImageCreateWithPNGDataProvider(dataProvider, NULL, NO, kCGRenderingIntentDefault);
-        
-        // Get info
-        int w = (int)CGImageGetWidth(srcImage);
-        int h = (int)CGImageGetHeight(srcImage);
-        
-        NSRect trimRect = [self trimmedRectForImage:srcImage];
-        
-        if (!colorSpace)
-        {
-            colorSpace = CGImageGetColorSpace(srcImage);
-        
-            if (CGColorSpaceGetModel(colorSpace) == kCGColorSpaceModelIndexed)
-            {
-                colorSpace = CGColorSpaceCreateDeviceRGB();
-                createdColorSpace = YES;
-            }
-        }
-        
-        NSMutableDictionary* imageInfo = [NSMutableDictionary dictionary];
-        [imageInfo setObject:[NSNumber numberWithInt:w] forKey:@"width"];
-        [imageInfo setObject:[NSNumber numberWithInt:h] forKey:@"height"];
-        [imageInfo setObject:[NSValue valueWithRect:trimRect] forKey:@"trimRect"];
-        
-        // Store info info
-        [imageInfos addObject:imageInfo];
-        [images addObject:[NSValue valueWithPointer:srcImage]];
-        
-        // Relase objects (images released later)
-        CGDataProviderRelease(dataProvider);
+        cacheKey = [self cacheKey];
+        if ([self restoreFromCache:cacheKey]) return;
     }
     
     // Check that the output format is valid
-    if (![self.outputFormat isEqualToString:TupacOutputFormatCocos2D]
-        && ![self.outputFormat isEqualToString:TupacOutputFormatAndEngine]) {
-        fprintf(stderr, "unknown output format %s\n", [self.outputFormat UTF8String]);
+    if ([self.outputFormat isEqualToString:TupacOutputFormatAndEngine])
+    {
+        fprintf(stderr, "[MO] output format %s not yet supported\n", [self.outputFormat UTF8String]);
         exit(EXIT_FAILURE);
     }
-
-    // Find the longest side
-    int maxSideLen = 8;
-    for (NSDictionary* imageInfo in imageInfos)
+    else if (![self.outputFormat isEqualToString:TupacOutputFormatCocos2D])
     {
-        NSRect trimRect = [[imageInfo objectForKey:@"trimRect"] rectValue];
-        
-        int w = trimRect.size.width;
-        if (w > maxSideLen) maxSideLen = w + self.padding * 2;
-        
-        int h = trimRect.size.height;
-        if (h > maxSideLen) maxSideLen = h + self.padding * 2;
+        fprintf(stderr, "unknown output format %s\n", [self.outputFormat UTF8String]);
+        exit(EXIT_FAILURE);
     }
-    maxSideLen = upper_power_of_two(maxSideLen);
     
-    // Pack using max rects
-    int outW = maxSideLen;
-    int outH = 8;
+    SpriteSheetSettings settings;
+    settings.imageFormat = (SpriteSheetImageFormat)self.imageFormat;
+    settings.maxSize = self.maxTextureSize;
+    settings.padding = self.padding;
+    settings.extrude = self.extrude;
+    settings.alphaBleed = self.alphaBleed;
+    settings.dither = self.dither;
+    settings.ditherMode = (self.ditherMode == kTupacDitherOrdered) ? DitherOrdered : DitherErrorDiffusion;
+    settings.compress = self.compress;
+    settings.polygonMode = self.polygonMode;
+    settings.pvrtcQuality = (PVRTCQuality)self.pvrtcQuality;
+    settings.mipmaps = self.mipmaps;
+    settings.mipmapFilter = (MipmapFilter)self.mipmapFilter;
+    settings.webpQuality = self.webpQuality;
+    settings.paletteColors = self.paletteColors;
+    
+    std::vector<SpriteSheetImage> images(self.filenames.count);
+    for (int i = 0; i < (int)self.filenames.count; i++)
+    {
+        images[i].path = [[self.filenames objectAtIndex:i] fileSystemRepresentation];
+        images[i].name = [[self exportFilenameForImage:i] UTF8String];
+    }
     
-    std::vector<TPRect> outRects;
+    // Trim, pack and export the images, the pages are drawn and written concurrently
+    SpriteSheetBuilder builder(settings);
+    builder.Build(images, [self.outputName fileSystemRepresentation]);
+    numPages_ = builder.NumPages();
     
-    BOOL makeSquare = NO;
-    if (self.imageFormat == kTupacImageFormatPVRTC_2BPP || kTupacImageFormatPVRTC_4BPP)
+    for (size_t i = 0; i < builder.Errors().size(); i++)
     {
-        makeSquare = YES;
-        outH = outW;
+        NSLog(@"%s", builder.Errors()[i].c_str());
     }
-    BOOL allFitted = NO;
-    while (outW <= self.maxTextureSize && !allFitted)
+    for (size_t i = 0; i < builder.Notices().size(); i++)
     {
-        MaxRectsBinPack bin(outW, outH);
-        
-        std::vector<TPRectSize> inRects;
-        
-        int numImages = 0;
-        for (NSDictionary* imageInfo in imageInfos)
-        {
-            NSRect trimRect = [[imageInfo objectForKey:@"trimRect"] rectValue];
-            
-            inRects.push_back(TPRectSize());
-            inRects[numImages].width = trimRect.size.width + self.padding * 2;
-            inRects[numImages].height = trimRect.size.height + self.padding * 2;
-            inRects[numImages].idx = numImages;
-            
-            numImages++;
-        }
-       
-        bin.Insert(inRects, outRects, MaxRectsBinPack::RectBestShortSideFit);
-        
-        if (numImages == (int)outRects.size())
-        {
-            allFitted = YES;
-        }
-        else
-        {
-            outH *= 2;
-            
-            if (makeSquare)
-            {
-                outW = outH;
-            }
-            else
-            {
-                if (outH > self.maxTextureSize)
-                {
-                    outH = 8;
-                    outW *= 2;
-                }
-            }
-        }
+        NSLog(@"%s", builder.Notices()[i].c_str());
     }
     
-    // Create the output graphics context
-    CGContextRef dstContext = CGBitmapContextCreate(NULL, outW, outH, 8, outW*32, colorSpace, kCGImageAlphaPremultipliedLast);
-    
-    // Draw all the individual images
-    int index = 0;
-    while (index < outRects.size())
+    NSMutableArray* outputFiles = [NSMutableArray arrayWithCapacity:builder.Files().size()];
+    for (size_t i = 0; i < builder.Files().size(); i++)
     {
-        bool rot = false;
-        int  x, y, w, h;
-        
-        // Get the image and info
-        CGImageRef srcImage = (CGImageRef)[[images objectAtIndex:outRects[index].idx] pointerValue];
-        NSDictionary* imageInfo = [imageInfos objectAtIndex:outRects[index].idx];
-        
-        x = outRects[index].x;
-        y = outRects[index].y;
-       
-        rot = outRects[index].rotated;
-        
-        x += self.padding;
-        y += self.padding;
-        
-        NSRect trimRect = [[imageInfo objectForKey:@"trimRect"] rectValue];
-        if (rot)
-        {
-            h = [[imageInfo objectForKey:@"width"] intValue];
-            w = [[imageInfo objectForKey:@"height"] intValue];
-            
-            x -= (w - trimRect.origin.y - trimRect.size.height);
-            y -= trimRect.origin.x;
-        }
-        else
-        {
-            w = [[imageInfo objectForKey:@"width"] intValue];
-            h = [[imageInfo objectForKey:@"height"] intValue];
-            
-            x -= trimRect.origin.x;
-            y -= trimRect.origin.y;
-        }
-        
-        if (rot)
-        {
-            // Rotate image 90 degrees
-            CGContextRef rotContext = CGBitmapContextCreate(NULL, w, h, 8, 32*h, colorSpace, kCGImageAlphaPremultipliedLast);
-            CGContextSaveGState(rotContext);
-            CGContextRotateCTM(rotContext, -M_PI/2);
-            CGContextTranslateCTM(rotContext, -h, 0);
-            CGContextDrawImage(rotContext, CGRectMake(0, 0, h, w), srcImage);
-            
-            CGImageRelease(srcImage);
-            srcImage = CGBitmapContextCreateImage(rotContext);
-            CFRelease(rotContext);
-        }
-        
-        // Draw the image
-        CGContextDrawImage(dstContext, CGRectMake(x, outH-y-h, w, h), srcImage);
-        
-        // Release the image
-        CGImageRelease(srcImage);
-        
-        index++;
+        [outputFiles addObject:[fm stringWithFileSystemRepresentation:builder.Files()[i].c_str() length:builder.Files()[i].size()]];
     }
     
-    [NSGraphicsContext restoreGraphicsState];
+    if (cacheKey) [self storeInCache:cacheKey files:outputFiles];
+}
+
+// Identifies a sprite sheet by the names and content of its images and the settings it is generated with
+- (NSString*) cacheKey
+{
+    NSArray* files = self.filenames;
+    
+    // Hash the images concurrently
+    std::vector<std::string> digests(files.count);
+    std::vector<std::string>* imageDigests = &digests;
+    dispatch_apply(files.count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+        NSData* data = [NSData dataWithContentsOfFile:[files objectAtIndex:i] options:NSDataReadingMappedIfSafe error:NULL];
+        SHA256 hash;
+        if (data) hash.Update([data bytes], [data length]);
+        (*imageDigests)[i] = hash.FinalHex();
+        [pool drain];
+    });
+    
+    // The order of the images doesn't matter
+    NSMutableArray* images = [NSMutableArray arrayWithCapacity:files.count];
+    for (int i = 0; i < (int)files.count; i++)
+    {
+        [images addObject:[NSString stringWithFormat:@"%@ %s", [self exportFilenameForImage:i], digests[i].c_str()]];
+    }
+    [images sortUsingSelector:@selector(compare:)];
+    
+    NSString* settings = [NSString stringWithFormat:@"%d %@ %@ %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %g",
+                          kTupacCacheVersion, [self.outputName lastPathComponent], self.outputFormat,
+                          self.imageFormat, self.maxTextureSize, self.padding, self.extrude, self.alphaBleed,
+                          self.dither, self.ditherMode, self.compress, self.polygonMode, self.pvrtcQuality, self.mipmaps, self.mipmapFilter,
+                          self.webpQuality, self.paletteColors, self.border, self.scale];
+    
+    NSString* key = [NSString stringWithFormat:@"%@\n%@", settings, [images componentsJoinedByString:@"\n"]];
+    const char* keyString = [key UTF8String];
+    SHA256 hash;
+    hash.Update(keyString, strlen(keyString));
+    return [NSString stringWithUTF8String:hash.FinalHex().c_str()];
+}
+
+// Copies a sprite sheet from the cache to the output directory
+- (BOOL) restoreFromCache:(NSString*)key
+{
+    NSFileManager* fm = [NSFileManager defaultManager];
+    NSString* entryDir = [self.cacheDirectory stringByAppendingPathComponent:key];
+    NSDictionary* manifest = [NSDictionary dictionaryWithContentsOfFile:[entryDir stringByAppendingPathComponent:kTupacCacheManifest]];
+    if (!manifest) return NO;
     
-    NSString* textureFileName = NULL;
+    // An earlier publish may have written more pages
+    numPages_ = [[manifest objectForKey:@"numPages"] intValue];
+    SpriteSheetBuilder::RemovePages([self.outputName fileSystemRepresentation], numPages_);
     
-    // Export PNG file
+    NSString* outputDir = [self.outputName stringByDeletingLastPathComponent];
+    for (NSString* file in [manifest objectForKey:@"files"])
+    {
+        NSString* dstFile = [outputDir stringByAppendingPathComponent:file];
+        [fm removeItemAtPath:dstFile error:NULL];
+        if (![fm copyItemAtPath:[entryDir stringByAppendingPathComponent:file] toPath:dstFile error:NULL]) return NO;
+    }
     
-    NSString *pngFilename  = [self.outputName stringByAppendingPathExtension:@"png"];
+    // Mark the entry as recently used
+    [fm setAttributes:[NSDictionary dictionaryWithObject:[NSDate date] forKey:NSFileModificationDate] ofItemAtPath:entryDir error:NULL];
+    return YES;
+}
+
+- (void) storeInCache:(NSString*)key files:(NSArray*)files
+{
+    NSFileManager* fm = [NSFileManager defaultManager];
+    NSString* entryDir = [self.cacheDirectory stringByAppendingPathComponent:key];
     
-    CFURLRef url = (CFURLRef)[NSURL fileURLWithPath:pngFilename];
-    CGImageRef imageDst = CGBitmapContextCreateImage(dstContext);
-    CGImageDestinationRef destination = CGImageDestinationCreateWithURL(url, kUTTypePNG, 1, NULL);
-    CGImageDestinationAddImage(destination, imageDst, nil);
+    // Fill a temporary directory and move it into place, so that an incomplete entry is never used
+    NSString* tempDir = [entryDir stringByAppendingFormat:@"-%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+    if (![fm createDirectoryAtPath:tempDir withIntermediateDirectories:YES attributes:NULL error:NULL]) return;
     
-    if (!CGImageDestinationFinalize(destination)) {
-        NSLog(@"Failed to write image to %@", pngFilename);
+    BOOL success = YES;
+    NSMutableArray* names = [NSMutableArray arrayWithCapacity:files.count];
+    for (NSString* file in files)
+    {
+        NSString* name = [file lastPathComponent];
+        [names addObject:name];
+        success = success && [fm copyItemAtPath:file toPath:[tempDir stringByAppendingPathComponent:name] error:NULL];
     }
     
-    textureFileName = pngFilename;
+    NSDictionary* manifest = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithInt:numPages_], @"numPages",
+                              names, @"files",
+                              nil];
+    success = success && [manifest writeToFile:[tempDir stringByAppendingPathComponent:kTupacCacheManifest] atomically:YES];
     
-    if (createdColorSpace)
+    // Another publish may have stored the same sprite sheet in the meantime
+    if (!success || ![fm moveItemAtPath:tempDir toPath:entryDir error:NULL])
     {
-        CFRelease(colorSpace);
+        [fm removeItemAtPath:tempDir error:NULL];
+        return;
     }
+    
+    [self pruneCache];
+}
 
-    // Convert file to 8 bit if original uses indexed colors
-    if (imageFormat_ == kTupacImageFormatPNG_8BIT)
+// Removes the least recently used sprite sheets from the cache if it holds too many
+- (void) pruneCache
+{
+    NSFileManager* fm = [NSFileManager defaultManager];
+    NSArray* entries = [fm contentsOfDirectoryAtPath:self.cacheDirectory error:NULL];
+    if (entries.count <= kTupacCacheMaxEntries) return;
+    
+    NSMutableDictionary* dates = [NSMutableDictionary dictionaryWithCapacity:entries.count];
+    for (NSString* entry in entries)
     {
-        NSTask* pngTask = [[NSTask alloc] init];
-        [pngTask setLaunchPath:[[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:@"pngquant"]];
-        NSMutableArray* args = [NSMutableArray arrayWithObjects:
-                                @"--force", @"--ext", @".png", pngFilename, nil];
-        if (self.dither) [args addObject:@"-dither"];
-        [pngTask setArguments:args];
-        [pngTask launch];
-        [pngTask waitUntilExit];
-        [pngTask release];
+        NSDictionary* attributes = [fm attributesOfItemAtPath:[self.cacheDirectory stringByAppendingPathComponent:entry] error:NULL];
+        [dates setObject:(attributes ? [attributes fileModificationDate] : [NSDate distantPast]) forKey:entry];
     }
-    else if (imageFormat_ == kTupacImageFormatWEBP)
+    
+    NSArray* sortedEntries = [dates keysSortedByValueUsingSelector:@selector(compare:)];
+    for (NSUInteger i = 0; i < sortedEntries.count - kTupacCacheMaxEntries; i++)
     {
-        NSString* dstFile = [self.outputName stringByAppendingPathExtension:@"webp"];
-        NSTask* webPTask = [[NSTask alloc] init];
-        [webPTask setLaunchPath:[[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:@"cwebp"]];
-        NSMutableArray* args = [NSMutableArray arrayWithObjects:
-                                @"-q", @"80", pngFilename, @"-o", dstFile, nil];
-        [webPTask setArguments:args];
-        [webPTask launch];
-        [webPTask waitUntilExit];
-        [webPTask release];
-        // Remove PNG file
-        [[NSFileManager defaultManager] removeItemAtPath:pngFilename error:NULL];
+        [fm removeItemAtPath:[self.cacheDirectory stringByAppendingPathComponent:[sortedEntries objectAtIndex:i]] error:NULL];
     }
-    else if (imageFormat_ != kTupacImageFormatPNG)
+}
+
+- (NSString*) exportFilenameForImage:(int)index
+{
+    NSString* exportFilename = [[self.filenames objectAtIndex:index] lastPathComponent];
+    if (directoryPrefix_) exportFilename = [directoryPrefix_ stringByAppendingPathComponent:exportFilename];
+    return exportFilename;
+}
+
++ (NSString*) pageName:(int)page forOutputName:(NSString*)name
+{
+    return [NSString stringWithUTF8String:SpriteSheetBuilder::PageName([name UTF8String], page).c_str()];
+}
+
++ (int) numPagesForOutputName:(NSString*)name
+{
+    NSDictionary* dict = [NSDictionary dictionaryWithContentsOfFile:[name stringByAppendingPathExtension:@"plist"]];
+    if (!dict) return 0;
+    return 1 + (int)[[[dict objectForKey:@"metadata"] objectForKey:@"pages"] count];
+}
+
+- (NSString*) textureExtension
+{
+    if (imageFormat_ == kTupacImageFormatWEBP) return @"webp";
+    if (imageFormat_ >= kTupacImageFormatPVR_RGBA8888 && imageFormat_ <= kTupacImageFormatPVRTC_2BPP)
     {
-        NSString *pvrFilename = [self.outputName stringByAppendingPathExtension:@"pvr"];
-        
-        NSString* format = NULL;
-        if (self.imageFormat == kTupacImageFormatPVR_RGBA8888) format = @"r8g8b8a8,UBN,lRGB";
-        else if (self.imageFormat == kTupacImageFormatPVR_RGBA4444) format = @"r4g4b4a4,USN,lRGB";
-        else if (self.imageFormat == kTupacImageFormatPVR_RGB565) format = @"r5g6b5,USN,lRGB";
-        else if (self.imageFormat == kTupacImageFormatPVRTC_4BPP) format = @"PVRTC1_4,UBN,lRGB";
-        else if (self.imageFormat == kTupacImageFormatPVRTC_2BPP) format = @"PVRTC1_2,UBN,lRGB";
-        
-        // Convert PNG to PVR(TC)
-        NSTask* pvrTask = [[NSTask alloc] init];
-        [pvrTask setCurrentDirectoryPath:outputDir];
-        [pvrTask setLaunchPath:[[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:@"PVRTexToolCL"]];
-        NSMutableArray* args = [NSMutableArray arrayWithObjects:
-                         @"-i", pngFilename,
-                         @"-o", [self.outputName stringByAppendingPathExtension:@"pvr"],
-                         @"-p",
-                         @"-legacypvr",
-                         @"-f", format,
-                         @"-q", @"pvrtcbest",
-                         nil];
-        if (self.dither) [args addObject:@"-dither"];
-        [pvrTask setArguments:args];
-        [pvrTask launch];
-        [pvrTask waitUntilExit];
-        [pvrTask release];
-        
-        textureFileName = pvrFilename;
-        
-        // Remove PNG file
-        [[NSFileManager defaultManager] removeItemAtPath:pngFilename error:NULL];
-        
-        if (self.compress)
-        {
-            // Create compressed file (ccz)
-            NSTask* zipTask = [[NSTask alloc] init];
-            [zipTask setCurrentDirectoryPath:outputDir];
-            [zipTask setLaunchPath:[[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:@"ccz"]];
-            NSMutableArray* args = [NSMutableArray arrayWithObjects:textureFileName, nil];
-            [zipTask setArguments:args];
-            [zipTask launch];
-            [zipTask waitUntilExit];
-            [zipTask release];
-            
-            // Remove uncompressed file
-            [[NSFileManager defaultManager] removeItemAtPath:textureFileName error:NULL];
-            
-            // Update name of texture file
-            textureFileName = [textureFileName stringByAppendingPathExtension:@"ccz"];
-        }
+        return compress_ ? @"pvr.ccz" : @"pvr";
     }
+    return @"png";
+}
+
++ (BOOL) convertToIndexedPNG:(NSString*)file colors:(int)colors dither:(BOOL)dither
+{
+    RGBAImage image;
+    if (!LoadPNG([file fileSystemRepresentation], image)) return NO;
     
-    // Metadata File Export
-    textureFileName = [textureFileName lastPathComponent];
-    
-    if ([self.outputFormat isEqualToString:TupacOutputFormatCocos2D])
-    {
-        NSMutableDictionary *outDict    = [[NSMutableDictionary alloc] initWithCapacity:2];
-        
-        NSMutableDictionary *frames     = [NSMutableDictionary dictionaryWithCapacity:self.filenames.count];
-        NSMutableDictionary *metadata   = [NSMutableDictionary dictionaryWithCapacity:4];
-        
-        [outDict setObject:frames   forKey:@"frames"];
-        [outDict setObject:metadata forKey:@"metadata"];
-        
-        int index = 0;
-        while(index < outRects.size())
-        {
-            // Get info about the image
-            NSString* filename = [self.filenames objectAtIndex:outRects[index].idx];
-            NSString* exportFilename = [filename lastPathComponent];
-            if (directoryPrefix_) exportFilename = [directoryPrefix_ stringByAppendingPathComponent:exportFilename];
-            NSDictionary* imageInfo = [imageInfos objectAtIndex:outRects[index].idx];
-            
-            bool rot = false;
-            int x, y, w, h, wSrc, hSrc, xOffset, yOffset;
-            x = outRects[index].x + self.padding;
-            y = outRects[index].y + self.padding;
-            w = outRects[index].width - self.padding*2;
-            h = outRects[index].height - self.padding*2;
-            wSrc = [[imageInfo objectForKey:@"width"] intValue];
-            hSrc = [[imageInfo objectForKey:@"height"] intValue];
-            NSRect trimRect = [[imageInfo objectForKey:@"trimRect"] rectValue];
-            
-            rot = outRects[index].rotated;
-            
-            if (rot)
-            {
-                int wRot = h;
-                int hRot = w;
-                w = wRot;
-                h = hRot;
-            }
-            
-            xOffset = trimRect.origin.x + trimRect.size.width/2 - wSrc/2;
-            yOffset = -trimRect.origin.y - trimRect.size.height/2 + hSrc/2;
-            
-            index++;
-            
-            [frames setObject:[NSDictionary dictionaryWithObjectsAndKeys:
-                               NSStringFromRect(NSMakeRect(x, y, w, h)),    @"frame",
-                               NSStringFromPoint(NSMakePoint(xOffset, yOffset)),        @"offset",
-                               [NSNumber numberWithBool:rot],               @"rotated",
-                               NSStringFromRect(trimRect),                  @"sourceColorRect",
-                               NSStringFromSize(NSMakeSize(wSrc, hSrc)),    @"sourceSize",
-                               nil]
-                       forKey:exportFilename];
-        }
-        
-        //[metadata setObject:textureFileName                                     forKey:@"realTextureFilename"];
-        [metadata setObject:textureFileName                                     forKey:@"textureFileName"];
-        [metadata setObject:[NSNumber numberWithInt:2]                      forKey:@"format"];
-        [metadata setObject:NSStringFromSize(NSMakeSize(outW, outH))        forKey:@"size"];
-        
-        [outDict writeToFile:[self.outputName stringByAppendingPathExtension:@"plist"] atomically:YES];
-        [outDict release];
-    }
-    else if ([self.outputFormat isEqualToString:TupacOutputFormatAndEngine]) {
-        fprintf(stderr, "[MO] output format %s not yet supported\n", [self.outputFormat UTF8String]);
-        exit(EXIT_FAILURE);
-    }
+    IndexedImage indexed;
+    QuantizePalette(image, colors, dither, indexed);
+    return SavePNG([file fileSystemRepresentation], indexed);
 }
 
 - (void) createTextureAtlasFromDirectoryPaths:(NSArray *)dirs
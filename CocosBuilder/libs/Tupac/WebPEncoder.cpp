@@ -0,0 +1,45 @@
+/** @file WebPEncoder.cpp
+
+	@brief Writes WebP files with libwebp.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#include <cstdio>
+#include <algorithm>
+
+#include <webp/encode.h>
+
+#include "WebPEncoder.h"
+
+bool EncodeWebP(const RGBAImage &image, int quality, std::vector<unsigned char> &data)
+{
+	data.clear();
+	if (image.width <= 0 || image.height <= 0)
+		return false;
+
+	uint8_t *output = 0;
+	size_t size;
+	if (quality >= 100)
+		size = WebPEncodeLosslessRGBA(&image.pixels[0], image.width, image.height, image.width * 4, &output);
+	else
+		size = WebPEncodeRGBA(&image.pixels[0], image.width, image.height, image.width * 4, (float)std::max(quality, 0), &output);
+
+	if (size > 0)
+		data.assign(output, output + size);
+	WebPFree(output);
+	return size > 0;
+}
+
+bool SaveWebP(const char *filename, const RGBAImage &image, int quality)
+{
+	std::vector<unsigned char> data;
+	if (!EncodeWebP(image, quality, data))
+		return false;
+
+	FILE *file = fopen(filename, "wb");
+	if (!file)
+		return false;
+
+	bool written = fwrite(&data[0], 1, data.size(), file) == data.size();
+	return fclose(file) == 0 && written;
+}
@@ -0,0 +1,22 @@
+/** @file WebPEncoder.h
+
+	@brief Writes WebP files with libwebp.
+
+	This work is released to Public Domain, do whatever you want with it.
+*/
+#pragma once
+
+#include <vector>
+
+#include "AtlasCompositor.h"
+
+/// Encodes an RGBA image as a WebP file.
+/// @param quality From 0 to 100. Below 100 the colors are encoded lossy (VP8), as cwebp -q does, and alpha
+///   losslessly. At 100 the image is encoded losslessly (VP8L), except for the colors of fully transparent
+///   pixels.
+/// @return False if libwebp could not encode the image.
+bool EncodeWebP(const RGBAImage &image, int quality, std::vector<unsigned char> &data);
+
+/// Encodes an RGBA image and writes it to a WebP file. @see EncodeWebP.
+/// @return False if the image could not be encoded or the file could not be written.
+bool SaveWebP(const char *filename, const RGBAImage &image, int quality);
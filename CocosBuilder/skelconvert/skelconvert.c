@@ -0,0 +1,145 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2013 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Converts skeleton JSON to the .skel binary that SkeletonBinary_readSkeletonData loads, then reads the binary back to check
+ * it. The JSON is only needed by the converter, so builds can ship the binaries alone. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spine.h"
+#include "extension.h"
+
+/* The converter loads no atlases. */
+void _AtlasPage_createTexture (AtlasPage* self, const char* path) {
+}
+
+void _AtlasPage_disposeTexture (AtlasPage* self) {
+}
+
+char* _Util_readFile (const char* path, int* length) {
+	return _readFile(path, length);
+}
+
+/* Makes region attachments without an atlas, so the binary is checked without one. */
+static Attachment* newAttachment (AttachmentLoader* self, Skin* skin, AttachmentType type, const char* name) {
+	RegionAttachment* attachment = RegionAttachment_create(name);
+	CONST_CAST(AttachmentType, SUPER(attachment)->type) = type;
+	return SUPER(attachment);
+}
+
+static void printUsage (const char* prog) {
+	printf(
+"Usage:\n"
+"%s [-o <output.skel>] <input.json>...\n"
+"%s -h|--help\n"
+"\n"
+"Converts each skeleton JSON file to a .skel binary next to it, with the extension replaced.\n"
+"\n"
+"Options:\n"
+"  -o, --output=<file>  the binary to write, when converting a single file\n", prog, prog);
+}
+
+/* Returns the path with its extension, if any, replaced by .skel, to be freed with FREE. */
+static char* binaryPath (const char* jsonPath) {
+	const char* dot = strrchr(jsonPath, '.');
+	const char* slash = strrchr(jsonPath, '/');
+	int length = dot && (!slash || dot > slash) ? (int)(dot - jsonPath) : (int)strlen(jsonPath);
+	char* path = MALLOC(char, length + 6);
+	memcpy(path, jsonPath, length);
+	strcpy(path + length, ".skel");
+	return path;
+}
+
+/* Returns whether the file was converted and read back. */
+static int/*bool*/convert (SkeletonBinary* binary, const char* jsonPath, const char* outputPath) {
+	char* path = outputPath ? 0 : binaryPath(jsonPath);
+	int jsonLength, binaryLength;
+	int/*bool*/success = 0;
+	char* data;
+	SkeletonData* skeletonData;
+
+	if (!outputPath) outputPath = path;
+	data = _readFile(jsonPath, &jsonLength);
+	if (!data) {
+		fprintf(stderr, "Error: Failed reading %s.\n", jsonPath);
+	} else if (!SkeletonBinary_convertJsonFile(binary, jsonPath, outputPath)) {
+		fprintf(stderr, "Error: Failed converting %s: %s\n", jsonPath, binary->error);
+	} else if (!(skeletonData = SkeletonBinary_readSkeletonDataFile(binary, outputPath))) {
+		fprintf(stderr, "Error: Failed reading back %s: %s\n", outputPath, binary->error);
+	} else {
+		FREE(_readFile(outputPath, &binaryLength));
+		fprintf(stderr, "Notice: Converted %s to %s, %d bones, %d animations, %d bytes from %d.\n", jsonPath, outputPath,
+				skeletonData->boneCount, skeletonData->animationCount, binaryLength, jsonLength);
+		SkeletonData_dispose(skeletonData);
+		success = 1;
+	}
+	FREE(data);
+	FREE(path);
+	return success;
+}
+
+int main (int argc, const char** argv) {
+	const char* outputPath = 0;
+	const char** inputPaths = MALLOC(const char*, argc);
+	int i, inputCount = 0, failures = 0;
+	AttachmentLoader* loader;
+	SkeletonBinary* binary;
+
+	for (i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+		if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+			printUsage(argv[0]);
+			return EXIT_SUCCESS;
+		} else if (!strcmp(arg, "-o") && i + 1 < argc)
+			outputPath = argv[++i];
+		else if (!strncmp(arg, "--output=", 9))
+			outputPath = arg + 9;
+		else if (arg[0] == '-') {
+			fprintf(stderr, "Error: Unknown option %s.\n", arg);
+			return EXIT_FAILURE;
+		} else
+			inputPaths[inputCount++] = arg;
+	}
+	if (!inputCount) {
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (outputPath && inputCount > 1) {
+		fprintf(stderr, "Error: The output can only be given when converting a single file.\n");
+		return EXIT_FAILURE;
+	}
+
+	loader = NEW(AttachmentLoader);
+	_AttachmentLoader_init(loader, _AttachmentLoader_deinit, newAttachment);
+	binary = SkeletonBinary_createWithLoader(loader);
+	for (i = 0; i < inputCount; ++i)
+		if (!convert(binary, inputPaths[i], outputPath)) ++failures;
+	SkeletonBinary_dispose(binary);
+	AttachmentLoader_dispose(loader);
+	FREE(inputPaths);
+
+	if (inputCount > 1) fprintf(stderr, "Done converting. %d files succeeded, %d files failed.\n", inputCount - failures, failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
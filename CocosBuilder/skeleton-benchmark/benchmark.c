@@ -0,0 +1,731 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2013 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Times SkeletonBatch_update on growing numbers of skeletons sharing one SkeletonData, on one thread and on several, and checks
+ * that every skeleton ends up with the same pose either way. Also compares baked curves with the curves they were baked from,
+ * and loading skeletons from JSON with loading them from binary. */
+
+#include <sys/time.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spine.h"
+#include "extension.h"
+
+/* The benchmark loads no atlases or files. */
+void _AtlasPage_createTexture (AtlasPage* self, const char* path) {
+}
+
+void _AtlasPage_disposeTexture (AtlasPage* self) {
+}
+
+char* _Util_readFile (const char* path, int* length) {
+	return _readFile(path, length);
+}
+
+typedef struct {
+	int maxInstances;
+	int boneCount;
+	int keyCount;
+	int threadCount;
+	int frameCount;
+	unsigned int seed;
+	int/*bool*/pose;
+	int curveResolution;
+	int/*bool*/curves;
+	int loadCount;
+} Options;
+
+/* The skeletons, poses and animation states of a set of instances. */
+typedef struct {
+	int count;
+	SkeletonInstance* instances;
+	AnimationState** states;
+} Instances;
+
+static unsigned int randomState;
+
+static float randomFloat (float min, float max) {
+	randomState = randomState * 1103515245u + 12345u;
+	return min + (max - min) * ((randomState >> 8) & 0xffff) / 65535.0f;
+}
+
+static double wallMilliseconds () {
+	struct timeval time;
+	gettimeofday(&time, 0);
+	return time.tv_sec * 1000.0 + time.tv_usec / 1000.0;
+}
+
+static void setRandomCurve (CurveTimeline* timeline, int frameIndex, int kind) {
+	switch (kind % 4) {
+	case 0:
+		CurveTimeline_setLinear(timeline, frameIndex);
+		break;
+	case 1:
+		CurveTimeline_setStepped(timeline, frameIndex);
+		break;
+	default:
+		CurveTimeline_setCurve(timeline, frameIndex, randomFloat(0, 1), randomFloat(0, 1), randomFloat(0, 1), randomFloat(0, 1));
+	}
+}
+
+/* Makes an animation that rotates, translates and scales every bone and colors every slot. */
+static Animation* makeAnimation (const char* name, const SkeletonData* data, int keyCount, float duration) {
+	int i, frame, timelineCount = 0;
+	Animation* animation = Animation_create(name, data->boneCount * 3 + data->slotCount);
+	animation->duration = duration;
+	for (i = 0; i < data->boneCount; ++i) {
+		RotateTimeline* rotate = RotateTimeline_create(keyCount);
+		TranslateTimeline* translate = TranslateTimeline_create(keyCount);
+		ScaleTimeline* scale = ScaleTimeline_create(keyCount);
+		rotate->boneIndex = translate->boneIndex = scale->boneIndex = i;
+		for (frame = 0; frame < keyCount; ++frame) {
+			float time = duration * frame / (keyCount - 1);
+			RotateTimeline_setFrame(rotate, frame, time, randomFloat(-180, 180));
+			TranslateTimeline_setFrame(translate, frame, time, randomFloat(-10, 10), randomFloat(-10, 10));
+			ScaleTimeline_setFrame(scale, frame, time, randomFloat(-0.2f, 0.2f), randomFloat(-0.2f, 0.2f));
+			if (frame < keyCount - 1) {
+				setRandomCurve(SUPER(rotate), frame, frame);
+				setRandomCurve(SUPER(translate), frame, frame + 1);
+				setRandomCurve(SUPER(scale), frame, frame + 2);
+			}
+		}
+		animation->timelines[timelineCount++] = SUPER_CAST(Timeline, rotate);
+		animation->timelines[timelineCount++] = SUPER_CAST(Timeline, translate);
+		animation->timelines[timelineCount++] = SUPER_CAST(Timeline, scale);
+	}
+	for (i = 0; i < data->slotCount; ++i) {
+		ColorTimeline* color = ColorTimeline_create(keyCount);
+		color->slotIndex = i;
+		for (frame = 0; frame < keyCount; ++frame) {
+			ColorTimeline_setFrame(color, frame, duration * frame / (keyCount - 1), randomFloat(0, 1), randomFloat(0, 1),
+					randomFloat(0, 1), 1);
+			if (frame < keyCount - 1) setRandomCurve(SUPER(color), frame, frame + 3);
+		}
+		animation->timelines[timelineCount++] = SUPER_CAST(Timeline, color);
+	}
+	return animation;
+}
+
+/* Makes a skeleton with a random hierarchy of bones, a slot on every bone and two animations. */
+static SkeletonData* makeSkeletonData (const Options* options) {
+	int i;
+	SkeletonData* data = SkeletonData_create();
+	randomState = options->seed;
+
+	data->boneCount = options->boneCount;
+	data->bones = MALLOC(BoneData*, data->boneCount);
+	for (i = 0; i < data->boneCount; ++i) {
+		char name[16];
+		BoneData* bone;
+		sprintf(name, "bone%d", i);
+		bone = BoneData_create(name, i ? data->bones[(int)randomFloat(0, i - 0.01f)] : 0);
+		bone->length = randomFloat(10, 50);
+		bone->x = randomFloat(-50, 50);
+		bone->y = randomFloat(-50, 50);
+		bone->rotation = randomFloat(-180, 180);
+		data->bones[i] = bone;
+	}
+
+	data->slotCount = data->boneCount;
+	data->slots = MALLOC(SlotData*, data->slotCount);
+	for (i = 0; i < data->slotCount; ++i) {
+		char name[16];
+		sprintf(name, "slot%d", i);
+		data->slots[i] = SlotData_create(name, data->bones[i]);
+	}
+
+	data->animationCount = 2;
+	data->animations = MALLOC(Animation*, 2);
+	data->animations[0] = makeAnimation("walk", data, options->keyCount, 1.2f);
+	data->animations[1] = makeAnimation("wave", data, options->keyCount, 2.5f);
+	if (options->curveResolution) {
+		Animation_bakeCurves(data->animations[0], options->curveResolution);
+		Animation_bakeCurves(data->animations[1], options->curveResolution);
+	}
+	return data;
+}
+
+/* Makes instances that play the animations from different times and switch between them at different times, so no two
+ * instances are posed alike. */
+static void makeInstances (Instances* self, int count, SkeletonData* data, AnimationStateData* stateData,
+		int/*bool*/pose) {
+	int i;
+	self->count = count;
+	self->instances = CALLOC(SkeletonInstance, count);
+	self->states = MALLOC(AnimationState*, count);
+	for (i = 0; i < count; ++i) {
+		SkeletonInstance* instance = self->instances + i;
+		AnimationState* state = AnimationState_create(stateData);
+		AnimationState_setAnimation(state, data->animations[i % 2], 1);
+		AnimationState_addAnimation(state, data->animations[(i + 1) % 2], 1, 0.5f + (i % 7) * 0.1f);
+		state->time = i * 0.013f;
+		self->states[i] = state;
+
+		instance->skeleton = Skeleton_create(data);
+		instance->skeleton->flipX = i % 3 == 0;
+		instance->pose = pose ? SkeletonPose_create(instance->skeleton) : 0;
+		instance->stateCount = 1;
+		instance->states = self->states + i;
+		instance->timeScale = 1 + (i % 5) * 0.05f;
+	}
+}
+
+static void disposeInstances (Instances* self) {
+	int i;
+	for (i = 0; i < self->count; ++i) {
+		if (self->instances[i].pose) SkeletonPose_dispose(self->instances[i].pose);
+		Skeleton_dispose(self->instances[i].skeleton);
+		AnimationState_dispose(self->states[i]);
+	}
+	FREE(self->states);
+	FREE(self->instances);
+}
+
+/* Returns the milliseconds per frame of updating the instances, the fastest of several tries. */
+static double timeFrames (SkeletonBatch* batch, Instances* instances, int frameCount) {
+	int try, frame;
+	double best = -1;
+	for (try = 0; try < 3; ++try) {
+		double start = wallMilliseconds(), milliseconds;
+		for (frame = 0; frame < frameCount; ++frame)
+			SkeletonBatch_update(batch, instances->instances, instances->count, 1 / 60.0f);
+		milliseconds = (wallMilliseconds() - start) / frameCount;
+		if (best < 0 || milliseconds < best) best = milliseconds;
+	}
+	return best;
+}
+
+static int/*bool*/isSamePose (const Skeleton* a, const Skeleton* b) {
+	int i;
+	for (i = 0; i < a->boneCount; ++i) {
+		const Bone* boneA = a->bones[i];
+		const Bone* boneB = b->bones[i];
+		if (boneA->m00 != boneB->m00 || boneA->m01 != boneB->m01 || boneA->m10 != boneB->m10 || boneA->m11 != boneB->m11
+				|| boneA->worldX != boneB->worldX || boneA->worldY != boneB->worldY) return 0;
+	}
+	for (i = 0; i < a->slotCount; ++i) {
+		const Slot* slotA = a->slots[i];
+		const Slot* slotB = b->slots[i];
+		if (slotA->r != slotB->r || slotA->g != slotB->g || slotA->b != slotB->b || slotA->a != slotB->a) return 0;
+	}
+	return 1;
+}
+
+/* Returns the nanoseconds per CurveTimeline_getCurvePercent of every curve at the given percents. */
+static double timeCurves (const CurveTimeline* timeline, const float* percents, int percentCount) {
+	int try, i, curve;
+	double best = -1;
+	volatile float sink = 0;
+	for (try = 0; try < 3; ++try) {
+		double start = wallMilliseconds(), nanoseconds;
+		float sum = 0;
+		for (curve = 0; curve < timeline->curveCount; ++curve)
+			for (i = 0; i < percentCount; ++i)
+				sum += CurveTimeline_getCurvePercent(timeline, curve, percents[i]);
+		sink += sum;
+		nanoseconds = (wallMilliseconds() - start) * 1e6 / ((double)timeline->curveCount * percentCount);
+		if (best < 0 || nanoseconds < best) best = nanoseconds;
+	}
+	return best;
+}
+
+/* Bakes random bezier curves at several resolutions and prints how far the tables are from the curves evaluated segment by
+ * segment, and how long each takes. */
+static void compareCurves (const Options* options) {
+	static const int resolutions[] = {1, 4, 8, 16, 32, 64};
+	const int curveCount = 1000, percentCount = 1000;
+	int i, r, curve;
+	float* percents = MALLOC(float, percentCount);
+	float* exact = MALLOC(float, curveCount * percentCount);
+	CurveTimeline* timeline = SUPER(RotateTimeline_create(curveCount + 1));
+	double exactNanoseconds;
+
+	randomState = options->seed;
+	for (curve = 0; curve < curveCount; ++curve)
+		CurveTimeline_setCurve(timeline, curve, randomFloat(0, 1), randomFloat(0, 1), randomFloat(0, 1), randomFloat(0, 1));
+	for (i = 0; i < percentCount; ++i)
+		percents[i] = randomFloat(0, 1);
+	percents[0] = 0;
+	percents[1] = 1;
+	for (curve = 0; curve < curveCount; ++curve)
+		for (i = 0; i < percentCount; ++i)
+			exact[curve * percentCount + i] = CurveTimeline_getCurvePercent(timeline, curve, percents[i]);
+	exactNanoseconds = timeCurves(timeline, percents, percentCount);
+
+	printf("%d bezier curves, %d percents each\n", curveCount, percentCount);
+	printf("%10s %10s %12s %12s\n", "resolution", "ns/curve", "max error", "mean error");
+	printf("%10s %10.2f %12s %12s\n", "segments", exactNanoseconds, "-", "-");
+	for (r = 0; r < (int)(sizeof(resolutions) / sizeof(resolutions[0])); ++r) {
+		double errorSum = 0, maxError = 0;
+		CurveTimeline_bakeCurves(timeline, resolutions[r]);
+		for (curve = 0; curve < curveCount; ++curve) {
+			for (i = 0; i < percentCount; ++i) {
+				double error = CurveTimeline_getCurvePercent(timeline, curve, percents[i]) - exact[curve * percentCount + i];
+				if (error < 0) error = -error;
+				errorSum += error;
+				if (error > maxError) maxError = error;
+			}
+		}
+		printf("%10d %10.2f %12.2e %12.2e\n", resolutions[r], timeCurves(timeline, percents, percentCount), maxError,
+				errorSum / ((double)curveCount * percentCount));
+	}
+
+	Timeline_dispose(SUPER(timeline));
+	FREE(exact);
+	FREE(percents);
+}
+
+/* Text that grows as it is appended to. */
+typedef struct {
+	char* chars;
+	int length, capacity;
+} Text;
+
+static void appendText (Text* self, const char* format, ...) {
+	va_list args;
+	int length;
+	for (;;) {
+		va_start(args, format);
+		length = vsnprintf(self->chars + self->length, self->capacity - self->length, format, args);
+		va_end(args);
+		if (self->length + length < self->capacity) break;
+		self->capacity = (self->length + length) * 2 + 256;
+		self->chars = realloc(self->chars, self->capacity);
+	}
+	self->length += length;
+}
+
+static void appendColor (Text* text) {
+	appendText(text, "\"%02x%02x%02x%02x\"", (int)randomFloat(0, 255), (int)randomFloat(0, 255), (int)randomFloat(0, 255),
+			(int)randomFloat(128, 255));
+}
+
+/* The last frame has no curve, as there is no frame after it. */
+static void appendCurve (Text* text, int frame, int kind, int keyCount) {
+	if (frame == keyCount - 1) return;
+	switch (kind % 4) {
+	case 0:
+		break;
+	case 1:
+		appendText(text, ",\"curve\":\"stepped\"");
+		break;
+	default:
+		appendText(text, ",\"curve\":[%.3f,%.3f,%.3f,%.3f]", randomFloat(0, 1), randomFloat(0, 1), randomFloat(0, 1),
+				randomFloat(0, 1));
+	}
+}
+
+static void appendAnimation (Text* text, const char* name, const Options* options, float duration) {
+	int i, frame;
+	const char* timelines[] = {"rotate", "translate", "scale"};
+	appendText(text, "\"%s\":{\"bones\":{", name);
+	for (i = 0; i < options->boneCount; ++i) {
+		int t;
+		appendText(text, "%s\"bone%d\":{", i ? "," : "", i);
+		for (t = 0; t < 3; ++t) {
+			appendText(text, "%s\"%s\":[", t ? "," : "", timelines[t]);
+			for (frame = 0; frame < options->keyCount; ++frame) {
+				appendText(text, "%s{\"time\":%.4f", frame ? "," : "", duration * frame / (options->keyCount - 1));
+				if (t == 0)
+					appendText(text, ",\"angle\":%.2f", randomFloat(-180, 180));
+				else
+					appendText(text, ",\"x\":%.3f,\"y\":%.3f", randomFloat(-10, 10), randomFloat(-10, 10));
+				appendCurve(text, frame, frame + t, options->keyCount);
+				appendText(text, "}");
+			}
+			appendText(text, "]");
+		}
+		appendText(text, "}");
+	}
+	appendText(text, "},\"slots\":{");
+	for (i = 0; i < options->boneCount; ++i) {
+		appendText(text, "%s\"slot%d\":{\"color\":[", i ? "," : "", i);
+		for (frame = 0; frame < options->keyCount; ++frame) {
+			appendText(text, "%s{\"time\":%.4f,\"color\":", frame ? "," : "", duration * frame / (options->keyCount - 1));
+			appendColor(text);
+			appendCurve(text, frame, frame + 3, options->keyCount);
+			appendText(text, "}");
+		}
+		appendText(text, "],\"attachment\":[{\"time\":0,\"name\":\"a%d\"},{\"time\":%.4f,\"name\":\"b%d\"},"
+				"{\"time\":%.4f,\"name\":null}]}", i, duration / 3, i, duration * 2 / 3);
+	}
+	appendText(text, "}}");
+}
+
+/* Writes the JSON of a skeleton like the one makeSkeletonData makes, with two skins of region attachments and attachment
+ * timelines as well. */
+static char* makeSkeletonJson (const Options* options) {
+	int i, skin;
+	Text text = {0, 0, 0};
+	randomState = options->seed;
+
+	appendText(&text, "{\"bones\":[");
+	for (i = 0; i < options->boneCount; ++i) {
+		appendText(&text, "%s{\"name\":\"bone%d\"", i ? "," : "", i);
+		if (i) appendText(&text, ",\"parent\":\"bone%d\"", (int)randomFloat(0, i - 0.01f));
+		appendText(&text, ",\"length\":%.3f,\"x\":%.3f,\"y\":%.3f,\"rotation\":%.3f", randomFloat(10, 50), randomFloat(-50, 50),
+				randomFloat(-50, 50), randomFloat(-180, 180));
+		if (i % 3 == 1) appendText(&text, ",\"scaleX\":%.3f,\"scaleY\":%.3f", randomFloat(0.5f, 2), randomFloat(0.5f, 2));
+		appendText(&text, "}");
+	}
+	appendText(&text, "],\"slots\":[");
+	for (i = 0; i < options->boneCount; ++i) {
+		appendText(&text, "%s{\"name\":\"slot%d\",\"bone\":\"bone%d\"", i ? "," : "", i, i);
+		if (i % 2) {
+			appendText(&text, ",\"color\":");
+			appendColor(&text);
+		}
+		if (i % 4 != 3) appendText(&text, ",\"attachment\":\"a%d\"", i);
+		appendText(&text, "}");
+	}
+	appendText(&text, "],\"skins\":{");
+	for (skin = 0; skin < 2; ++skin) {
+		appendText(&text, "%s\"%s\":{", skin ? "," : "", skin ? "armored" : "default");
+		for (i = 0; i < options->boneCount; ++i) {
+			appendText(&text, "%s\"slot%d\":{\"a%d\":{\"x\":%.3f,\"y\":%.3f,\"rotation\":%.3f,\"width\":%.1f,\"height\":%.1f}",
+					i ? "," : "", i, i, randomFloat(-20, 20), randomFloat(-20, 20), randomFloat(-180, 180), randomFloat(8, 128),
+					randomFloat(8, 128));
+			appendText(&text, ",\"b%d\":{\"name\":\"%s-b%d\",\"type\":\"%s\",\"scaleX\":%.3f}}", i, skin ? "armored" : "plain", i,
+					i % 5 ? "region" : "regionSequence", randomFloat(0.5f, 2));
+		}
+		appendText(&text, "}");
+	}
+	appendText(&text, "},\"animations\":{");
+	appendAnimation(&text, "walk", options, 1.2f);
+	appendText(&text, ",");
+	appendAnimation(&text, "wave", options, 2.5f);
+	appendText(&text, "}}");
+	return text.chars;
+}
+
+/* Makes region attachments without an atlas, so any attachment loads. */
+static Attachment* newAttachment (AttachmentLoader* self, Skin* skin, AttachmentType type, const char* name) {
+	RegionAttachment* attachment = RegionAttachment_create(name);
+	CONST_CAST(AttachmentType, SUPER(attachment)->type) = type;
+	return SUPER(attachment);
+}
+
+static int/*bool*/isSameString (const char* a, const char* b) {
+	return a == b || (a && b && !strcmp(a, b));
+}
+
+static int/*bool*/isSameFloats (const float* a, const float* b, int count) {
+	return !memcmp(a, b, sizeof(float) * count);
+}
+
+/* The functions of a timeline, as _TimelineVtable in Animation.c has them. Each timeline has its own vtable, so timelines of
+ * the same type are told apart by the functions in their vtables. */
+typedef struct {
+	void (*apply) (const Timeline* self, Skeleton* skeleton, float time, float alpha, int* frameCursor);
+	void (*dispose) (Timeline* self);
+} TimelineVtable;
+
+static int/*bool*/isSameTimeline (const Timeline* a, const Timeline* b, const TimelineVtable* attachmentVtable) {
+	if (memcmp(a->vtable, b->vtable, sizeof(TimelineVtable))) return 0;
+	if (!memcmp(a->vtable, attachmentVtable, sizeof(TimelineVtable))) {
+		const AttachmentTimeline* attachmentA = (const AttachmentTimeline*)a;
+		const AttachmentTimeline* attachmentB = (const AttachmentTimeline*)b;
+		int i;
+		if (attachmentA->framesLength != attachmentB->framesLength || attachmentA->slotIndex != attachmentB->slotIndex) return 0;
+		for (i = 0; i < attachmentA->framesLength; ++i)
+			if (!isSameString(attachmentA->attachmentNames[i], attachmentB->attachmentNames[i])) return 0;
+		return isSameFloats(attachmentA->frames, attachmentB->frames, attachmentA->framesLength);
+	} else {
+		/* Color timelines are laid out like the others. */
+		const RotateTimeline* curveA = (const RotateTimeline*)a;
+		const RotateTimeline* curveB = (const RotateTimeline*)b;
+		return curveA->framesLength == curveB->framesLength && curveA->boneIndex == curveB->boneIndex
+				&& curveA->super.curveCount == curveB->super.curveCount
+				&& curveA->super.tableResolution == curveB->super.tableResolution
+				&& isSameFloats(curveA->frames, curveB->frames, curveA->framesLength)
+				&& isSameFloats(curveA->super.curves, curveB->super.curves, curveA->super.curveCount * 6);
+	}
+}
+
+static int/*bool*/isSameSkeletonData (const SkeletonData* a, const SkeletonData* b) {
+	int i, ii;
+	TimelineVtable attachmentVtable;
+	Timeline* attachmentTimeline = SUPER(AttachmentTimeline_create(1));
+	attachmentVtable = *(const TimelineVtable*)attachmentTimeline->vtable;
+	Timeline_dispose(attachmentTimeline);
+
+	if (a->boneCount != b->boneCount || a->slotCount != b->slotCount || a->skinCount != b->skinCount
+			|| a->animationCount != b->animationCount || !a->defaultSkin != !b->defaultSkin) return 0;
+	for (i = 0; i < a->boneCount; ++i) {
+		const BoneData* boneA = a->bones[i];
+		const BoneData* boneB = b->bones[i];
+		if (!isSameString(boneA->name, boneB->name) || !isSameString(boneA->parent ? boneA->parent->name : 0,
+				boneB->parent ? boneB->parent->name : 0)) return 0;
+		if (boneA->length != boneB->length || boneA->x != boneB->x || boneA->y != boneB->y || boneA->rotation != boneB->rotation
+				|| boneA->scaleX != boneB->scaleX || boneA->scaleY != boneB->scaleY) return 0;
+	}
+	for (i = 0; i < a->slotCount; ++i) {
+		const SlotData* slotA = a->slots[i];
+		const SlotData* slotB = b->slots[i];
+		if (!isSameString(slotA->name, slotB->name) || !isSameString(slotA->boneData->name, slotB->boneData->name)
+				|| !isSameString(slotA->attachmentName, slotB->attachmentName)) return 0;
+		if (slotA->r != slotB->r || slotA->g != slotB->g || slotA->b != slotB->b || slotA->a != slotB->a) return 0;
+	}
+	for (i = 0; i < a->skinCount; ++i) {
+		if (!isSameString(a->skins[i]->name, b->skins[i]->name)) return 0;
+		for (ii = 0; ii < a->slotCount * 2; ++ii) {
+			char name[16];
+			const RegionAttachment* regionA;
+			const RegionAttachment* regionB;
+			sprintf(name, "%c%d", ii % 2 ? 'b' : 'a', ii / 2);
+			regionA = (const RegionAttachment*)Skin_getAttachment(a->skins[i], ii / 2, name);
+			regionB = (const RegionAttachment*)Skin_getAttachment(b->skins[i], ii / 2, name);
+			if (!regionA || !regionB) return 0;
+			if (!isSameString(regionA->super.name, regionB->super.name) || regionA->super.type != regionB->super.type) return 0;
+			if (!isSameFloats(&regionA->x, &regionB->x, 7) || !isSameFloats(regionA->offset, regionB->offset, 8)) return 0;
+		}
+	}
+	for (i = 0; i < a->animationCount; ++i) {
+		const Animation* animationA = a->animations[i];
+		const Animation* animationB = b->animations[i];
+		if (!isSameString(animationA->name, animationB->name) || animationA->duration != animationB->duration
+				|| animationA->timelineCount != animationB->timelineCount) return 0;
+		for (ii = 0; ii < animationA->timelineCount; ++ii)
+			if (!isSameTimeline(animationA->timelines[ii], animationB->timelines[ii], &attachmentVtable)) return 0;
+	}
+	return 1;
+}
+
+/* Returns the fastest of 3 tries at loading count skeletons from JSON, or from binary when binary isn't 0, in milliseconds. */
+static double timeLoads (SkeletonJson* json, const char* jsonText, SkeletonBinary* binary, const unsigned char* binaryData,
+		int binaryLength, int count) {
+	int i, tries;
+	double best = 0;
+	for (tries = 0; tries < 3; ++tries) {
+		double start = wallMilliseconds(), milliseconds;
+		for (i = 0; i < count; ++i) {
+			SkeletonData* data = binary ? SkeletonBinary_readSkeletonData(binary, binaryData, binaryLength)
+					: SkeletonJson_readSkeletonData(json, jsonText);
+			SkeletonData_dispose(data);
+		}
+		milliseconds = wallMilliseconds() - start;
+		if (!tries || milliseconds < best) best = milliseconds;
+	}
+	return best;
+}
+
+/* Converts the JSON of a synthetic skeleton to binary, checks that both load the same skeleton data and prints how long
+ * loading a level's worth of skeletons from each takes. */
+static int/*bool*/compareLoading (const Options* options) {
+	AttachmentLoader* loader = NEW(AttachmentLoader);
+	SkeletonJson* json = SkeletonJson_createWithLoader(loader);
+	SkeletonBinary* binary = SkeletonBinary_createWithLoader(loader);
+	char* jsonText = makeSkeletonJson(options);
+	unsigned char* binaryData;
+	int binaryLength, same;
+	SkeletonData* jsonData;
+	SkeletonData* binaryData2;
+	double start, convertMilliseconds, jsonMilliseconds, binaryMilliseconds;
+
+	_AttachmentLoader_init(loader, _AttachmentLoader_deinit, newAttachment);
+
+	start = wallMilliseconds();
+	binaryData = SkeletonBinary_convertJson(binary, jsonText, &binaryLength);
+	convertMilliseconds = wallMilliseconds() - start;
+	if (!binaryData) {
+		fprintf(stderr, "Error: %s\n", binary->error);
+		exit(EXIT_FAILURE);
+	}
+
+	/* Scaled and baked, so the loaders are compared on everything they do. */
+	json->scale = binary->scale = 0.75f;
+	json->curveResolution = binary->curveResolution = 16;
+	jsonData = SkeletonJson_readSkeletonData(json, jsonText);
+	binaryData2 = SkeletonBinary_readSkeletonData(binary, binaryData, binaryLength);
+	if (!jsonData || !binaryData2) {
+		fprintf(stderr, "Error: %s\n", jsonData ? binary->error : json->error);
+		exit(EXIT_FAILURE);
+	}
+	same = isSameSkeletonData(jsonData, binaryData2);
+	SkeletonData_dispose(binaryData2);
+	SkeletonData_dispose(jsonData);
+	json->scale = binary->scale = 1;
+	json->curveResolution = binary->curveResolution = options->curveResolution;
+
+	jsonMilliseconds = timeLoads(json, jsonText, 0, 0, 0, options->loadCount);
+	binaryMilliseconds = timeLoads(0, 0, binary, binaryData, binaryLength, options->loadCount);
+
+	printf("%d bones, %d keyframes per timeline, %d skeletons loaded\n", options->boneCount, options->keyCount, options->loadCount);
+	printf("%6s %10s %10s %13s\n", "format", "bytes", "total ms", "ms/skeleton");
+	printf("%6s %10d %10.2f %13.3f\n", "json", (int)strlen(jsonText), jsonMilliseconds, jsonMilliseconds / options->loadCount);
+	printf("%6s %10d %10.2f %13.3f\n", "binary", binaryLength, binaryMilliseconds, binaryMilliseconds / options->loadCount);
+	printf("converted in %.2f ms, loaded %.1fx faster, same skeleton data: %s\n", convertMilliseconds,
+			jsonMilliseconds / binaryMilliseconds, same ? "ok" : "MISMATCH");
+
+	FREE(binaryData);
+	free(jsonText);
+	SkeletonBinary_dispose(binary);
+	SkeletonJson_dispose(json);
+	AttachmentLoader_dispose(loader);
+	return same;
+}
+
+static void printUsage (const char* prog) {
+	printf(
+"Usage:\n"
+"%s [options]\n"
+"%s -h|--help\n"
+"\n"
+"Updates from 1 up to the maximum number of instances of a synthetic skeleton, on one thread and on several,\n"
+"and prints the time per frame of each. Fails if any instance is posed differently on several threads.\n"
+"With --curves, compares curves baked into tables with the curves evaluated segment by segment instead.\n"
+"With --load, loads the skeleton from JSON and from binary converted from it, and prints how long each takes instead.\n"
+"\n"
+"Options:\n"
+"  -n, --instances=<n>  largest number of instances (default 1000)\n"
+"  -b, --bones=<n>      bones of the skeleton, each with a slot (default 40)\n"
+"  -k, --keys=<n>       keyframes of every timeline (default 30)\n"
+"  -t, --threads=<n>    threads to update on, 0 for one per processor (default 0)\n"
+"  -f, --frames=<n>     frames timed, the fastest of 3 tries counts (default 60)\n"
+"  -c, --curve-table=<n> bakes the curves of the animations into tables of n intervals (default 0, not baked)\n"
+"      --curves         compares baked curves with the curves they were baked from\n"
+"      --load[=<n>]     compares loading n skeletons from JSON and from binary (default 200)\n"
+"      --seed=<n>       seed of the synthetic skeleton (default 1)\n"
+"      --bones-only     updates the world transforms with Skeleton_updateWorldTransform, not SkeletonPose\n", prog, prog);
+}
+
+static int parseInt (const char* value, int min, int max, const char* option) {
+	char* end;
+	long n = strtol(value, &end, 10);
+	if (!*value || *end || n < min || n > max) {
+		fprintf(stderr, "Error: The %s must be a number from %d to %d.\n", option, min, max);
+		exit(EXIT_FAILURE);
+	}
+	return (int)n;
+}
+
+int main (int argc, const char** argv) {
+	static const int counts[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000};
+	Options options;
+	SkeletonData* data;
+	AnimationStateData* stateData;
+	SkeletonBatch* serial;
+	SkeletonBatch* parallel;
+	int i, c, success = 1;
+
+	options.maxInstances = 1000;
+	options.boneCount = 40;
+	options.keyCount = 30;
+	options.threadCount = 0;
+	options.frameCount = 60;
+	options.seed = 1;
+	options.pose = 1;
+	options.curveResolution = 0;
+	options.curves = 0;
+	options.loadCount = 0;
+	for (i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+		if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+			printUsage(argv[0]);
+			return EXIT_SUCCESS;
+		} else if (!strcmp(arg, "--bones-only"))
+			options.pose = 0;
+		else if (!strcmp(arg, "--curves"))
+			options.curves = 1;
+		else if (!strcmp(arg, "--load"))
+			options.loadCount = 200;
+		else if (!strncmp(arg, "--load=", 7))
+			options.loadCount = parseInt(arg + 7, 1, 100000, "number of skeletons loaded");
+		else if (!strcmp(arg, "-c") && i + 1 < argc)
+			options.curveResolution = parseInt(argv[++i], 0, 4096, "curve table resolution");
+		else if (!strncmp(arg, "--curve-table=", 14))
+			options.curveResolution = parseInt(arg + 14, 0, 4096, "curve table resolution");
+		else if (!strcmp(arg, "-n") && i + 1 < argc)
+			options.maxInstances = parseInt(argv[++i], 1, 10000, "number of instances");
+		else if (!strncmp(arg, "--instances=", 12))
+			options.maxInstances = parseInt(arg + 12, 1, 10000, "number of instances");
+		else if (!strcmp(arg, "-b") && i + 1 < argc)
+			options.boneCount = parseInt(argv[++i], 1, 1000, "number of bones");
+		else if (!strncmp(arg, "--bones=", 8))
+			options.boneCount = parseInt(arg + 8, 1, 1000, "number of bones");
+		else if (!strcmp(arg, "-k") && i + 1 < argc)
+			options.keyCount = parseInt(argv[++i], 2, 10000, "number of keyframes");
+		else if (!strncmp(arg, "--keys=", 7))
+			options.keyCount = parseInt(arg + 7, 2, 10000, "number of keyframes");
+		else if (!strcmp(arg, "-t") && i + 1 < argc)
+			options.threadCount = parseInt(argv[++i], 0, 256, "number of threads");
+		else if (!strncmp(arg, "--threads=", 10))
+			options.threadCount = parseInt(arg + 10, 0, 256, "number of threads");
+		else if (!strcmp(arg, "-f") && i + 1 < argc)
+			options.frameCount = parseInt(argv[++i], 1, 100000, "number of frames");
+		else if (!strncmp(arg, "--frames=", 9))
+			options.frameCount = parseInt(arg + 9, 1, 100000, "number of frames");
+		else if (!strncmp(arg, "--seed=", 7))
+			options.seed = (unsigned int)parseInt(arg + 7, 0, 0x7fffffff, "seed");
+		else {
+			fprintf(stderr, "Error: Unknown option %s.\n", arg);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (options.curves) {
+		compareCurves(&options);
+		return EXIT_SUCCESS;
+	}
+	if (options.loadCount) return compareLoading(&options) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	data = makeSkeletonData(&options);
+	stateData = AnimationStateData_create(data);
+	AnimationStateData_setMix(stateData, data->animations[0], data->animations[1], 0.3f);
+	AnimationStateData_setMix(stateData, data->animations[1], data->animations[0], 0.2f);
+	serial = SkeletonBatch_create(1);
+	parallel = SkeletonBatch_create(options.threadCount);
+
+	printf("%d bones, %d keyframes per timeline, %d threads", options.boneCount, options.keyCount, parallel->threadCount);
+	if (options.curveResolution) printf(", curve tables of %d intervals", options.curveResolution);
+	printf("\n");
+	printf("%9s %10s %10s %8s %13s  %s\n", "instances", "serial ms", "batch ms", "speedup", "us/instance", "result");
+	for (c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])) && counts[c] <= options.maxInstances; ++c) {
+		Instances serialInstances, parallelInstances;
+		double serialMilliseconds, parallelMilliseconds;
+		int/*bool*/same = 1;
+
+		makeInstances(&serialInstances, counts[c], data, stateData, options.pose);
+		makeInstances(&parallelInstances, counts[c], data, stateData, options.pose);
+		serialMilliseconds = timeFrames(serial, &serialInstances, options.frameCount);
+		parallelMilliseconds = timeFrames(parallel, &parallelInstances, options.frameCount);
+		for (i = 0; i < counts[c]; ++i)
+			same = same && isSamePose(serialInstances.instances[i].skeleton, parallelInstances.instances[i].skeleton);
+		success = success && same;
+
+		printf("%9d %10.3f %10.3f %7.2fx %13.2f  %s\n", counts[c], serialMilliseconds, parallelMilliseconds,
+				serialMilliseconds / parallelMilliseconds, parallelMilliseconds * 1000 / counts[c], same ? "ok" : "MISMATCH");
+
+		disposeInstances(&parallelInstances);
+		disposeInstances(&serialInstances);
+	}
+
+	SkeletonBatch_dispose(parallel);
+	SkeletonBatch_dispose(serial);
+	AnimationStateData_dispose(stateData);
+	SkeletonData_dispose(data);
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1322 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2013 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Compares the sprite sheet packers on synthetic and recorded sets of sprite sizes, so that changes to
+// them can be checked for regressions in speed, packing quality and memory use.
+
+#include <dirent.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "MaxRectsBinPack.h"
+#include "PackingSearch.h"
+#include "TexturePacker.h"
+#include "AtlasCompositor.h"
+#include "CCZFile.h"
+#include "PNGCodec.h"
+#include "WebPEncoder.h"
+
+#include <webp/decode.h>
+
+#if __cplusplus >= 201103L
+#define BENCHMARK_THROWS_BAD_ALLOC
+#define BENCHMARK_THROWS_NOTHING noexcept
+#else
+#define BENCHMARK_THROWS_BAD_ALLOC throw(std::bad_alloc)
+#define BENCHMARK_THROWS_NOTHING throw()
+#endif
+
+// The global allocation functions are replaced to measure the peak memory use of each packing.
+// Every block is preceded by its size, padded to keep the alignment of malloc.
+
+namespace
+{
+	const size_t AllocationHeader = 16;
+
+	volatile long allocatedBytes = 0;
+	volatile long peakBytes = 0;
+
+	__attribute__((noinline)) void *Allocate(size_t size)
+	{
+		char *block = (char *)malloc(size + AllocationHeader);
+		if (!block)
+			return NULL;
+		*(size_t *)block = size;
+
+		long allocated = __sync_add_and_fetch(&allocatedBytes, (long)size);
+		for(long peak = peakBytes; allocated > peak; peak = peakBytes)
+			if (__sync_bool_compare_and_swap(&peakBytes, peak, allocated))
+				break;
+		return block + AllocationHeader;
+	}
+
+	__attribute__((noinline)) void Deallocate(void *p)
+	{
+		if (!p)
+			return;
+		char *block = (char *)p - AllocationHeader;
+		__sync_sub_and_fetch(&allocatedBytes, (long)*(size_t *)block);
+		free(block);
+	}
+}
+
+void *operator new(size_t size) BENCHMARK_THROWS_BAD_ALLOC
+{
+	void *p = Allocate(size);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size) BENCHMARK_THROWS_BAD_ALLOC
+{
+	return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) BENCHMARK_THROWS_NOTHING
+{
+	return Allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) BENCHMARK_THROWS_NOTHING
+{
+	return Allocate(size);
+}
+
+void operator delete(void *p) BENCHMARK_THROWS_NOTHING
+{
+	Deallocate(p);
+}
+
+void operator delete[](void *p) BENCHMARK_THROWS_NOTHING
+{
+	Deallocate(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) BENCHMARK_THROWS_NOTHING
+{
+	Deallocate(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) BENCHMARK_THROWS_NOTHING
+{
+	Deallocate(p);
+}
+
+void operator delete(void *p, size_t) BENCHMARK_THROWS_NOTHING
+{
+	Deallocate(p);
+}
+
+void operator delete[](void *p, size_t) BENCHMARK_THROWS_NOTHING
+{
+	Deallocate(p);
+}
+
+namespace
+{
+	/// A set of sprite sizes to pack.
+	struct Corpus
+	{
+		std::string name;
+		std::vector<TPRectSize> rects;
+	};
+
+	/// The outcome of one packer on one corpus.
+	struct Measurement
+	{
+		double milliseconds; ///< Wall clock time, the fastest of the repetitions.
+		double cpuMilliseconds; ///< Processor time of all threads, of the same repetition.
+		long peakBytes; ///< Largest amount of memory allocated while packing, above what was allocated before.
+		int width;
+		int height;
+		float occupancy; ///< As returned by MaxRectsBinPack::Occupancy, or computed from the unused area TexturePacker returns.
+		bool fitted; ///< Whether all rectangles were packed.
+		bool valid; ///< Whether the rectangles are inside the bin, unrotated or rotated by 90 degrees, and apart.
+	};
+
+	/// What the benchmark measures.
+	enum Mode
+	{
+		ModeCompare, ///< Every packer on every corpus.
+		ModeScaling, ///< MaxRects against the number of rectangles, with and without the free rectangle index.
+		ModePrune, ///< The size of the MaxRects free list and the time spent pruning it after every insertion.
+		ModeTrim, ///< TrimmedRect against scalar trimming, on directories of PNG images.
+		ModeCCZ, ///< Round trips of ccz files written with one and several threads.
+		ModeWebP ///< Round trips of WebP files through libwebp, and their sizes against PNG.
+	};
+
+	struct Options
+	{
+		Mode mode;
+		int maxSize;
+		int repeat;
+		int scale;
+		unsigned seed;
+		bool synthetic;
+	};
+
+	/// A small linear congruential generator, so the synthetic corpora are the same on every platform.
+	class Random
+	{
+	public:
+		Random(unsigned seed) : state(seed) {}
+
+		int Next(int min, int max)
+		{
+			state = state * 1103515245u + 12345u;
+			return min + (int)((state >> 8) % (unsigned)(max - min + 1));
+		}
+
+	private:
+		unsigned state;
+	};
+
+	double WallMilliseconds()
+	{
+		timeval time;
+		gettimeofday(&time, NULL);
+		return time.tv_sec * 1000.0 + time.tv_usec / 1000.0;
+	}
+
+	/// A monotonic clock with a finer resolution than WallMilliseconds, for timing steps of a few microseconds.
+	double PreciseMilliseconds()
+	{
+#ifdef CLOCK_MONOTONIC
+		timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+#else
+		return WallMilliseconds();
+#endif
+	}
+
+	double CPUMilliseconds()
+	{
+		return clock() * 1000.0 / CLOCKS_PER_SEC;
+	}
+
+	void AddRect(Corpus &corpus, int width, int height)
+	{
+		TPRectSize rect;
+		rect.width = width;
+		rect.height = height;
+		rect.idx = (int)corpus.rects.size();
+		corpus.rects.push_back(rect);
+	}
+
+	/// Builds corpora that resemble the sprite sheets of games: many small sprites, a few backgrounds,
+	/// icons of the same size, and long thin bars.
+	void MakeSyntheticCorpora(const Options &options, std::vector<Corpus> &corpora)
+	{
+		Random random(options.seed);
+		Corpus corpus;
+
+		corpus.name = "uniform-small";
+		corpus.rects.clear();
+		for(int i = 0; i < 200 * options.scale; ++i)
+			AddRect(corpus, random.Next(8, 64), random.Next(8, 64));
+		corpora.push_back(corpus);
+
+		corpus.name = "uniform-large";
+		corpus.rects.clear();
+		for(int i = 0; i < 60 * options.scale; ++i)
+			AddRect(corpus, random.Next(32, 256), random.Next(32, 256));
+		corpora.push_back(corpus);
+
+		corpus.name = "mixed";
+		corpus.rects.clear();
+		for(int i = 0; i < 400 * options.scale; ++i)
+		{
+			if (random.Next(0, 9) < 8)
+				AddRect(corpus, random.Next(8, 48), random.Next(8, 48));
+			else
+				AddRect(corpus, random.Next(64, 320), random.Next(64, 320));
+		}
+		corpora.push_back(corpus);
+
+		corpus.name = "icons";
+		corpus.rects.clear();
+		for(int i = 0; i < 150 * options.scale; ++i)
+		{
+			int size = random.Next(0, 3) ? 64 : 32;
+			AddRect(corpus, size, size);
+		}
+		corpora.push_back(corpus);
+
+		corpus.name = "strips";
+		corpus.rects.clear();
+		for(int i = 0; i < 150 * options.scale; ++i)
+		{
+			int length = random.Next(64, 256), thickness = random.Next(4, 16);
+			if (random.Next(0, 1))
+				AddRect(corpus, length, thickness);
+			else
+				AddRect(corpus, thickness, length);
+		}
+		corpora.push_back(corpus);
+
+		corpus.name = "many-tiny";
+		corpus.rects.clear();
+		for(int i = 0; i < 1000 * options.scale; ++i)
+			AddRect(corpus, random.Next(4, 24), random.Next(4, 24));
+		corpora.push_back(corpus);
+	}
+
+	/// Builds a corpus of the given number of mostly small sprites, in proportions that keep the total area
+	/// within a 4096x4096 sheet up to a few thousand sprites.
+	void MakeScalingCorpus(int count, unsigned seed, Corpus &corpus)
+	{
+		Random random(seed);
+		char name[32];
+		sprintf(name, "scaling-%d", count);
+		corpus.name = name;
+		corpus.rects.clear();
+		for(int i = 0; i < count; ++i)
+		{
+			if (random.Next(0, 9) < 9)
+				AddRect(corpus, random.Next(8, 48), random.Next(8, 48));
+			else
+				AddRect(corpus, random.Next(64, 160), random.Next(64, 160));
+		}
+	}
+
+	/// Reads a recorded corpus: a directory of PNG images, packed by their trimmed sizes, or a text file
+	/// with the width and height of a sprite on every line. Lines starting with # are ignored.
+	bool LoadCorpus(const char *path, Corpus &corpus)
+	{
+		corpus.name = path;
+		corpus.rects.clear();
+
+		if (DIR *dir = opendir(path))
+		{
+			while(dirent *entry = readdir(dir))
+			{
+				std::string name = entry->d_name;
+				if (name.size() < 4 || (name.substr(name.size() - 4) != ".png" && name.substr(name.size() - 4) != ".PNG"))
+					continue;
+				RGBAImage image;
+				if (!LoadPNG((std::string(path) + "/" + name).c_str(), image))
+				{
+					fprintf(stderr, "Error: Failed reading image %s/%s.\n", path, name.c_str());
+					continue;
+				}
+				TPRect trim = TrimmedRect(image);
+				AddRect(corpus, trim.width, trim.height);
+			}
+			closedir(dir);
+			return !corpus.rects.empty();
+		}
+
+		FILE *file = fopen(path, "r");
+		if (!file)
+			return false;
+		char line[256];
+		while(fgets(line, sizeof(line), file))
+		{
+			int width, height;
+			if (line[0] != '#' && sscanf(line, "%d %d", &width, &height) == 2 && width > 0 && height > 0)
+				AddRect(corpus, width, height);
+		}
+		fclose(file);
+		return !corpus.rects.empty();
+	}
+
+	/// Checks a packing by drawing the rectangles into a bitmap of the bin.
+	bool IsValidPacking(const std::vector<TPRectSize> &sizes, const std::vector<TPRect> &rects, int width, int height)
+	{
+		if (width <= 0 || height <= 0)
+			return rects.empty();
+		std::vector<unsigned char> used((size_t)width * height, 0);
+		for(size_t i = 0; i < rects.size(); ++i)
+		{
+			const TPRect &rect = rects[i];
+			if (rect.idx < 0 || rect.idx >= (int)sizes.size())
+				return false;
+			const TPRectSize &size = sizes[rect.idx];
+			if (!(rect.width == size.width && rect.height == size.height) && !(rect.width == size.height && rect.height == size.width))
+				return false;
+			if (rect.x < 0 || rect.y < 0 || rect.x + rect.width > width || rect.y + rect.height > height)
+				return false;
+			for(int y = rect.y; y < rect.y + rect.height; ++y)
+				for(int x = rect.x; x < rect.x + rect.width; ++x)
+				{
+					unsigned char &pixel = used[(size_t)y * width + x];
+					if (pixel)
+						return false;
+					pixel = 1;
+				}
+		}
+		return true;
+	}
+
+	/// A packer under test, which packs the rectangles into a bin of its choosing.
+	class Packer
+	{
+	public:
+		virtual ~Packer() {}
+		virtual std::string Name() const = 0;
+
+		/// @param occupancy [out] The ratio of the packed area to the bin area.
+		/// @return False if not all rectangles could be packed.
+		virtual bool Pack(const std::vector<TPRectSize> &rects, std::vector<TPRect> &packed, int &width, int &height, float &occupancy) = 0;
+	};
+
+	/// TEXTURE_PACKER::MyTexturePacker, which grows its bin downwards from the width of the longest edge.
+	class TexturePackerUnderTest : public Packer
+	{
+	public:
+		std::string Name() const { return "TexturePacker"; }
+
+		bool Pack(const std::vector<TPRectSize> &rects, std::vector<TPRect> &packed, int &width, int &height, float &occupancy)
+		{
+			TEXTURE_PACKER::TexturePacker *packer = TEXTURE_PACKER::createTexturePacker();
+			packer->setTextureCount((int)rects.size());
+			for(size_t i = 0; i < rects.size(); ++i)
+				packer->addTexture(rects[i].width, rects[i].height);
+			int unusedArea = packer->packTextures(width, height, true, false);
+			occupancy = (width > 0 && height > 0) ? 1 - (float)unusedArea / ((float)width * height) : 0;
+
+			packed.resize(rects.size());
+			for(size_t i = 0; i < rects.size(); ++i)
+			{
+				TPRect &rect = packed[i];
+				rect.rotated = packer->getTextureLocation((int)i, rect.x, rect.y, rect.width, rect.height);
+				rect.idx = rects[i].idx;
+			}
+			TEXTURE_PACKER::releaseTexturePacker(packer);
+			return true;
+		}
+	};
+
+	/// MaxRectsBinPack driven by PackingSearch, with one heuristic in every insertion order or with the default strategies.
+	class MaxRectsUnderTest : public Packer
+	{
+	public:
+		/// @param heuristic A FreeRectChoiceHeuristic, or -1 for the default strategies of PackingSearch.
+		MaxRectsUnderTest(int heuristic, int maxSize) : heuristic(heuristic)
+		{
+			search.SetMaxSize(maxSize);
+			if (heuristic < 0)
+				return;
+
+			std::vector<PackingStrategy> strategies;
+			for(int order = PackingOrderBatch; order <= PackingOrderPerimeter; ++order)
+			{
+				if (heuristic == MaxRectsBinPack::RectContactPointRule && order == PackingOrderBatch)
+					continue;
+				PackingStrategy strategy = { (MaxRectsBinPack::FreeRectChoiceHeuristic)heuristic, (PackingOrder)order };
+				strategies.push_back(strategy);
+			}
+			search.SetStrategies(strategies);
+		}
+
+		std::string Name() const
+		{
+			const char *names[] = { "MaxRects BSSF", "MaxRects BLSF", "MaxRects BAF", "MaxRects BL", "MaxRects CP" };
+			return heuristic < 0 ? "MaxRects default" : names[heuristic];
+		}
+
+		bool Pack(const std::vector<TPRectSize> &rects, std::vector<TPRect> &packed, int &width, int &height, float &occupancy)
+		{
+			PackingResult result;
+			bool fitted = search.Pack(rects, result);
+			packed.swap(result.rects);
+			width = result.width;
+			height = result.height;
+			occupancy = result.occupancy;
+			return fitted;
+		}
+
+	private:
+		int heuristic;
+		PackingSearch search;
+	};
+
+	Measurement Measure(Packer &packer, const Corpus &corpus, const Options &options)
+	{
+		Measurement measurement;
+		measurement.milliseconds = -1;
+		for(int run = 0; run < options.repeat; ++run)
+		{
+			std::vector<TPRect> packed;
+			packed.reserve(corpus.rects.size());
+			int width = 0, height = 0;
+			float occupancy = 0;
+
+			long baseBytes = allocatedBytes;
+			peakBytes = baseBytes;
+			double cpuStart = CPUMilliseconds(), start = WallMilliseconds();
+			bool fitted = packer.Pack(corpus.rects, packed, width, height, occupancy);
+			double milliseconds = WallMilliseconds() - start, cpuMilliseconds = CPUMilliseconds() - cpuStart;
+			long peak = peakBytes - baseBytes;
+
+			if (measurement.milliseconds < 0 || milliseconds < measurement.milliseconds)
+			{
+				measurement.milliseconds = milliseconds;
+				measurement.cpuMilliseconds = cpuMilliseconds;
+			}
+			if (run == 0)
+			{
+				measurement.peakBytes = peak;
+				measurement.width = width;
+				measurement.height = height;
+				measurement.occupancy = occupancy;
+				measurement.fitted = fitted && packed.size() == corpus.rects.size();
+				measurement.valid = IsValidPacking(corpus.rects, packed, width, height);
+			}
+		}
+		return measurement;
+	}
+
+	/// Finds the side of a square bin for the rectangles: the smallest power of two with at least a quarter
+	/// more area than the rectangles, limited to the maximum size.
+	int SquareBinSide(const std::vector<TPRectSize> &rects, int maxSize)
+	{
+		double area = 0;
+		for(size_t i = 0; i < rects.size(); ++i)
+			area += (double)rects[i].width * rects[i].height;
+		int side = 8;
+		while(side < maxSize && (double)side * side < area * 1.25)
+			side *= 2;
+		return std::min(side, maxSize);
+	}
+
+	/// Times MaxRectsBinPack::Insert of all rectangles at once into a square bin.
+	/// @param packed [out] The rectangles placed by the first repetition.
+	double TimeMaxRectsInsert(const std::vector<TPRectSize> &rects, int side, MaxRectsBinPack::FreeRectChoiceHeuristic method,
+		bool useFreeRectIndex, int repeat, std::vector<TPRect> &packed)
+	{
+		double best = -1;
+		for(int run = 0; run < repeat; ++run)
+		{
+			std::vector<TPRectSize> input = rects;
+			std::vector<TPRect> output;
+			MaxRectsBinPack bin;
+			bin.SetUseFreeRectIndex(useFreeRectIndex);
+			bin.Init(side, side);
+
+			double start = WallMilliseconds();
+			bin.Insert(input, output, method);
+			double milliseconds = WallMilliseconds() - start;
+
+			if (best < 0 || milliseconds < best)
+				best = milliseconds;
+			if (run == 0)
+				packed.swap(output);
+		}
+		return best;
+	}
+
+	bool IsSamePlacement(const std::vector<TPRect> &a, const std::vector<TPRect> &b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for(size_t i = 0; i < a.size(); ++i)
+			if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].width != b[i].width || a[i].height != b[i].height ||
+				a[i].idx != b[i].idx || a[i].rotated != b[i].rotated)
+				return false;
+		return true;
+	}
+
+	/// Packs ever larger corpora with MaxRects in a single bin, with and without the free rectangle index,
+	/// and checks that both place every rectangle at the same position. The contact point rule rescores all
+	/// rectangles after every placement, which takes minutes for the larger corpora, so it is left out.
+	bool RunScaling(const Options &options)
+	{
+		const char *names[] = { "BSSF", "BLSF", "BAF", "BL" };
+
+		printf("%-6s %6s %11s %7s %13s %13s %8s  %s\n",
+			"method", "rects", "sheet", "placed", "no index ms", "index ms", "speedup", "result");
+
+		bool success = true;
+		for(int count = 250; count <= 4000 * options.scale; count *= 2)
+		{
+			Corpus corpus;
+			MakeScalingCorpus(count, options.seed, corpus);
+			int side = SquareBinSide(corpus.rects, options.maxSize);
+
+			for(int method = MaxRectsBinPack::RectBestShortSideFit; method < MaxRectsBinPack::RectContactPointRule; ++method)
+			{
+				MaxRectsBinPack::FreeRectChoiceHeuristic heuristic = (MaxRectsBinPack::FreeRectChoiceHeuristic)method;
+				std::vector<TPRect> plain, indexed;
+				double plainMilliseconds = TimeMaxRectsInsert(corpus.rects, side, heuristic, false, options.repeat, plain);
+				double indexedMilliseconds = TimeMaxRectsInsert(corpus.rects, side, heuristic, true, options.repeat, indexed);
+
+				bool same = IsSamePlacement(plain, indexed);
+				bool valid = IsValidPacking(corpus.rects, plain, side, side);
+				success = success && same && valid;
+
+				char sheet[32];
+				sprintf(sheet, "%dx%d", side, side);
+				printf("%-6s %6d %11s %7d %13.2f %13.2f %7.2fx  %s\n",
+					names[method], count, sheet, (int)plain.size(), plainMilliseconds, indexedMilliseconds,
+					indexedMilliseconds > 0 ? plainMilliseconds / indexedMilliseconds : 0.0,
+					!valid ? "INVALID" : !same ? "DIFFERENT" : "ok");
+			}
+		}
+		return success;
+	}
+
+	bool RunPrune(const Options &options, const std::vector<Corpus> &corpora);
+
+#if defined(__AVX2__)
+	const char *TrimInstructionSet = "AVX2";
+#elif defined(__SSE2__)
+	const char *TrimInstructionSet = "SSE2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	const char *TrimInstructionSet = "NEON";
+#else
+	const char *TrimInstructionSet = "scalar";
+#endif
+
+	/// Trims an image the way Tupac did before TrimmedRect: each bound is searched for separately, the left
+	/// and right ones column by column, and every pixel of a row or column is read.
+	TPRect TrimmedRectByColumns(const RGBAImage &image)
+	{
+		int w = image.width, h = image.height;
+		const unsigned *pixels = (const unsigned *)&image.pixels[0];
+
+		int left, right, top, bottom;
+		for(left = 0; left < w; ++left)
+		{
+			bool empty = true;
+			for(int y = 0; y < h; ++y)
+				if (pixels[y*w + left] & 0xff000000)
+					empty = false;
+			if (!empty)
+				break;
+		}
+		for(right = w-1; right >= 0; --right)
+		{
+			bool empty = true;
+			for(int y = 0; y < h; ++y)
+				if (pixels[y*w + right] & 0xff000000)
+					empty = false;
+			if (!empty)
+				break;
+		}
+		for(top = 0; top < h; ++top)
+		{
+			bool empty = true;
+			for(int x = 0; x < w; ++x)
+				if (pixels[top*w + x] & 0xff000000)
+					empty = false;
+			if (!empty)
+				break;
+		}
+		for(bottom = h-1; bottom >= 0; --bottom)
+		{
+			bool empty = true;
+			for(int x = 0; x < w; ++x)
+				if (pixels[bottom*w + x] & 0xff000000)
+					empty = false;
+			if (!empty)
+				break;
+		}
+
+		TPRect r;
+		memset(&r, 0, sizeof(TPRect));
+		r.width = 1;
+		r.height = 1;
+		if (right < 0)
+			return r;
+		r.x = left;
+		r.y = top;
+		r.width = right - left + 1;
+		r.height = bottom - top + 1;
+		return r;
+	}
+
+	/// TrimmedRect with the alpha of one pixel tested at a time, to tell the gain of its vector compares.
+	TPRect TrimmedRectScalar(const RGBAImage &image)
+	{
+		int left = image.width, right = -1, top = 0, bottom = -1;
+		for(int y = 0; y < image.height; ++y)
+		{
+			const unsigned char *row = image.Row(y);
+
+			if (right < 0)
+			{
+				int first = 0;
+				while(first < image.width && !row[first*4 + 3])
+					++first;
+				if (first == image.width)
+					continue;
+
+				int last = image.width - 1;
+				while(!row[last*4 + 3])
+					--last;
+				left = first;
+				right = last;
+				top = bottom = y;
+				continue;
+			}
+
+			bool opaque = false;
+			for(int x = 0; x < left; ++x)
+				if (row[x*4 + 3])
+				{
+					left = x;
+					opaque = true;
+					break;
+				}
+			for(int x = image.width - 1; x > right; --x)
+				if (row[x*4 + 3])
+				{
+					right = x;
+					opaque = true;
+					break;
+				}
+			for(int x = left; x <= right && !opaque; ++x)
+				if (row[x*4 + 3])
+					opaque = true;
+			if (opaque)
+				bottom = y;
+		}
+
+		TPRect r;
+		memset(&r, 0, sizeof(TPRect));
+		r.width = 1;
+		r.height = 1;
+		if (right < 0)
+			return r;
+		r.x = left;
+		r.y = top;
+		r.width = right - left + 1;
+		r.height = bottom - top + 1;
+		return r;
+	}
+
+	bool IsSameRect(const TPRect &a, const TPRect &b)
+	{
+		return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+	}
+
+	/// Trims every image repeatedly with the given function.
+	/// @return The time of the fastest repetition in milliseconds.
+	double TimeTrim(TPRect (*trim)(const RGBAImage &), const std::vector<RGBAImage> &images, int repeat, std::vector<TPRect> &rects)
+	{
+		double best = -1;
+		for(int run = 0; run < repeat; ++run)
+		{
+			rects.resize(images.size());
+			double start = PreciseMilliseconds();
+			for(size_t i = 0; i < images.size(); ++i)
+				rects[i] = trim(images[i]);
+			double milliseconds = PreciseMilliseconds() - start;
+			if (best < 0 || milliseconds < best)
+				best = milliseconds;
+		}
+		return best;
+	}
+
+	/// Reads all PNG images of a directory.
+	bool LoadImages(const char *path, std::vector<RGBAImage> &images)
+	{
+		DIR *dir = opendir(path);
+		if (!dir)
+			return false;
+		while(dirent *entry = readdir(dir))
+		{
+			std::string name = entry->d_name;
+			if (name.size() < 4 || (name.substr(name.size() - 4) != ".png" && name.substr(name.size() - 4) != ".PNG"))
+				continue;
+			RGBAImage image;
+			if (!LoadPNG((std::string(path) + "/" + name).c_str(), image))
+			{
+				fprintf(stderr, "Error: Failed reading image %s/%s.\n", path, name.c_str());
+				continue;
+			}
+			images.push_back(image);
+		}
+		closedir(dir);
+		return !images.empty();
+	}
+
+	/// Times TrimmedRect on the images of every directory, against TrimmedRectScalar and TrimmedRectByColumns,
+	/// and checks that all three find the same rectangles.
+	bool RunTrim(const Options &options, const std::vector<const char *> &paths)
+	{
+		if (paths.empty())
+		{
+			fprintf(stderr, "Error: --trim needs at least one directory of PNG images.\n");
+			return false;
+		}
+
+		printf("%-32s %7s %10s %12s %11s %11s %8s  %s\n",
+			"directory", "images", "megapixels", "columns ms", "scalar ms", TrimInstructionSet, "speedup", "result");
+
+		bool success = true;
+		for(size_t p = 0; p < paths.size(); ++p)
+		{
+			std::vector<RGBAImage> images;
+			if (!LoadImages(paths[p], images))
+			{
+				fprintf(stderr, "Error: Failed reading images from %s.\n", paths[p]);
+				success = false;
+				continue;
+			}
+
+			double pixels = 0;
+			for(size_t i = 0; i < images.size(); ++i)
+				pixels += (double)images[i].width * images[i].height;
+
+			std::vector<TPRect> byColumns, scalar, vector;
+			double columnsMilliseconds = TimeTrim(TrimmedRectByColumns, images, options.repeat, byColumns);
+			double scalarMilliseconds = TimeTrim(TrimmedRectScalar, images, options.repeat, scalar);
+			double vectorMilliseconds = TimeTrim(TrimmedRect, images, options.repeat, vector);
+
+			bool same = true;
+			for(size_t i = 0; i < images.size(); ++i)
+				same = same && IsSameRect(vector[i], scalar[i]) && IsSameRect(vector[i], byColumns[i]);
+			success = success && same;
+
+			printf("%-32s %7d %10.2f %12.3f %11.3f %11.3f %7.2fx  %s\n",
+				paths[p], (int)images.size(), pixels / 1000000, columnsMilliseconds, scalarMilliseconds, vectorMilliseconds,
+				vectorMilliseconds > 0 ? scalarMilliseconds / vectorMilliseconds : 0.0, same ? "ok" : "DIFFERENT");
+		}
+		return success;
+	}
+
+	/// Fills data with bytes of the given kind: "zeros", "noise", or "sprites", which resembles the rows of an
+	/// RGBA sprite sheet with runs of transparent pixels between blocks of smoothly varying color.
+	void MakeCCZPayload(const char *kind, size_t size, unsigned seed, std::vector<unsigned char> &data)
+	{
+		Random random(seed);
+		data.assign(size, 0);
+		if (!strcmp(kind, "noise"))
+		{
+			for(size_t i = 0; i < size; ++i)
+				data[i] = (unsigned char)random.Next(0, 255);
+		}
+		else if (!strcmp(kind, "sprites"))
+		{
+			for(size_t i = 0; i + 4 <= size; )
+			{
+				size_t run = (size_t)random.Next(1, 64) * 4;
+				bool opaque = random.Next(0, 2) > 0;
+				int r = random.Next(0, 255), g = random.Next(0, 255), b = random.Next(0, 255);
+				for(size_t end = std::min(size - size % 4, i + run); i < end; i += 4)
+					if (opaque)
+					{
+						data[i] = (unsigned char)(r + (int)(i / 4) % 8);
+						data[i+1] = (unsigned char)g;
+						data[i+2] = (unsigned char)(b - (int)(i / 4) % 8);
+						data[i+3] = 255;
+					}
+			}
+		}
+	}
+
+	bool ReadFile(const char *filename, std::vector<unsigned char> &data)
+	{
+		FILE *file = fopen(filename, "rb");
+		if (!file)
+			return false;
+		data.clear();
+		unsigned char buffer[64 * 1024];
+		size_t length;
+		while((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			data.insert(data.end(), buffer, buffer + length);
+		bool ok = !ferror(file);
+		fclose(file);
+		return ok;
+	}
+
+	/// Writes payloads of several kinds and sizes to a ccz file with one thread and with several, reads every
+	/// file back with LoadCCZ and with DecodeCCZ, and checks that both return the payload.
+	bool RunCCZ(const Options &options)
+	{
+		const char *kinds[] = { "zeros", "noise", "sprites" };
+		const size_t sizes[] = { 0, 1, 1000, 128 * 1024, 128 * 1024 + 1, 4 * 1024 * 1024 + 12 };
+		const int threadCounts[] = { 1, 4 };
+
+		char filename[] = "/tmp/tupac-benchmark-XXXXXX";
+		int fd = mkstemp(filename);
+		if (fd < 0)
+		{
+			fprintf(stderr, "Error: Failed creating a temporary file.\n");
+			return false;
+		}
+		close(fd);
+
+		printf("%-8s %10s %8s %11s %10s %10s  %s\n", "payload", "bytes", "threads", "ccz bytes", "save ms", "load ms", "result");
+
+		bool success = true;
+		for(size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k)
+			for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+			{
+				std::vector<unsigned char> payload;
+				MakeCCZPayload(kinds[k], sizes[s], options.seed, payload);
+
+				for(size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+				{
+					double start = WallMilliseconds();
+					bool saved = SaveCCZ(filename, payload.empty() ? NULL : &payload[0], payload.size(), 9, threadCounts[t]);
+					double saveMilliseconds = WallMilliseconds() - start;
+
+					std::vector<unsigned char> loaded, file, decoded;
+					start = WallMilliseconds();
+					bool ok = saved && LoadCCZ(filename, loaded);
+					double loadMilliseconds = WallMilliseconds() - start;
+
+					ok = ok && loaded == payload;
+					ok = ok && ReadFile(filename, file) && DecodeCCZ(&file[0], file.size(), decoded) && decoded == payload;
+					success = success && ok;
+
+					printf("%-8s %10d %8d %11d %10.2f %10.2f  %s\n", kinds[k], (int)payload.size(), threadCounts[t],
+						(int)file.size(), saveMilliseconds, loadMilliseconds, !saved ? "SAVE FAILED" : ok ? "ok" : "MISMATCH");
+				}
+			}
+
+		unlink(filename);
+		return success;
+	}
+
+	/// The peak signal to noise ratio of the colors of the decoded pixels that aren't fully transparent, in
+	/// decibels, or a negative number if they are exact.
+	double ColorPSNR(const RGBAImage &image, const unsigned char *decoded)
+	{
+		double squaredError = 0;
+		size_t count = 0;
+		for(size_t j = 0; j < image.pixels.size(); j += 4)
+		{
+			if (image.pixels[j + 3] == 0)
+				continue;
+			for(int c = 0; c < 3; ++c)
+			{
+				double error = (double)decoded[j + c] - image.pixels[j + c];
+				squaredError += error * error;
+			}
+			count += 3;
+		}
+		if (squaredError == 0)
+			return -1;
+		return 10 * log10(255.0 * 255.0 * count / squaredError);
+	}
+
+	/// Encodes the images of every corpus, a directory of PNG images or a single PNG image such as a sprite
+	/// sheet, as WebP at several qualities and decodes them again. Checks that alpha is exact at every quality
+	/// and the colors are exact when lossless, and prints the sizes against those of PNG files and the PSNR
+	/// of the colors.
+	bool RunWebP(const std::vector<const char *> &paths)
+	{
+		const int qualities[] = { 100, 80, 50, 0 };
+
+		if (paths.empty())
+		{
+			fprintf(stderr, "Error: --webp needs directories of PNG images or PNG images to encode.\n");
+			return false;
+		}
+
+		printf("%-32s %7s %8s %11s %11s %7s %10s %9s  %s\n", "corpus", "images", "quality", "png bytes", "webp bytes",
+			"ratio", "encode ms", "psnr dB", "result");
+
+		bool success = true;
+		for(size_t p = 0; p < paths.size(); ++p)
+		{
+			std::vector<RGBAImage> images;
+			std::string path = paths[p];
+			bool loaded;
+			if (path.size() > 4 && (path.substr(path.size() - 4) == ".png" || path.substr(path.size() - 4) == ".PNG"))
+			{
+				images.resize(1);
+				loaded = LoadPNG(paths[p], images[0]);
+			}
+			else
+				loaded = LoadImages(paths[p], images);
+			if (!loaded)
+			{
+				fprintf(stderr, "Error: Failed reading images from %s.\n", paths[p]);
+				success = false;
+				continue;
+			}
+
+			size_t pngBytes = 0;
+			for(size_t i = 0; i < images.size(); ++i)
+			{
+				std::vector<unsigned char> png;
+				EncodePNG(images[i], png);
+				pngBytes += png.size();
+			}
+
+			for(size_t q = 0; q < sizeof(qualities) / sizeof(qualities[0]); ++q)
+			{
+				size_t webpBytes = 0;
+				double encodeMilliseconds = 0;
+				double minPSNR = -1;
+				bool ok = true;
+				for(size_t i = 0; i < images.size(); ++i)
+				{
+					const RGBAImage &image = images[i];
+					std::vector<unsigned char> webp;
+					double start = WallMilliseconds();
+					bool encoded = EncodeWebP(image, qualities[q], webp);
+					encodeMilliseconds += WallMilliseconds() - start;
+					webpBytes += webp.size();
+
+					int width = 0, height = 0;
+					unsigned char *decoded = encoded ? WebPDecodeRGBA(&webp[0], webp.size(), &width, &height) : 0;
+					if (!decoded || width != image.width || height != image.height)
+					{
+						ok = false;
+						WebPFree(decoded);
+						continue;
+					}
+
+					for(size_t j = 3; j < image.pixels.size(); j += 4)
+						ok = ok && decoded[j] == image.pixels[j];
+
+					double psnr = ColorPSNR(image, decoded);
+					if (psnr >= 0 && (minPSNR < 0 || psnr < minPSNR))
+						minPSNR = psnr;
+					WebPFree(decoded);
+				}
+				ok = ok && (qualities[q] < 100 || minPSNR < 0);
+				success = success && ok;
+
+				char psnr[16];
+				if (minPSNR < 0)
+					strcpy(psnr, "exact");
+				else
+					sprintf(psnr, "%.2f", minPSNR);
+				printf("%-32s %7d %8d %11d %11d %6.2fx %10.1f %9s  %s\n", paths[p], (int)images.size(), qualities[q],
+					(int)pngBytes, (int)webpBytes, webpBytes ? (double)pngBytes / webpBytes : 0.0, encodeMilliseconds,
+					psnr, ok ? "ok" : "MISMATCH");
+			}
+		}
+		return success;
+	}
+
+	void PrintUsage(const char *prog)
+	{
+		fprintf(stdout,
+"Usage:\n"
+"%s [options] [corpus ...]\n"
+"%s -h|--help\n"
+"\n"
+"Packs every corpus with every packer and prints the time, sheet size, occupancy and peak memory of each.\n"
+"A corpus is a directory of PNG images or a text file with the width and height of a sprite on every\n"
+"line. The synthetic corpora are packed when no corpus is given, or when --synthetic is.\n"
+"\n"
+"With --scaling, times MaxRects on synthetic corpora of 250 to 4000 sprites (times the scale) packed\n"
+"into one sheet, with and without the free rectangle index, and checks that the placements are the same.\n"
+"\n"
+"With --prune, inserts the sprites of every corpus one at a time, largest first, into a square sheet with\n"
+"MaxRects, and prints the size of the free list and the time spent pruning it, against the pairwise\n"
+"pruning of every free rectangle, in ten groups of insertions.\n"
+"\n"
+"With --trim, the corpora must be directories of PNG images. Times the trimming of their transparent\n"
+"borders by TrimmedRect, by the same pass testing one pixel at a time, and by the separate scans of every\n"
+"row and column Tupac used to do, and checks that all three find the same bounds.\n"
+"\n"
+"With --ccz, writes ccz files of several payloads with one and with four threads, and checks that LoadCCZ\n"
+"and DecodeCCZ read the payloads back.\n"
+"\n"
+"With --webp, a corpus may also be a single PNG image, such as a sprite sheet. Encodes the images as WebP\n"
+"at qualities 100, 80, 50 and 0 and decodes them again, and checks that alpha is exact and that the colors\n"
+"are exact at 100. Prints the sizes against PNG and the PSNR of the colors.\n"
+"\n"
+"Options:\n"
+"      --ccz                checks ccz round trips instead\n"
+"  -m, --max-size=<pixels>  largest width and height MaxRects may use (default 4096)\n"
+"  -r, --repeat=<n>         times each packing is timed, the fastest counts (default 3)\n"
+"  -s, --scale=<n>          multiplies the number of sprites of the synthetic corpora (default 1)\n"
+"      --prune              times the pruning of the MaxRects free list instead\n"
+"      --scaling            times MaxRects against the number of sprites instead\n"
+"      --seed=<n>           seed of the synthetic corpora (default 1)\n"
+"      --synthetic          packs the synthetic corpora as well as the given ones\n"
+"      --trim               times the trimming of the images of the corpora instead\n"
+"      --webp               checks WebP round trips through libwebp instead\n", prog, prog);
+	}
+
+	int ParseInt(const char *value, int min, int max, const char *option)
+	{
+		char *end;
+		long n = strtol(value, &end, 10);
+		if (!*value || *end || n < min || n > max)
+		{
+			fprintf(stderr, "Error: The %s must be a number from %d to %d.\n", option, min, max);
+			exit(EXIT_FAILURE);
+		}
+		return (int)n;
+	}
+}
+
+/// Inserts rectangles one at a time as MaxRectsBinPack::Insert(width, height, method) does, but prunes the
+/// free list apart from the rest of the placement, so that the pruning can be timed on its own.
+class MaxRectsBinPackProfiler
+{
+public:
+	struct Step
+	{
+		size_t freeRects; ///< Free rectangles after splitting, before pruning.
+		size_t prunedFreeRects; ///< Free rectangles left after pruning.
+		double pruneMicroseconds; ///< Time of MaxRectsBinPack::PruneFreeList.
+		double pairwiseMicroseconds; ///< Time of PrunePairwise on a copy of the same free list.
+		bool same; ///< Whether PrunePairwise left as many free rectangles. Both remove every free rectangle contained in another.
+	};
+
+	/// @return False if the rectangle does not fit.
+	static bool Insert(MaxRectsBinPack &bin, int width, int height, MaxRectsBinPack::FreeRectChoiceHeuristic method, Step &step)
+	{
+		int score1;
+		int score2;
+		TPRect node = bin.ScoreRect(width, height, method, score1, score2, 0);
+		if (node.height == 0)
+			return false;
+
+		int firstNewFreeRectOrder = bin.SplitFreeRects(node);
+		step.freeRects = bin.freeRectangles.size();
+
+		std::vector<TPRect> pairwise = bin.freeRectangles;
+		double start = PreciseMilliseconds();
+		PrunePairwise(pairwise);
+		step.pairwiseMicroseconds = (PreciseMilliseconds() - start) * 1000;
+
+		start = PreciseMilliseconds();
+		bin.PruneFreeList(firstNewFreeRectOrder);
+		step.pruneMicroseconds = (PreciseMilliseconds() - start) * 1000;
+
+		bin.usedRectangles.push_back(node);
+		step.prunedFreeRects = bin.freeRectangles.size();
+		step.same = pairwise.size() == step.prunedFreeRects;
+		return true;
+	}
+
+private:
+	/// The pruning MaxRectsBinPack did before it only checked the new free rectangles: every pair of free
+	/// rectangles is tested, and the redundant ones are erased from the middle of the list.
+	static void PrunePairwise(std::vector<TPRect> &freeRects)
+	{
+		for(size_t i = 0; i < freeRects.size(); ++i)
+			for(size_t j = i+1; j < freeRects.size(); ++j)
+			{
+				if (IsContainedIn(freeRects[i], freeRects[j]))
+				{
+					freeRects.erase(freeRects.begin()+i);
+					--i;
+					break;
+				}
+				if (IsContainedIn(freeRects[j], freeRects[i]))
+				{
+					freeRects.erase(freeRects.begin()+j);
+					--j;
+				}
+			}
+	}
+};
+
+namespace
+{
+	bool LargerArea(const TPRectSize &a, const TPRectSize &b)
+	{
+		return a.width * a.height > b.width * b.height;
+	}
+
+	bool RunPrune(const Options &options, const std::vector<Corpus> &corpora)
+	{
+		const int Groups = 10;
+
+		printf("%-16s %11s %11s %10s %10s %11s %11s  %s\n",
+			"corpus", "sheet", "insertions", "free mean", "free max", "prune us", "pairwise us", "result");
+
+		bool success = true;
+		for(size_t c = 0; c < corpora.size(); ++c)
+		{
+			const Corpus &corpus = corpora[c];
+			std::vector<TPRectSize> rects = corpus.rects;
+			std::stable_sort(rects.begin(), rects.end(), LargerArea);
+			int side = SquareBinSide(rects, options.maxSize);
+
+			MaxRectsBinPack bin(side, side);
+			std::vector<MaxRectsBinPackProfiler::Step> steps;
+			bool same = true;
+			for(size_t i = 0; i < rects.size(); ++i)
+			{
+				MaxRectsBinPackProfiler::Step step;
+				if (MaxRectsBinPackProfiler::Insert(bin, rects[i].width, rects[i].height, MaxRectsBinPack::RectBestShortSideFit, step))
+				{
+					steps.push_back(step);
+					same = same && step.same;
+				}
+			}
+			success = success && same;
+
+			char sheet[32];
+			sprintf(sheet, "%dx%d", side, side);
+			for(int group = 0; group < Groups && !steps.empty(); ++group)
+			{
+				size_t begin = steps.size() * group / Groups, end = steps.size() * (group + 1) / Groups;
+				if (begin == end)
+					continue;
+
+				double freeRects = 0, pruneMicroseconds = 0, pairwiseMicroseconds = 0;
+				size_t maxFreeRects = 0;
+				for(size_t i = begin; i < end; ++i)
+				{
+					freeRects += steps[i].freeRects;
+					maxFreeRects = std::max(maxFreeRects, steps[i].freeRects);
+					pruneMicroseconds += steps[i].pruneMicroseconds;
+					pairwiseMicroseconds += steps[i].pairwiseMicroseconds;
+				}
+
+				char insertions[32];
+				sprintf(insertions, "%d-%d", (int)begin + 1, (int)end);
+				printf("%-16s %11s %11s %10.1f %10d %11.2f %11.2f  %s\n",
+					corpus.name.c_str(), sheet, insertions, freeRects / (end - begin), (int)maxFreeRects,
+					pruneMicroseconds / (end - begin), pairwiseMicroseconds / (end - begin), same ? "ok" : "DIFFERENT");
+			}
+		}
+		return success;
+	}
+}
+
+int main(int argc, const char **argv)
+{
+	Options options;
+	options.mode = ModeCompare;
+	options.maxSize = 4096;
+	options.repeat = 3;
+	options.scale = 1;
+	options.seed = 1;
+	options.synthetic = false;
+
+	std::vector<const char *> paths;
+	for(int i = 1; i < argc; ++i)
+	{
+		const char *arg = argv[i];
+		if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
+		{
+			PrintUsage(argv[0]);
+			return EXIT_SUCCESS;
+		}
+		else if (!strcmp(arg, "--synthetic"))
+			options.synthetic = true;
+		else if (!strcmp(arg, "--scaling"))
+			options.mode = ModeScaling;
+		else if (!strcmp(arg, "--prune"))
+			options.mode = ModePrune;
+		else if (!strcmp(arg, "--trim"))
+			options.mode = ModeTrim;
+		else if (!strcmp(arg, "--ccz"))
+			options.mode = ModeCCZ;
+		else if (!strcmp(arg, "--webp"))
+			options.mode = ModeWebP;
+		else if (!strcmp(arg, "-m") && i + 1 < argc)
+			options.maxSize = ParseInt(argv[++i], 1, 16384, "maximum size");
+		else if (!strncmp(arg, "--max-size=", 11))
+			options.maxSize = ParseInt(arg + 11, 1, 16384, "maximum size");
+		else if (!strcmp(arg, "-r") && i + 1 < argc)
+			options.repeat = ParseInt(argv[++i], 1, 1000, "number of repetitions");
+		else if (!strncmp(arg, "--repeat=", 9))
+			options.repeat = ParseInt(arg + 9, 1, 1000, "number of repetitions");
+		else if (!strcmp(arg, "-s") && i + 1 < argc)
+			options.scale = ParseInt(argv[++i], 1, 100, "scale");
+		else if (!strncmp(arg, "--scale=", 8))
+			options.scale = ParseInt(arg + 8, 1, 100, "scale");
+		else if (!strncmp(arg, "--seed=", 7))
+			options.seed = (unsigned)ParseInt(arg + 7, 0, 0x7fffffff, "seed");
+		else if (arg[0] == '-')
+		{
+			fprintf(stderr, "Error: Unknown option %s.\n", arg);
+			return EXIT_FAILURE;
+		}
+		else
+			paths.push_back(arg);
+	}
+
+	if (options.mode == ModeScaling)
+		return RunScaling(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+	if (options.mode == ModeTrim)
+		return RunTrim(options, paths) ? EXIT_SUCCESS : EXIT_FAILURE;
+	if (options.mode == ModeCCZ)
+		return RunCCZ(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+	if (options.mode == ModeWebP)
+		return RunWebP(paths) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	std::vector<Corpus> corpora;
+	for(size_t i = 0; i < paths.size(); ++i)
+	{
+		Corpus corpus;
+		if (!LoadCorpus(paths[i], corpus))
+		{
+			fprintf(stderr, "Error: Failed reading sprite sizes from %s.\n", paths[i]);
+			return EXIT_FAILURE;
+		}
+		corpora.push_back(corpus);
+	}
+
+	if (corpora.empty() || options.synthetic)
+	{
+		std::vector<Corpus> synthetic;
+		MakeSyntheticCorpora(options, synthetic);
+		corpora.insert(corpora.begin(), synthetic.begin(), synthetic.end());
+	}
+
+	if (options.mode == ModePrune)
+		return RunPrune(options, corpora) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	std::vector<Packer *> packers;
+	packers.push_back(new TexturePackerUnderTest);
+	for(int heuristic = MaxRectsBinPack::RectBestShortSideFit; heuristic <= MaxRectsBinPack::RectContactPointRule; ++heuristic)
+		packers.push_back(new MaxRectsUnderTest(heuristic, options.maxSize));
+	packers.push_back(new MaxRectsUnderTest(-1, options.maxSize));
+
+	printf("%-16s %-16s %6s %10s %10s %11s %10s %9s %9s  %s\n",
+		"corpus", "packer", "rects", "time ms", "cpu ms", "sheet", "area", "occupancy", "peak KB", "result");
+
+	bool success = true;
+	for(size_t c = 0; c < corpora.size(); ++c)
+	{
+		const Corpus &corpus = corpora[c];
+		for(size_t p = 0; p < packers.size(); ++p)
+		{
+			Measurement m = Measure(*packers[p], corpus, options);
+			char sheet[32];
+			sprintf(sheet, "%dx%d", m.width, m.height);
+			const char *result = !m.valid ? "INVALID" : !m.fitted ? "no fit" : "ok";
+			success = success && m.valid;
+
+			printf("%-16s %-16s %6d %10.2f %10.2f %11s %10ld %8.2f%% %9.1f  %s\n",
+				corpus.name.c_str(), packers[p]->Name().c_str(), (int)corpus.rects.size(), m.milliseconds,
+				m.cpuMilliseconds, sheet, (long)m.width * m.height, m.occupancy * 100, m.peakBytes / 1024.0, result);
+		}
+	}
+
+	for(size_t p = 0; p < packers.size(); ++p)
+		delete packers[p];
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
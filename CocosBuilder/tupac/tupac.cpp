@@ -0,0 +1,394 @@
+/*
+ * CocosBuilder: http://www.cocosbuilder.com
+ *
+ * Copyright (c) 2013 Zynga Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Packs directories of PNG images into cocos2d sprite sheets without Cocoa, so sprite sheets can be
+// built on any POSIX system. The output matches that of the Tupac class used when publishing.
+
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "MaxRectsBinPack.h"
+#include "ParallelFor.h"
+#include "SpriteSheetBuilder.h"
+
+namespace
+{
+	/// The names of the image formats on the command line, in the order of SpriteSheetImageFormat.
+	const char *const ImageFormatNames[] = { "png", "png8", "rgba8888", "rgba4444", "rgb565", "pvrtc4", "pvrtc2", "webp" };
+
+	/// The names of the FreeRectChoiceHeuristic values on the command line, as abbreviated in MaxRectsBinPack.h.
+	const char *const HeuristicNames[] = { "bssf", "blsf", "baf", "bl", "cp" };
+
+	const char *const PVRTCQualityNames[] = { "fast", "normal", "best" };
+
+	const char *const MipmapFilterNames[] = { "box", "kaiser" };
+
+	/// The names of the DitherMode values on the command line, in their order.
+	const char *const DitherModeNames[] = { "none", "ordered", "diffusion" };
+
+	/// The settings the sprite sheets are generated with, which default to those of the Tupac class.
+	struct Options
+	{
+		SpriteSheetSettings settings;
+		int heuristic; ///< A FreeRectChoiceHeuristic, or -1 for the default strategies of PackingSearch.
+		std::string outputName;
+		std::string prefix;
+		int jobs; ///< The largest number of threads, each packing a sprite sheet, or 0 for one per processor.
+		bool verbose;
+	};
+
+	/// A sprite sheet to generate.
+	struct Sheet
+	{
+		/// The directories the images are taken from. An image in several of them is taken from the first.
+		std::vector<std::string> directories;
+		std::string outputName;
+		bool success;
+	};
+
+	int ParseName(const char *value, const char *const *names, int count, const char *option)
+	{
+		for(int i = 0; i < count; ++i)
+			if (!strcmp(value, names[i]))
+				return i;
+		fprintf(stderr, "Error: Unknown %s %s.\n", option, value);
+		exit(EXIT_FAILURE);
+	}
+
+	int ParseInt(const char *value, int min, int max, const char *option)
+	{
+		char *end;
+		long n = strtol(value, &end, 10);
+		if (!*value || *end || n < min || n > max)
+		{
+			fprintf(stderr, "Error: The %s must be a number from %d to %d.\n", option, min, max);
+			exit(EXIT_FAILURE);
+		}
+		return (int)n;
+	}
+
+	/// Returns the value of an option given as "-x value", "-xvalue" or "--long=value", or NULL if arg is not the option.
+	const char *OptionValue(int argc, const char **argv, int &i, const char *shortName, const char *longName)
+	{
+		const char *arg = argv[i];
+		size_t longLength = strlen(longName);
+		if (!strncmp(arg, longName, longLength) && arg[longLength] == '=')
+			return arg + longLength + 1;
+		if (!shortName || strncmp(arg, shortName, strlen(shortName)))
+			return NULL;
+		if (arg[strlen(shortName)])
+			return arg + strlen(shortName);
+		if (i + 1 >= argc)
+		{
+			fprintf(stderr, "Error: Missing value of %s.\n", shortName);
+			exit(EXIT_FAILURE);
+		}
+		return argv[++i];
+	}
+
+	void PrintUsage(const char *prog)
+	{
+		fprintf(stdout,
+"Usage:\n"
+"%s [options] [-o <outputname>|--output=<outputname>] dir[:dir...]\n"
+"%s [options] [-o <outputdir>|--output=<outputdir>] dir1[:dir...] [dir2[:dir...] ...]\n"
+"%s -h|--help\n"
+"\n"
+"Every operand is packed into a sprite sheet named after its first directory, the others are searched\n"
+"for the images the first doesn't have. Several sprite sheets are packed at the same time.\n"
+"\n"
+"Options:\n"
+"  -f, --format=<format>        png, png8, webp, rgba8888, rgba4444, rgb565, pvrtc4 or pvrtc2 (default png)\n"
+"  -p, --padding=<pixels>       transparent pixels around each frame (default 1)\n"
+"  -m, --max-size=<pixels>      largest width and height of a page (default 2048)\n"
+"  -H, --heuristic=<heuristic>  bssf, blsf, baf, bl, cp or all (default all). all leaves out\n"
+"                               cp, which is slow for many small frames\n"
+"  -P, --prefix=<dir>           directory the frame names are prefixed with\n"
+"      --extrude=<pixels>       pixels the edges of each frame are repeated by\n"
+"      --polygons               outlines the frames with polygons, in format 3 property lists\n"
+"      --alpha-bleed            gives transparent pixels the color of their neighbours\n"
+"      --dither[=<mode>]        dithers png8, rgba4444 and rgb565 sprite sheets, by diffusion or\n"
+"                               ordered (default diffusion). png8 is always dithered by diffusion\n"
+"      --compress               writes pvr sprite sheets as pvr.ccz\n"
+"      --pvrtc-quality=<q>      fast, normal or best (default best)\n"
+"      --mipmaps[=<filter>]     stores mipmaps in pvr sprite sheets, box or kaiser (default kaiser)\n"
+"      --webp-quality=<q>       from 0 to 100, lossless at 100 (default 80)\n"
+"      --colors=<n>             largest number of colors of png8 sprite sheets (default 256)\n"
+"  -j, --jobs=<n>               sprite sheets packed at the same time, or threads a lone one is\n"
+"                               packed with (default one per processor)\n"
+"  -v, --verbose\n", prog, prog, prog);
+	}
+
+	void ParseArgs(int argc, const char **argv, Options &options, std::vector<Sheet> &sheets)
+	{
+		SpriteSheetSettings &settings = options.settings;
+		options.heuristic = -1;
+		options.jobs = 0;
+		options.verbose = false;
+
+		bool stillParsingArgs = true;
+		for(int i = 1; i < argc; ++i)
+		{
+			const char *arg = argv[i];
+			const char *value;
+
+			if (stillParsingArgs && (!strcmp(arg, "-h") || !strcmp(arg, "--help")))
+			{
+				PrintUsage(argv[0]);
+				exit(EXIT_SUCCESS);
+			}
+			else if (stillParsingArgs && (!strcmp(arg, "-v") || !strcmp(arg, "--verbose")))
+				options.verbose = true;
+			else if (stillParsingArgs && !strcmp(arg, "--alpha-bleed"))
+				settings.alphaBleed = true;
+			else if (stillParsingArgs && !strcmp(arg, "--dither"))
+				settings.dither = true;
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, NULL, "--dither")))
+			{
+				settings.ditherMode = (DitherMode)ParseName(value, DitherModeNames, 3, "dither mode");
+				settings.dither = settings.ditherMode != DitherNone;
+			}
+			else if (stillParsingArgs && !strcmp(arg, "--polygons"))
+				settings.polygonMode = true;
+			else if (stillParsingArgs && !strcmp(arg, "--compress"))
+				settings.compress = true;
+			else if (stillParsingArgs && !strcmp(arg, "--mipmaps"))
+				settings.mipmaps = true;
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, NULL, "--mipmaps")))
+			{
+				settings.mipmaps = true;
+				settings.mipmapFilter = (MipmapFilter)ParseName(value, MipmapFilterNames, 2, "mipmap filter");
+			}
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, "-o", "--output")))
+				options.outputName = value;
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, "-f", "--format")))
+				settings.imageFormat = (SpriteSheetImageFormat)ParseName(value, ImageFormatNames, 8, "image format");
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, "-p", "--padding")))
+				settings.padding = ParseInt(value, 0, 64, "padding");
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, "-m", "--max-size")))
+				settings.maxSize = ParseInt(value, 1, 16384, "maximum size");
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, "-H", "--heuristic")))
+				options.heuristic = strcmp(value, "all") ? ParseName(value, HeuristicNames, 5, "heuristic") : -1;
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, "-P", "--prefix")))
+				options.prefix = value;
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, NULL, "--extrude")))
+				settings.extrude = ParseInt(value, 0, 64, "extrusion");
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, NULL, "--pvrtc-quality")))
+				settings.pvrtcQuality = (PVRTCQuality)ParseName(value, PVRTCQualityNames, 3, "PVRTC quality");
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, NULL, "--webp-quality")))
+				settings.webpQuality = ParseInt(value, 0, 100, "WebP quality");
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, NULL, "--colors")))
+				settings.paletteColors = ParseInt(value, 2, 256, "number of colors");
+			else if (stillParsingArgs && (value = OptionValue(argc, argv, i, "-j", "--jobs")))
+				options.jobs = ParseInt(value, 1, 1024, "number of jobs");
+
+			else if (stillParsingArgs && !strcmp(arg, "--"))
+				stillParsingArgs = false;
+			else if (stillParsingArgs && arg[0] == '-' && arg[1])
+			{
+				fprintf(stderr, "Error: Unknown option %s.\n", arg);
+				exit(EXIT_FAILURE);
+			}
+			else
+			{
+				stillParsingArgs = false;
+				Sheet sheet;
+				sheet.success = false;
+				std::string dirs = arg;
+				for(size_t begin = 0; begin <= dirs.size(); )
+				{
+					size_t end = std::min(dirs.find(':', begin), dirs.size());
+					if (end > begin)
+						sheet.directories.push_back(dirs.substr(begin, end - begin));
+					begin = end + 1;
+				}
+				if (!sheet.directories.empty())
+					sheets.push_back(sheet);
+			}
+		}
+		if (sheets.empty())
+		{
+			fprintf(stdout, "Error: Must provide at least one directory to pack.\n");
+			exit(EXIT_FAILURE);
+		}
+
+		for(size_t i = 0; i < sheets.size(); ++i)
+		{
+			std::string dir = sheets[i].directories[0];
+			while(dir.size() > 1 && dir[dir.size() - 1] == '/')
+				dir.erase(dir.size() - 1);
+			std::string name = dir.substr(dir.rfind('/') == std::string::npos ? 0 : dir.rfind('/') + 1);
+
+			if (options.outputName.empty()) // no output name: name the sprite sheet after the directory, next to it
+				sheets[i].outputName = dir;
+			else if (sheets.size() == 1) // output name and only one sprite sheet: use output verbatim
+				sheets[i].outputName = options.outputName;
+			else // output name and several sprite sheets: use the directory's name in the output directory
+				sheets[i].outputName = options.outputName + "/" + name;
+		}
+	}
+
+	bool CreateDirectories(const std::string &path)
+	{
+		for(size_t i = 1; i <= path.size(); ++i)
+		{
+			if (i < path.size() && path[i] != '/')
+				continue;
+			if (mkdir(path.substr(0, i).c_str(), 0777) && errno != EEXIST)
+				return false;
+		}
+		return true;
+	}
+
+	/// Lists the PNG files of the directories, each name once, from the first directory that has it.
+	/// @return False if a directory could not be read.
+	bool ListImages(const std::vector<std::string> &directories, std::vector<std::string> &names, std::vector<std::string> &paths)
+	{
+		std::set<std::string> found;
+		for(size_t i = 0; i < directories.size(); ++i)
+		{
+			DIR *dir = opendir(directories[i].c_str());
+			if (!dir)
+			{
+				fprintf(stderr, "Error: Failed reading directory %s.\n", directories[i].c_str());
+				return false;
+			}
+			while(dirent *entry = readdir(dir))
+			{
+				std::string name = entry->d_name;
+				if (name.size() < 4 || name[0] == '.')
+					continue;
+				std::string extension = name.substr(name.size() - 4);
+				for(size_t c = 0; c < extension.size(); ++c)
+					extension[c] = (char)tolower(extension[c]);
+				if (extension == ".png")
+					found.insert(name);
+			}
+			closedir(dir);
+		}
+
+		for(std::set<std::string>::const_iterator name = found.begin(); name != found.end(); ++name)
+			for(size_t i = 0; i < directories.size(); ++i)
+			{
+				std::string path = directories[i] + "/" + *name;
+				struct stat info;
+				if (!stat(path.c_str(), &info))
+				{
+					names.push_back(*name);
+					paths.push_back(path);
+					break;
+				}
+			}
+		return true;
+	}
+
+	/// Generates a sprite sheet, using up to numThreads threads for its pages.
+	bool PackSheet(const Sheet &sheet, const Options &options, int numThreads)
+	{
+		std::vector<std::string> names, paths;
+		if (!ListImages(sheet.directories, names, paths))
+			return false;
+
+		std::vector<SpriteSheetImage> images(paths.size());
+		for(size_t i = 0; i < paths.size(); ++i)
+		{
+			images[i].path = paths[i];
+			images[i].name = options.prefix.empty() ? names[i] : options.prefix + "/" + names[i];
+		}
+
+		SpriteSheetSettings settings = options.settings;
+		settings.numThreads = numThreads;
+		if (options.heuristic >= 0)
+		{
+			// Try the heuristic with every insertion order it supports
+			for(int order = PackingOrderBatch; order <= PackingOrderPerimeter; ++order)
+			{
+				if (options.heuristic == MaxRectsBinPack::RectContactPointRule && order == PackingOrderBatch)
+					continue;
+				PackingStrategy strategy = { (MaxRectsBinPack::FreeRectChoiceHeuristic)options.heuristic, (PackingOrder)order };
+				settings.strategies.push_back(strategy);
+			}
+		}
+
+		SpriteSheetBuilder builder(settings);
+		bool success = builder.Build(images, sheet.outputName);
+
+		for(size_t i = 0; i < builder.Errors().size(); ++i)
+			fprintf(stderr, "Error: %s.\n", builder.Errors()[i].c_str());
+		if (options.verbose)
+			for(size_t i = 0; i < builder.Notices().size(); ++i)
+				fprintf(stderr, "Notice: %s.\n", builder.Notices()[i].c_str());
+		return success;
+	}
+
+	struct SheetPacker
+	{
+		std::vector<Sheet> *sheets;
+		const Options *options;
+		int threadsPerSheet;
+
+		void operator()(int i)
+		{
+			Sheet &sheet = (*sheets)[i];
+			std::string outputDir = sheet.outputName.substr(0, sheet.outputName.rfind('/') == std::string::npos ? 0 : sheet.outputName.rfind('/'));
+			if (!outputDir.empty() && !CreateDirectories(outputDir))
+			{
+				fprintf(stderr, "Error: Failed creating directory %s.\n", outputDir.c_str());
+				return;
+			}
+			sheet.success = PackSheet(sheet, *options, threadsPerSheet);
+			if (sheet.success && options->verbose)
+				fprintf(stderr, "Notice: Successfully packed %s.\n", sheet.outputName.c_str());
+		}
+	};
+}
+
+int main(int argc, const char **argv)
+{
+	Options options;
+	std::vector<Sheet> sheets;
+	ParseArgs(argc, argv, options, sheets);
+
+	// Sprite sheets are packed concurrently on a thread each, so a single one is given all the threads
+	int jobs = options.jobs ? options.jobs : ParallelForThreadCount();
+	SheetPacker packer = { &sheets, &options, (int)sheets.size() > 1 ? 1 : jobs };
+	ParallelFor((int)sheets.size(), packer, jobs);
+
+	long succeeds = 0, failures = 0;
+	for(size_t i = 0; i < sheets.size(); ++i)
+		sheets[i].success ? ++succeeds : ++failures;
+
+	if (options.verbose)
+		fprintf(stderr, "Done packing. %ld sprite sheets succeeded, %ld sprite sheets failed.\n", succeeds, failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}